@@ -17,7 +17,8 @@ int main(int argc, char **argv) {
     g(x, y) = f(y, x) + f(x, y) + cast<uint16_t>(an_extern_func(x, y)) + h();
 
     h.compute_root();
-    f.compute_root();
+    f.compute_root().vectorize(x, 8).parallel(y);
+    g.vectorize(x, 8).parallel(y);
     f.debug_to_file("f.tiff");
 
     std::vector<Argument> args;
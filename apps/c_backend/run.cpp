@@ -58,6 +58,7 @@ int main(int argc, char **argv) {
                 printf("out_native(%d, %d) = %d, but out_c(%d, %d) = %d\n",
                        x, y, out_native(x, y),
                        x, y, out_c(x, y));
+                return -1;
             }
         }
     }
@@ -0,0 +1,100 @@
+// Compares the throughput of the image loaders in halide_image_io.h:
+// PNG loading with one thread and with one thread per core, PPM loading
+// against mapping the same file, and the old per-pixel conversion loop
+// against the row-at-a-time conversion the loaders now use.
+
+#include <stdio.h>
+
+#include "halide_image.h"
+#include "halide_image_io.h"
+#include "benchmark.h"
+
+using namespace Halide::Tools;
+
+int main(int argc, char **argv) {
+    const int W = 4096, H = 3072;
+
+    Image<uint8_t> im(W, H, 3);
+    for (int c = 0; c < 3; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                im(x, y, c) = (uint8_t)(x * 3 + y * 5 + c * 64 + ((x * y) >> 6));
+            }
+        }
+    }
+    save_image(im, "bench.png");
+    save_image(im, "bench.ppm");
+
+    const double mb = (double)W * H * 3 / (1024 * 1024);
+    double t;
+
+    t = benchmark(3, 1, [&]() {
+        Image<float> out;
+        load_png<Image<float>, Internal::CheckFail>("bench.png", &out, 1);
+    });
+    printf("load_png, 1 thread:        %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    t = benchmark(3, 1, [&]() {
+        Image<float> out;
+        load_png<Image<float>, Internal::CheckFail>("bench.png", &out);
+    });
+    printf("load_png, all threads:     %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    t = benchmark(3, 1, [&]() {
+        Image<uint8_t> out;
+        load_ppm<Image<uint8_t>, Internal::CheckFail>("bench.ppm", &out);
+    });
+    printf("load_ppm:                  %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    // Mapping is lazy, so touch every pixel to make the comparison fair.
+    t = benchmark(3, 1, [&]() {
+        MappedImage mapped;
+        map_ppm<Internal::CheckFail>("bench.ppm", &mapped);
+        Image<uint8_t> out(mapped.raw_buffer());
+        uint32_t sum = 0;
+        const uint8_t *p = out.data();
+        for (size_t i = 0; i < (size_t)W * H * 3; i++) {
+            sum += p[i];
+        }
+        if (sum == 1) printf(" ");
+    });
+    printf("map_ppm, then read pixels: %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    // The conversion loops alone, on an interleaved buffer already in
+    // memory.
+    std::vector<uint8_t> interleaved((size_t)W * H * 3);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            for (int c = 0; c < 3; c++) {
+                interleaved[((size_t)y * W + x) * 3 + c] = im(x, y, c);
+            }
+        }
+    }
+    Image<float> out(W, H, 3);
+
+    t = benchmark(3, 1, [&]() {
+        float *ptr = out.data();
+        const uint8_t *src = interleaved.data();
+        int c_stride = out.stride(2);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                for (int c = 0; c < 3; c++) {
+                    Internal::convert(*src++, ptr[c * c_stride]);
+                }
+                ptr++;
+            }
+        }
+    });
+    printf("per-pixel conversion:      %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    t = benchmark(3, 1, [&]() {
+        for (int y = 0; y < H; y++) {
+            Internal::deinterleave_row(interleaved.data() + (size_t)y * W * 3, W, 3,
+                                       out.data() + (size_t)y * out.stride(1),
+                                       out.stride(0), out.stride(2));
+        }
+    });
+    printf("per-row conversion:        %8.2f ms (%7.1f MB/s)\n", t * 1e3, mb / t);
+
+    return 0;
+}
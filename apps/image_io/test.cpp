@@ -0,0 +1,233 @@
+// Checks that the loaders, savers, and mapped readers in
+// halide_image_io.h agree with each other: PPM and PGM files survive a
+// round trip at both bit depths, threaded PNG decoding matches
+// single-threaded decoding, and mapping a PPM, NPY, or raw file gives
+// the same pixels as loading it.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "halide_image.h"
+#include "halide_image_io.h"
+
+using namespace Halide::Tools;
+
+namespace {
+
+const int W = 67, H = 43;
+
+template<typename T>
+Image<T> make_image(int channels) {
+    Image<T> im = channels == 1 ? Image<T>(W, H) : Image<T>(W, H, channels);
+    const int shift = sizeof(T) == 1 ? 0 : 5;
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                im(x, y, c) = (T)((x * 3 + y * 5 + c * 64 + ((x * y) >> 3)) << shift);
+            }
+        }
+    }
+    return im;
+}
+
+template<typename T>
+T mapped_pixel(const MappedImage &im, int x, int y, int c) {
+    const buffer_t *buf = im.raw_buffer();
+    const T *p = (const T *)buf->host;
+    return p[x * buf->stride[0] + y * buf->stride[1] + c * buf->stride[2]];
+}
+
+template<typename T>
+bool same_pixels(Image<T> a, Image<T> b, int channels, const char *what) {
+    if (a.width() != W || a.height() != H || b.width() != W || b.height() != H) {
+        printf("%s: wrong size\n", what);
+        return false;
+    }
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (a(x, y, c) != b(x, y, c)) {
+                    printf("%s: pixel (%d, %d, %d) is %d instead of %d\n",
+                           what, x, y, c, (int)b(x, y, c), (int)a(x, y, c));
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool same_pixels(Image<T> a, const MappedImage &b, int channels, const char *what) {
+    if (b.type().bits != sizeof(T) * 8 || b.width() != W || b.height() != H ||
+        (channels > 1 && b.channels() != channels)) {
+        printf("%s: wrong type or size\n", what);
+        return false;
+    }
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                T actual = mapped_pixel<T>(b, x, y, c);
+                if (a(x, y, c) != actual) {
+                    printf("%s: pixel (%d, %d, %d) is %d instead of %d\n",
+                           what, x, y, c, (int)actual, (int)a(x, y, c));
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Save as PPM or PGM, then check that loading and mapping the file both
+// give back the original pixels.
+template<typename T>
+bool check_ppm(int channels, const std::string &filename) {
+    Image<T> im = make_image<T>(channels);
+    if (!save_ppm(im, filename)) return false;
+
+    Image<T> loaded;
+    if (!load_ppm(filename, &loaded) ||
+        !same_pixels(im, loaded, channels, "load_ppm")) return false;
+
+    Image<T> loaded_threaded;
+    if (!load_ppm(filename, &loaded_threaded, 4) ||
+        !same_pixels(im, loaded_threaded, channels, "load_ppm with four threads")) return false;
+
+    MappedImage mapped;
+    if (!map_ppm(filename, &mapped) ||
+        !same_pixels(im, mapped, channels, "map_ppm")) return false;
+
+    return true;
+}
+
+bool check_png(const std::string &filename) {
+    Image<uint8_t> im = make_image<uint8_t>(3);
+    if (!save_png(im, filename)) return false;
+
+    Image<uint8_t> single, threaded;
+    if (!load_png(filename, &single, 1) || !load_png(filename, &threaded, 4)) return false;
+    if (!same_pixels(im, single, 3, "load_png with one thread") ||
+        !same_pixels(single, threaded, 3, "load_png with four threads")) return false;
+
+    // Converting while decoding should also be independent of the
+    // number of threads.
+    Image<float> single_f, threaded_f;
+    if (!load_png(filename, &single_f, 1) || !load_png(filename, &threaded_f, 0)) return false;
+    for (int c = 0; c < 3; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (single_f(x, y, c) != threaded_f(x, y, c)) {
+                    printf("load_png to float: pixel (%d, %d, %d) depends on the number of threads\n", x, y, c);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void write_file(const std::string &filename, const std::string &header,
+                const void *data, size_t bytes) {
+    FILE *f = fopen(filename.c_str(), "wb");
+    fwrite(header.data(), 1, header.size(), f);
+    fwrite(data, 1, bytes, f);
+    fclose(f);
+}
+
+// Writes a version 1 NPY file, padding the header so that the data is
+// 16-byte aligned as numpy does.
+void write_npy(const std::string &filename, const std::string &dict,
+               const void *data, size_t bytes) {
+    std::string header = dict;
+    while ((10 + header.size() + 1) % 16) header += ' ';
+    header += '\n';
+    std::string prefix("\x93NUMPY\x01\x00", 8);
+    prefix += (char)(header.size() & 0xff);
+    prefix += (char)(header.size() >> 8);
+    write_file(filename, prefix + header, data, bytes);
+}
+
+bool check_npy(const std::string &filename) {
+    Image<uint16_t> im = make_image<uint16_t>(3);
+
+    // An array of shape (H, W, 3), as most Python imaging libraries
+    // would produce, has the channels innermost.
+    std::vector<uint16_t> hwc;
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            for (int c = 0; c < 3; c++) {
+                hwc.push_back(im(x, y, c));
+            }
+        }
+    }
+    char dict[128];
+    snprintf(dict, sizeof(dict), "{'descr': '<u2', 'fortran_order': False, 'shape': (%d, %d, 3), }", H, W);
+    write_npy(filename, dict, hwc.data(), hwc.size() * 2);
+
+    MappedImage mapped;
+    if (!map_npy(filename, &mapped) ||
+        !same_pixels(im, mapped, 3, "map_npy")) return false;
+    if (mapped.stride(0) != 3 || mapped.stride(1) != W * 3 || mapped.stride(2) != 1) {
+        printf("map_npy: strides are %d %d %d instead of 3 %d 1\n",
+               mapped.stride(0), mapped.stride(1), mapped.stride(2), W * 3);
+        return false;
+    }
+
+    // A Fortran-order array of shape (H, W) has y innermost.
+    std::vector<uint16_t> column_major;
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            column_major.push_back(im(x, y, 0));
+        }
+    }
+    snprintf(dict, sizeof(dict), "{'descr': '<u2', 'fortran_order': True, 'shape': (%d, %d), }", H, W);
+    write_npy(filename, dict, column_major.data(), column_major.size() * 2);
+
+    if (!map_npy(filename, &mapped) ||
+        !same_pixels(im, mapped, 1, "map_npy of a Fortran-order array")) return false;
+    if (mapped.stride(0) != H || mapped.stride(1) != 1) {
+        printf("map_npy: strides of a Fortran-order array are %d %d instead of %d 1\n",
+               mapped.stride(0), mapped.stride(1), H);
+        return false;
+    }
+    return true;
+}
+
+bool check_raw(const std::string &ppm_filename, const std::string &filename) {
+    Image<uint16_t> loaded;
+    if (!load_ppm(ppm_filename, &loaded)) return false;
+
+    // Write the planar pixels after a header that maps must skip.
+    std::vector<uint16_t> planar;
+    for (int c = 0; c < 3; c++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                planar.push_back(loaded(x, y, c));
+            }
+        }
+    }
+    write_file(filename, std::string(16, 'h'), planar.data(), planar.size() * 2);
+
+    MappedImage mapped;
+    return map_raw(filename, halide_type_t(halide_type_uint, 16), {W, H, 3}, &mapped, 16) &&
+        same_pixels(loaded, mapped, 3, "map_raw");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (!check_ppm<uint8_t>(3, "test_8.ppm") ||
+        !check_ppm<uint8_t>(1, "test_8.pgm") ||
+        !check_ppm<uint16_t>(3, "test_16.ppm") ||
+        !check_ppm<uint16_t>(1, "test_16.pgm") ||
+        !check_png("test.png") ||
+        !check_npy("test.npy") ||
+        !check_raw("test_16.ppm", "test.raw")) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
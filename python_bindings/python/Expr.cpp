@@ -101,5 +101,15 @@ void defineExpr()
             .export_values()
             ;
 
+    p::enum_<h::MemoryType>("MemoryType",
+                            "An enum describing where the storage for a Func should live. "
+                            "Used by Func.store_in, and in the Allocate IR node.")
+            .value("Auto", h::MemoryType::Auto)
+            .value("Heap", h::MemoryType::Heap)
+            .value("Stack", h::MemoryType::Stack)
+            .value("Register", h::MemoryType::Register)
+            .export_values()
+            ;
+
     return;
 }
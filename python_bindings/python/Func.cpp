@@ -12,6 +12,7 @@
 #include "Func_Stage.h"
 #include "Func_VarOrRVar.h"
 #include "Func_gpu.h"
+#include "Image.h"
 
 #include <vector>
 #include <string>
@@ -20,9 +21,37 @@ namespace h = Halide;
 namespace p = boost::python;
 
 
+/// Releases the Python global interpreter lock for the lifetime of the object,
+/// so that other Python threads can run (or realize other pipelines) meanwhile.
+class ScopedGILRelease
+{
+public:
+    ScopedGILRelease() : state(PyEval_SaveThread()) {}
+    ~ScopedGILRelease() { PyEval_RestoreThread(state); }
+
+private:
+    PyThreadState *state;
+};
+
+
+/// Compiles the function (if needed) while still holding the GIL, and returns
+/// the target the jitted code will run with. Lowering and code generation touch
+/// global state (unique names, reference counts of shared IR) that Python threads
+/// may also be modifying, so only the jitted code itself runs without the GIL.
+h::Target func_prepare_realize(h::Func &that, const h::Target &target)
+{
+    const h::Target jit_target = (target.os == h::Target::OSUnknown) ?
+                h::get_jit_target_from_environment() : target;
+    that.compile_jit(jit_target);
+    return jit_target;
+}
+
+
 h::Realization func_realize0(h::Func &that, std::vector<int32_t> sizes, const h::Target &target = h::Target())
 {
-    return that.realize(sizes, target);
+    const h::Target jit_target = func_prepare_realize(that, target);
+    ScopedGILRelease release;
+    return that.realize(sizes, jit_target);
 }
 
 BOOST_PYTHON_FUNCTION_OVERLOADS( func_realize0_overloads, func_realize0, 2, 3)
@@ -31,7 +60,9 @@ BOOST_PYTHON_FUNCTION_OVERLOADS( func_realize0_overloads, func_realize0, 2, 3)
 h::Realization func_realize1(h::Func &that, int x_size=0, int y_size=0, int z_size=0, int w_size=0,
                              const h::Target &target = h::Target())
 {
-    return that.realize(x_size, y_size, z_size, w_size, target);
+    const h::Target jit_target = func_prepare_realize(that, target);
+    ScopedGILRelease release;
+    return that.realize(x_size, y_size, z_size, w_size, jit_target);
 }
 
 BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize1_overloads, func_realize1, 1, 6)
@@ -39,7 +70,9 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize1_overloads, func_realize1, 1, 6)
 
 void func_realize2(h::Func &that, h::Realization dst, const h::Target &target = h::Target())
 {
-    that.realize(dst, target);
+    const h::Target jit_target = func_prepare_realize(that, target);
+    ScopedGILRelease release;
+    that.realize(dst, jit_target);
     return;
 }
 
@@ -48,13 +81,28 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize2_overloads, func_realize2, 2, 3)
 
 void func_realize3(h::Func &that, h::Buffer dst, const h::Target &target = h::Target())
 {
-    that.realize(dst, target);
+    const h::Target jit_target = func_prepare_realize(that, target);
+    ScopedGILRelease release;
+    that.realize(dst, jit_target);
     return;
 }
 
 BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize3_overloads, func_realize3, 2, 3)
 
 
+#ifdef USE_NUMPY
+void func_realize4(h::Func &that, bn::ndarray dst, const h::Target &target = h::Target())
+{
+    // dst is kept alive by the caller for the duration of the call
+    h::Buffer buffer = ndarray_to_buffer(dst, "", true);
+    func_realize3(that, buffer, target);
+    return;
+}
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize4_overloads, func_realize4, 2, 3)
+#endif // USE_NUMPY
+
+
 void func_compile_jit0(h::Func &that)
 {
     that.compile_jit();
@@ -139,6 +187,16 @@ h::Func &func_compute_at1(h::Func &that, h::Func f, h::RVar var)
     return that.compute_at(f, var);
 }
 
+h::Func &func_compute_with0(h::Func &that, h::Stage s, h::VarOrRVar var)
+{
+    return that.compute_with(s, var);
+}
+
+h::Func &func_compute_with1(h::Func &that, h::Func f, h::VarOrRVar var)
+{
+    return that.compute_with(f, var);
+}
+
 
 
 void tuple_to_var_expr_vector(
@@ -374,7 +432,11 @@ void defineFunc()
                        "Evaluate this function over some rectangular domain and return"
                        "the resulting buffer. The buffer should probably be instantly"
                        "wrapped in an Image class.\n\n" \
-                       "One can use f.realize(Buffer) to realize into an existing buffer."))
+                       "One can use f.realize(Buffer) to realize into an existing buffer.\n\n" \
+                       "The Python global interpreter lock is released while the pipeline "
+                       "runs, so several Python threads can realize different pipelines "
+                       "concurrently (a single Func must not be realized from two threads at once). "
+                       "If no target is given, the target from HL_JIT_TARGET is used."))
             .def("realize", &func_realize0, func_realize0_overloads(
                      p::args("self", "sizes", "target")))
             .def("realize", &func_realize3, func_realize3_overloads(
@@ -387,6 +449,15 @@ void defineFunc()
             .def("realize", &func_realize2, func_realize2_overloads(
                      p::args("self", "dst", "target")));
 
+#ifdef USE_NUMPY
+    func_class.def("realize", &func_realize4, func_realize4_overloads(
+                       p::args("self", "dst", "target"),
+                       "Evaluate this function directly into an existing numpy array "
+                       "(no copy). Dimension 0 of the function is the first axis of the "
+                       "array, and any strides are allowed. The array must be writeable, "
+                       "aligned, and in native byte order."));
+#endif
+
 
     func_class.def("compile_to_bitcode", &func_compile_to_bitcode0,
                    func_compile_to_bitcode0_overloads(
@@ -596,6 +667,14 @@ void defineFunc()
             .def("unroll", &func_unroll0<Func>, p::args("self", "var"),
                  p::return_internal_reference<1>());
 
+    func_class.def("unroll_and_jam", &func_unroll_and_jam<Func>, p::args("self", "var", "inner", "factor"),
+                   p::return_internal_reference<1>(),
+                   "Split a dimension by the given factor, move the inner dimension "
+                   "of the split to just inside the loop over inner, and unroll it. "
+                   "Used on update definitions to accumulate a tile of outputs in "
+                   "registers over a reduction. After this call, var refers to the "
+                   "outer dimension of the split.");
+
     func_class.def("bound", &Func::bound,  p::args("self", "var", "min", "extent"),
                    p::return_internal_reference<1>(),
                    "Statically declare that the range over which a function should "
@@ -671,6 +750,14 @@ void defineFunc()
                    p::return_internal_reference<1>(),
                    "Compute all of this function once ahead of time.");
 
+    func_class.def("compute_with", &func_compute_with0, p::args("self", "s", "var"),
+                   p::return_internal_reference<1>(),
+                   "Compute this function in the same loop nest as stage s of a "
+                   "sibling function computed at the same loop level, fusing all "
+                   "loops from the outermost in down to var (can be a Var or an RVar).")
+            .def("compute_with", &func_compute_with1, p::args("self", "f", "var"),
+                 p::return_internal_reference<1>());
+
 
     func_class.def("store_at", &func_store_at0, p::args("self", "f", "var"),
                    p::return_internal_reference<1>(),
@@ -686,6 +773,32 @@ void defineFunc()
                    p::return_internal_reference<1>(),
                    "Equivalent to Func.store_at, but schedules storage outside the outermost loop.");
 
+    func_class.def("fold_storage", &Func::fold_storage, p::args("self", "dim", "extent"),
+                   p::return_internal_reference<1>(),
+                   "Fold the storage of this function along the given dimension into a "
+                   "circular buffer of the given extent, for cases where Halide can't "
+                   "infer the fold factor itself. The extent is checked at runtime.");
+
+    func_class.def("split_storage", &Func::split_storage, p::args("self", "dim", "factor"),
+                   p::return_internal_reference<1>(),
+                   "Store this function in blocks of factor contiguous elements along "
+                   "the given dimension. Blocks nest innermost first in the order they "
+                   "are declared, inside all of the ordinary dimensions.");
+
+    func_class.def("skip_tiles", &Func::skip_tiles, p::args("self", "var", "mask", "fill"),
+                   p::return_internal_reference<1>(),
+                   "Skip each iteration of the loop over var in which every value of "
+                   "mask it reads is zero, writing fill to the part of this function "
+                   "it would have computed instead. The mask must be computed at or "
+                   "outside of the loop.");
+
+    func_class.def("store_in", &Func::store_in, p::args("self", "memory_type"),
+                   p::return_internal_reference<1>(),
+                   "Choose where the storage for this function lives: on the heap, "
+                   "on the stack, or in registers. Register storage requires that the "
+                   "allocation have a constant size and that all accesses to it be at "
+                   "constant indices, which usually means fully unrolling the loops over it.");
+
     func_class.def("compute_inline", &Func::compute_inline, p::arg("self"),
                    p::return_internal_reference<1>(),
                    "Aggressively inline all uses of this function. This is the "
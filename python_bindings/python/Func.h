@@ -66,6 +66,12 @@ FuncOrStage &func_unroll1(FuncOrStage &that, hh::VarOrRVar var, int factor)
     return that.unroll(var, factor);
 }
 
+template<typename FuncOrStage>
+FuncOrStage &func_unroll_and_jam(FuncOrStage &that, hh::VarOrRVar var, hh::VarOrRVar inner, int factor)
+{
+    return that.unroll_and_jam(var, inner, factor);
+}
+
 template<typename FuncOrStage>
 FuncOrStage &func_tile0(FuncOrStage &that, hh::VarOrRVar x, hh::VarOrRVar y,
                         hh::VarOrRVar xo, hh::VarOrRVar yo,
@@ -20,6 +20,16 @@ h::Stage &stage_split0(h::Stage &that, h::VarOrRVar old, h::VarOrRVar outer, h::
     return that.split(old, outer, inner, factor);
 }
 
+h::Stage &stage_compute_with0(h::Stage &that, h::Stage s, h::VarOrRVar var)
+{
+    return that.compute_with(s, var);
+}
+
+h::Stage &stage_compute_with1(h::Stage &that, h::Func f, h::VarOrRVar var)
+{
+    return that.compute_with(f, var);
+}
+
 
 void defineStage()
 {
@@ -41,6 +51,12 @@ void defineStage()
                  "Return the name of this stage, e.g. \"f.update(2)\"")
             .def("allow_race_conditions", &Stage::allow_race_conditions, p::arg("self"),
                  p::return_internal_reference<1>())
+            .def("compute_with", &stage_compute_with0, p::args("self", "s", "var"),
+                 p::return_internal_reference<1>(),
+                 "Compute this stage in the same loop nest as stage s, "
+                 "fusing all loops from the outermost in down to var.")
+            .def("compute_with", &stage_compute_with1, p::args("self", "f", "var"),
+                 p::return_internal_reference<1>())
             ;
 
 
@@ -110,6 +126,14 @@ void defineStage()
             .def("unroll", &func_unroll0<Stage>, p::args("self", "var"),
                  p::return_internal_reference<1>());
 
+    stage_class.def("unroll_and_jam", &func_unroll_and_jam<Stage>, p::args("self", "var", "inner", "factor"),
+                    p::return_internal_reference<1>(),
+                    "Split a dimension by the given factor, move the inner dimension "
+                    "of the split to just inside the loop over inner, and unroll it. "
+                    "Used on update definitions to accumulate a tile of outputs in "
+                    "registers over a reduction. After this call, var refers to the "
+                    "outer dimension of the split.");
+
     stage_class.def("tile", &func_tile0<Stage>,  p::args("self", "x", "y", "xo", "yo", "xi", "yi", "xfactor", "yfactor"),
                     p::return_internal_reference<1>(),
                     "Split two dimensions at once by the given factors, and then "
@@ -22,6 +22,11 @@ h::Expr cast0(h::Type t, h::Expr e)
     return Halide::cast(t, e);
 }
 
+h::Expr saturating_cast0(h::Type t, h::Expr e)
+{
+    return h::saturating_cast(t, e);
+}
+
 h::Expr select0(h::Expr condition, h::Expr true_value, h::Expr false_value)
 {
     return h::select(condition, true_value, false_value);
@@ -608,6 +613,33 @@ void defineOperators()
            "Count the number of trailing zero bits in an expression. The result is "
            "undefined if the value of the expression is zero.");
 
+    p::def("saturating_add", &h::saturating_add, p::args("a", "b"),
+           "Add two integers, clamping the result to the range of the type "
+           "instead of wrapping around.");
+
+    p::def("saturating_sub", &h::saturating_sub, p::args("a", "b"),
+           "Subtract two integers, clamping the result to the range of the type "
+           "instead of wrapping around.");
+
+    p::def("halving_add", &h::halving_add, p::args("a", "b"),
+           "Compute (a + b) / 2, rounding down, as if the sum were computed "
+           "with enough bits that it doesn't overflow.");
+
+    p::def("rounding_halving_add", &h::rounding_halving_add, p::args("a", "b"),
+           "Compute (a + b + 1) / 2, as if the sum were computed with enough "
+           "bits that it doesn't overflow.");
+
+    p::def("mul_hi", &h::mul_hi, p::args("a", "b"),
+           "Compute the high half of the double-width product of two integers "
+           "of 32 bits or narrower.");
+
+    p::def("rounding_shift_right", &h::rounding_shift_right, p::args("a", "b"),
+           "Shift a right by b bits, rounding to nearest with ties rounding up.");
+
+    p::def("saturating_cast", &saturating_cast0, p::args("t", "e"),
+           "Cast an expression to a new type, clamping it to the range of the "
+           "new type first.");
+
     p::def("random_float", &random_float1, p::args("seed"),
            "Return a random variable representing a uniformly distributed "
            "float in the half-open interval [0.0f, 1.0f). For random numbers of "
@@ -4,17 +4,6 @@
 #include <boost/python.hpp>
 #include <boost/format.hpp>
 
-#define USE_NUMPY
-
-#ifdef USE_NUMPY
-#ifdef USE_BOOST_NUMPY
-#include <boost/numpy.hpp>
-#else
-// we use Halide::numpy
-#include "../numpy/numpy.hpp"
-#endif
-#endif // USE_NUMPY
-
 #include <boost/cstdint.hpp>
 #include <boost/mpl/list.hpp>
 #include <boost/functional/hash/hash.hpp>
@@ -31,14 +20,6 @@
 namespace h = Halide;
 namespace p = boost::python;
 
-#ifdef USE_NUMPY
-#ifdef USE_BOOST_NUMPY
-namespace bn = boost::numpy;
-#else
-namespace bn = Halide::numpy;
-#endif
-#endif // USE_NUMPY
-
 
 template<typename T>
 h::Expr image_to_expr_operator0(h::Image<T> &that)
@@ -615,6 +596,67 @@ buffer_t ndarray_to_buffer_t(bn::ndarray &array)
     return raw_buffer;
 }
 
+h::Type dtype_to_type(const bn::dtype &t)
+{
+    if(t == bn::dtype::get_builtin<bool>()) return h::Bool();
+
+    if(t == bn::dtype::get_builtin<boost::uint8_t>()) return h::UInt(8);
+    if(t == bn::dtype::get_builtin<boost::uint16_t>()) return h::UInt(16);
+    if(t == bn::dtype::get_builtin<boost::uint32_t>()) return h::UInt(32);
+    if(t == bn::dtype::get_builtin<boost::uint64_t>()) return h::UInt(64);
+
+    if(t == bn::dtype::get_builtin<boost::int8_t>()) return h::Int(8);
+    if(t == bn::dtype::get_builtin<boost::int16_t>()) return h::Int(16);
+    if(t == bn::dtype::get_builtin<boost::int32_t>()) return h::Int(32);
+    if(t == bn::dtype::get_builtin<boost::int64_t>()) return h::Int(64);
+
+    if(t == bn::dtype::get_builtin<float>()) return h::Float(32);
+    if(t == bn::dtype::get_builtin<double>()) return h::Float(64);
+
+    const std::string type_repr = p::extract<std::string>(p::str(t));
+    printf("dtype_to_type received %s\n", type_repr.c_str());
+    throw std::invalid_argument("dtype_to_type received a numpy dtype with no Halide::Type equivalent");
+}
+
+
+h::Buffer ndarray_to_buffer(bn::ndarray &array, const std::string &name, bool writable)
+{
+    const h::Type t = dtype_to_type(array.get_dtype());
+
+    // Halide reads the data in place, so it must already be in a layout
+    // the generated code understands.
+    if(p::extract<bool>(array.get_dtype().attr("isnative")) == false)
+    {
+        throw std::invalid_argument("ndarray_to_buffer received an array that is not in native byte order");
+    }
+    if((array.get_flags() & bn::ndarray::ALIGNED) == 0)
+    {
+        throw std::invalid_argument("ndarray_to_buffer received an array that is not aligned");
+    }
+    if(writable && (array.get_flags() & bn::ndarray::WRITEABLE) == 0)
+    {
+        throw std::invalid_argument("ndarray_to_buffer received an array that is not writeable");
+    }
+
+    buffer_t raw_buffer = ndarray_to_buffer_t(array);
+    if(writable)
+    {
+        // Broadcast arrays (e.g. from numpy.broadcast_to) alias the same
+        // memory for several elements, so they can only be read.
+        for(int c = 0; c < array.get_nd(); c += 1)
+        {
+            if(raw_buffer.stride[c] == 0 && raw_buffer.extent[c] > 1)
+            {
+                throw std::invalid_argument("ndarray_to_buffer received an array with a zero stride as an output");
+            }
+        }
+    }
+
+    // Buffer makes its own copy of the buffer_t, but not of the data
+    return h::Buffer(t, &raw_buffer, name);
+}
+
+
 /// Will create a Halide::Image object pointing to the array data
 p::object ndarray_to_image(bn::ndarray &array, const std::string name="")
 {
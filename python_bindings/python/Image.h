@@ -1,8 +1,31 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#define USE_NUMPY
+
+#ifdef USE_NUMPY
+#ifdef USE_BOOST_NUMPY
+#include <boost/numpy.hpp>
+namespace bn = boost::numpy;
+#else
+// we use Halide::numpy
+#include "../numpy/numpy.hpp"
+namespace bn = Halide::numpy;
+#endif
+#endif // USE_NUMPY
+
+#include <string>
+
+#include "../../src/Buffer.h"
 
 void defineImage();
 
+#ifdef USE_NUMPY
+/// Wraps a numpy array in a Halide::Buffer that refers to the array data (no copy).
+/// Any strides are allowed, as long as they are a multiple of the element size.
+/// The caller is responsible for keeping the array alive while the buffer is in use.
+/// If writable is true, the array must be writeable (e.g. to be used as a realize output).
+Halide::Buffer ndarray_to_buffer(bn::ndarray &array, const std::string &name = "", bool writable = false);
+#endif // USE_NUMPY
 
 #endif // IMAGE_H
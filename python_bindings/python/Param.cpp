@@ -9,6 +9,7 @@
 #include "../../src/Param.h"
 #include "../../src/IROperator.h" // enables Param + Expr operations (which include is it ?)
 #include "Type.h"
+#include "Image.h"
 
 #include <boost/format.hpp>
 #include <vector>
@@ -17,6 +18,14 @@
 namespace h = Halide;
 namespace p = boost::python;
 
+#ifdef USE_NUMPY
+void imageparam_set_ndarray(h::ImageParam &that, bn::ndarray array)
+{
+    that.set(ndarray_to_buffer(array, that.name() + "_ndarray"));
+    return;
+}
+#endif // USE_NUMPY
+
 h::Expr imageparam_to_expr_operator0(h::ImageParam &that, p::tuple args_passed)
 {
     std::vector<h::Expr> expr_args;
@@ -107,6 +116,14 @@ void defineImageParam()
 
             .def("set", &ImageParam::set, p::args("self", "b"),
                  "Get the buffer bound to this ImageParam. Only relevant for jitting.")
+#ifdef USE_NUMPY
+            .def("set", &imageparam_set_ndarray, p::args("self", "array"),
+                 p::with_custodian_and_ward<1, 2>(), // the array reference count is increased
+                 "Bind a numpy array to this ImageParam without copying it. "
+                 "Dimension 0 of the ImageParam is the first axis of the array, and any "
+                 "strides are allowed. The array must be aligned and in native byte order, "
+                 "and must not be modified while a pipeline using it runs.")
+#endif
             .def("get", &ImageParam::get, p::arg("self"),
                  "Get the buffer bound to this ImageParam. Only relevant for jitting.")
             .def("__getitem__", &imageparam_to_expr_operator0, p::args("self", "tuple"),
@@ -94,9 +94,11 @@ void defineTarget()
             .value("FMA", Target::Feature::FMA)
             .value("FMA4", Target::Feature::FMA4)
             .value("F16C", Target::Feature::F16C)
+            .value("AVX512_VNNI", Target::Feature::AVX512_VNNI)
 
             .value("ARMv7s", Target::Feature::ARMv7s)
             .value("NoNEON", Target::Feature::NoNEON)
+            .value("ARMDotProd", Target::Feature::ARMDotProd)
 
             .value("CUDA", Target::Feature::CUDA)
             .value("CUDACapability30", Target::Feature::CUDACapability30)
@@ -113,6 +115,9 @@ void defineTarget()
             .value("RegisterMetadata", Target::Feature::RegisterMetadata)
             .value("Matlab", Target::Feature::Matlab)
             .value("Metal", Target::Feature::Metal)
+            .value("FastCompile", Target::Feature::FastCompile)
+            .value("SoftFloat16", Target::Feature::SoftFloat16)
+            .value("HoistLoopInvariants", Target::Feature::HoistLoopInvariants)
             .value("FeatureEnd", Target::Feature::FeatureEnd)
 
             .export_values()
@@ -35,6 +35,10 @@ std::string type_code_to_string(const h::Type &t)
         code_string = "Handle";
         break;
 
+    case h::Type::BFloat:
+        code_string = "BFloat";
+        break;
+
     default:
         code_string = "unknown";
     }
@@ -77,7 +81,9 @@ void defineType()
             .def("is_scalar", &Type::is_scalar, p::arg("self"),
                  "Is this type a scalar type? (width == 1)")
             .def("is_float", &Type::is_float, p::arg("self"),
-                 "Is this type a floating point type (float or double).")
+                 "Is this type a floating point type (float, double, or bfloat).")
+            .def("is_bfloat", &Type::is_bfloat, p::arg("self"),
+                 "Is this type a floating point type in the bfloat format?")
             .def("is_int", &Type::is_int, p::arg("self"),
                  "Is this type a signed integer type?")
             .def("is_uint", &Type::is_uint, p::arg("self"),
@@ -114,6 +120,10 @@ void defineType()
            (p::arg("bits"), p::arg("width")=1),
            "Constructing a floating-point type");
 
+    p::def("BFloat", h::BFloat,
+           (p::arg("bits"), p::arg("width")=1),
+           "Construct a floating-point type in the bfloat format");
+
     p::def("Bool", h::Bool,
            (p::arg("width")=1),
            "Construct a boolean type");
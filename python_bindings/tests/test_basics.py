@@ -270,6 +270,44 @@ def test_image_to_ndarray():
 
     return
 
+def test_ndarray_zero_copy():
+
+    if "ndarray_to_image" not in globals():
+        print("Skipping test_ndarray_zero_copy")
+        return
+
+    import numpy
+    import threading
+
+    def make_pipeline(a):
+        x, y = Var("x"), Var("y")
+        input = ImageParam(Float(32), 2, "input")
+        f = Func("f")
+        f[x, y] = input[x, y] * 2.0 + 1.0
+        input.set(a)
+        return f
+
+    # A transposed view with non-unit strides as input, and a strided
+    # slice as output. Neither should be copied.
+    a = numpy.arange(64 * 48, dtype=numpy.float32).reshape((48, 64)).T
+    out = numpy.zeros((128, 48), dtype=numpy.float32)[::2, :]
+    make_pipeline(a).realize(out)
+    assert numpy.array_equal(out, a * 2.0 + 1.0)
+
+    # The GIL is released while the pipelines run, so several Python
+    # threads can realize (distinct) pipelines at the same time.
+    funcs = [make_pipeline(a) for i in range(4)]
+    outs = [numpy.zeros((64, 48), dtype=numpy.float32) for i in range(4)]
+    threads = [threading.Thread(target=f.realize, args=(o,)) for f, o in zip(funcs, outs)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for o in outs:
+        assert numpy.array_equal(o, a * 2.0 + 1.0)
+
+    return
+
 def test_param_bug():
     "see https://github.com/rodrigob/Halide/issues/1"
 
@@ -297,6 +335,7 @@ if __name__ == "__main__":
     test_float_or_int()
     test_ndarray_to_image()
     test_image_to_ndarray()
+    test_ndarray_zero_copy()
     test_types()
     test_operator_order()
     test_basics()
@@ -153,11 +153,16 @@ Stmt add_image_checks(Stmt s,
         bool is_output_buffer = false;
         bool is_secondary_output_buffer = false;
         string buffer_name = name;
+        vector<StorageBlock> blocks;
+        if (param.defined()) {
+            blocks = param.storage_blocks();
+        }
         for (Function f : outputs) {
             for (size_t i = 0; i < f.output_buffers().size(); i++) {
                 if (param.defined() &&
                     param.same_as(f.output_buffers()[i])) {
                     is_output_buffer = true;
+                    blocks = f.storage_blocks();
                     // If we're one of multiple output buffers, we should use the
                     // region inferred for the func in general.
                     buffer_name = f.name();
@@ -171,6 +176,16 @@ Stmt add_image_checks(Stmt s,
         Box touched = boxes[buffer_name];
         internal_assert(touched.empty() || (int)(touched.size()) == dimensions);
 
+        // A blocked buffer stores whole blocks innermost, so the
+        // stride of every dimension is the stride between blocks.
+        vector<int> block_factor(dimensions, 1);
+        int block_size = 1;
+        for (const StorageBlock &b : blocks) {
+            internal_assert(b.dim < dimensions);
+            block_factor[b.dim] = b.factor;
+            block_size *= b.factor;
+        }
+
         // The buffer may be used in one or more extern stage. If so we need to
         // expand the box touched to include the results of the
         // top-level bounds query calls to those extern stages.
@@ -285,6 +300,16 @@ Stmt add_image_checks(Stmt s,
 
             asserts_required.push_back(AssertStmt::make(oob_condition, oob_error));
 
+            // Strides smaller than a block make the blocks overlap,
+            // e.g. if a dense buffer is passed in.
+            if (!blocks.empty()) {
+                Expr blocked_condition = actual_extent <= 1 || actual_stride >= block_size;
+                Expr blocked_error = Call::make(Int(32), "halide_error_bad_blocked_stride",
+                                                {error_name, j, actual_stride, block_size},
+                                                Call::Extern);
+                asserts_required.push_back(AssertStmt::make(blocked_condition, blocked_error));
+            }
+
             // Come up with a required stride to use in bounds
             // inference mode. We don't assert it. It's just used to
             // apply the constraints to to come up with a proposed
@@ -293,11 +318,16 @@ Stmt add_image_checks(Stmt s,
             // order).
             Expr stride_required;
             if (j == 0) {
-                stride_required = 1;
+                stride_required = block_size;
             } else {
                 string last_dim = std::to_string(j-1);
+                Expr last_extent = Variable::make(Int(32), name + ".extent." + last_dim + ".required");
+                if (block_factor[j-1] > 1) {
+                    // The number of blocks.
+                    last_extent = (last_extent + (block_factor[j-1] - 1)) / block_factor[j-1];
+                }
                 stride_required = (Variable::make(Int(32), name + ".stride." + last_dim + ".required") *
-                                   Variable::make(Int(32), name + ".extent." + last_dim + ".required"));
+                                   last_extent);
             }
             lets_required.push_back(make_pair(name + ".stride." + dim + ".required", stride_required));
 
@@ -13,6 +13,15 @@
 
 namespace Halide {
 
+/** One dimension of a buffer with a blocked storage layout. The
+ * dimension is stored as blocks of the given number of contiguous
+ * elements. The blocks of a buffer are nested innermost first, in
+ * the order they are listed, and all of them are stored inside
+ * the ordinary dimensions. */
+struct StorageBlock {
+    int dim, factor;
+};
+
 /**
  * A struct representing an argument to a halide-generated
  * function. Used for specifying the function signature of
@@ -56,6 +65,12 @@ struct Argument {
      * By default, they are left unset, implying "no default, no min, no max". */
     Expr def, min, max;
 
+    /** If this is a buffer argument with a blocked storage layout,
+     * these are the blocked dimensions, innermost first. For these
+     * dimensions the stride in the buffer_t is the stride between
+     * blocks. Empty for ordinary strided layouts. */
+    std::vector<StorageBlock> storage_blocks;
+
     Argument() : kind(InputScalar), dimensions(0) {}
     Argument(const std::string &_name, Kind _kind, const Type &_type, uint8_t _dimensions,
                 Expr _def = Expr(),
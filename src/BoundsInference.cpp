@@ -265,8 +265,21 @@ public:
             }
 
             if (in_pipeline.count(name) == 0) {
-                // Inject any explicit bounds
                 string prefix = name + ".s" + std::to_string(stage) + ".";
+
+                // Round the region out to whole tiles of a function
+                // that is memoized in tiles, so that each tile can be
+                // cached on its own.
+                for (const MemoizeTile &t : func.schedule().memoize_tiles()) {
+                    string min_var = prefix + t.var + ".min";
+                    string max_var = prefix + t.var + ".max";
+                    Expr min = Variable::make(Int(32), min_var);
+                    Expr max = Variable::make(Int(32), max_var);
+                    s = LetStmt::make(min_var, (min / t.extent) * t.extent, s);
+                    s = LetStmt::make(max_var, (max / t.extent) * t.extent + (t.extent - 1), s);
+                }
+
+                // Inject any explicit bounds
                 for (size_t i = 0; i < func.schedule().bounds().size(); i++) {
                     const Bound &bound = func.schedule().bounds()[i];
                     string min_var = prefix + bound.var + ".min";
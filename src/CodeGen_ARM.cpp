@@ -2,6 +2,8 @@
 #include <sstream>
 
 #include "CodeGen_ARM.h"
+#include "CodeGen_Internal.h"
+#include "FixedPoint.h"
 #include "IROperator.h"
 #include "IRMatch.h"
 #include "IREquality.h"
@@ -316,6 +318,18 @@ void CodeGen_ARM::visit(const Cast *op) {
 
     Type t = op->type;
 
+    if (target.bits == 64 && t.is_vector()) {
+        // Conversions between float16 and float32.
+        Type src = op->value.type();
+        if (t == Float(32, t.lanes()) && src == Float(16, src.lanes())) {
+            value = call_intrin(t, 4, "llvm.aarch64.neon.vcvthf2fp", {op->value});
+            return;
+        } else if (t == Float(16, t.lanes()) && src == Float(32, src.lanes())) {
+            value = call_intrin(t, 4, "llvm.aarch64.neon.vcvtfp2hf", {op->value});
+            return;
+        }
+    }
+
     vector<Expr> matches;
 
     for (size_t i = 0; i < casts.size() ; i++) {
@@ -630,6 +644,18 @@ void CodeGen_ARM::visit(const Div *op) {
 }
 
 void CodeGen_ARM::visit(const Add *op) {
+    // Try to fold the addition into an accumulating dot product.
+    const Call *reduce_a = op->a.as<Call>();
+    const Call *reduce_b = op->b.as<Call>();
+    if (op->type.is_vector() && reduce_b &&
+        (value = codegen_dot_product(reduce_b, op->a))) {
+        return;
+    }
+    if (op->type.is_vector() && reduce_a &&
+        (value = codegen_dot_product(reduce_a, op->b))) {
+        return;
+    }
+
     CodeGen_Posix::visit(op);
 }
 
@@ -1177,6 +1203,16 @@ void CodeGen_ARM::visit(const Load *op) {
 }
 
 void CodeGen_ARM::visit(const Call *op) {
+    if (op->call_type == Call::Intrinsic && op->name == Call::vector_reduce_add) {
+        value = codegen_dot_product(op, Expr());
+        if (value) return;
+    }
+
+    if (is_vector_reduce(op) && op->type.is_scalar() && !neon_intrinsics_disabled()) {
+        value = codegen_vector_reduce(op);
+        if (value) return;
+    }
+
     if (op->call_type == Call::Intrinsic) {
         if (op->name == Call::abs && op->type.is_uint()) {
             internal_assert(op->args.size() == 1);
@@ -1207,9 +1243,181 @@ void CodeGen_ARM::visit(const Call *op) {
         }
     }
 
+    if (is_fixed_point_intrinsic(op) && op->name != Call::mul_hi &&
+        op->type.is_vector() && op->type.bits() <= 32 && !neon_intrinsics_disabled()) {
+        // Neon has all of these except mul_hi, for 8, 16, and 32-bit
+        // integers. Use the 64-bit versions for vectors that fit.
+        Type t = op->type;
+        int bits = t.bits();
+        int lanes = (bits * t.lanes() <= 64 ? 64 : 128) / bits;
+        std::ostringstream oss;
+        oss << ".v" << lanes << "i" << bits;
+        string t_str = oss.str();
+        string s = t.is_int() ? "s" : "u";
+
+        vector<Expr> args = op->args;
+        string intrin32, intrin64;
+        if (op->name == Call::saturating_add) {
+            intrin32 = "vqadd" + s;
+            intrin64 = s + "qadd";
+        } else if (op->name == Call::saturating_sub) {
+            intrin32 = "vqsub" + s;
+            intrin64 = s + "qsub";
+        } else if (op->name == Call::halving_add) {
+            intrin32 = "vhadd" + s;
+            intrin64 = s + "hadd";
+        } else if (op->name == Call::rounding_halving_add) {
+            intrin32 = "vrhadd" + s;
+            intrin64 = s + "rhadd";
+        } else {
+            internal_assert(op->name == Call::rounding_shift_right);
+            // Rounding shifts take a signed shift amount, where
+            // negative means shift right.
+            intrin32 = "vrshift" + s;
+            intrin64 = s + "rshl";
+            Type signed_t = t.with_code(Type::Int);
+            args[1] = make_zero(signed_t) - cast(signed_t, args[1]);
+        }
+
+        Pattern p(intrin32 + t_str, intrin64 + t_str, lanes, Expr());
+        value = call_pattern(p, t, args);
+        return;
+    }
+
     CodeGen_Posix::visit(op);
 }
 
+Value *CodeGen_ARM::codegen_dot_product(const Call *op, Expr accumulator) {
+    #if LLVM_VERSION >= 60
+    if (op->call_type != Call::Intrinsic ||
+        op->name != Call::vector_reduce_add ||
+        !target.has_feature(Target::ARMDotProd) ||
+        neon_intrinsics_disabled()) {
+        return NULL;
+    }
+
+    // sdot and udot sum groups of four adjacent products of 8-bit
+    // values into each 32-bit lane of the accumulator.
+    Type t = op->type;
+    Type arg_t = op->args[0].type();
+    if (!(t.is_int() || t.is_uint()) || t.bits() != 32 ||
+        arg_t.lanes() % (t.lanes() * 4) != 0) {
+        return NULL;
+    }
+    int factor = arg_t.lanes() / t.lanes();
+
+    Type partial_t = t.with_lanes(arg_t.lanes() / 4);
+    if (partial_t.is_scalar()) {
+        return NULL;
+    }
+    Expr partial = op;
+    if (factor != 4) {
+        partial = Call::make(partial_t, Call::vector_reduce_add, op->args, Call::Intrinsic);
+    }
+
+    Expr a, b;
+    string intrin;
+    if (is_dot_product(partial.as<Call>(), 4, Int(8), Int(8), a, b)) {
+        intrin = "sdot";
+    } else if (is_dot_product(partial.as<Call>(), 4, UInt(8), UInt(8), a, b)) {
+        intrin = "udot";
+    } else {
+        return NULL;
+    }
+
+    if (factor != 4) {
+        // Use the instruction to get part of the way, and then finish
+        // the job with other horizontal ops.
+        Expr e = Call::make(t, Call::vector_reduce_add, {partial}, Call::Intrinsic);
+        if (accumulator.defined()) {
+            e = accumulator + e;
+        }
+        return codegen(e);
+    }
+
+    int lanes = (t.lanes() % 4 == 0) ? 4 : 2;
+    intrin = (target.bits == 32 ? "llvm.arm.neon." : "llvm.aarch64.neon.") + intrin;
+    intrin += lanes == 4 ? ".v4i32.v16i8" : ".v2i32.v8i8";
+
+    Value *acc = (accumulator.defined() ?
+                  codegen(accumulator) :
+                  Constant::getNullValue(llvm_type_of(t)));
+    return call_intrin(llvm_type_of(t), lanes, intrin, {acc, codegen(a), codegen(b)});
+    #else
+    return NULL;
+    #endif
+}
+
+Value *CodeGen_ARM::codegen_vector_reduce(const Call *op) {
+    Type t = op->args[0].type();
+    if (op->name == Call::vector_reduce_mul ||
+        (t.is_float() && t.bits() != 32) ||
+        t.bits() > 32) {
+        return NULL;
+    }
+
+    // First reduce elementwise down to a single native vector (128
+    // bits on aarch64, 64 bits on arm), then finish with horizontal
+    // instructions.
+    int native_lanes = (target.bits == 32 ? 64 : 128) / t.bits();
+    if (t.lanes() % native_lanes != 0) {
+        return NULL;
+    }
+    Value *partial = codegen(lower_vector_reduce(op, native_lanes));
+    Type pt = t.with_lanes(native_lanes);
+
+    std::ostringstream suffix;
+    suffix << ".v" << native_lanes << (t.is_float() ? "f" : "i") << t.bits();
+
+    if (target.bits == 32) {
+        // Pairwise instructions combine adjacent lanes of two
+        // vectors. Using the same vector for both halves the number
+        // of distinct lanes each time.
+        string intrin;
+        if (op->name == Call::vector_reduce_add) {
+            intrin = "llvm.arm.neon.vpadd";
+        } else if (op->name == Call::vector_reduce_min) {
+            intrin = t.is_uint() ? "llvm.arm.neon.vpminu" : "llvm.arm.neon.vpmins";
+        } else {
+            intrin = t.is_uint() ? "llvm.arm.neon.vpmaxu" : "llvm.arm.neon.vpmaxs";
+        }
+        intrin += suffix.str();
+        for (int lanes = native_lanes; lanes > 1; lanes /= 2) {
+            partial = call_intrin(llvm_type_of(pt), native_lanes, intrin, {partial, partial});
+        }
+        return builder->CreateExtractElement(partial, ConstantInt::get(i32, 0));
+    } else {
+        // Across-vector instructions reduce a whole vector to a
+        // scalar. The integer versions produce an i32 for narrower
+        // types.
+        string intrin;
+        if (op->name == Call::vector_reduce_add) {
+            intrin = t.is_float() ? "faddv" : t.is_uint() ? "uaddv" : "saddv";
+        } else if (op->name == Call::vector_reduce_min) {
+            intrin = t.is_float() ? "fminv" : t.is_uint() ? "uminv" : "sminv";
+        } else {
+            intrin = t.is_float() ? "fmaxv" : t.is_uint() ? "umaxv" : "smaxv";
+        }
+        llvm::Type *result_t = t.is_float() ? f32 : i32;
+        intrin = "llvm.aarch64.neon." + intrin + (t.is_float() ? ".f32" : ".i32") + suffix.str();
+
+        llvm::Function *fn = module->getFunction(intrin);
+        if (!fn) {
+            FunctionType *fn_t = FunctionType::get(result_t, {partial->getType()}, false);
+            fn = llvm::Function::Create(fn_t, llvm::Function::ExternalLinkage, intrin, module.get());
+        }
+        CallInst *call = builder->CreateCall(fn, {partial});
+        call->setDoesNotAccessMemory();
+        call->setDoesNotThrow();
+
+        Value *result = call;
+        if (!t.is_float() && t.bits() < 32) {
+            result = builder->CreateTrunc(result, llvm_type_of(op->type));
+        }
+        return result;
+    }
+}
+
 string CodeGen_ARM::mcpu() const {
     if (target.bits == 32) {
         if (target.has_feature(Target::ARMv7s)) {
@@ -1231,16 +1439,28 @@ string CodeGen_ARM::mattrs() const {
         if (target.has_feature(Target::ARMv7s)) {
             return "+neon";
         } if (!target.has_feature(Target::NoNEON)) {
+            #if LLVM_VERSION >= 60
+            if (target.has_feature(Target::ARMDotProd)) {
+                return "+neon,+dotprod";
+            }
+            #endif
             return "+neon";
         } else {
             return "-neon";
         }
     } else {
+        string arch_flags;
+        string separator;
         if (target.os == Target::IOS || target.os == Target::OSX) {
-            return "+reserve-x18";
-        } else {
-            return "";
+            arch_flags = "+reserve-x18";
+            separator = ",";
+        }
+        #if LLVM_VERSION >= 60
+        if (target.has_feature(Target::ARMDotProd)) {
+            arch_flags += separator + "+dotprod";
         }
+        #endif
+        return arch_flags;
     }
 }
 
@@ -62,6 +62,16 @@ protected:
     llvm::Value *call_pattern(const Pattern &p, llvm::Type *t, const std::vector<llvm::Value *> &args);
     // @}
 
+    /** Generate sdot or udot for a vector_reduce_add of a product of
+     * 8-bit integers, adding the accumulator if it's defined. Returns
+     * NULL if the target doesn't support them or the pattern doesn't
+     * match. */
+    llvm::Value *codegen_dot_product(const Call *op, Expr accumulator);
+
+    /** Reduce a vector to a scalar using neon horizontal
+     * instructions. Returns NULL if there's no good way to do it. */
+    llvm::Value *codegen_vector_reduce(const Call *op);
+
     std::string mcpu() const;
     std::string mattrs() const;
     bool use_soft_float_abi() const;
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <iostream>
 #include <limits>
 
@@ -7,6 +8,7 @@
 #include "IROperator.h"
 #include "Param.h"
 #include "Var.h"
+#include "FixedPoint.h"
 #include "Lerp.h"
 #include "Simplify.h"
 
@@ -65,6 +67,7 @@ const string globals =
     "int halide_start_clock(void *ctx);\n"
     "int64_t halide_current_time_ns(void *ctx);\n"
     "void halide_profiler_pipeline_end(void *, void *);\n"
+    "int halide_do_par_for(void *ctx, int (*f)(void *, int, uint8_t *), int min, int size, uint8_t *closure);\n"
     "}\n"
     "\n"
 
@@ -152,6 +155,23 @@ const string globals =
     // for a detailed comparison of type-punning methods.
     "template<typename A, typename B> A reinterpret(B b) {A a; memcpy(&a, &b, sizeof(a)); return a;}\n"
     "\n"
+
+    // Vector types are GCC/Clang vector extensions, declared as they
+    // are needed. Dense loads and stores go through memcpy for the
+    // same reason as reinterpret, and because the addresses may not
+    // be aligned to the vector size. Gathers and scatters are done a
+    // lane at a time.
+    "template<typename V, typename T> V halide_vector_load(const T *p) {V v; memcpy(&v, p, sizeof(v)); return v;}\n"
+    "template<typename V, typename T> void halide_vector_store(T *p, V v) {memcpy(p, &v, sizeof(v));}\n"
+    "template<typename V, typename T, typename I> V halide_vector_gather(const T *p, I idx) {\n"
+    " V v;\n"
+    " for (size_t i = 0; i < sizeof(V) / sizeof(T); i++) v[i] = p[idx[i]];\n"
+    " return v;\n"
+    "}\n"
+    "template<typename V, typename T, typename I> void halide_vector_scatter(T *p, I idx, V v) {\n"
+    " for (size_t i = 0; i < sizeof(V) / sizeof(T); i++) p[idx[i]] = v[i];\n"
+    "}\n"
+    "\n"
     "static bool halide_rewrite_buffer(buffer_t *b, int32_t elem_size,\n"
     "                           int32_t min0, int32_t extent0, int32_t stride0,\n"
     "                           int32_t min1, int32_t extent1, int32_t stride1,\n"
@@ -220,7 +240,20 @@ CodeGen_C::~CodeGen_C() {
 namespace {
 string type_to_c_type(Type type) {
     ostringstream oss;
-    user_assert(type.lanes() == 1) << "Can't use vector types when compiling to C (yet)\n";
+    if (type.is_vector()) {
+        // Vector types are typedefs emitted by VectorTypedefs below,
+        // e.g. halide_float32x8_t.
+        oss << "halide_";
+        if (type.is_bool()) {
+            oss << "bool";
+        } else if (type.is_float()) {
+            oss << "float" << type.bits();
+        } else {
+            oss << (type.is_uint() ? "uint" : "int") << type.bits();
+        }
+        oss << "x" << type.lanes() << "_t";
+        return oss.str();
+    }
     if (type.is_float()) {
         if (type.bits() == 32) {
             oss << "float";
@@ -291,7 +324,9 @@ class ExternCallPrototypes : public IRGraphVisitor {
 
         if (op->call_type == Call::Extern) {
             if (!emitted.count(op->name)) {
-                stream << type_to_c_type(op->type) << " " << op->name << "(";
+                // Vector calls are emitted a lane at a time, so
+                // declare the scalar version.
+                stream << type_to_c_type(op->type.element_of()) << " " << op->name << "(";
                 if (function_takes_user_context(op->name)) {
                     stream << "void *";
                     if (op->args.size()) {
@@ -305,7 +340,7 @@ class ExternCallPrototypes : public IRGraphVisitor {
                     if (op->args[i].as<StringImm>()) {
                         stream << "const char *";
                     } else {
-                        stream << type_to_c_type(op->args[i].type());
+                        stream << type_to_c_type(op->args[i].type().element_of());
                     }
                 }
                 stream << ");\n";
@@ -339,6 +374,48 @@ public:
 };
 }
 
+namespace {
+// Emit a typedef for each vector type used, along with the bool and
+// integer vector types of the same shape used for select masks
+// (including the ones min and max are printed with), gather indices,
+// and bool loads and stores.
+class VectorTypedefs : public IRGraphVisitor {
+    ostream &stream;
+    std::set<string> &emitted;
+    using IRGraphVisitor::include;
+
+    void emit_typedef(Type t) {
+        string name = type_to_c_type(t);
+        if (emitted.count(name)) return;
+        emitted.insert(name);
+
+        user_assert(!t.is_handle())
+            << "Can't use vectors of handles when compiling to C\n";
+        user_assert((t.lanes() & (t.lanes() - 1)) == 0)
+            << "Can only use vectors with a power-of-two number of lanes when compiling to C, not "
+            << t << "\n";
+        // Bool vectors are masks of all ones or all zeros, one byte per lane.
+        Type elem = t.is_bool() ? Int(8) : t.element_of();
+        stream << "typedef " << type_to_c_type(elem) << " " << name
+               << " __attribute__((vector_size(" << elem.bytes() * t.lanes() << ")));\n";
+    }
+
+    void include(const Expr &e) {
+        Type t = e.type();
+        if (t.is_vector()) {
+            emit_typedef(t);
+            emit_typedef(Bool(t.lanes()));
+            emit_typedef(Int(t.is_bool() ? 8 : t.bits(), t.lanes()));
+            emit_typedef(Int(32, t.lanes()));
+        }
+        IRGraphVisitor::include(e);
+    }
+
+public:
+    VectorTypedefs(ostream &s, std::set<string> &emitted) : stream(s), emitted(emitted) {}
+};
+}
+
 void CodeGen_C::compile(const Module &input) {
     for (size_t i = 0; i < input.buffers.size(); i++) {
         compile(input.buffers[i]);
@@ -371,6 +448,8 @@ void CodeGen_C::compile(const LoweredFunc &f) {
         stream << "\n";
         ExternCallPrototypes e(stream, emitted);
         f.body.accept(&e);
+        VectorTypedefs v(stream, emitted);
+        f.body.accept(&v);
         stream << "\n";
     }
 
@@ -598,13 +677,32 @@ void CodeGen_C::visit(const Variable *op) {
 }
 
 void CodeGen_C::visit(const Cast *op) {
-    print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    if (op->type.is_vector()) {
+        if (op->type.is_bool()) {
+            print_expr(op->value != make_zero(op->value.type()));
+        } else {
+            string value = print_expr(op->value);
+            if (op->value.type().is_bool()) {
+                // Turn the mask into zeros and ones.
+                value = print_assignment(op->value.type(), "-" + value);
+            }
+            print_assignment(op->type, "__builtin_convertvector(" + value + ", " + print_type(op->type) + ")");
+        }
+    } else {
+        print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    }
 }
 
 void CodeGen_C::visit_binop(Type t, Expr a, Expr b, const char * op) {
     string sa = print_expr(a);
     string sb = print_expr(b);
-    print_assignment(t, sa + " " + op + " " + sb);
+    if (t.is_vector() && t.is_bool() && !a.type().is_bool()) {
+        // Vector comparisons give a mask with lanes the width of the
+        // operands.
+        print_assignment(t, "__builtin_convertvector(" + sa + " " + op + " " + sb + ", " + print_type(t) + ")");
+    } else {
+        print_assignment(t, sa + " " + op + " " + sb);
+    }
 }
 
 void CodeGen_C::visit(const Add *op) {
@@ -646,9 +744,9 @@ void CodeGen_C::visit(const Div *op) {
 void CodeGen_C::visit(const Mod *op) {
     int bits;
     if (is_const_power_of_two_integer(op->b, &bits)) {
-        ostringstream oss;
-        oss << print_expr(op->a) << " & " << ((1 << bits)-1);
-        print_assignment(op->type, oss.str());
+        string a = print_expr(op->a);
+        string mask = print_expr(make_const(op->type, (1 << bits)-1));
+        print_assignment(op->type, a + " & " + mask);
     } else if (op->type.is_int()) {
         string a = print_expr(op->a);
         string b = print_expr(op->b);
@@ -666,11 +764,19 @@ void CodeGen_C::visit(const Mod *op) {
 }
 
 void CodeGen_C::visit(const Max *op) {
-    print_expr(Call::make(op->type, "max", {op->a, op->b}, Call::Extern));
+    if (op->type.is_vector()) {
+        print_expr(Select::make(op->a > op->b, op->a, op->b));
+    } else {
+        print_expr(Call::make(op->type, "max", {op->a, op->b}, Call::Extern));
+    }
 }
 
 void CodeGen_C::visit(const Min *op) {
-    print_expr(Call::make(op->type, "min", {op->a, op->b}, Call::Extern));
+    if (op->type.is_vector()) {
+        print_expr(Select::make(op->a < op->b, op->a, op->b));
+    } else {
+        print_expr(Call::make(op->type, "min", {op->a, op->b}, Call::Extern));
+    }
 }
 
 void CodeGen_C::visit(const EQ *op) {
@@ -698,15 +804,19 @@ void CodeGen_C::visit(const GE *op) {
 }
 
 void CodeGen_C::visit(const Or *op) {
-    visit_binop(op->type, op->a, op->b, "||");
+    visit_binop(op->type, op->a, op->b, op->type.is_vector() ? "|" : "||");
 }
 
 void CodeGen_C::visit(const And *op) {
-    visit_binop(op->type, op->a, op->b, "&&");
+    visit_binop(op->type, op->a, op->b, op->type.is_vector() ? "&" : "&&");
 }
 
 void CodeGen_C::visit(const Not *op) {
-    print_assignment(op->type, "!(" + print_expr(op->a) + ")");
+    if (op->type.is_vector()) {
+        print_assignment(op->type, "~" + print_expr(op->a));
+    } else {
+        print_assignment(op->type, "!(" + print_expr(op->a) + ")");
+    }
 }
 
 void CodeGen_C::visit(const IntImm *op) {
@@ -721,6 +831,35 @@ void CodeGen_C::visit(const UIntImm *op) {
     print_assignment(op->type, "(" + print_type(op->type) + ")(" + std::to_string(op->value) + ")");
 }
 
+void CodeGen_C::visit(const Ramp *op) {
+    string base = print_expr(op->base);
+    string stride = print_expr(op->stride);
+    string elem = print_type(op->type.element_of());
+    ostringstream rhs;
+    rhs << "{";
+    for (int i = 0; i < op->lanes; i++) {
+        if (i > 0) rhs << ", ";
+        rhs << "(" << elem << ")(" << base << " + " << stride << " * " << i << ")";
+    }
+    rhs << "}";
+    print_assignment(op->type, rhs.str());
+}
+
+void CodeGen_C::visit(const Broadcast *op) {
+    string value = print_expr(op->value);
+    if (op->type.is_bool()) {
+        value = "(int8_t)-" + value;
+    }
+    ostringstream rhs;
+    rhs << "{";
+    for (int i = 0; i < op->lanes; i++) {
+        if (i > 0) rhs << ", ";
+        rhs << value;
+    }
+    rhs << "}";
+    print_assignment(op->type, rhs.str());
+}
+
 void CodeGen_C::visit(const StringImm *op) {
     ostringstream oss;
     oss << Expr(op);
@@ -857,6 +996,42 @@ void CodeGen_C::visit(const Call *op) {
             Expr b = op->args[1];
             Expr e = select(a < b, b - a, a - b);
             rhs << print_expr(e);
+        } else if (is_fixed_point_intrinsic(op)) {
+            rhs << print_expr(lower_fixed_point_intrinsic(op));
+        } else if (op->name == Call::shuffle_vector) {
+            internal_assert((int) op->args.size() == 1 + op->type.lanes());
+            string vec = print_expr(op->args[0]);
+            if (op->type.is_scalar()) {
+                rhs << vec << "[" << print_expr(op->args[1]) << "]";
+            } else {
+                rhs << "{";
+                for (int i = 0; i < op->type.lanes(); i++) {
+                    const IntImm *idx = op->args[i+1].as<IntImm>();
+                    internal_assert(idx);
+                    // An index one past the end means the lane is undefined.
+                    int lane = idx->value < op->args[0].type().lanes() ? (int)idx->value : 0;
+                    if (i > 0) rhs << ", ";
+                    rhs << vec << "[" << lane << "]";
+                }
+                rhs << "}";
+            }
+        } else if (op->name == Call::interleave_vectors) {
+            internal_assert(!op->args.empty());
+            vector<string> vecs(op->args.size());
+            for (size_t i = 0; i < op->args.size(); i++) {
+                vecs[i] = print_expr(op->args[i]);
+            }
+            int lanes = op->args[0].type().lanes();
+            rhs << "{";
+            for (int i = 0; i < lanes; i++) {
+                for (size_t j = 0; j < vecs.size(); j++) {
+                    if (i > 0 || j > 0) rhs << ", ";
+                    rhs << vecs[j] << "[" << i << "]";
+                }
+            }
+            rhs << "}";
+        } else if (is_vector_reduce(op)) {
+            rhs << print_expr(lower_vector_reduce(op));
         } else if (op->name == Call::null_handle) {
             rhs << "NULL";
         } else if (op->name == Call::address_of) {
@@ -1064,6 +1239,30 @@ void CodeGen_C::visit(const Call *op) {
             internal_error << "Unhandled intrinsic in C backend: " << op->name << '\n';
         }
 
+    } else if (op->type.is_vector()) {
+        // There are no vector versions of extern functions, so call
+        // the scalar version on each lane.
+        vector<string> args(op->args.size());
+        for (size_t i = 0; i < op->args.size(); i++) {
+            args[i] = print_expr(op->args[i]);
+        }
+        rhs << "{";
+        for (int lane = 0; lane < op->type.lanes(); lane++) {
+            if (lane > 0) rhs << ", ";
+            rhs << op->name << "(";
+            if (function_takes_user_context(op->name)) {
+                rhs << (have_user_context ? "__user_context_, " : "NULL, ");
+            }
+            for (size_t i = 0; i < op->args.size(); i++) {
+                if (i > 0) rhs << ", ";
+                rhs << args[i];
+                if (op->args[i].type().is_vector()) {
+                    rhs << "[" << lane << "]";
+                }
+            }
+            rhs << ")";
+        }
+        rhs << "}";
     } else {
         // Generic calls
         vector<string> args(op->args.size());
@@ -1093,6 +1292,33 @@ void CodeGen_C::visit(const Load *op) {
         !allocations.contains(op->name) ||
         allocations.get(op->name).type != t;
 
+    if (t.is_vector()) {
+        // Bools are stored as one byte per lane holding zero or one.
+        Type elem = t.is_bool() ? Int(8) : t.element_of();
+        Type load_type = elem.with_lanes(t.lanes());
+        type_cast_needed = t.is_bool() || !allocations.contains(op->name) ||
+            allocations.get(op->name).type != elem;
+        string ptr = print_name(op->name);
+        if (type_cast_needed) {
+            ptr = "((const " + print_type(elem) + " *)" + ptr + ")";
+        }
+
+        ostringstream rhs;
+        const Ramp *ramp = op->index.as<Ramp>();
+        if (ramp && is_one(ramp->stride)) {
+            string base = print_expr(ramp->base);
+            rhs << "halide_vector_load<" << print_type(load_type) << ">(" << ptr << " + " << base << ")";
+        } else {
+            string index = print_expr(op->index);
+            rhs << "halide_vector_gather<" << print_type(load_type) << ">(" << ptr << ", " << index << ")";
+        }
+        string value = print_assignment(load_type, rhs.str());
+        if (t.is_bool()) {
+            print_assignment(t, "-" + value);
+        }
+        return;
+    }
+
     ostringstream rhs;
     if (type_cast_needed) {
         rhs << "(("
@@ -1119,6 +1345,31 @@ void CodeGen_C::visit(const Store *op) {
         !allocations.contains(op->name) ||
         allocations.get(op->name).type != t;
 
+    if (t.is_vector()) {
+        Type elem = t.is_bool() ? Int(8) : t.element_of();
+        type_cast_needed = t.is_bool() || !allocations.contains(op->name) ||
+            allocations.get(op->name).type != elem;
+        string ptr = print_name(op->name);
+        if (type_cast_needed) {
+            ptr = "((" + print_type(elem) + " *)" + ptr + ")";
+        }
+
+        const Ramp *ramp = op->index.as<Ramp>();
+        string index = print_expr(ramp && is_one(ramp->stride) ? ramp->base : op->index);
+        string value = print_expr(op->value);
+        if (t.is_bool()) {
+            value = print_assignment(t, "-" + value);
+        }
+        do_indent();
+        if (ramp && is_one(ramp->stride)) {
+            stream << "halide_vector_store(" << ptr << " + " << index << ", " << value << ");\n";
+        } else {
+            stream << "halide_vector_scatter(" << ptr << ", " << index << ", " << value << ");\n";
+        }
+        cache.clear();
+        return;
+    }
+
     string id_index = print_expr(op->index);
     string id_value = print_expr(op->value);
     do_indent();
@@ -1153,11 +1404,23 @@ void CodeGen_C::visit(const Select *op) {
     string true_val = print_expr(op->true_value);
     string false_val = print_expr(op->false_value);
     string cond = print_expr(op->condition);
-    rhs << "(" << print_type(op->type) << ")"
-        << "(" << cond
-        << " ? " << true_val
-        << " : " << false_val
-        << ")";
+    if (op->condition.type().is_vector()) {
+        // Widen the mask to the width of the values, and blend them
+        // with bitwise ops.
+        Type mask_type = Int(op->type.is_bool() ? 8 : op->type.bits(), op->type.lanes());
+        string m = print_type(mask_type);
+        string mask = print_assignment(mask_type, "__builtin_convertvector(" + cond + ", " + m + ")");
+        rhs << "(" << print_type(op->type) << ")"
+            << "((" << mask << " & (" << m << ")" << true_val
+            << ") | (~" << mask << " & (" << m << ")" << false_val
+            << "))";
+    } else {
+        rhs << "(" << print_type(op->type) << ")"
+            << "(" << cond
+            << " ? " << true_val
+            << " : " << false_val
+            << ")";
+    }
     print_assignment(op->type, rhs.str());
 }
 
@@ -1203,16 +1466,67 @@ void CodeGen_C::visit(const ProducerConsumer *op) {
 }
 
 void CodeGen_C::visit(const For *op) {
+    string id_min = print_expr(op->min);
+    string id_extent = print_expr(op->extent);
+
     if (op->for_type == ForType::Parallel) {
+        // The body becomes a lambda that captures the enclosing
+        // scope by reference, which serves as the closure. It's
+        // called from a task function passed to halide_do_par_for,
+        // or from an OpenMP parallel loop if the generated code is
+        // compiled with HALIDE_USE_OPENMP defined.
+        string task = unique_name('t');
+        string result = unique_name('r');
+        string user_context = have_user_context ? "(void *)__user_context_" : "NULL";
+
+        do_indent();
+        stream << "auto " << task << " = [&](int " << print_name(op->name) << ") -> int\n";
+        open_scope();
+        op->body.accept(this);
+        do_indent();
+        stream << "return 0;\n";
+        cache.clear();
+        indent--;
+        do_indent();
+        stream << "}; // task for " << print_name(op->name) << "\n";
+
+        do_indent();
+        stream << "int " << result << " = 0;\n";
+        stream << "#ifdef HALIDE_USE_OPENMP\n";
         do_indent();
         stream << "#pragma omp parallel for\n";
-    } else {
-        internal_assert(op->for_type == ForType::Serial)
-            << "Can only emit serial or parallel for loops to C\n";
+        do_indent();
+        stream << "for (int i = " << id_min << "; i < " << id_min << " + " << id_extent << "; i++)\n";
+        open_scope();
+        do_indent();
+        stream << "int r = " << task << "(i);\n";
+        do_indent();
+        stream << "if (r != 0)\n";
+        open_scope();
+        do_indent();
+        stream << "#pragma omp atomic write\n";
+        do_indent();
+        stream << result << " = r;\n";
+        close_scope("");
+        close_scope("");
+        stream << "#else\n";
+        do_indent();
+        stream << result << " = halide_do_par_for(" << user_context << ", "
+               << "[](void *ctx, int i, uint8_t *closure) -> int "
+               << "{return (*(decltype(" << task << ") *)closure)(i);}, "
+               << id_min << ", " << id_extent << ", (uint8_t *)&" << task << ");\n";
+        stream << "#endif\n";
+        do_indent();
+        stream << "if (" << result << " != 0)\n";
+        open_scope();
+        do_indent();
+        stream << "return " << result << ";\n";
+        close_scope("");
+        return;
     }
 
-    string id_min = print_expr(op->min);
-    string id_extent = print_expr(op->extent);
+    internal_assert(op->for_type == ForType::Serial)
+        << "Can only emit serial or parallel for loops to C\n";
 
     do_indent();
     stream << "for (int "
@@ -1239,7 +1553,8 @@ void CodeGen_C::visit(const Provide *op) {
 void CodeGen_C::visit(const Allocate *op) {
     open_scope();
 
-    // For sizes less than 8k, do a stack allocation
+    // For sizes less than 8k, do a stack allocation, unless the
+    // schedule asked for something else.
     bool on_stack = false;
     int32_t constant_size;
     string size_id;
@@ -1259,7 +1574,9 @@ void CodeGen_C::visit(const Allocate *op) {
                            << op->name << " is constant but exceeds 2^31 - 1.\n";
             } else {
                 size_id = print_expr(Expr(static_cast<int32_t>(constant_size)));
-                if (stack_bytes <= 1024 * 8) {
+                if (op->memory_type == MemoryType::Stack ||
+                    op->memory_type == MemoryType::Register ||
+                    (op->memory_type == MemoryType::Auto && stack_bytes <= 1024 * 8)) {
                     on_stack = true;
                 }
             }
@@ -1402,9 +1719,9 @@ void CodeGen_C::test() {
     Stmt s = Store::make("buf", e, x);
     s = LetStmt::make("x", beta+1, s);
     s = Block::make(s, Free::make("tmp.stack"));
-    s = Allocate::make("tmp.stack", Int(32), {127}, const_true(), s);
+    s = Allocate::make("tmp.stack", Int(32), MemoryType::Auto, {127}, const_true(), s);
     s = Block::make(s, Free::make("tmp.heap"));
-    s = Allocate::make("tmp.heap", Int(32), {43, beta}, const_true(), s);
+    s = Allocate::make("tmp.heap", Int(32), MemoryType::Auto, {43, beta}, const_true(), s);
 
     Module m("", get_host_target());
     m.append(LoweredFunc("test1", args, s, LoweredFunc::External));
@@ -1514,6 +1831,80 @@ void CodeGen_C::test() {
 
     }
 
+    // Check that vectors become vector extension types, with dense
+    // loads and stores, and masked selects.
+    {
+        Expr index = Ramp::make(Variable::make(Int(32), "x"), 1, 8);
+        Expr value = Load::make(Int(32, 8), "buf", index, Buffer(), Parameter());
+        value = max(value * 2, Broadcast::make(beta, 8));
+        Stmt s = Store::make("buf", value, index);
+        s = LetStmt::make("x", beta + 1, s);
+        Module m("", get_host_target());
+        m.append(LoweredFunc("test2", args, s, LoweredFunc::External));
+
+        ostringstream source;
+        {
+            CodeGen_C cg(source, false);
+            cg.compile(m);
+        }
+        // The temporaries are numbered by a counter shared with
+        // everything else, so replace their numbers with #.
+        string src;
+        {
+            string raw = source.str();
+            for (size_t i = 0; i < raw.size(); i++) {
+                src += raw[i];
+                bool starts_name = (raw[i] == '_' && (i == 0 || !(isalnum(raw[i-1]) || raw[i-1] == '_')));
+                if (starts_name && i + 1 < raw.size() && isdigit(raw[i+1])) {
+                    src += '#';
+                    while (i + 1 < raw.size() && isdigit(raw[i+1])) i++;
+                }
+            }
+        }
+        const char *expected[] = {
+            "typedef int32_t halide_int32x8_t __attribute__((vector_size(32)));\n",
+            "typedef int8_t halide_boolx8_t __attribute__((vector_size(8)));\n",
+            " halide_int32x8_t _# = halide_vector_load<halide_int32x8_t>(_buf + _#);\n",
+            " halide_boolx8_t _# = __builtin_convertvector(_# > _#, halide_boolx8_t);\n",
+            " halide_int32x8_t _# = __builtin_convertvector(_#, halide_int32x8_t);\n",
+            " halide_int32x8_t _# = (halide_int32x8_t)((_# & (halide_int32x8_t)_#) | (~_# & (halide_int32x8_t)_#));\n",
+            " halide_vector_store(_buf + _#, _#);\n"
+        };
+        for (const char *e : expected) {
+            if (src.find(e) == string::npos) {
+                internal_error << "Vector source code:\n" << src
+                               << "\nDoes not contain: " << e << "\n";
+            }
+        }
+    }
+
+    // Check that parallel loops become tasks for halide_do_par_for.
+    {
+        Stmt s = Store::make("buf", Variable::make(Int(32), "y"), Variable::make(Int(32), "y"));
+        s = For::make("y", 0, beta, ForType::Parallel, DeviceAPI::Host, s);
+        Module m("", get_host_target());
+        m.append(LoweredFunc("test3", args, s, LoweredFunc::External));
+
+        ostringstream source;
+        {
+            CodeGen_C cg(source, false);
+            cg.compile(m);
+        }
+        string src = source.str();
+        const char *expected[] = {
+            " = [&](int _y) -> int\n",
+            "  _buf[_y] = _y;\n",
+            " }; // task for _y\n",
+            " = halide_do_par_for((void *)__user_context_, [](void *ctx, int i, uint8_t *closure) -> int "
+            "{return (*(decltype(t"
+        };
+        for (const char *e : expected) {
+            if (src.find(e) == string::npos) {
+                internal_error << "Parallel source code:\n" << src
+                               << "\nDoes not contain: " << e << "\n";
+            }
+        }
+    }
 
     std::cout << "CodeGen_C test passed\n";
 }
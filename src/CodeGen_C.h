@@ -19,7 +19,11 @@ namespace Internal {
 /** This class emits C++ code equivalent to a halide Stmt. It's
  * mostly the same as an IRPrinter, but it's wrapped in a function
  * definition, and some things are handled differently to be valid
- * C++.
+ * C++. Vector types are emitted using GCC/Clang vector extensions, so
+ * the output of vectorized pipelines must be compiled with one of
+ * those (gcc 9 or later, for __builtin_convertvector). Parallel loops
+ * call halide_do_par_for, or use OpenMP if the output is compiled with
+ * HALIDE_USE_OPENMP defined.
  */
 class CodeGen_C : public IRPrinter {
 public:
@@ -105,6 +109,8 @@ protected:
     void visit(const UIntImm *);
     void visit(const StringImm *);
     void visit(const FloatImm *);
+    void visit(const Ramp *);
+    void visit(const Broadcast *);
     void visit(const Cast *);
     void visit(const Add *);
     void visit(const Sub *);
@@ -1,5 +1,6 @@
 #include "CodeGen_Internal.h"
 #include "Debug.h"
+#include "IROperator.h"
 
 namespace Halide {
 namespace Internal {
@@ -195,7 +196,10 @@ llvm::Type *llvm_type_of(LLVMContext *c, Halide::Type t) {
         if (t.is_float()) {
             switch (t.bits()) {
             case 16:
-                return llvm::Type::getHalfTy(*c);
+                // float16 and bfloat16 values are held as their
+                // bits. Arithmetic on them is done in float32. See
+                // EmulateFloat16Math.h
+                return llvm::Type::getInt16Ty(*c);
             case 32:
                 return llvm::Type::getFloatTy(*c);
             case 64:
@@ -255,6 +259,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_copy_to_device",
         "halide_current_time_ns",
         "halide_debug_to_file",
+        "halide_debug_to_file_region",
+        "halide_debug_to_file_wait",
         "halide_device_free",
         "halide_device_malloc",
         "halide_device_sync",
@@ -272,6 +278,8 @@ bool function_takes_user_context(const std::string &name) {
         "halide_trace",
         "halide_memoization_cache_lookup",
         "halide_memoization_cache_store",
+        "halide_memoization_cache_lookup_tile",
+        "halide_memoization_cache_store_tile",
         "halide_memoization_cache_release",
         "halide_cuda_run",
         "halide_opencl_run",
@@ -298,5 +306,110 @@ bool function_takes_user_context(const std::string &name) {
     return starts_with(name, "halide_error_");
 }
 
+bool is_vector_reduce(const Call *op) {
+    return (op->call_type == Call::Intrinsic &&
+            (op->name == Call::vector_reduce_add ||
+             op->name == Call::vector_reduce_mul ||
+             op->name == Call::vector_reduce_min ||
+             op->name == Call::vector_reduce_max));
+}
+
+namespace {
+
+// Select lanes start, start + stride, ... of a vector.
+Expr slice_lanes(Expr v, int start, int stride, int lanes) {
+    vector<Expr> args(lanes + 1);
+    args[0] = v;
+    for (int i = 0; i < lanes; i++) {
+        args[i + 1] = start + i * stride;
+    }
+    return Call::make(v.type().with_lanes(lanes), Call::shuffle_vector, args, Call::Intrinsic);
+}
+
+Expr combine(const string &reduce_op, Expr a, Expr b) {
+    if (reduce_op == Call::vector_reduce_add) {
+        return Add::make(a, b);
+    } else if (reduce_op == Call::vector_reduce_mul) {
+        return Mul::make(a, b);
+    } else if (reduce_op == Call::vector_reduce_min) {
+        return Min::make(a, b);
+    } else {
+        internal_assert(reduce_op == Call::vector_reduce_max)
+            << "Unknown vector reduction: " << reduce_op << "\n";
+        return Max::make(a, b);
+    }
+}
+
+Expr lower_vector_reduce(const string &reduce_op, Expr value, int lanes, bool halves) {
+    int value_lanes = value.type().lanes();
+    internal_assert(lanes > 0 && value_lanes % lanes == 0)
+        << "Can't reduce a vector of " << value_lanes << " lanes to " << lanes << " lanes\n";
+
+    if (value_lanes == lanes) {
+        return value;
+    }
+
+    // The value is used by several shuffles, so bind it to a name.
+    string name = unique_name('t');
+    Expr v = Variable::make(value.type(), name);
+
+    int factor = value_lanes / lanes;
+    Expr result;
+    if (factor % 2 == 0) {
+        int half = value_lanes / 2;
+        Expr a, b;
+        if (halves) {
+            a = slice_lanes(v, 0, 1, half);
+            b = slice_lanes(v, half, 1, half);
+        } else {
+            a = slice_lanes(v, 0, 2, half);
+            b = slice_lanes(v, 1, 2, half);
+        }
+        result = lower_vector_reduce(reduce_op, combine(reduce_op, a, b), lanes, halves);
+    } else {
+        result = slice_lanes(v, 0, factor, lanes);
+        for (int i = 1; i < factor; i++) {
+            result = combine(reduce_op, result, slice_lanes(v, i, factor, lanes));
+        }
+    }
+
+    return Let::make(name, value, result);
+}
+
+}
+
+Expr lower_vector_reduce(const Call *op, int partial_lanes) {
+    internal_assert(is_vector_reduce(op) && op->args.size() == 1);
+    if (op->type.is_scalar()) {
+        return lower_vector_reduce(op->name, op->args[0], partial_lanes, true);
+    } else {
+        return lower_vector_reduce(op->name, op->args[0], op->type.lanes(), false);
+    }
+}
+
+bool is_dot_product(const Call *op, int factor, Type a_type, Type b_type, Expr &a, Expr &b) {
+    if (!op || op->call_type != Call::Intrinsic || op->name != Call::vector_reduce_add) {
+        return false;
+    }
+    internal_assert(op->args.size() == 1);
+    const Mul *mul = op->args[0].as<Mul>();
+    int lanes = op->args[0].type().lanes();
+    if (!mul || lanes != op->type.lanes() * factor) {
+        return false;
+    }
+
+    Expr operands[] = {mul->a, mul->b};
+    for (int i = 0; i < 2; i++) {
+        Expr narrow_a = lossless_cast(a_type.with_lanes(lanes), operands[i]);
+        Expr narrow_b = lossless_cast(b_type.with_lanes(lanes), operands[1-i]);
+        if (narrow_a.defined() && narrow_b.defined()) {
+            a = narrow_a;
+            b = narrow_b;
+            return true;
+        }
+    }
+    return false;
+}
+
 }
 }
@@ -113,6 +113,26 @@ bool constant_allocation_size(const std::vector<Expr> &extents, const std::strin
 /** Which built-in functions require a user-context first argument? */
 bool function_takes_user_context(const std::string &name);
 
+/** Is this call one of the vector_reduce_* intrinsics? */
+bool is_vector_reduce(const Call *op);
+
+/** Lower a vector_reduce_* intrinsic (see \ref Call) into shuffles
+ * and elementwise operations. When reducing to a scalar the vector is
+ * repeatedly split in half, so that each step is a single vector op
+ * between the halves, and the lowering can be stopped early once the
+ * value has been reduced to the given number of lanes, so that target
+ * specific code can finish the job with horizontal
+ * instructions. Otherwise even and odd lanes are combined to preserve
+ * the grouping of adjacent lanes. */
+Expr lower_vector_reduce(const Call *op, int partial_lanes = 1);
+
+/** Check if a call is a vector_reduce_add that sums groups of 'factor'
+ * adjacent lanes of a product of two values that can be narrowed
+ * losslessly to the element types a_type and b_type (in either
+ * order). If so, sets a and b to the narrowed operands. Used to select
+ * widening dot-product instructions. */
+bool is_dot_product(const Call *op, int factor, Type a_type, Type b_type, Expr &a, Expr &b);
+
 }}
 
 #endif
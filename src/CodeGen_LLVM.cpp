@@ -10,6 +10,7 @@
 #include "Simplify.h"
 #include "JITModule.h"
 #include "CodeGen_Internal.h"
+#include "FixedPoint.h"
 #include "Lerp.h"
 #include "Util.h"
 #include "LLVM_Runtime_Linker.h"
@@ -36,6 +37,53 @@ std::unique_ptr<llvm::Module> codegen_llvm(const Module &module, llvm::LLVMConte
     return cg->compile(module);
 }
 
+void optimize_llvm_module(llvm::Module &module, const Target &target) {
+    using namespace llvm;
+    using Internal::debug;
+
+    debug(3) << "Optimizing module\n";
+
+    if (debug::debug_level >= 3) {
+        module.dump();
+    }
+
+    #if LLVM_VERSION < 37
+    FunctionPassManager function_pass_manager(&module);
+    PassManager module_pass_manager;
+    #else
+    legacy::FunctionPassManager function_pass_manager(&module);
+    legacy::PassManager module_pass_manager;
+    #endif
+
+    #if (LLVM_VERSION >= 36) && (LLVM_VERSION < 37)
+    internal_assert(module.getDataLayout()) << "Optimizing module with no data layout, probably will crash in LLVM.\n";
+    module_pass_manager.add(new DataLayoutPass());
+    #endif
+
+    // Make sure things marked as always-inline get inlined
+    module_pass_manager.add(createAlwaysInlinerPass());
+
+    PassManagerBuilder b;
+    // When compiling quickly, only run the cheap passes that clean
+    // up the code we emit.
+    b.OptLevel = target.has_feature(Target::FastCompile) ? 1 : 3;
+    b.populateFunctionPassManager(function_pass_manager);
+    b.populateModulePassManager(module_pass_manager);
+
+    // Run optimization passes
+    module_pass_manager.run(module);
+    function_pass_manager.doInitialization();
+    for (llvm::Module::iterator i = module.begin(); i != module.end(); i++) {
+        function_pass_manager.run(*i);
+    }
+    function_pass_manager.doFinalization();
+
+    debug(3) << "After LLVM optimizations:\n";
+    if (debug::debug_level >= 2) {
+        module.dump();
+    }
+}
+
 namespace Internal {
 
 using namespace llvm;
@@ -249,6 +297,10 @@ void CodeGen_LLVM::set_context(llvm::LLVMContext &context) {
 
 CodeGen_LLVM *CodeGen_LLVM::new_for_target(const Target &target,
                                            llvm::LLVMContext &context) {
+    user_assert(target.supported())
+        << "Target " << target.to_string() << " has features that need a newer "
+        << "version of LLVM than the one Halide was built with.\n";
+
     // The awkward mapping from targets to code generators
     if (target.features_any_of({Target::CUDA,
                                 Target::OpenCL,
@@ -735,8 +787,37 @@ llvm::Constant *CodeGen_LLVM::embed_metadata(const std::string &metadata_name,
 
     const int num_args = (int) args.size();
 
+    llvm::PointerType *storage_blocks_ptr_type = cast<PointerType>(argument_t_type->getElementType(10));
+    StructType *storage_block_t_type = cast<StructType>(storage_blocks_ptr_type->getElementType());
+
     vector<Constant *> arguments_array_entries;
     for (int arg = 0; arg < num_args; ++arg) {
+        const std::vector<StorageBlock> &blocks = args[arg].storage_blocks;
+        Constant *storage_blocks = ConstantPointerNull::get(storage_blocks_ptr_type);
+        if (!blocks.empty()) {
+            vector<Constant *> block_entries;
+            for (const StorageBlock &b : blocks) {
+                Constant *block_fields[] = {
+                    ConstantInt::get(i32, b.dim),
+                    ConstantInt::get(i32, b.factor)
+                };
+                block_entries.push_back(ConstantStruct::get(storage_block_t_type, block_fields));
+            }
+            llvm::ArrayType *blocks_array = ArrayType::get(storage_block_t_type, blocks.size());
+            GlobalVariable *blocks_storage = new GlobalVariable(
+                *module,
+                blocks_array,
+                /*isConstant*/ true,
+                GlobalValue::PrivateLinkage,
+                ConstantArray::get(blocks_array, block_entries));
+            Constant *zeros[] = {zero, zero};
+#if LLVM_VERSION >= 37
+            storage_blocks = ConstantExpr::getInBoundsGetElementPtr(blocks_array, blocks_storage, zeros);
+#else
+            storage_blocks = ConstantExpr::getInBoundsGetElementPtr(blocks_storage, zeros);
+#endif
+        }
+
         Constant *argument_fields[] = {
             create_string_constant(args[arg].name),
             ConstantInt::get(i32, args[arg].kind),
@@ -745,7 +826,10 @@ llvm::Constant *CodeGen_LLVM::embed_metadata(const std::string &metadata_name,
             ConstantInt::get(i32, args[arg].type.bits()),
             embed_constant_expr(args[arg].def),
             embed_constant_expr(args[arg].min),
-            embed_constant_expr(args[arg].max)
+            embed_constant_expr(args[arg].max),
+            ConstantInt::get(i32, (int)blocks.size()),
+            zero,
+            storage_blocks
         };
         arguments_array_entries.push_back(ConstantStruct::get(argument_t_type, argument_fields));
     }
@@ -759,7 +843,7 @@ llvm::Constant *CodeGen_LLVM::embed_metadata(const std::string &metadata_name,
 
     Value *zeros[] = {zero, zero};
     Constant *metadata_fields[] = {
-        /* version */ zero,
+        /* version */ ConstantInt::get(i32, 1),
         /* num_arguments */ ConstantInt::get(i32, num_args),
 #if LLVM_VERSION >= 37
         /* arguments */ ConstantExpr::getInBoundsGetElementPtr(arguments_array, arguments_array_storage, zeros),
@@ -819,45 +903,7 @@ llvm::Type *CodeGen_LLVM::llvm_type_of(Type t) {
 }
 
 void CodeGen_LLVM::optimize_module() {
-    debug(3) << "Optimizing module\n";
-
-    if (debug::debug_level >= 3) {
-        module->dump();
-    }
-
-    #if LLVM_VERSION < 37
-    FunctionPassManager function_pass_manager(module.get());
-    PassManager module_pass_manager;
-    #else
-    legacy::FunctionPassManager function_pass_manager(module.get());
-    legacy::PassManager module_pass_manager;
-    #endif
-
-    #if (LLVM_VERSION >= 36) && (LLVM_VERSION < 37)
-    internal_assert(module->getDataLayout()) << "Optimizing module with no data layout, probably will crash in LLVM.\n";
-    module_pass_manager.add(new DataLayoutPass());
-    #endif
-
-    // Make sure things marked as always-inline get inlined
-    module_pass_manager.add(createAlwaysInlinerPass());
-
-    PassManagerBuilder b;
-    b.OptLevel = 3;
-    b.populateFunctionPassManager(function_pass_manager);
-    b.populateModulePassManager(module_pass_manager);
-
-    // Run optimization passes
-    module_pass_manager.run(*module);
-    function_pass_manager.doInitialization();
-    for (llvm::Module::iterator i = module->begin(); i != module->end(); i++) {
-        function_pass_manager.run(*i);
-    }
-    function_pass_manager.doFinalization();
-
-    debug(3) << "After LLVM optimizations:\n";
-    if (debug::debug_level >= 2) {
-        module->dump();
-    }
+    optimize_llvm_module(*module, target);
 }
 
 void CodeGen_LLVM::sym_push(const string &name, llvm::Value *value) {
@@ -1126,7 +1172,13 @@ void CodeGen_LLVM::visit(const UIntImm *op) {
 }
 
 void CodeGen_LLVM::visit(const FloatImm *op) {
-    value = ConstantFP::get(llvm_type_of(op->type), op->value);
+    if (op->type.is_bfloat()) {
+        value = ConstantInt::get(i16, bfloat16_t(op->value).to_bits());
+    } else if (op->type.bits() == 16) {
+        value = ConstantInt::get(i16, float16_t(op->value).to_bits());
+    } else {
+        value = ConstantFP::get(llvm_type_of(op->type), op->value);
+    }
 }
 
 void CodeGen_LLVM::visit(const StringImm *op) {
@@ -1145,6 +1197,25 @@ void CodeGen_LLVM::visit(const Cast *op) {
         value = builder->CreateBitCast(value, llvm_dst);
     } else if (dst.is_handle() || src.is_handle()) {
         internal_error << "Can't cast from " << src << " to " << dst << "\n";
+    } else if ((src.is_float() && src.bits() == 16) ||
+               (dst.is_float() && dst.bits() == 16)) {
+        // 16-bit floats are held as their bits. The only conversions
+        // left by emulate_float16_math are between float16 and
+        // float32, on targets that have instructions for them.
+        internal_assert(src.is_float() && dst.is_float() &&
+                        !src.is_bfloat() && !dst.is_bfloat())
+            << "Can't cast from " << src << " to " << dst << "\n";
+        llvm::Type *llvm_half = f16;
+        if (src.is_vector()) {
+            llvm_half = VectorType::get(f16, src.lanes());
+        }
+        if (src.bits() == 16) {
+            value = builder->CreateBitCast(value, llvm_half);
+            value = builder->CreateFPExt(value, llvm_dst);
+        } else {
+            value = builder->CreateFPTrunc(value, llvm_half);
+            value = builder->CreateBitCast(value, llvm_dst);
+        }
     } else if (!src.is_float() && !dst.is_float()) {
         // Widening integer casts either zero extend or sign extend,
         // depending on the source type. Narrowing integer casts
@@ -1696,6 +1767,56 @@ void CodeGen_LLVM::visit(const Load *op) {
             }
 
             value = builder->CreateShuffleVector(vec_a, vec_b, ConstantVector::get(indices));
+        } else if (ramp && stride && (stride->value == 3 || stride->value == 4)) {
+            // Load stride dense vectors worth and pick out every
+            // stride-th element with a single shuffle, which llvm
+            // lowers to a network of unpacks or byte shuffles. This
+            // is the common case of deinterleaving RGB or RGBA data.
+            int s = stride->value;
+            int lanes = ramp->lanes;
+            Expr base = ramp->base;
+
+            // As above, for internal buffers start at the previous
+            // multiple of the stride when the base ends in a
+            // constant, so that the loads for f(3*x), f(3*x+1),
+            // and f(3*x+2) can be shared.
+            int offset = 0;
+            bool external = op->param.defined() || op->image.defined();
+            if (!external) {
+                const Add *add = base.as<Add>();
+                const IntImm *add_b = add ? add->b.as<IntImm>() : NULL;
+                if (add_b) {
+                    offset = mod_imp((int)add_b->value, s);
+                    base = simplify(base - offset);
+                }
+            }
+
+            // The position of the last element needed relative to
+            // base. The final load is placed to end there, so that
+            // we don't read past the end of the buffer.
+            int last = (lanes - 1) * s + offset;
+            vector<Value *> vecs;
+            vector<int> starts;
+            for (int j = 0; j < s; j++) {
+                int start = std::min(j * lanes, last - lanes + 1);
+                Expr dense_index = Ramp::make(simplify(base + start), 1, lanes);
+                vecs.push_back(codegen(Load::make(op->type, op->name, dense_index, op->image, op->param)));
+                starts.push_back(start);
+            }
+            Value *all = concat_vectors(vecs);
+
+            vector<Constant *> indices(lanes);
+            for (int i = 0; i < lanes; i++) {
+                int pos = i * s + offset;
+                int j = 0;
+                while (pos >= starts[j] + lanes) {
+                    j++;
+                }
+                internal_assert(j < s && pos >= starts[j]);
+                indices[i] = ConstantInt::get(i32, j * lanes + pos - starts[j]);
+            }
+
+            value = builder->CreateShuffleVector(all, UndefValue::get(all->getType()), ConstantVector::get(indices));
         } else if (ramp && stride && stride->value == -1) {
             // Load the vector and then flip it in-place
             Expr flipped_base = ramp->base - ramp->lanes + 1;
@@ -2007,6 +2128,10 @@ void CodeGen_LLVM::visit(const Call *op) {
         } else if (op->name == Call::interleave_vectors) {
             internal_assert(0 < op->args.size());
             value = interleave_vectors(op->type, op->args);
+        } else if (is_vector_reduce(op)) {
+            codegen(lower_vector_reduce(op));
+        } else if (is_fixed_point_intrinsic(op)) {
+            codegen(lower_fixed_point_intrinsic(op));
         } else if (op->name == Call::debug_to_file) {
             internal_assert(op->args.size() == 9);
             const StringImm *filename = op->args[0].as<StringImm>();
@@ -3177,8 +3302,12 @@ Value *CodeGen_LLVM::call_intrin(llvm::Type *result_type, int intrin_lanes,
             vector<Value *> args;
             for (size_t i = 0; i < arg_values.size(); i++) {
                 if (arg_values[i]->getType()->isVectorTy()) {
-                    internal_assert((int)arg_values[i]->getType()->getVectorNumElements() == arg_lanes);
-                    args.push_back(slice_vector(arg_values[i], start, intrin_lanes));
+                    // Args may be some multiple of the width of the
+                    // result (e.g. for widening horizontal ops).
+                    int lanes_i = (int)(arg_values[i]->getType()->getVectorNumElements());
+                    internal_assert(lanes_i % arg_lanes == 0);
+                    int factor = lanes_i / arg_lanes;
+                    args.push_back(slice_vector(arg_values[i], start * factor, intrin_lanes * factor));
                 } else {
                     args.push_back(arg_values[i]);
                 }
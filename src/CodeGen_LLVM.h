@@ -376,7 +376,9 @@ protected:
      * into the original type 't'. For the version that takes an
      * llvm::Type *, the type may be void, so the vector width of the
      * arguments must be specified explicitly as
-     * 'called_lanes'. */
+     * 'called_lanes'. Vector arguments may be a whole multiple of the
+     * width of the result, as for widening horizontal operations, in
+     * which case they are sliced proportionally. */
     // @{
     llvm::Value *call_intrin(Type t, int intrin_lanes,
                              const std::string &name, std::vector<Expr>);
@@ -446,6 +448,10 @@ private:
 EXPORT std::unique_ptr<llvm::Module> codegen_llvm(const Module &module,
                                                   llvm::LLVMContext &context);
 
+/** Run llvm's optimization passes over an llvm::Module. Fewer passes
+ * are run if the target has the FastCompile feature. */
+EXPORT void optimize_llvm_module(llvm::Module &module, const Target &target);
+
 }
 
 #endif
@@ -50,6 +50,7 @@ Value *CodeGen_Posix::codegen_allocation_size(const std::string &name, Type type
 }
 
 CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &name, Type type,
+                                                           MemoryType memory_type,
                                                            const std::vector<Expr> &extents, Expr condition,
                                                            Expr new_expr, std::string free_function) {
     Value *llvm_size = NULL;
@@ -61,7 +62,11 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
 
         if (stack_bytes > ((int64_t(1) << 31) - 1)) {
             user_error << "Total size for allocation " << name << " is constant but exceeds 2^31 - 1.";
-        } else if (stack_bytes <= 1024 * 16) {
+        } else if (memory_type == MemoryType::Register) {
+            // Registers get an exactly-typed alloca of their own (see
+            // below), so there's no rounding.
+        } else if (memory_type != MemoryType::Heap &&
+                   (stack_bytes <= 1024 * 16 || memory_type == MemoryType::Stack)) {
             // Round up to nearest multiple of 32.
             stack_bytes = ((stack_bytes + 31)/32)*32;
         } else {
@@ -69,6 +74,8 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
             llvm_size = codegen(Expr(constant_bytes));
         }
     } else {
+        internal_assert(memory_type != MemoryType::Register)
+            << "Allocation " << name << " is stored in registers, but doesn't have a constant size\n";
         llvm_size = codegen_allocation_size(name, type, extents);
     }
 
@@ -83,11 +90,32 @@ CodeGen_Posix::Allocation CodeGen_Posix::create_allocation(const std::string &na
     Allocation allocation;
     allocation.constant_bytes = constant_bytes;
     allocation.stack_bytes = new_expr.defined() ? 0 : stack_bytes;
+    allocation.memory_type = memory_type;
+    allocation.saved_stack = NULL;
     allocation.ptr = NULL;
     allocation.destructor = NULL;
     allocation.destructor_function = NULL;
 
-    if (!new_expr.defined() && stack_bytes != 0) {
+    if (!new_expr.defined() && memory_type == MemoryType::Register) {
+        // Give each register allocation its own alloca of the right
+        // type at the function entry, and never share it with other
+        // allocations, so that llvm can promote the elements to
+        // registers. This only works out if all the accesses are at
+        // constant indices, which lowering has checked.
+        internal_assert(stack_bytes > 0);
+        debug(4) << "Allocating " << stack_bytes << " bytes in registers for " << name << "\n";
+        allocation.ptr = create_alloca_at_entry(llvm_type_of(type), stack_bytes / type.bytes(), false, name);
+    } else if (!new_expr.defined() && memory_type == MemoryType::Stack && stack_bytes == 0) {
+        // A dynamically-sized stack allocation. The stack pointer is
+        // restored when the Allocate node goes out of scope, rather
+        // than at the Free, because early frees may not be nested.
+        debug(4) << "Allocating a dynamic amount of stack for " << name << "\n";
+        llvm::Function *stacksave = Intrinsic::getDeclaration(module.get(), Intrinsic::stacksave);
+        allocation.saved_stack = builder->CreateCall(stacksave);
+        AllocaInst *ptr = builder->CreateAlloca(i8, llvm_size, name);
+        ptr->setAlignment(32);
+        allocation.ptr = ptr;
+    } else if (!new_expr.defined() && stack_bytes != 0) {
         // Try to find a free stack allocation we can use.
         vector<Allocation>::iterator free = free_stack_allocs.end();
         for (free = free_stack_allocs.begin(); free != free_stack_allocs.end(); ++free) {
@@ -177,13 +205,18 @@ void CodeGen_Posix::visit(const Allocate *alloc) {
                    << alloc->name << "\n";
     }
 
-    Allocation allocation = create_allocation(alloc->name, alloc->type,
+    Allocation allocation = create_allocation(alloc->name, alloc->type, alloc->memory_type,
                                               alloc->extents, alloc->condition,
                                               alloc->new_expr, alloc->free_function);
     sym_push(alloc->name + ".host", allocation.ptr);
 
     codegen(alloc->body);
 
+    if (allocation.saved_stack) {
+        llvm::Function *stackrestore = Intrinsic::getDeclaration(module.get(), Intrinsic::stackrestore);
+        builder->CreateCall(stackrestore, {allocation.saved_stack});
+    }
+
     // Should have been freed
     internal_assert(!sym_exists(alloc->name + ".host"));
     internal_assert(!allocations.contains(alloc->name));
@@ -192,7 +225,10 @@ void CodeGen_Posix::visit(const Allocate *alloc) {
 void CodeGen_Posix::visit(const Free *stmt) {
     Allocation alloc = allocations.get(stmt->name);
 
-    if (alloc.stack_bytes) {
+    if (alloc.memory_type == MemoryType::Register || alloc.saved_stack) {
+        // Register allocations are never shared, and dynamic stack
+        // allocations are released at the end of their scope.
+    } else if (alloc.stack_bytes) {
         // Remember this allocation so it can be re-used by a later allocation.
         free_stack_allocs.push_back(alloc);
     } else {
@@ -24,7 +24,8 @@ protected:
 
     /** Posix implementation of Allocate. Small constant-sized allocations go
      * on the stack. The rest go on the heap by calling "halide_malloc"
-     * and "halide_free" in the standard library. */
+     * and "halide_free" in the standard library. The memory type of the
+     * Allocate node can override this choice. */
     // @{
     void visit(const Allocate *);
     void visit(const Free *);
@@ -46,8 +47,15 @@ protected:
         int constant_bytes;
 
         /** How many bytes of stack space used. 0 implies it was a
-         * heap allocation. */
+         * heap allocation or a dynamically-sized stack allocation. */
         int stack_bytes;
+
+        /** Where the allocation lives. */
+        MemoryType memory_type;
+
+        /** For dynamically-sized stack allocations, the stack pointer
+         * to restore when the allocation goes out of scope. */
+        llvm::Value *saved_stack;
     };
 
     /** The allocations currently in scope. The stack gets pushed when
@@ -80,7 +88,7 @@ private:
      *
      * When the allocation can be freed call 'free_allocation', and
      * when it goes out of scope call 'destroy_allocation'. */
-    Allocation create_allocation(const std::string &name, Type type,
+    Allocation create_allocation(const std::string &name, Type type, MemoryType memory_type,
                                  const std::vector<Expr> &extents,
                                  Expr condition, Expr new_expr, std::string free_function);
 };
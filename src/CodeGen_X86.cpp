@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <iostream>
 
 #include "CodeGen_X86.h"
+#include "CodeGen_Internal.h"
+#include "FixedPoint.h"
 #include "JITModule.h"
 #include "IROperator.h"
 #include "IRMatch.h"
@@ -107,6 +110,18 @@ bool should_use_pmaddwd(Expr a, Expr b, vector<Expr> &result) {
 
 
 void CodeGen_X86::visit(const Add *op) {
+    // Try to fold the addition into an accumulating dot product.
+    const Call *reduce_a = op->a.as<Call>();
+    const Call *reduce_b = op->b.as<Call>();
+    if (op->type.is_vector() && reduce_b &&
+        (value = codegen_dot_product(reduce_b, op->a))) {
+        return;
+    }
+    if (op->type.is_vector() && reduce_a &&
+        (value = codegen_dot_product(reduce_a, op->b))) {
+        return;
+    }
+
     vector<Expr> matches;
     if (should_use_pmaddwd(op->a, op->b, matches)) {
         codegen(Call::make(op->type, "pmaddwd", matches, Call::Extern));
@@ -265,6 +280,297 @@ void CodeGen_X86::visit(const Select *op) {
 
 }
 
+Value *CodeGen_X86::codegen_dot_product(const Call *op, Expr accumulator) {
+    if (op->call_type != Call::Intrinsic ||
+        op->name != Call::vector_reduce_add) {
+        return NULL;
+    }
+
+    Type t = op->type;
+    Type arg_t = op->args[0].type();
+    if (!(t.is_int() || t.is_uint()) || arg_t.lanes() % t.lanes() != 0) {
+        return NULL;
+    }
+    int factor = arg_t.lanes() / t.lanes();
+
+    // Instructions that sum 'factor' adjacent products of a_type and
+    // b_type into each lane of the result, in order of preference.
+    struct DotProduct {
+        int bits, factor;
+        Type a_type, b_type;
+        int lanes;
+        const char *intrin;
+        bool accumulates, saturates;
+    };
+    vector<DotProduct> instructions;
+    #if LLVM_VERSION >= 70
+    if (target.has_feature(Target::AVX512_VNNI)) {
+        instructions.push_back({32, 4, UInt(8), Int(8), 8, "llvm.x86.avx512.vpdpbusd.256", true, false});
+        instructions.push_back({32, 4, UInt(8), Int(8), 4, "llvm.x86.avx512.vpdpbusd.128", true, false});
+    }
+    #endif
+    instructions.push_back({32, 2, Int(16), Int(16), 4, "llvm.x86.sse2.pmadd.wd", false, false});
+    if (target.has_feature(Target::SSE41)) {
+        instructions.push_back({16, 2, UInt(8), Int(8), 8, "llvm.x86.ssse3.pmadd.ub.sw.128", false, true});
+    }
+
+    for (const DotProduct &d : instructions) {
+        if (t.bits() != d.bits || factor % d.factor != 0) continue;
+
+        // If we're reducing over more lanes than the instruction
+        // does, use the instruction to get part of the way, and then
+        // finish the job with shuffles.
+        Type partial_t = t.with_lanes(arg_t.lanes() / d.factor);
+        if (partial_t.is_scalar()) continue;
+        Expr partial = op;
+        if (factor != d.factor) {
+            partial = Call::make(partial_t, Call::vector_reduce_add, op->args, Call::Intrinsic);
+        }
+
+        // Only use the wider versions if they're fully used.
+        if (partial_t.lanes() < d.lanes && d.lanes * d.bits > 128) continue;
+
+        Expr a, b;
+        if (!is_dot_product(partial.as<Call>(), d.factor, d.a_type, d.b_type, a, b)) continue;
+
+        if (d.saturates) {
+            // pmaddubsw saturates the sum of each pair of
+            // products. This can't happen if the signed operand is a
+            // constant in [-64, 64].
+            const int64_t *c = as_const_int(b);
+            if (!c || *c < -64 || *c > 64) continue;
+        }
+
+        if (factor != d.factor) {
+            Expr e = Call::make(t, Call::vector_reduce_add, {partial}, Call::Intrinsic);
+            if (accumulator.defined()) {
+                e = accumulator + e;
+            }
+            return codegen(e);
+        }
+
+        Value *va = codegen(a), *vb = codegen(b);
+        if (!d.accumulates) {
+            Value *result = call_intrin(llvm_type_of(t), d.lanes, d.intrin, {va, vb});
+            if (accumulator.defined()) {
+                result = builder->CreateAdd(codegen(accumulator), result);
+            }
+            return result;
+        }
+
+        // The accumulating instructions take the bytes packed into
+        // 32-bit lanes.
+        Value *acc = (accumulator.defined() ?
+                      codegen(accumulator) :
+                      Constant::getNullValue(llvm_type_of(t)));
+        llvm::Type *slice_t = VectorType::get(i32, d.lanes);
+        vector<Value *> results;
+        for (int i = 0; i < t.lanes(); i += d.lanes) {
+            Value *acc_slice = slice_vector(acc, i, d.lanes);
+            Value *a_slice = slice_vector(va, i * d.factor, d.lanes * d.factor);
+            Value *b_slice = slice_vector(vb, i * d.factor, d.lanes * d.factor);
+            a_slice = builder->CreateBitCast(a_slice, slice_t);
+            b_slice = builder->CreateBitCast(b_slice, slice_t);
+            results.push_back(call_intrin(slice_t, d.lanes, d.intrin, {acc_slice, a_slice, b_slice}));
+        }
+        return slice_vector(concat_vectors(results), 0, t.lanes());
+    }
+
+    return NULL;
+}
+
+void CodeGen_X86::visit(const Call *op) {
+    if (op->call_type == Call::Intrinsic &&
+        op->name == Call::vector_reduce_add) {
+        value = codegen_dot_product(op, Expr());
+        if (value) return;
+    }
+
+    if (op->call_type == Call::Intrinsic &&
+        op->name == Call::vector_reduce_add &&
+        op->type.is_scalar()) {
+        internal_assert(op->args.size() == 1);
+
+        // The sum of a vector of widened uint8s can be done using
+        // psadbw against zero, which sums each group of 8 bytes into
+        // a 64-bit lane. We can do the whole sum at 64 bits and
+        // truncate, because integer overflow wraps.
+        const Cast *cast = op->args[0].as<Cast>();
+        if (cast &&
+            cast->value.type().element_of() == UInt(8) &&
+            cast->value.type().lanes() % 16 == 0 &&
+            (op->type.is_int() || op->type.is_uint()) &&
+            op->type.bits() >= 16) {
+            Value *bytes = codegen(cast->value);
+            int lanes = cast->value.type().lanes();
+            llvm::Type *i64x2_t = VectorType::get(i64, 2);
+            Value *zero = Constant::getNullValue(VectorType::get(i8, 16));
+            Value *sum = NULL;
+            for (int i = 0; i < lanes; i += 16) {
+                Value *sad = call_intrin(i64x2_t, 2, "llvm.x86.sse2.psad.bw",
+                                         {slice_vector(bytes, i, 16), zero});
+                sum = sum ? builder->CreateAdd(sum, sad) : sad;
+            }
+            Value *lo = builder->CreateExtractElement(sum, ConstantInt::get(i32, 0));
+            Value *hi = builder->CreateExtractElement(sum, ConstantInt::get(i32, 1));
+            value = builder->CreateAdd(lo, hi);
+            value = builder->CreateIntCast(value, llvm_type_of(op->type), false);
+            return;
+        }
+    }
+
+    if (is_fixed_point_intrinsic(op) && op->type.is_vector()) {
+        // Fixed-point intrinsics with an sse2 (or avx2)
+        // instruction. The rest are lowered to wider arithmetic.
+        struct FixedPointIntrinsic {
+            const char *name;
+            Type type;
+            const char *intrin;
+        };
+        static FixedPointIntrinsic intrinsics[] = {
+            {Call::saturating_add, Int(8), "padds.b"},
+            {Call::saturating_add, UInt(8), "paddus.b"},
+            {Call::saturating_add, Int(16), "padds.w"},
+            {Call::saturating_add, UInt(16), "paddus.w"},
+            {Call::saturating_sub, Int(8), "psubs.b"},
+            {Call::saturating_sub, UInt(8), "psubus.b"},
+            {Call::saturating_sub, Int(16), "psubs.w"},
+            {Call::saturating_sub, UInt(16), "psubus.w"},
+            {Call::rounding_halving_add, UInt(8), "pavg.b"},
+            {Call::rounding_halving_add, UInt(16), "pavg.w"},
+            {Call::mul_hi, Int(16), "pmulh.w"},
+            {Call::mul_hi, UInt(16), "pmulhu.w"}
+        };
+
+        for (const FixedPointIntrinsic &i : intrinsics) {
+            if (op->name == i.name && op->type.element_of() == i.type) {
+                bool avx2 = (target.has_feature(Target::AVX2) &&
+                             op->type.bits() * op->type.lanes() >= 256);
+                int lanes = (avx2 ? 256 : 128) / op->type.bits();
+                string prefix = avx2 ? "llvm.x86.avx2." : "llvm.x86.sse2.";
+                value = call_intrin(op->type, lanes, prefix + i.intrin, op->args);
+                return;
+            }
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
+void CodeGen_X86::visit(const Load *op) {
+    // Dense and strided loads are handled well already. We only care
+    // about general gathers here.
+    if (op->type.is_vector() && !op->type.is_handle() && !op->index.as<Ramp>()) {
+        if ((value = codegen_table_lookup(op)) ||
+            (value = codegen_gather(op))) {
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
+Value *CodeGen_X86::codegen_table_lookup(const Load *op) {
+    // A gather of bytes from a small internal allocation can be done
+    // with pshufb, using each 16-byte slice of the table in turn.
+    const int max_table_size = 32;
+    if (op->type.bits() != 8 ||
+        !target.has_feature(Target::SSE41) ||
+        !allocations.contains(op->name)) {
+        return NULL;
+    }
+    int table_size = allocations.get(op->name).constant_bytes;
+    if (table_size <= 0 || table_size > max_table_size) {
+        return NULL;
+    }
+
+    // The allocation is large enough for all the indices used, so
+    // they're all in [0, table_size), and can be narrowed to bytes.
+    int lanes = op->type.lanes();
+    Expr table_load = Load::make(op->type.with_lanes(table_size), op->name,
+                                 Ramp::make(0, 1, table_size), op->image, op->param);
+    Value *table = codegen(table_load);
+    Value *index = builder->CreateTrunc(codegen(op->index), VectorType::get(i8, lanes));
+
+    llvm::Type *slice_t = VectorType::get(i8, 16);
+    vector<Value *> results;
+    for (int i = 0; i < lanes; i += 16) {
+        Value *index_slice = slice_vector(index, i, 16);
+        Value *result = NULL;
+        for (int j = 0; j < table_size; j += 16) {
+            Value *table_slice = slice_vector(table, j, 16);
+            Value *idx = index_slice;
+            if (j > 0) {
+                idx = builder->CreateSub(idx, ConstantInt::get(slice_t, j));
+            }
+            Value *lookup = call_intrin(slice_t, 16, "llvm.x86.ssse3.pshuf.b.128", {table_slice, idx});
+            if (result) {
+                Value *in_slice = builder->CreateICmpUGE(index_slice, ConstantInt::get(slice_t, j));
+                result = builder->CreateSelect(in_slice, lookup, result);
+            } else {
+                result = lookup;
+            }
+        }
+        results.push_back(result);
+    }
+    return slice_vector(concat_vectors(results), 0, lanes);
+}
+
+Value *CodeGen_X86::codegen_gather(const Load *op) {
+    Type t = op->type;
+    if (!target.has_feature(Target::AVX2) ||
+        !(t.bits() == 32 || t.bits() == 64) ||
+        op->index.type().bits() != 32) {
+        return NULL;
+    }
+
+    Value *base = codegen_buffer_pointer(op->name, t.element_of(), make_zero(Int(32)));
+    Value *index = codegen(op->index);
+
+    // The 32-bit gathers do 4 or 8 lanes at a time, and the 64-bit
+    // gathers do 2 or 4 lanes at a time with a vector of 4 indices.
+    int gather_lanes = 256 / t.bits();
+    if (t.lanes() % gather_lanes != 0) {
+        gather_lanes /= 2;
+        if (t.lanes() % gather_lanes != 0) {
+            return NULL;
+        }
+    }
+
+    string intrin = "llvm.x86.avx2.gather.d.";
+    intrin += t.is_float() ? (t.bits() == 32 ? "ps" : "pd") : (t.bits() == 32 ? "d" : "q");
+    if (gather_lanes * t.bits() == 256) {
+        intrin += ".256";
+    }
+    int index_lanes = std::max(gather_lanes, 4);
+
+    llvm::Type *slice_t = VectorType::get(llvm_type_of(t.element_of()), gather_lanes);
+    Value *src = UndefValue::get(slice_t);
+    Value *mask = Constant::getAllOnesValue(slice_t);
+    Value *scale = ConstantInt::get(i8, t.bytes());
+    Value *base_i8 = builder->CreatePointerCast(base, i8->getPointerTo());
+
+    llvm::Function *fn = module->getFunction(intrin);
+    if (!fn) {
+        vector<llvm::Type *> arg_types = {slice_t, base_i8->getType(),
+                                          VectorType::get(i32, index_lanes),
+                                          slice_t, i8};
+        FunctionType *fn_t = FunctionType::get(slice_t, arg_types, false);
+        fn = llvm::Function::Create(fn_t, llvm::Function::ExternalLinkage, intrin, module.get());
+    }
+
+    vector<Value *> results;
+    for (int i = 0; i < t.lanes(); i += gather_lanes) {
+        // Any extra indices in the 128-bit 64-bit gather are ignored.
+        Value *index_slice = slice_vector(index, i, index_lanes);
+        Value *args[] = {src, base_i8, index_slice, mask, scale};
+        CallInst *gather = builder->CreateCall(fn, args);
+        add_tbaa_metadata(gather, op->name, op->index);
+        results.push_back(gather);
+    }
+    return concat_vectors(results);
+}
+
 void CodeGen_X86::visit(const Cast *op) {
 
     if (!op->type.is_vector()) {
@@ -273,6 +579,22 @@ void CodeGen_X86::visit(const Cast *op) {
         return;
     }
 
+    #if LLVM_VERSION >= 35
+    if (target.has_feature(Target::F16C)) {
+        // Use the F16C conversions between vectors of float16 and
+        // float32, which llvm would otherwise scalarize.
+        Type src = op->value.type();
+        if (op->type == Float(32, op->type.lanes()) && src == Float(16, src.lanes())) {
+            value = call_intrin(op->type, 8, "llvm.x86.vcvtph2ps.256", {op->value});
+            return;
+        } else if (op->type == Float(16, op->type.lanes()) && src == Float(32, src.lanes())) {
+            // Round to nearest even.
+            value = call_intrin(op->type, 8, "llvm.x86.vcvtps2ph.256", {op->value, Expr(0)});
+            return;
+        }
+    }
+    #endif
+
     vector<Expr> matches;
 
     struct Pattern {
@@ -623,6 +945,16 @@ string CodeGen_X86::mattrs() const {
         features += separator + "+f16c";
         separator = ",";
     }
+    if (target.has_feature(Target::AVX2)) {
+        features += separator + "+avx2";
+        separator = ",";
+    }
+    #endif
+    #if LLVM_VERSION >= 70
+    if (target.has_feature(Target::AVX512_VNNI)) {
+        features += separator + "+avx512f,+avx512bw,+avx512vl,+avx512vnni";
+        separator = ",";
+    }
     #endif
     return features;
 }
@@ -46,7 +46,25 @@ protected:
     void visit(const EQ *);
     void visit(const NE *);
     void visit(const Select *);
+    void visit(const Call *);
+    void visit(const Load *);
     // @}
+
+    /** Lookups into small tables of bytes can be done with pshufb
+     * instead of a gather. Returns NULL if the load isn't from a small
+     * enough internal allocation. */
+    llvm::Value *codegen_table_lookup(const Load *op);
+
+    /** Generate an AVX2 gather instruction for a load
+     * with arbitrary indices of 32 or 64-bit values. Returns NULL if
+     * the target or type is unsuitable. */
+    llvm::Value *codegen_gather(const Load *op);
+
+    /** Generate a widening dot-product instruction (e.g. pmaddwd)
+     * for a vector_reduce_add of a product of narrow integers, adding
+     * the accumulator if it's defined. Returns NULL if there's no
+     * suitable instruction. */
+    llvm::Value *codegen_dot_product(const Call *op, Expr accumulator);
 };
 
 }}
@@ -0,0 +1,365 @@
+#include "ComputeWith.h"
+#include "FindCalls.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Debug.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+using std::map;
+
+namespace {
+
+// A LetStmt or AssertStmt that precedes a for loop in a stage's loop
+// nest.
+struct Container {
+    string name;
+    Expr value;
+    Stmt assertion;
+};
+
+// Strip off the lets and asserts that precede the next for loop.
+Stmt peel_containers(Stmt s, vector<Container> &containers) {
+    while (true) {
+        if (const LetStmt *let = s.as<LetStmt>()) {
+            Container c = {let->name, let->value, Stmt()};
+            containers.push_back(c);
+            s = let->body;
+        } else if (const Block *block = s.as<Block>()) {
+            if (block->first.as<AssertStmt>() && block->rest.defined()) {
+                Container c = {"", Expr(), block->first};
+                containers.push_back(c);
+                s = block->rest;
+            } else {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+    return s;
+}
+
+// Put back the lets and asserts stripped off by
+// peel_containers. Asserts only run when the stage they belong to
+// would have run.
+Stmt rewrap_containers(Stmt s, const vector<Container> &containers, Expr condition) {
+    for (size_t i = containers.size(); i > 0; i--) {
+        const Container &c = containers[i-1];
+        if (c.assertion.defined()) {
+            Stmt check = c.assertion;
+            if (condition.defined()) {
+                check = IfThenElse::make(condition, check);
+            }
+            s = Block::make(check, s);
+        } else {
+            s = LetStmt::make(c.name, c.value, s);
+        }
+    }
+    return s;
+}
+
+Expr and_condition(Expr a, Expr b) {
+    return a.defined() ? (a && b) : b;
+}
+
+Stmt guard(Stmt s, Expr condition) {
+    return condition.defined() ? IfThenElse::make(condition, s) : s;
+}
+
+// The loop nest of a single stage of a function, and the condition
+// (injected by skip_stages) under which it runs, if any.
+struct StageNest {
+    Stmt body;
+    Expr condition;
+};
+
+// Break the produce or update section of a ProducerConsumer node
+// into the loop nests of its stages.
+void add_stage_nests(Stmt s, vector<StageNest> &stages) {
+    Expr condition;
+    if (const IfThenElse *op = s.as<IfThenElse>()) {
+        if (!op->else_case.defined()) {
+            condition = op->condition;
+            s = op->then_case;
+        }
+    }
+
+    while (const Block *block = s.as<Block>()) {
+        StageNest n = {block->first, condition};
+        stages.push_back(n);
+        s = block->rest;
+    }
+    if (s.defined()) {
+        StageNest n = {s, condition};
+        stages.push_back(n);
+    }
+}
+
+// Stmt made of a list of statements in order.
+Stmt block_of(const vector<Stmt> &stmts) {
+    Stmt result;
+    for (size_t i = stmts.size(); i > 0; i--) {
+        result = result.defined() ? Block::make(stmts[i-1], result) : stmts[i-1];
+    }
+    return result;
+}
+
+class ComputeWith : public IRMutator {
+    const map<string, Function> &env;
+
+    // A stage of one function (the child) to be fused into the loops
+    // of a stage of another function (the parent).
+    struct FusedPair {
+        Function child, parent;
+        int child_stage, parent_stage;
+        string var;
+    };
+
+    // Each pair is recorded under the names of both functions.
+    map<string, FusedPair> pairs;
+
+    void add_pair(Function child, int child_stage, const FuseLoopLevel &level) {
+        map<string, Function>::const_iterator iter = env.find(level.func);
+        user_assert(iter != env.end())
+            << "Func " << child.name() << " is computed with " << level.func
+            << ", which is not used in this pipeline.\n";
+        Function parent = iter->second;
+
+        user_assert(level.stage <= (int)parent.updates().size())
+            << "Func " << child.name() << " is computed with a stage of "
+            << parent.name() << " that does not exist.\n";
+
+        user_assert(!child.has_extern_definition() && !parent.has_extern_definition())
+            << "Can't compute " << child.name() << " with " << parent.name()
+            << " because one of them is an extern stage.\n";
+
+        const LoopLevel &child_level = child.schedule().compute_level();
+        const LoopLevel &parent_level = parent.schedule().compute_level();
+        user_assert(!child_level.is_inline() &&
+                    child_level.func == parent_level.func &&
+                    child_level.var == parent_level.var)
+            << "Can't compute " << child.name() << " with " << parent.name()
+            << " because they are not computed at the same loop level.\n";
+
+        user_assert(!pairs.count(child.name()) && !pairs.count(parent.name()))
+            << "Can't compute " << child.name() << " with " << parent.name()
+            << " because one of them is already computed with another Func.\n";
+
+        FusedPair p = {child, parent, child_stage, level.stage, level.var};
+        pairs[child.name()] = p;
+        pairs[parent.name()] = p;
+    }
+
+    // Find how many loops of a stage's loop nest, from the outermost
+    // in, are to be fused.
+    int fused_depth(Stmt s, const string &var, const FusedPair &p) {
+        int depth = 0;
+        while (true) {
+            vector<Container> ignored;
+            s = peel_containers(s, ignored);
+            const For *loop = s.as<For>();
+            user_assert(loop)
+                << "Can't compute " << p.child.name() << " with " << p.parent.name()
+                << " at " << var << ", because something else is computed within "
+                << p.parent.name() << " outside of its loop over " << var << ".\n";
+            depth++;
+            if (ends_with(loop->name, "." + var)) {
+                return depth;
+            }
+            s = loop->body;
+        }
+    }
+
+    // Fuse the outermost depth loops of stage nest a into those of
+    // stage nest b. Where the bounds of the two loops differ, the
+    // fused loop covers both, and each stage is guarded by its own
+    // bounds.
+    Stmt fuse_loops(Stmt a, Stmt b, Expr cond_a, Expr cond_b, int depth, const FusedPair &p) {
+        if (depth == 0) {
+            return Block::make(guard(b, cond_b), guard(a, cond_a));
+        }
+
+        vector<Container> containers_a, containers_b;
+        a = peel_containers(a, containers_a);
+        b = peel_containers(b, containers_b);
+
+        const For *loop_a = a.as<For>();
+        const For *loop_b = b.as<For>();
+        user_assert(loop_a && loop_b)
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << " at " << p.var << ", because their loop nests have different structures.\n";
+        user_assert(loop_a->for_type == loop_b->for_type)
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << " at " << p.var << ", because the loops over " << loop_a->name
+            << " and " << loop_b->name << " have different types.\n";
+        user_assert(loop_a->device_api == loop_b->device_api &&
+                    (loop_b->device_api == DeviceAPI::Parent ||
+                     loop_b->device_api == DeviceAPI::Host))
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << " at " << p.var << ", because the loops over " << loop_a->name
+            << " and " << loop_b->name << " are not both host loops.\n";
+
+        Expr min = loop_b->min, extent = loop_b->extent;
+        Expr inner_cond_a = cond_a, inner_cond_b = cond_b;
+        if (!equal(loop_a->min, loop_b->min) || !equal(loop_a->extent, loop_b->extent)) {
+            Expr var = Variable::make(Int(32), loop_b->name);
+            Expr end_a = loop_a->min + loop_a->extent;
+            Expr end_b = loop_b->min + loop_b->extent;
+            min = Min::make(loop_a->min, loop_b->min);
+            extent = Max::make(end_a, end_b) - min;
+            inner_cond_a = and_condition(cond_a, var >= loop_a->min && var < end_a);
+            inner_cond_b = and_condition(cond_b, var >= loop_b->min && var < end_b);
+        }
+
+        Stmt body = fuse_loops(loop_a->body, loop_b->body, inner_cond_a, inner_cond_b, depth - 1, p);
+        body = LetStmt::make(loop_a->name, Variable::make(Int(32), loop_b->name), body);
+
+        Stmt result = For::make(loop_b->name, min, extent, loop_b->for_type, loop_b->device_api, body);
+        result = rewrap_containers(result, containers_a, cond_a);
+        result = rewrap_containers(result, containers_b, cond_b);
+        return result;
+    }
+
+    using IRMutator::visit;
+
+    void visit(const ProducerConsumer *op) {
+        map<string, FusedPair>::iterator iter = pairs.find(op->name);
+        if (iter == pairs.end()) {
+            IRMutator::visit(op);
+            return;
+        }
+        const FusedPair &p = iter->second;
+
+        bool outer_is_child = (op->name == p.child.name());
+        Function outer = outer_is_child ? p.child : p.parent;
+        Function inner = outer_is_child ? p.parent : p.child;
+
+        // The production of the other function must come right after
+        // this one, perhaps inside some lets and its realization.
+        vector<Stmt> wrappers;
+        Stmt s = op->consume;
+        while (true) {
+            if (const LetStmt *let = s.as<LetStmt>()) {
+                wrappers.push_back(s);
+                s = let->body;
+            } else if (const Realize *realize = s.as<Realize>()) {
+                wrappers.push_back(s);
+                s = realize->body;
+            } else {
+                break;
+            }
+        }
+        const ProducerConsumer *inner_op = s.as<ProducerConsumer>();
+        user_assert(inner_op && inner_op->name == inner.name())
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << ", because " << (inner_op ? inner_op->name : string("something else"))
+            << " is computed between them.\n";
+
+        user_assert(!find_transitive_calls(inner).count(outer.name()))
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << ", because " << inner.name() << " depends on " << outer.name() << ".\n";
+
+        debug(3) << "Fusing " << p.child.name() << " stage " << p.child_stage
+                 << " into " << p.parent.name() << " stage " << p.parent_stage
+                 << " at " << p.var << "\n";
+
+        vector<StageNest> outer_stages, inner_stages;
+        add_stage_nests(mutate(op->produce), outer_stages);
+        if (op->update.defined()) {
+            add_stage_nests(mutate(op->update), outer_stages);
+        }
+        add_stage_nests(mutate(inner_op->produce), inner_stages);
+        if (inner_op->update.defined()) {
+            add_stage_nests(mutate(inner_op->update), inner_stages);
+        }
+        user_assert(outer_stages.size() == outer.updates().size() + 1 &&
+                    inner_stages.size() == inner.updates().size() + 1)
+            << "Can't compute " << p.child.name() << " with " << p.parent.name()
+            << ", because their stages could not be told apart.\n";
+
+        int outer_idx = outer_is_child ? p.child_stage : p.parent_stage;
+        int inner_idx = outer_is_child ? p.parent_stage : p.child_stage;
+        const StageNest &child_nest = outer_is_child ? outer_stages[outer_idx] : inner_stages[inner_idx];
+        const StageNest &parent_nest = outer_is_child ? inner_stages[inner_idx] : outer_stages[outer_idx];
+
+        int depth = fused_depth(parent_nest.body, p.var, p);
+        Stmt fused = fuse_loops(child_nest.body, parent_nest.body,
+                                child_nest.condition, parent_nest.condition, depth, p);
+
+        // The two functions don't depend on each other, so the stages
+        // before the fused pair can all run first, and the stages
+        // after it can all run afterwards.
+        vector<Stmt> stages;
+        for (int i = 0; i < outer_idx; i++) {
+            stages.push_back(guard(outer_stages[i].body, outer_stages[i].condition));
+        }
+        for (int i = 0; i < inner_idx; i++) {
+            stages.push_back(guard(inner_stages[i].body, inner_stages[i].condition));
+        }
+        stages.push_back(fused);
+        for (size_t i = outer_idx + 1; i < outer_stages.size(); i++) {
+            stages.push_back(guard(outer_stages[i].body, outer_stages[i].condition));
+        }
+        for (size_t i = inner_idx + 1; i < inner_stages.size(); i++) {
+            stages.push_back(guard(inner_stages[i].body, inner_stages[i].condition));
+        }
+
+        Stmt consume = mutate(inner_op->consume);
+        Stmt result = ProducerConsumer::make(inner.name(), Evaluate::make(0), Stmt(), consume);
+        result = ProducerConsumer::make(outer.name(), block_of(stages), Stmt(), result);
+
+        // Lift the lets and the realization of the inner function
+        // outside of the fused production.
+        for (size_t i = wrappers.size(); i > 0; i--) {
+            if (const LetStmt *let = wrappers[i-1].as<LetStmt>()) {
+                result = LetStmt::make(let->name, let->value, result);
+            } else {
+                const Realize *realize = wrappers[i-1].as<Realize>();
+                internal_assert(realize);
+                result = Realize::make(realize->name, realize->types, realize->bounds,
+                                       realize->condition, result);
+            }
+        }
+
+        stmt = result;
+    }
+
+public:
+    ComputeWith(const map<string, Function> &e) : env(e) {
+        for (map<string, Function>::const_iterator i = env.begin(); i != env.end(); ++i) {
+            const Function &f = i->second;
+            if (f.schedule().fuse_level().defined()) {
+                add_pair(f, 0, f.schedule().fuse_level());
+            }
+            for (size_t j = 0; j < f.updates().size(); j++) {
+                const FuseLoopLevel &level = f.updates()[j].schedule.fuse_level();
+                if (level.defined()) {
+                    add_pair(f, (int)j + 1, level);
+                }
+            }
+        }
+    }
+
+    bool any_fused() const {
+        return !pairs.empty();
+    }
+};
+
+}
+
+Stmt fuse_compute_with(Stmt s, const map<string, Function> &env) {
+    ComputeWith fuser(env);
+    if (!fuser.any_fused()) {
+        return s;
+    }
+    return fuser.mutate(s);
+}
+
+}
+}
@@ -0,0 +1,30 @@
+#ifndef HALIDE_COMPUTE_WITH_H
+#define HALIDE_COMPUTE_WITH_H
+
+/** \file
+ * Defines the lowering pass that fuses the loop nests of stages
+ * scheduled with compute_with.
+ */
+
+#include <map>
+
+#include "IR.h"
+#include "Function.h"
+
+namespace Halide {
+namespace Internal {
+
+/** For each stage scheduled with Func::compute_with, merge its loop
+ * nest into the loop nest of the stage it's computed with, down to
+ * the requested loop level. The two productions must be adjacent in
+ * the statement, which is the case when both functions are computed
+ * at the same loop level and nothing else is computed between
+ * them. Should be run after bounds inference, sliding window, and
+ * storage folding have dealt with each function separately, and
+ * before storage flattening. */
+Stmt fuse_compute_with(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
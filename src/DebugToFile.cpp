@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include <map>
 #include <vector>
 #include <sstream>
@@ -19,6 +21,55 @@ class DebugToFile : public IRMutator {
 
     using IRMutator::visit;
 
+    // Whether the plain halide_debug_to_file can write this Func, or
+    // it needs halide_debug_to_file_region, which can append frames.
+    bool needs_options(Function f) {
+        const DebugToFileOptions &options = f.debug_file_options();
+        string file = f.debug_file();
+        std::transform(file.begin(), file.end(), file.begin(), ::tolower);
+        return (!options.region.empty() || options.every != 1 || options.async ||
+                ends_with(file, ".npy") || ends_with(file, ".raw"));
+    }
+
+    Expr debug_to_file_region(Function f, const Realize *op, int type_code) {
+        const DebugToFileOptions &options = f.debug_file_options();
+
+        user_assert(op->bounds.size() <= 4)
+            << "debug_to_file with options for Func " << f.name()
+            << " only handles Funcs with up to four dimensions\n";
+        user_assert(f.storage_blocks().empty())
+            << "debug_to_file with options for Func " << f.name()
+            << " can't be used with blocked storage\n";
+
+        vector<Expr> args;
+        args.push_back(f.name());
+        args.push_back(f.debug_file());
+        args.push_back(type_code);
+        // Referring to the buffer also tells later passes that the
+        // data is needed on the host.
+        args.push_back(Variable::make(Handle(), f.name() + ".buffer"));
+        args.push_back((int)op->bounds.size());
+        for (size_t i = 0; i < 4; i++) {
+            if (i < options.region.size()) {
+                args.push_back(cast<int>(options.region[i].first));
+                args.push_back(cast<int>(options.region[i].second));
+            } else if (i < op->bounds.size()) {
+                args.push_back(op->bounds[i].min);
+                args.push_back(op->bounds[i].extent);
+            } else {
+                args.push_back(0);
+                args.push_back(1);
+            }
+        }
+        args.push_back(options.every);
+        args.push_back(options.async ? 1 : 0);
+        if (options.async) {
+            any_async = true;
+        }
+
+        return Call::make(Int(32), "halide_debug_to_file_region", args, Call::Extern);
+    }
+
     void visit(const Realize *op) {
         map<string, Function>::const_iterator iter = env.find(op->name);
         if (iter != env.end() && !iter->second.debug_file().empty()) {
@@ -78,10 +129,14 @@ class DebugToFile : public IRMutator {
             } else {
                 user_error << "Type " << t << " not supported for debug_to_file\n";
             }
-            args.push_back(type_code);
-            args.push_back(t.bytes());
-
-            Expr call = Call::make(Int(32), Call::debug_to_file, args, Call::Intrinsic);
+            Expr call;
+            if (needs_options(f)) {
+                call = debug_to_file_region(f, op, type_code);
+            } else {
+                args.push_back(type_code);
+                args.push_back(t.bytes());
+                call = Call::make(Int(32), Call::debug_to_file, args, Call::Intrinsic);
+            }
             string call_result_name = unique_name("debug_to_file_result");
             Expr call_result_var = Variable::make(Int(32), call_result_name);
             Stmt body = AssertStmt::make(call_result_var == 0,
@@ -99,7 +154,10 @@ class DebugToFile : public IRMutator {
     }
 
 public:
-    DebugToFile(const map<string, Function> &e) : env(e) {}
+    // Whether any Func is written asynchronously.
+    bool any_async;
+
+    DebugToFile(const map<string, Function> &e) : env(e), any_async(false) {}
 };
 
 Stmt debug_to_file(Stmt s, const vector<Function> &outputs, const map<string, Function> &env) {
@@ -114,7 +172,8 @@ Stmt debug_to_file(Stmt s, const vector<Function> &outputs, const map<string, Fu
         }
         s = Realize::make(out.name(), out.output_types(), output_bounds, const_true(), s);
     }
-    s = DebugToFile(env).mutate(s);
+    DebugToFile injector(env);
+    s = injector.mutate(s);
 
     // Remove the realize node we wrapped around the output
     for (Function out : outputs) {
@@ -129,6 +188,17 @@ Stmt debug_to_file(Stmt s, const vector<Function> &outputs, const map<string, Fu
         }
     }
 
+    // Finish any asynchronous writes before the pipeline returns. The
+    // writer thread has already reported any errors.
+    if (injector.any_async) {
+        Expr call = Call::make(Int(32), "halide_debug_to_file_wait", {}, Call::Extern);
+        string call_result_name = unique_name("debug_to_file_wait_result");
+        Expr call_result_var = Variable::make(Int(32), call_result_name);
+        Stmt wait = LetStmt::make(call_result_name, call,
+                                  AssertStmt::make(call_result_var == 0, call_result_var));
+        s = Block::make(s, wait);
+    }
+
     return s;
 }
 
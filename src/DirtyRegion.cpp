@@ -0,0 +1,320 @@
+#include "DirtyRegion.h"
+#include "Bounds.h"
+#include "Debug.h"
+#include "ExprUsesVar.h"
+#include "FindCalls.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "RealizationOrder.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Replace references to scalar params and to the dimensions of
+// bound buffers with their current values.
+class BindParameters : public IRMutator {
+    using IRMutator::visit;
+
+    Expr buffer_property(const Buffer &b, const string &prefix, const string &name) {
+        for (int d = 0; d < b.dimensions(); d++) {
+            string dim = std::to_string(d);
+            if (name == prefix + ".min." + dim) {
+                return b.min(d);
+            } else if (name == prefix + ".extent." + dim) {
+                return b.extent(d);
+            } else if (name == prefix + ".stride." + dim) {
+                return b.stride(d);
+            }
+        }
+        return Expr();
+    }
+
+    void visit(const Variable *op) {
+        Expr value;
+        if (op->param.defined() && !op->param.is_buffer()) {
+            value = op->param.get_scalar_expr();
+        } else if (op->param.defined() && op->param.get_buffer().defined()) {
+            value = buffer_property(op->param.get_buffer(), op->param.name(), op->name);
+        } else if (op->image.defined()) {
+            value = buffer_property(op->image, op->image.name(), op->name);
+        }
+        if (value.defined() && value.type() == op->type) {
+            expr = value;
+        } else {
+            expr = op;
+        }
+    }
+};
+
+// Check that an expression never decreases as the given variable
+// increases. Only recognizes the forms that bounds inference
+// produces for stencils and clamped boundary conditions.
+bool nondecreasing(Expr e, const string &var) {
+    if (!expr_uses_var(e, var)) {
+        return true;
+    } else if (e.as<Variable>()) {
+        return true;
+    } else if (const Add *op = e.as<Add>()) {
+        return nondecreasing(op->a, var) && nondecreasing(op->b, var);
+    } else if (const Sub *op = e.as<Sub>()) {
+        return nondecreasing(op->a, var) && !expr_uses_var(op->b, var);
+    } else if (const Mul *op = e.as<Mul>()) {
+        return ((nondecreasing(op->a, var) && is_positive_const(op->b)) ||
+                (nondecreasing(op->b, var) && is_positive_const(op->a)));
+    } else if (const Div *op = e.as<Div>()) {
+        return nondecreasing(op->a, var) && is_positive_const(op->b);
+    } else if (const Min *op = e.as<Min>()) {
+        return nondecreasing(op->a, var) && nondecreasing(op->b, var);
+    } else if (const Max *op = e.as<Max>()) {
+        return nondecreasing(op->a, var) && nondecreasing(op->b, var);
+    }
+    return false;
+}
+
+bool evaluate(Expr e, const string &var, int32_t value, int64_t &result) {
+    const int64_t *c = as_const_int(simplify(substitute(var, value, e)));
+    if (c) {
+        result = *c;
+    }
+    return c != NULL;
+}
+
+// Find the first x in [lo, hi] with e(x) >= threshold, for
+// nondecreasing e. Sets result to hi + 1 if there isn't one. Returns
+// false if e can't be evaluated.
+bool first_at_least(Expr e, const string &var, int32_t lo, int32_t hi,
+                    int64_t threshold, int32_t &result) {
+    int64_t value;
+    hi++;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (!evaluate(e, var, mid, value)) {
+            return false;
+        }
+        if (value >= threshold) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    result = lo;
+    return true;
+}
+
+// Find the last x in [lo, hi] with e(x) <= threshold, for
+// nondecreasing e. Sets result to lo - 1 if there isn't one.
+bool last_at_most(Expr e, const string &var, int32_t lo, int32_t hi,
+                  int64_t threshold, int32_t &result) {
+    int64_t value;
+    lo--;
+    while (lo < hi) {
+        int32_t mid = hi - (hi - lo) / 2;
+        if (!evaluate(e, var, mid, value)) {
+            return false;
+        }
+        if (value <= threshold) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    result = lo;
+    return true;
+}
+
+bool same_bound(Expr a, Expr b) {
+    if (!a.defined() || !b.defined()) {
+        return !a.defined() && !b.defined();
+    }
+    return equal(simplify(a), simplify(b));
+}
+
+// Find the box of the input needed to compute a single point of the
+// output, given by the coordinate variables. Returns false if it
+// can't be bounded that way.
+bool input_box_required(Function output, const string &input,
+                        const vector<string> &coords, Box &input_box) {
+    map<string, Function> env = find_transitive_calls(output);
+    vector<string> order = realization_order({output}, env);
+
+    map<string, Box> required;
+    Box &output_box = required[output.name()];
+    for (const string &c : coords) {
+        Expr v = Variable::make(Int(32), c);
+        output_box.push_back(Interval(v, v));
+    }
+
+    // Walk from the output back towards the inputs.
+    for (size_t i = order.size(); i > 0; i--) {
+        Function f = env[order[i-1]];
+        map<string, Box>::iterator iter = required.find(f.name());
+        if (iter == required.end()) {
+            continue;
+        }
+        if (f.has_extern_definition()) {
+            debug(2) << "Can't see through extern stage " << f.name() << "\n";
+            return false;
+        }
+        Box box = iter->second;
+
+        Scope<Interval> scope;
+        for (size_t j = 0; j < f.args().size(); j++) {
+            scope.push(f.args()[j], box[j]);
+        }
+
+        vector<map<string, Box>> calls;
+        for (Expr v : f.values()) {
+            calls.push_back(boxes_required(v, scope));
+        }
+
+        for (const UpdateDefinition &u : f.updates()) {
+            // An update that writes anywhere other than the point
+            // being computed can move changes anywhere in the output.
+            for (size_t j = 0; j < u.args.size(); j++) {
+                const Variable *v = u.args[j].as<Variable>();
+                if (!v || v->name != f.args()[j]) {
+                    debug(2) << "Can't see through update of " << f.name() << " at " << u.args[j] << "\n";
+                    return false;
+                }
+            }
+            Scope<Interval> update_scope;
+            update_scope.set_containing_scope(&scope);
+            if (u.domain.defined()) {
+                for (const ReductionVariable &rv : u.domain.domain()) {
+                    update_scope.push(rv.var, Interval(rv.min, rv.min + rv.extent - 1));
+                }
+            }
+            for (Expr v : u.values) {
+                calls.push_back(boxes_required(v, update_scope));
+            }
+        }
+
+        for (const map<string, Box> &c : calls) {
+            for (const auto &call : c) {
+                if (call.first == f.name()) {
+                    // Updates may only read the value they're about
+                    // to replace.
+                    for (size_t j = 0; j < box.size(); j++) {
+                        if (!same_bound(call.second[j].min, box[j].min) ||
+                            !same_bound(call.second[j].max, box[j].max)) {
+                            debug(2) << "Can't see through recursive update of " << f.name() << "\n";
+                            return false;
+                        }
+                    }
+                } else if (call.first == input) {
+                    merge_boxes(input_box, call.second);
+                } else if (env.count(call.first)) {
+                    merge_boxes(required[call.first], call.second);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+void dirty_output_region(Function output, const string &input,
+                         const vector<pair<int32_t, int32_t>> &dirty,
+                         vector<pair<int32_t, int32_t>> &output_region) {
+    internal_assert(output_region.size() == output.args().size());
+
+    vector<string> coords;
+    for (const string &arg : output.args()) {
+        coords.push_back(output.name() + ".dirty." + arg);
+    }
+
+    Box input_box;
+    if (!input_box_required(output, input, coords, input_box)) {
+        return;
+    }
+
+    if (input_box.empty()) {
+        // The output doesn't depend on the input.
+        for (pair<int32_t, int32_t> &r : output_region) {
+            r.second = 0;
+        }
+        return;
+    }
+
+    user_assert(input_box.size() == dirty.size())
+        << "The dirty region of " << input << " has " << dirty.size()
+        << " dimensions, but " << input << " has " << input_box.size() << "\n";
+
+    BindParameters bind;
+    for (size_t d = 0; d < input_box.size(); d++) {
+        Expr min = input_box[d].min, max = input_box[d].max;
+        if (min.defined()) {
+            min = simplify(bind.mutate(min));
+        }
+        if (max.defined()) {
+            max = simplify(bind.mutate(max));
+        }
+        debug(3) << "Bounds of " << input << " in dimension " << d
+                 << " required by one point of " << output.name()
+                 << ": [" << min << ", " << max << "]\n";
+
+        int64_t dirty_min = dirty[d].first;
+        int64_t dirty_max = dirty_min + dirty[d].second - 1;
+
+        // Find the output coordinate this dimension depends on.
+        int k = -1;
+        bool several = false;
+        for (size_t j = 0; j < coords.size(); j++) {
+            if ((min.defined() && expr_uses_var(min, coords[j])) ||
+                (max.defined() && expr_uses_var(max, coords[j]))) {
+                several = several || k >= 0;
+                k = (int)j;
+            }
+        }
+        if (several) {
+            continue;
+        }
+
+        if (k < 0) {
+            // The same part of the input is used everywhere. Check if
+            // it's the changed part.
+            const int64_t *c_min = min.defined() ? as_const_int(min) : NULL;
+            const int64_t *c_max = max.defined() ? as_const_int(max) : NULL;
+            if ((c_max && *c_max < dirty_min) || (c_min && *c_min > dirty_max)) {
+                for (pair<int32_t, int32_t> &r : output_region) {
+                    r.second = 0;
+                }
+                return;
+            }
+            continue;
+        }
+
+        // The point x of the output reads [min(x), max(x)] of the
+        // input, so it is affected if max(x) >= dirty_min and
+        // min(x) <= dirty_max.
+        const string &c = coords[k];
+        int32_t lo = output_region[k].first;
+        int32_t hi = lo + output_region[k].second - 1;
+        int32_t new_lo = lo, new_hi = hi;
+        if (max.defined() && nondecreasing(max, c) &&
+            !first_at_least(max, c, lo, hi, dirty_min, new_lo)) {
+            new_lo = lo;
+        }
+        if (min.defined() && nondecreasing(min, c) &&
+            !last_at_most(min, c, lo, hi, dirty_max, new_hi)) {
+            new_hi = hi;
+        }
+        output_region[k].first = new_lo;
+        output_region[k].second = std::max(0, new_hi - new_lo + 1);
+    }
+}
+
+}
+}
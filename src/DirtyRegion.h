@@ -0,0 +1,39 @@
+#ifndef HALIDE_DIRTY_REGION_H
+#define HALIDE_DIRTY_REGION_H
+
+/** \file
+ * Defines an analysis that finds the region of the output of a
+ * pipeline affected by a change to a region of one of its inputs.
+ */
+
+#include <utility>
+#include <vector>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Given the output Function of a pipeline, the name of one of its
+ * input buffers, and the region of that input that has changed,
+ * narrow down the region of the output that may have changed as a
+ * result. Regions are given as (min, extent) pairs. On entry,
+ * output_region is the region of the output that has been
+ * computed. On exit, it is the part of that region that needs to be
+ * recomputed, which may be empty.
+ *
+ * Works by walking the bounds of the input required by a single
+ * point of the output back through every Func, and then inverting
+ * them. Dimensions that can't be inverted (e.g. because they depend
+ * on the values of some Func, or on several output coordinates) are
+ * left at their full extent, as is the whole output if some Func in
+ * the pipeline scatters values with an update definition or is
+ * defined externally. */
+void dirty_output_region(Function output, const std::string &input,
+                         const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                         std::vector<std::pair<int32_t, int32_t>> &output_region);
+
+}
+}
+
+#endif
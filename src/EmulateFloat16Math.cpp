@@ -0,0 +1,285 @@
+#include "EmulateFloat16Math.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+bool is_float16(Type t) {
+    return t.is_float() && !t.is_bfloat() && t.bits() == 16;
+}
+
+bool is_bfloat16(Type t) {
+    return t.is_bfloat() && t.bits() == 16;
+}
+
+// Convert float16 to float32 using integer arithmetic and a
+// multiply. This is exact.
+Expr float16_to_float32(Expr e) {
+    int lanes = e.type().lanes();
+    Type u32 = UInt(32, lanes), f32 = Float(32, lanes);
+    Expr bits = cast(u32, reinterpret(UInt(16, lanes), e));
+    Expr sign = (bits & make_const(u32, 0x8000)) << make_const(u32, 16);
+    Expr exp_and_mantissa = bits & make_const(u32, 0x7fff);
+    Expr shifted = exp_and_mantissa << make_const(u32, 13);
+
+    // Finite values, including denormals, have the exponent and
+    // mantissa in the right place, but the wrong exponent bias. Fix
+    // it by multiplying by 2^(127 - 15).
+    Expr finite = reinterpret(u32, reinterpret(f32, shifted) * make_const(f32, 5.192296858534828e33));
+
+    // Infinities and nans just need the exponent filled in.
+    Expr inf_or_nan = shifted | make_const(u32, 0x7f800000);
+    Expr is_inf_or_nan = exp_and_mantissa >= make_const(u32, 0x7c00);
+
+    return reinterpret(f32, select(is_inf_or_nan, inf_or_nan, finite) | sign);
+}
+
+// Convert float32 to float16 using integer arithmetic and an
+// add, rounding to nearest with ties to even.
+Expr float32_to_float16(Expr e) {
+    int lanes = e.type().lanes();
+    Type u32 = UInt(32, lanes), f32 = Float(32, lanes);
+    Expr bits = reinterpret(u32, e);
+    Expr sign = bits & make_const(u32, 0x80000000);
+    Expr magnitude = bits & make_const(u32, 0x7fffffff);
+
+    // Too big to represent, infinity, or nan.
+    Expr overflow = select(magnitude > make_const(u32, 0x7f800000),
+                           make_const(u32, 0x7e00), make_const(u32, 0x7c00));
+
+    // Results that are denormal or zero. Adding 0.5 aligns the
+    // mantissa so that the float32 add does the rounding.
+    const uint32_t denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+    Expr denormal = reinterpret(u32, reinterpret(f32, magnitude) +
+                                reinterpret(f32, make_const(u32, denorm_magic)));
+    denormal = denormal - make_const(u32, denorm_magic);
+
+    // Normal results. Rebias the exponent, and round the mantissa to
+    // nearest even.
+    Expr odd = (magnitude >> make_const(u32, 13)) & make_const(u32, 1);
+    Expr normal = magnitude + make_const(u32, (uint32_t)((15 - 127) << 23) + 0xfff) + odd;
+    normal = normal >> make_const(u32, 13);
+
+    Expr result = select(magnitude >= make_const(u32, (127 + 16) << 23), overflow,
+                         select(magnitude < make_const(u32, 113 << 23), denormal, normal));
+    result = result | (sign >> make_const(u32, 16));
+    return reinterpret(Float(16, lanes), cast(UInt(16, lanes), result));
+}
+
+// bfloat16 is the top half of a float32.
+Expr bfloat16_to_float32(Expr e) {
+    int lanes = e.type().lanes();
+    Type u32 = UInt(32, lanes);
+    Expr bits = cast(u32, reinterpret(UInt(16, lanes), e));
+    return reinterpret(Float(32, lanes), bits << make_const(u32, 16));
+}
+
+// Round float32 to bfloat16, to nearest with ties to even.
+Expr float32_to_bfloat16(Expr e) {
+    int lanes = e.type().lanes();
+    Type u32 = UInt(32, lanes);
+    Expr bits = reinterpret(u32, e);
+    Expr odd = (bits >> make_const(u32, 16)) & make_const(u32, 1);
+    Expr rounded = (bits + make_const(u32, 0x7fff) + odd) >> make_const(u32, 16);
+    // Keep nans quiet, and don't let rounding turn them into infinities.
+    Expr is_nan = (bits & make_const(u32, 0x7fffffff)) > make_const(u32, 0x7f800000);
+    Expr nan = (bits >> make_const(u32, 16)) | make_const(u32, 0x40);
+    return reinterpret(BFloat(16, lanes), cast(UInt(16, lanes), select(is_nan, nan, rounded)));
+}
+
+class EmulateFloat16Math : public IRMutator {
+    // False inside loops for device APIs with a native half type.
+    bool emulate_float16;
+
+    // True in host code on targets with instructions to convert
+    // between float16 and float32.
+    bool native_conversions;
+
+    bool should_emulate(Type t) {
+        return is_bfloat16(t) || (emulate_float16 && is_float16(t));
+    }
+
+    // Convert a 16-bit float to float32.
+    Expr widen(Expr e) {
+        Type f32 = Float(32, e.type().lanes());
+        if (const double *f = as_const_float(e)) {
+            return make_const(f32, *f);
+        } else if (e.type().is_bfloat()) {
+            return bfloat16_to_float32(e);
+        } else if (native_conversions) {
+            return Cast::make(f32, e);
+        } else {
+            return float16_to_float32(e);
+        }
+    }
+
+    // Convert a float32 to a 16-bit float type.
+    Expr narrow(Type t, Expr e) {
+        internal_assert(e.type() == Float(32, t.lanes()));
+        if (const double *f = as_const_float(e)) {
+            return make_const(t, *f);
+        } else if (t.is_bfloat()) {
+            return float32_to_bfloat16(e);
+        } else if (native_conversions) {
+            return Cast::make(t, e);
+        } else {
+            return float32_to_float16(e);
+        }
+    }
+
+    template<typename T>
+    void visit_binary_operator(const T *op) {
+        Expr a = mutate(op->a), b = mutate(op->b);
+        if (should_emulate(op->a.type())) {
+            expr = T::make(widen(a), widen(b));
+            if (op->type == op->a.type()) {
+                expr = narrow(op->type, expr);
+            }
+        } else if (a.same_as(op->a) && b.same_as(op->b)) {
+            expr = op;
+        } else {
+            expr = T::make(a, b);
+        }
+    }
+
+    using IRMutator::visit;
+
+    void visit(const Add *op) {visit_binary_operator(op);}
+    void visit(const Sub *op) {visit_binary_operator(op);}
+    void visit(const Mul *op) {visit_binary_operator(op);}
+    void visit(const Div *op) {visit_binary_operator(op);}
+    void visit(const Mod *op) {visit_binary_operator(op);}
+    void visit(const Min *op) {visit_binary_operator(op);}
+    void visit(const Max *op) {visit_binary_operator(op);}
+    void visit(const EQ *op) {visit_binary_operator(op);}
+    void visit(const NE *op) {visit_binary_operator(op);}
+    void visit(const LT *op) {visit_binary_operator(op);}
+    void visit(const LE *op) {visit_binary_operator(op);}
+    void visit(const GT *op) {visit_binary_operator(op);}
+    void visit(const GE *op) {visit_binary_operator(op);}
+
+    void visit(const Cast *op) {
+        Expr value = mutate(op->value);
+        Type src = value.type(), dst = op->type;
+        if (should_emulate(src)) {
+            // Everything goes via float32, which can represent all
+            // float16 and bfloat16 values exactly.
+            expr = widen(value);
+            if (should_emulate(dst)) {
+                expr = narrow(dst, expr);
+            } else if (dst != expr.type()) {
+                expr = Cast::make(dst, expr);
+            }
+        } else if (should_emulate(dst)) {
+            // Converting from types other than float32 rounds twice,
+            // so may not be correctly rounded.
+            expr = value;
+            if (src != Float(32, src.lanes())) {
+                expr = Cast::make(Float(32, src.lanes()), expr);
+            }
+            expr = narrow(dst, expr);
+        } else if (value.same_as(op->value)) {
+            expr = op;
+        } else {
+            expr = Cast::make(dst, value);
+        }
+    }
+
+    void visit(const Ramp *op) {
+        if (should_emulate(op->type)) {
+            Expr base = widen(mutate(op->base));
+            Expr stride = widen(mutate(op->stride));
+            expr = narrow(op->type, Ramp::make(base, stride, op->lanes));
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+    void visit(const Call *op) {
+        bool any_emulated = should_emulate(op->type);
+        for (Expr e : op->args) {
+            any_emulated = any_emulated || should_emulate(e.type());
+        }
+        if (!any_emulated) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        vector<Expr> args(op->args.size());
+        for (size_t i = 0; i < op->args.size(); i++) {
+            args[i] = mutate(op->args[i]);
+        }
+
+        if (op->call_type == Call::Intrinsic && op->name == Call::abs) {
+            // Clear the sign bit.
+            Type u16 = UInt(16, op->type.lanes());
+            expr = reinterpret(op->type, reinterpret(u16, args[0]) & make_const(u16, 0x7fff));
+        } else if ((op->call_type == Call::Intrinsic &&
+                    (op->name == Call::absd || op->name == Call::lerp ||
+                     op->name == Call::stringify ||
+                     op->name == Call::vector_reduce_add ||
+                     op->name == Call::vector_reduce_mul ||
+                     op->name == Call::vector_reduce_min ||
+                     op->name == Call::vector_reduce_max)) ||
+                   (op->call_type == Call::Extern && ends_with(op->name, "_f16"))) {
+            // Do the math in float32. Horizontal reductions are only
+            // rounded once, at the end.
+            for (Expr &e : args) {
+                if (should_emulate(e.type())) {
+                    e = widen(e);
+                }
+            }
+            string name = op->name;
+            if (op->call_type == Call::Extern) {
+                name = name.substr(0, name.size() - 4) + "_f32";
+            }
+            Type t = should_emulate(op->type) ? Float(32, op->type.lanes()) : op->type;
+            expr = Call::make(t, name, args, op->call_type);
+            if (t != op->type) {
+                expr = narrow(op->type, expr);
+            }
+        } else {
+            // Other calls just move the bits around.
+            expr = Call::make(op->type, op->name, args, op->call_type,
+                              op->func, op->value_index, op->image, op->param);
+        }
+    }
+
+    void visit(const For *op) {
+        bool old_emulate_float16 = emulate_float16;
+        bool old_native_conversions = native_conversions;
+        if (op->device_api != DeviceAPI::Host &&
+            op->device_api != DeviceAPI::Parent) {
+            emulate_float16 = (op->device_api != DeviceAPI::OpenCL &&
+                               op->device_api != DeviceAPI::Metal);
+            native_conversions = false;
+        }
+        IRMutator::visit(op);
+        emulate_float16 = old_emulate_float16;
+        native_conversions = old_native_conversions;
+    }
+
+public:
+    EmulateFloat16Math(const Target &t) : emulate_float16(true) {
+        // The conversions are part of the base 64-bit ARM ISA.
+        native_conversions = (!t.has_feature(Target::SoftFloat16) &&
+                              ((t.arch == Target::X86 && t.has_feature(Target::F16C)) ||
+                               (t.arch == Target::ARM && t.bits == 64)));
+    }
+};
+
+}
+
+Stmt emulate_float16_math(Stmt s, const Target &t) {
+    return EmulateFloat16Math(t).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,31 @@
+#ifndef HALIDE_EMULATE_FLOAT16_MATH_H
+#define HALIDE_EMULATE_FLOAT16_MATH_H
+
+/** \file
+ * Defines the lowering pass that implements arithmetic on 16-bit
+ * floating point types using 32-bit floats.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite arithmetic on float16 and bfloat16 values to convert to
+ * float32, do the arithmetic, and convert back. After this pass,
+ * 16-bit floats are only loaded, stored, selected between, and
+ * converted, so the backends can represent them by their bits.
+ *
+ * Conversions to and from bfloat16 are always done with integer bit
+ * manipulation. Conversions to and from float16 use the hardware
+ * instructions on targets that have them (F16C on x86, and all 64-bit
+ * ARM), and bit manipulation otherwise, or if the target has the
+ * SoftFloat16 feature. Loops for OpenCL and Metal, which have a
+ * native half type, keep their float16 math. */
+Stmt emulate_float16_math(Stmt s, const Target &t);
+
+}
+}
+
+#endif
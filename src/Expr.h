@@ -181,7 +181,11 @@ struct FloatImm : public ExprNode<FloatImm> {
         node->type = t;
         switch (t.bits()) {
         case 16:
-            node->value = (double)((float16_t)value);
+            if (t.is_bfloat()) {
+                node->value = (double)((bfloat16_t)value);
+            } else {
+                node->value = (double)((float16_t)value);
+            }
             break;
         case 32:
             node->value = (float)value;
@@ -233,6 +237,7 @@ struct Expr : public Internal::IRHandle {
     EXPORT explicit Expr(uint32_t x)  : IRHandle(Internal::UIntImm::make(UInt(32), x)) {}
     EXPORT explicit Expr(uint64_t x)  : IRHandle(Internal::UIntImm::make(UInt(64), x)) {}
     EXPORT          Expr(float16_t x) : IRHandle(Internal::FloatImm::make(Float(16), (double)x)) {}
+    EXPORT          Expr(bfloat16_t x) : IRHandle(Internal::FloatImm::make(BFloat(16), (double)x)) {}
     EXPORT          Expr(float x)     : IRHandle(Internal::FloatImm::make(Float(32), x)) {}
     EXPORT explicit Expr(double x)    : IRHandle(Internal::FloatImm::make(Float(64), x)) {}
     // @}
@@ -268,6 +273,16 @@ enum class DeviceAPI {
     Metal
 };
 
+/** An enum describing where the storage for a Func should live. Used
+ * by schedules (see \ref Func::store_in), and in the Allocate IR
+ * node. */
+enum class MemoryType {
+    Auto, /// Let the code generator decide, based on the size of the allocation
+    Heap, /// Always allocate with halide_malloc
+    Stack, /// Allocate on the stack, even if the size isn't constant
+    Register /// Keep each element in a register. Requires a constant size and all accesses at constant indices (i.e. fully unrolled)
+};
+
 namespace Internal {
 
 /** An enum describing a type of loop traversal. Used in schedules,
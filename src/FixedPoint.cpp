@@ -0,0 +1,98 @@
+#include "FixedPoint.h"
+#include "IROperator.h"
+
+namespace Halide {
+namespace Internal {
+
+bool is_fixed_point_intrinsic(const Call *op) {
+    return (op->call_type == Call::Intrinsic &&
+            (op->name == Call::saturating_add ||
+             op->name == Call::saturating_sub ||
+             op->name == Call::halving_add ||
+             op->name == Call::rounding_halving_add ||
+             op->name == Call::mul_hi ||
+             op->name == Call::rounding_shift_right));
+}
+
+namespace {
+
+// Saturating add and subtract, and the halving adds, on 64-bit
+// integers, where there's no wider type to do the math in.
+Expr lower_64_bit(const Call *op, Expr a, Expr b) {
+    Type t = op->type;
+    Type ut = t.with_code(Type::UInt);
+    Expr one = make_one(t);
+
+    if (op->name == Call::halving_add) {
+        return (a >> one) + (b >> one) + (a & b & one);
+    } else if (op->name == Call::rounding_halving_add) {
+        return (a >> one) + (b >> one) + ((a | b) & one);
+    } else if (t.is_uint()) {
+        if (op->name == Call::saturating_add) {
+            Expr sum = a + b;
+            return select(sum < a, t.max(), sum);
+        } else {
+            return select(a > b, a - b, make_zero(t));
+        }
+    } else {
+        // Do the math with wrap-around, and check the sign bits for
+        // overflow.
+        Expr result, overflow;
+        if (op->name == Call::saturating_add) {
+            result = cast(t, cast(ut, a) + cast(ut, b));
+            overflow = ((a ^ result) & (b ^ result)) < make_zero(t);
+        } else {
+            result = cast(t, cast(ut, a) - cast(ut, b));
+            overflow = ((a ^ b) & (a ^ result)) < make_zero(t);
+        }
+        return select(overflow, select(a < make_zero(t), t.min(), t.max()), result);
+    }
+}
+
+}
+
+Expr lower_fixed_point_intrinsic(const Call *op) {
+    internal_assert(is_fixed_point_intrinsic(op) && op->args.size() == 2);
+    Type t = op->type;
+    Expr a = op->args[0], b = op->args[1];
+    internal_assert((t.is_int() || t.is_uint()) && a.type() == t && b.type() == t);
+
+    if (op->name == Call::rounding_shift_right) {
+        // Add back the last bit shifted out. Clamp the shift used for
+        // that so that it stays in range when b is zero.
+        Expr one = make_one(t);
+        Expr last_bit = (a >> (max(b, one) - one)) & one;
+        return select(b > make_zero(t), (a >> b) + last_bit, a);
+    }
+
+    int bits = t.bits();
+    if (bits == 64) {
+        internal_assert(op->name != Call::mul_hi) << "mul_hi of 64-bit integers\n";
+        return lower_64_bit(op, a, b);
+    }
+
+    // Everything else can be done exactly in a type twice as wide. Use
+    // a signed wide type for subtraction, so the result can go
+    // negative.
+    Type wide = t.with_bits(bits * 2);
+    if (op->name == Call::saturating_sub) {
+        wide = wide.with_code(Type::Int);
+    }
+    Expr wa = cast(wide, a), wb = cast(wide, b);
+
+    if (op->name == Call::saturating_add) {
+        return saturating_cast(t, wa + wb);
+    } else if (op->name == Call::saturating_sub) {
+        return saturating_cast(t, wa - wb);
+    } else if (op->name == Call::halving_add) {
+        return cast(t, (wa + wb) >> make_one(wide));
+    } else if (op->name == Call::rounding_halving_add) {
+        return cast(t, (wa + wb + make_one(wide)) >> make_one(wide));
+    } else {
+        internal_assert(op->name == Call::mul_hi);
+        return cast(t, (wa * wb) >> make_const(wide, bits));
+    }
+}
+
+}
+}
@@ -0,0 +1,27 @@
+#ifndef HALIDE_FIXED_POINT_H
+#define HALIDE_FIXED_POINT_H
+
+/** \file
+ * Defines methods for converting the fixed-point arithmetic
+ * intrinsics into Halide IR.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Check if a call is one of the fixed-point intrinsics: saturating
+ * add and subtract, halving and rounding halving add, mul_hi, and
+ * rounding shift right. */
+bool is_fixed_point_intrinsic(const Call *op);
+
+/** Build Halide IR that computes a fixed-point intrinsic using
+ * ordinary integer arithmetic. Used by codegen targets that don't
+ * have an instruction for it. */
+Expr EXPORT lower_fixed_point_intrinsic(const Call *op);
+
+}
+}
+
+#endif
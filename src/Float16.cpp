@@ -1,5 +1,6 @@
 #include "Float16.h"
 #include "Error.h"
+#include <string.h>
 #include "llvm/ADT/APFloat.h"
 #include "llvm/Support/ErrorHandling.h"
 
@@ -332,3 +333,53 @@ uint16_t float16_t::to_bits() const {
 }
 
 }  // namespace halide
+
+namespace Halide {
+
+bfloat16_t::bfloat16_t(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        // Keep NaNs quiet, and don't round them to infinity.
+        data = (uint16_t)((bits >> 16) | 0x40);
+    } else {
+        // Round to nearest, ties to even.
+        bits += 0x7fff + ((bits >> 16) & 1);
+        data = (uint16_t)(bits >> 16);
+    }
+}
+
+bfloat16_t::bfloat16_t(double value) : bfloat16_t((float)value) {}
+
+bfloat16_t::bfloat16_t() : data(0) {}
+
+bfloat16_t::operator float() const {
+    uint32_t bits = (uint32_t)data << 16;
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+bfloat16_t::operator double() const {
+    return (double)(float)(*this);
+}
+
+bfloat16_t bfloat16_t::make_from_bits(uint16_t bits) {
+    bfloat16_t result;
+    result.data = bits;
+    return result;
+}
+
+bool bfloat16_t::operator==(bfloat16_t rhs) const {
+    return (float)(*this) == (float)rhs;
+}
+
+bool bfloat16_t::is_nan() const {
+    return (data & 0x7fff) > 0x7f80;
+}
+
+uint16_t bfloat16_t::to_bits() const {
+    return data;
+}
+
+}
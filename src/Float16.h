@@ -198,6 +198,57 @@ private:
     // this data type is 16-bits wide.
     uint16_t data;
 };
+
+/** Class that provides a type that implements the bfloat16 format
+ *  (the upper 16 bits of an IEEE754 binary32) in software. It has the
+ *  same exponent range as a float, and fewer bits of mantissa than
+ *  float16_t.
+ *
+ *  Like float16_t, this type maintains no state other than the raw
+ *  bits, so it can be used for buffer_t allocation.
+ * */
+struct bfloat16_t {
+    /// \name Constructors
+    /// @{
+
+    /** Construct from a float, rounding to nearest with ties to even. */
+    EXPORT explicit bfloat16_t(float value);
+
+    /** Construct from a double, rounding to nearest with ties to
+     * even. The double is first rounded to a float. */
+    EXPORT explicit bfloat16_t(double value);
+
+    /** Construct a bfloat16_t with the bits initialised to 0. This
+     * represents positive zero. */
+    EXPORT bfloat16_t();
+
+    /// @}
+
+    /** Cast to float. This is exact. */
+    EXPORT explicit operator float() const;
+    /** Cast to double. This is exact. */
+    EXPORT explicit operator double() const;
+
+    /** Get a new bfloat16_t with the given raw bits */
+    EXPORT static bfloat16_t make_from_bits(uint16_t bits);
+
+    /** \name Comparison operators
+     * These compare the values as floats, so NaN is not equal to
+     * anything. */
+    /**@{*/
+    EXPORT bool operator==(bfloat16_t rhs) const;
+    EXPORT bool operator!=(bfloat16_t rhs) const { return !(*this == rhs); }
+    /**@}*/
+
+    EXPORT bool is_nan() const;
+
+    /** Returns the bits that represent this bfloat16_t. */
+    EXPORT uint16_t to_bits() const;
+
+private:
+    // The raw bits. This must be the only data member.
+    uint16_t data;
+};
 }  // namespace Halide
 
 namespace {
@@ -207,6 +258,11 @@ struct halide_type_of_helper<Halide::float16_t> {
     operator halide_type_t() { return halide_type_t(halide_type_float, 16); }
 };
 
+template<>
+struct halide_type_of_helper<Halide::bfloat16_t> {
+    operator halide_type_t() { return halide_type_t(halide_type_bfloat, 16); }
+};
+
 }
 
 #endif
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <iostream>
 #include <string.h>
+#include <stdlib.h>
 #include <fstream>
 
 #ifdef _MSC_VER
@@ -259,7 +260,11 @@ void Stage::set_dim_type(VarOrRVar var, ForType t) {
 
             // If it's an rvar and the for type is parallel, we need to
             // validate that this doesn't introduce a race condition.
-            if (!dims[i].pure && var.is_rvar && (t == ForType::Vectorized || t == ForType::Parallel)) {
+            // Vectorizing an associative accumulation is safe: it
+            // becomes a horizontal reduction of the vector.
+            bool horizontal = (t == ForType::Vectorized) && dims[i].associative;
+            if (!dims[i].pure && !horizontal && var.is_rvar &&
+                (t == ForType::Vectorized || t == ForType::Parallel)) {
                 user_assert(schedule.allow_race_conditions())
                     << "In schedule for " << stage_name
                     << ", marking var " << var.name()
@@ -352,6 +357,7 @@ void Stage::split(const string &old, const string &outer, const string &inner, E
             dims[i].var = inner_name;
             dims[i+1].var = outer_name;
             dims[i+1].pure = dims[i].pure;
+            dims[i+1].associative = dims[i].associative;
         }
     }
 
@@ -398,12 +404,13 @@ Stage &Stage::fuse(VarOrRVar inner, VarOrRVar outer, VarOrRVar fused) {
     string inner_name, outer_name, fused_name;
     vector<Dim> &dims = schedule.dims();
 
-    bool outer_pure = false;
+    bool outer_pure = false, outer_associative = false;
     for (size_t i = 0; (!found_outer) && i < dims.size(); i++) {
         if (var_name_match(dims[i].var, outer.name())) {
             found_outer = true;
             outer_name = dims[i].var;
             outer_pure = dims[i].pure;
+            outer_associative = dims[i].associative;
             dims.erase(dims.begin() + i);
         }
     }
@@ -422,6 +429,7 @@ Stage &Stage::fuse(VarOrRVar inner, VarOrRVar outer, VarOrRVar fused) {
             fused_name = inner_name + "." + fused.name();
             dims[i].var = fused_name;
             dims[i].pure &= outer_pure;
+            dims[i].associative &= outer_associative;
         }
     }
 
@@ -545,6 +553,50 @@ Stage &Stage::allow_race_conditions() {
     return *this;
 }
 
+namespace {
+// Split a stage name of the form "f" or "f.update(2)" into the name
+// of the function and the index of the stage (0 for the pure
+// definition).
+void split_stage_name(const string &name, string &func, int &stage) {
+    size_t idx = name.rfind(".update(");
+    if (idx == string::npos || !ends_with(name, ")")) {
+        func = name;
+        stage = 0;
+    } else {
+        func = name.substr(0, idx);
+        string num = name.substr(idx + 8, name.size() - idx - 9);
+        stage = std::atoi(num.c_str()) + 1;
+    }
+}
+}
+
+Stage &Stage::compute_with(Stage s, VarOrRVar var) {
+    string func, parent_func;
+    int stage, parent_stage;
+    split_stage_name(stage_name, func, stage);
+    split_stage_name(s.stage_name, parent_func, parent_stage);
+
+    user_assert(func != parent_func)
+        << "In schedule for " << stage_name
+        << ", can't compute a stage with another stage of the same Func.\n";
+
+    bool found = false;
+    for (const Dim &d : s.schedule.dims()) {
+        if (var_name_match(d.var, var.name())) {
+            found = true;
+        }
+    }
+    user_assert(found)
+        << "In schedule for " << stage_name
+        << ", can't compute with " << s.stage_name
+        << " at " << var.name() << ", because " << s.stage_name
+        << " has no loop over " << var.name() << ".\n"
+        << s.dump_argument_list();
+
+    schedule.fuse_level() = FuseLoopLevel(parent_func, parent_stage, var.name());
+    return *this;
+}
+
 Stage &Stage::serial(VarOrRVar var) {
     set_dim_type(var, ForType::Serial);
     return *this;
@@ -577,6 +629,12 @@ Stage &Stage::parallel(VarOrRVar var, Expr factor) {
     return *this;
 }
 
+Stage &Stage::parallel_strips(VarOrRVar var, VarOrRVar strip, Expr strip_size) {
+    split(var, strip, var, strip_size);
+    parallel(strip);
+    return *this;
+}
+
 Stage &Stage::vectorize(VarOrRVar var, int factor) {
     if (var.is_rvar) {
         RVar tmp;
@@ -604,6 +662,51 @@ Stage &Stage::unroll(VarOrRVar var, int factor) {
     return *this;
 }
 
+Stage &Stage::unroll_and_jam(VarOrRVar var, VarOrRVar inner, int factor) {
+    user_assert(!var.is_rvar)
+        << "In schedule for " << stage_name
+        << ", can't unroll-and-jam RVar " << var.name()
+        << ", because it would reorder the reduction.\n";
+    user_assert(factor > 0)
+        << "In schedule for " << stage_name
+        << ", can't unroll-and-jam " << var.name()
+        << " by non-positive factor " << factor << "\n";
+
+    Var tmp;
+    split(var.var, var.var, tmp, factor);
+
+    // The inner dimension of the split is pure, so it can be moved
+    // anywhere inside the outer dimension.
+    vector<Dim> &dims = schedule.dims();
+    size_t tmp_idx = dims.size(), inner_idx = dims.size();
+    for (size_t i = 0; i < dims.size(); i++) {
+        if (var_name_match(dims[i].var, tmp.name())) {
+            tmp_idx = i;
+        } else if (var_name_match(dims[i].var, inner.name())) {
+            inner_idx = i;
+        }
+    }
+    internal_assert(tmp_idx < dims.size());
+    user_assert(inner_idx < dims.size())
+        << "In schedule for " << stage_name
+        << ", could not find dimension " << inner.name()
+        << " to unroll-and-jam into.\n"
+        << dump_argument_list();
+    user_assert(inner_idx < tmp_idx)
+        << "In schedule for " << stage_name
+        << ", can't unroll-and-jam " << var.name()
+        << " into " << inner.name()
+        << ", because " << inner.name() << " is not inside " << var.name() << ".\n"
+        << dump_argument_list();
+
+    Dim d = dims[tmp_idx];
+    dims.erase(dims.begin() + tmp_idx);
+    dims.insert(dims.begin() + inner_idx, d);
+
+    unroll(tmp);
+    return *this;
+}
+
 Stage &Stage::tile(VarOrRVar x, VarOrRVar y,
                    VarOrRVar xo, VarOrRVar yo,
                    VarOrRVar xi, VarOrRVar yi,
@@ -861,6 +964,55 @@ Func &Func::memoize() {
     return *this;
 }
 
+Func &Func::memoize(Var x, int x_extent) {
+    invalidate_cache();
+    const vector<string> &args = func.args();
+    user_assert(std::find(args.begin(), args.end(), x.name()) != args.end())
+        << "Can't memoize " << name() << " in tiles over " << x.name()
+        << " because " << x.name() << " is not one of its pure variables.\n";
+    user_assert(x_extent > 0)
+        << "Can't memoize " << name() << " in tiles of extent " << x_extent
+        << " over " << x.name() << ". The extent must be positive.\n";
+    for (const MemoizeTile &t : func.schedule().memoize_tiles()) {
+        user_assert(t.var != x.name())
+            << "Can't memoize " << name() << " in tiles over " << x.name()
+            << " twice.\n";
+    }
+    func.schedule().memoized() = true;
+    MemoizeTile tile = {x.name(), x_extent};
+    func.schedule().memoize_tiles().push_back(tile);
+    return *this;
+}
+
+Func &Func::memoize(Var x, Var y, int x_extent, int y_extent) {
+    return memoize(x, x_extent).memoize(y, y_extent);
+}
+
+Func &Func::skip_tiles(Var var, Func mask, Expr fill) {
+    invalidate_cache();
+    user_assert(mask.defined() && mask.outputs() == 1)
+        << "Can't skip tiles of " << name()
+        << " using a mask that isn't a single-valued Func.\n";
+    user_assert(mask.name() != name())
+        << "Can't skip tiles of " << name() << " using itself as the mask.\n";
+    user_assert(outputs() == 1)
+        << "Can't skip tiles of " << name() << " because it returns a Tuple.\n";
+    user_assert(fill.defined())
+        << "Can't skip tiles of " << name() << " with an undefined fill value.\n";
+
+    bool found = false;
+    for (const Dim &d : func.schedule().dims()) {
+        found = found || var_name_match(d.var, var.name());
+    }
+    user_assert(found)
+        << "Can't skip tiles of " << name() << " over " << var.name()
+        << " because " << var.name() << " is not a dimension of its pure definition.\n";
+
+    SkipTiles skip = {var.name(), mask.name(), cast(output_types()[0], fill)};
+    func.schedule().skip_tiles().push_back(skip);
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func.schedule(), name()).specialize(c);
@@ -896,6 +1048,12 @@ Func &Func::parallel(VarOrRVar var, Expr factor) {
     return *this;
 }
 
+Func &Func::parallel_strips(VarOrRVar var, VarOrRVar strip, Expr strip_size) {
+    invalidate_cache();
+    Stage(func.schedule(), name()).parallel_strips(var, strip, strip_size);
+    return *this;
+}
+
 Func &Func::vectorize(VarOrRVar var, int factor) {
     invalidate_cache();
     Stage(func.schedule(), name()).vectorize(var, factor);
@@ -908,6 +1066,12 @@ Func &Func::unroll(VarOrRVar var, int factor) {
     return *this;
 }
 
+Func &Func::unroll_and_jam(VarOrRVar var, VarOrRVar inner, int factor) {
+    invalidate_cache();
+    Stage(func.schedule(), name()).unroll_and_jam(var, inner, factor);
+    return *this;
+}
+
 Func &Func::bound(Var var, Expr min, Expr extent) {
     invalidate_cache();
     bool found = false;
@@ -1096,6 +1260,78 @@ Func &Func::reorder_storage(const std::vector<Var> &dims) {
     return reorder_storage(dims, 0);
 }
 
+Func &Func::fold_storage(Var dim, Expr extent) {
+    invalidate_cache();
+    bool found = false;
+    for (size_t i = 0; i < func.args().size(); i++) {
+        if (dim.name() == func.args()[i]) {
+            found = true;
+        }
+    }
+    user_assert(found)
+        << "Can't fold storage of function " << name()
+        << " over " << dim.name()
+        << " because " << dim.name()
+        << " is not one of the pure variables of " << name() << ".\n";
+    user_assert(extent.defined() && extent.type().is_int() && extent.type().is_scalar())
+        << "The fold factor for " << name() << "." << dim.name()
+        << " must be a scalar integer.\n";
+    if (const int64_t *e = as_const_int(extent)) {
+        user_assert(*e > 0)
+            << "The fold factor for " << name() << "." << dim.name()
+            << " must be positive.\n";
+    }
+
+    vector<FoldFactor> &folds = func.schedule().fold_factors();
+    for (size_t i = 0; i < folds.size(); i++) {
+        if (folds[i].var == dim.name()) {
+            folds[i].factor = cast<int>(extent);
+            return *this;
+        }
+    }
+    FoldFactor fold = {dim.name(), cast<int>(extent)};
+    folds.push_back(fold);
+    return *this;
+}
+
+Func &Func::split_storage(Var dim, int factor) {
+    invalidate_cache();
+    bool found = false;
+    for (size_t i = 0; i < func.args().size(); i++) {
+        if (dim.name() == func.args()[i]) {
+            found = true;
+        }
+    }
+    user_assert(found)
+        << "Can't split storage of function " << name()
+        << " over " << dim.name()
+        << " because " << dim.name()
+        << " is not one of the pure variables of " << name() << ".\n";
+    user_assert(factor > 0)
+        << "The storage block size for " << name() << "." << dim.name()
+        << " must be positive.\n";
+
+    vector<StorageSplit> &splits = func.schedule().storage_splits();
+    for (size_t i = 0; i < splits.size(); i++) {
+        user_assert(splits[i].var != dim.name())
+            << "Can't split storage of function " << name()
+            << " over " << dim.name()
+            << " because it has already been split.\n";
+    }
+    StorageSplit split = {dim.name(), factor};
+    splits.push_back(split);
+
+    // The stride of dimension zero of a blocked output buffer is the
+    // stride between blocks, so drop the default constraint that
+    // it's one.
+    for (Parameter buf : func.output_buffers()) {
+        if (is_one(buf.stride_constraint(0))) {
+            buf.set_stride_constraint(0, Expr());
+        }
+    }
+    return *this;
+}
+
 Func &Func::compute_at(Func f, RVar var) {
     return compute_at(f, Var(var.name()));
 }
@@ -1119,6 +1355,12 @@ Func &Func::compute_root() {
     return *this;
 }
 
+Func &Func::compute_with(Stage s, VarOrRVar var) {
+    invalidate_cache();
+    Stage(func.schedule(), name()).compute_with(s, var);
+    return *this;
+}
+
 Func &Func::store_at(Func f, RVar var) {
     return store_at(f, Var(var.name()));
 }
@@ -1135,6 +1377,12 @@ Func &Func::store_root() {
     return *this;
 }
 
+Func &Func::store_in(MemoryType t) {
+    invalidate_cache();
+    func.schedule().memory_type() = t;
+    return *this;
+}
+
 Func &Func::compute_inline() {
     invalidate_cache();
     func.schedule().compute_level() = LoopLevel();
@@ -1161,8 +1409,27 @@ Func &Func::trace_realizations() {
 }
 
 void Func::debug_to_file(const string &filename) {
+    debug_to_file(filename, DebugToFileOptions());
+}
+
+void Func::debug_to_file(const string &filename, const DebugToFileOptions &options) {
+    user_assert(options.every >= 1)
+        << "In debug_to_file for Func " << name()
+        << ": every must be at least one.\n";
+    user_assert((int)options.region.size() <= dimensions())
+        << "In debug_to_file for Func " << name()
+        << ": region has " << options.region.size()
+        << " dimensions, but the Func has " << dimensions() << ".\n";
+    for (const std::pair<Expr, Expr> &r : options.region) {
+        user_assert(r.first.defined() && r.second.defined() &&
+                    (r.first.type().is_int() || r.first.type().is_uint()) &&
+                    (r.second.type().is_int() || r.second.type().is_uint()))
+            << "In debug_to_file for Func " << name()
+            << ": the region must be given as integer mins and extents.\n";
+    }
     invalidate_cache();
     func.debug_file() = filename;
+    func.debug_file_options() = options;
 }
 
 Stage Func::update(int idx) {
@@ -1677,6 +1944,14 @@ void Func::set_custom_print(void (*cust_print)(void *, const char *)) {
     pipeline().set_custom_print(cust_print);
 }
 
+void Func::set_tiered_jit(bool tiered) {
+    pipeline().set_tiered_jit(tiered);
+}
+
+void Func::wait_for_tiered_jit() {
+    pipeline().wait_for_tiered_jit();
+}
+
 void Func::add_custom_lowering_pass(IRMutator *pass, void (*deleter)(IRMutator *)) {
     pipeline().add_custom_lowering_pass(pass, deleter);
 }
@@ -1701,6 +1976,42 @@ void Func::realize(Realization dst, const Target &target) {
     pipeline().realize(dst, target);
 }
 
+void Func::realize_tiled(std::vector<int32_t> sizes,
+                         std::vector<int32_t> tile_sizes,
+                         const std::map<std::string, TileReader> &inputs,
+                         TileWriter output,
+                         const Target &target) {
+    pipeline().realize_tiled(sizes, tile_sizes, inputs, output, target);
+}
+
+std::vector<std::pair<int32_t, int32_t>>
+Func::realize_dirty(Realization dst, const std::string &input,
+                    const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                    const Target &target) {
+    return pipeline().realize_dirty(dst, input, dirty, target);
+}
+
+std::vector<std::pair<int32_t, int32_t>>
+Func::realize_dirty(Buffer dst, const std::string &input,
+                    const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                    const Target &target) {
+    return pipeline().realize_dirty(dst, input, dirty, target);
+}
+
+std::vector<std::string>
+Func::realize_tile_list(Realization dst,
+                        const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                        const Target &target) {
+    return pipeline().realize_tile_list(dst, tiles, target);
+}
+
+std::vector<std::string>
+Func::realize_tile_list(Buffer dst,
+                        const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                        const Target &target) {
+    return pipeline().realize_tile_list(dst, tiles, target);
+}
+
 void Func::infer_input_bounds(Buffer dst) {
     pipeline().infer_input_bounds(dst);
 }
@@ -68,8 +68,10 @@ public:
     EXPORT Stage &vectorize(VarOrRVar var);
     EXPORT Stage &unroll(VarOrRVar var);
     EXPORT Stage &parallel(VarOrRVar var, Expr task_size);
+    EXPORT Stage &parallel_strips(VarOrRVar var, VarOrRVar strip, Expr strip_size);
     EXPORT Stage &vectorize(VarOrRVar var, int factor);
     EXPORT Stage &unroll(VarOrRVar var, int factor);
+    EXPORT Stage &unroll_and_jam(VarOrRVar var, VarOrRVar inner, int factor);
     EXPORT Stage &tile(VarOrRVar x, VarOrRVar y,
                                 VarOrRVar xo, VarOrRVar yo,
                                 VarOrRVar xi, VarOrRVar yi, Expr
@@ -115,6 +117,7 @@ public:
                                     Expr x_size, Expr y_size, Expr z_size, DeviceAPI device_api = DeviceAPI::Default_GPU);
 
     EXPORT Stage &allow_race_conditions();
+    EXPORT Stage &compute_with(Stage s, VarOrRVar var);
     // @}
 
     // These calls are for legacy compatibility only.
@@ -433,6 +436,44 @@ public:
     }
     // @}
 
+    /** Evaluate this function over an output too large to hold in
+     * memory, one tile at a time, streaming the given ImageParams in
+     * from tile readers and the output to a tile writer. See
+     * Pipeline::realize_tiled. */
+    EXPORT void realize_tiled(std::vector<int32_t> sizes,
+                              std::vector<int32_t> tile_sizes,
+                              const std::map<std::string, TileReader> &inputs,
+                              TileWriter output,
+                              const Target &target = Target());
+
+    /** Recompute the part of a previous output of this function
+     * affected by a change to a region of one of its input
+     * buffers. See Pipeline::realize_dirty. */
+    // @{
+    EXPORT std::vector<std::pair<int32_t, int32_t>>
+    realize_dirty(Realization dst, const std::string &input,
+                  const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                  const Target &target = Target());
+    EXPORT std::vector<std::pair<int32_t, int32_t>>
+    realize_dirty(Buffer dst, const std::string &input,
+                  const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                  const Target &target = Target());
+    // @}
+
+    /** Compute only some tiles of this function, in a single
+     * call. Returns an error message for each tile that couldn't be
+     * computed. See Pipeline::realize_tile_list. */
+    // @{
+    EXPORT std::vector<std::string>
+    realize_tile_list(Realization dst,
+                      const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                      const Target &target = Target());
+    EXPORT std::vector<std::string>
+    realize_tile_list(Buffer dst,
+                      const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                      const Target &target = Target());
+    // @}
+
     /** For a given size of output, or a given output buffer,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
@@ -638,6 +679,19 @@ public:
      */
     EXPORT void set_custom_print(void (*handler)(void *, const char *));
 
+    /** Compile for the JIT in two tiers: first quickly, with few
+     * optimizations, so that the first realization doesn't wait for a
+     * full compile, and then again with full optimization on a
+     * background thread. realize switches to the optimized code once
+     * it is ready. Useful for interactive tools, where the pipeline
+     * changes often. Takes effect the next time the pipeline is
+     * compiled. */
+    EXPORT void set_tiered_jit(bool tiered);
+
+    /** Wait for the optimized version of a tiered JIT compile. See
+     * Pipeline::wait_for_tiered_jit. */
+    EXPORT void wait_for_tiered_jit();
+
     /** Get a struct containing the currently set custom functions
      * used by JIT. */
     EXPORT const Internal::JITHandlers &jit_handlers();
@@ -688,9 +742,36 @@ public:
      * 5, uint32_t = 6, int32_t = 7, uint64_t = 8, int64_t = 9. The
      * data follows the header, as a densely packed array of the given
      * size and the given type. If given the extension .tmp, this file
-     * format can be natively read by the program ImageStack. */
+     * format can be natively read by the program ImageStack.
+     *
+     * If filename ends in ".npy" or ".raw", each realization of the
+     * Func is appended to the file as a new frame, and the file is
+     * only truncated the first time it is written by the
+     * process. ".npy" files are in numpy's format, with the frame as
+     * the outermost (first) dimension, so all frames must have the
+     * same size. ".raw" files are just the densely packed frames,
+     * with no header. */
     EXPORT void debug_to_file(const std::string &filename);
 
+    /** Dump the values of this function to a file as above, but
+     * limited to a region of interest, and to every nth realization of
+     * the Func. If options.async is set, the data is copied and
+     * written by a background thread, so that debugging large
+     * pipelines doesn't stall the threads computing them. The memory
+     * used by the copies is bounded (see
+     * halide_debug_to_file_set_queue_size). E.g. to record a 64x64
+     * window of a Func every tenth time it is computed:
+     *
+     \code
+     DebugToFileOptions options;
+     options.region = {{x0, 64}, {y0, 64}};
+     options.every = 10;
+     options.async = true;
+     f.debug_to_file("f.npy", options);
+     \endcode
+     */
+    EXPORT void debug_to_file(const std::string &filename, const DebugToFileOptions &options);
+
     /** The name of this function, either given during construction,
      * or automatically generated. */
     EXPORT const std::string &name() const;
@@ -839,6 +920,27 @@ public:
      * manually. */
     EXPORT Func &parallel(VarOrRVar var, Expr task_size);
 
+    /** Split a dimension into strips of the given size, and traverse
+     * the strips in parallel. Unlike parallel(var, task_size), var
+     * refers to the serial loop within each strip after this call, and
+     * the parallel loop over strips is named strip. This lets a
+     * producer keep a sliding window while the consumer runs on many
+     * cores. Store the producer per strip and compute it per
+     * scanline:
+     *
+     \code
+     Func blur_x, blur_y;
+     blur_x(x, y) = input(x-1, y) + input(x, y) + input(x+1, y);
+     blur_y(x, y) = blur_x(x, y-1) + blur_x(x, y) + blur_x(x, y+1);
+     blur_y.parallel_strips(y, strip, 32);
+     blur_x.store_at(blur_y, strip).compute_at(blur_y, y);
+     \endcode
+     *
+     * Each strip computes the two extra rows of blur_x once when it
+     * starts. After that it computes one new row per scanline, and
+     * storage folding applies within each strip. */
+    EXPORT Func &parallel_strips(VarOrRVar var, VarOrRVar strip, Expr strip_size);
+
     /** Mark a dimension to be computed all-at-once as a single
      * vector. The dimension should have constant extent -
      * e.g. because it is the inner dimension following a split by a
@@ -866,6 +968,30 @@ public:
      * dimension of the split. */
     EXPORT Func &unroll(VarOrRVar var, int factor);
 
+    /** Split a dimension by the given factor, move the inner
+     * dimension of the split to just inside the loop over inner, and
+     * unroll it. The copies of the loop body for each value of var
+     * are fused into a single loop over inner. This is most useful on
+     * update definitions, to accumulate a tile of outputs at once
+     * over a reduction domain:
+     *
+     \code
+     Func prod;
+     prod(x, y) = 0.0f;
+     prod(x, y) += a(r, y) * b(x, r);
+     prod.update()
+         .split(x, x, xi, 8).reorder(xi, r, x, y).vectorize(xi)
+         .unroll_and_jam(y, r, 4);
+     \endcode
+     *
+     * Each iteration of the loop over r now updates four vectors of
+     * prod, which are kept in registers over the loop (see
+     * MemoryType::Register). var must be a pure Var outside of
+     * inner. After this call, var refers to the outer dimension of
+     * the split. A warning is printed if the tile of accumulators is
+     * larger than the target's vector register file. */
+    EXPORT Func &unroll_and_jam(VarOrRVar var, VarOrRVar inner, int factor);
+
     /** Statically declare that the range over which a function should
      * be evaluated is given by the second and third arguments. This
      * can let Halide perform some optimizations. E.g. if you know
@@ -1229,6 +1355,46 @@ public:
     }
     // @}
 
+    /** Fold the storage of this function along the given dimension
+     * into a circular buffer whose size is the given extent, rounded
+     * up to a power of two. Halide folds storage
+     * automatically when it can prove that the region used by each
+     * iteration of a loop moves monotonically and has a constant
+     * bound on its size. Use this when it can't. Every iteration of
+     * the loop the storage is folded over must use no more than
+     * extent values along the dimension, and this is checked at
+     * runtime. E.g. a line buffer whose consumer needs a data-dependent
+     * number of rows, known to be at most eight, could be scheduled
+     * as:
+     \code
+     f.store_root().compute_at(g, y).fold_storage(y, 8);
+     \endcode
+     */
+    EXPORT Func &fold_storage(Var dim, Expr extent);
+
+    /** Store this function in blocks of factor contiguous elements
+     * along the given dimension. Blocks nest inside each other in
+     * the order they are declared, and inside all of the ordinary
+     * dimensions, whose order is still set by reorder_storage. For a
+     * function of x, y, and c:
+     \code
+     f.split_storage(c, 16);
+     \endcode
+     * gives the layout often called NCHW16c, in which a vector
+     * across 16 channels is a dense load, and:
+     \code
+     f.split_storage(x, 8).split_storage(y, 8);
+     \endcode
+     * stores f as 8x8 tiles, so that a column of a tile is as close
+     * together in memory as a row. If f is an output, the buffer
+     * passed in must use the same layout; the stride in its buffer_t
+     * for a blocked dimension is the stride between successive
+     * blocks, and the strides within the blocks are implied. Every
+     * stride must be at least the size of a block, which is checked
+     * at runtime. realize allocates its output in this layout. The
+     * layout is recorded in the pipeline's metadata. */
+    EXPORT Func &split_storage(Var dim, int factor);
+
     /** Compute this function as needed for each unique value of the
      * given var for the given calling function f.
      *
@@ -1342,12 +1508,68 @@ public:
      */
     EXPORT Func &compute_root();
 
+    /** Fuse the loop nest of this function with the loop nest of the
+     * given stage of another function, from the outermost loop in
+     * down to and including its loop over var. Both functions must be
+     * computed at the same loop level, and neither may depend on the
+     * other. For example, two statistics of the same input:
+     *
+     \code
+     Func mean, sq;
+     mean(x, y) = (in(x-1, y) + in(x, y) + in(x+1, y)) / 3;
+     sq(x, y) = in(x, y) * in(x, y);
+     out(x, y) = sq(x, y) - mean(x, y) * mean(x, y);
+     mean.compute_at(out, y);
+     sq.compute_at(out, y).compute_with(mean, x);
+     \endcode
+     *
+     * computes mean and sq in a single loop over x for each
+     * scanline of out, so each value of in is loaded once. The loops
+     * being fused must have the same types. Where their bounds differ,
+     * the fused loop covers both, and each stage is guarded to its own
+     * bounds. To fuse update definitions, call compute_with on the
+     * update stage, e.g. f.update(0).compute_with(g.update(0), x).
+     * The remaining stages of the two functions run before or after
+     * the fused pair in their usual order. */
+    EXPORT Func &compute_with(Stage s, VarOrRVar var);
+
     /** Use the halide_memoization_cache_... interface to store a
      *  computed version of this function across invocations of the
      *  Func.
      */
     EXPORT Func &memoize();
 
+    /** Memoize this function in tiles instead of as a whole. The
+     * region of it that is computed is rounded out to whole tiles of
+     * the given size, aligned to multiples of that size, and each tile
+     * is stored in and looked up from the cache under its own bounds.
+     * Requests for overlapping regions of the function, e.g. as a
+     * viewport is panned, then only compute the tiles that are not in
+     * the cache already. Any update definitions must be pure in the
+     * tiled vars. */
+    // @{
+    EXPORT Func &memoize(Var x, int x_extent);
+    EXPORT Func &memoize(Var x, Var y, int x_extent, int y_extent);
+    // @}
+
+    /** Skip each iteration of the loop over the given var of the pure
+     * definition in which every value of mask it reads is zero, and
+     * write fill to the part of this function it would have computed
+     * instead. Funcs computed inside the loop are skipped too, unless
+     * they are stored outside of it. The mask must be computed at or
+     * outside of the loop, and it is checked by scanning the region of
+     * it the iteration reads, so it should be much cheaper to compute
+     * than the tile. It's up to you that the tile would have been fill
+     * anyway. E.g. to only run an expensive filter where a mask is
+     * set:
+     \code
+     out(x, y) = select(mask(x, y) != 0, expensive(x, y), 0.0f);
+     out.tile(x, y, xo, yo, xi, yi, 32, 32).skip_tiles(xo, mask, 0.0f);
+     mask.compute_root();
+     \endcode
+     * Update definitions of this function aren't skipped. */
+    EXPORT Func &skip_tiles(Var var, Func mask, Expr fill);
+
 
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
@@ -1453,6 +1675,27 @@ public:
      * outside the outermost loop. */
     EXPORT Func &store_root();
 
+    /** Choose where the storage for this function lives. By default
+     * (MemoryType::Auto), allocations of constant size up to 16K are
+     * placed on the stack, and everything else on the heap.
+     *
+     * MemoryType::Stack places the allocation on the stack even if
+     * its size isn't known at compile time. This is useful for small
+     * scratch tiles whose size depends on a parameter, but be careful
+     * not to overflow the stack.
+     *
+     * MemoryType::Heap always allocates using halide_malloc.
+     *
+     * MemoryType::Register keeps each element in its own register. The
+     * allocation must have a constant size, and every access to it
+     * must be at a constant index, which usually means all loops over
+     * it must be unrolled. Small allocations that meet these
+     * conditions are promoted to registers automatically.
+     *
+     * Functions scheduled inline, and output functions, have no
+     * allocation, so may not use this. */
+    EXPORT Func &store_in(MemoryType memory_type);
+
     /** Aggressively inline all uses of this function. This is the
      * default schedule, so you're unlikely to need to call this. For
      * a Func with an update definition, that means it gets computed
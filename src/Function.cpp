@@ -30,6 +30,7 @@ struct FunctionContents {
     std::vector<UpdateDefinition> updates;
 
     std::string debug_file;
+    DebugToFileOptions debug_file_options;
 
     std::vector<Parameter> output_buffers;
 
@@ -77,6 +78,15 @@ struct FunctionContents {
             }
         }
 
+        for (const std::pair<Expr, Expr> &i : debug_file_options.region) {
+            if (i.first.defined()) {
+                i.first.accept(visitor);
+            }
+            if (i.second.defined()) {
+                i.second.accept(visitor);
+            }
+        }
+
         for (Parameter i : output_buffers) {
             for (size_t j = 0; j < args.size() && j < 4; j++) {
                 if (i.min_constraint(j).defined()) {
@@ -299,14 +309,14 @@ void Function::define(const vector<string> &args, vector<Expr> values) {
     }
 
     for (size_t i = 0; i < args.size(); i++) {
-        Dim d = {args[i], ForType::Serial, DeviceAPI::Parent, true};
+        Dim d = {args[i], ForType::Serial, DeviceAPI::Parent, true, false};
         contents.ptr->schedule.dims().push_back(d);
         contents.ptr->schedule.storage_dims().push_back(args[i]);
     }
 
     // Add the dummy outermost dim
     {
-        Dim d = {Var::outermost().name(), ForType::Serial, DeviceAPI::Parent, true};
+        Dim d = {Var::outermost().name(), ForType::Serial, DeviceAPI::Parent, true, false};
         contents.ptr->schedule.dims().push_back(d);
     }
 
@@ -476,7 +486,12 @@ void Function::define_update(const vector<Expr> &_args, vector<Expr> values) {
 
             bool pure = can_parallelize_rvar(v, name(), r);
 
-            Dim d = {v, ForType::Serial, DeviceAPI::Parent, pure};
+            // Even if it isn't, it may be a simple associative
+            // accumulation that can be vectorized with a horizontal
+            // reduction.
+            bool associative = !pure && is_associative_rvar(v, name(), r);
+
+            Dim d = {v, ForType::Serial, DeviceAPI::Parent, pure, associative};
             r.schedule.dims().push_back(d);
         }
     }
@@ -484,14 +499,14 @@ void Function::define_update(const vector<Expr> &_args, vector<Expr> values) {
     // Then add the pure args outside of that
     for (size_t i = 0; i < pure_args.size(); i++) {
         if (!pure_args[i].empty()) {
-            Dim d = {pure_args[i], ForType::Serial, DeviceAPI::Parent, true};
+            Dim d = {pure_args[i], ForType::Serial, DeviceAPI::Parent, true, false};
             r.schedule.dims().push_back(d);
         }
     }
 
     // Then the dummy outermost dim
     {
-        Dim d = {Var::outermost().name(), ForType::Serial, DeviceAPI::Parent, true};
+        Dim d = {Var::outermost().name(), ForType::Serial, DeviceAPI::Parent, true, false};
         r.schedule.dims().push_back(d);
     }
 
@@ -580,6 +595,21 @@ const std::vector<Parameter> &Function::output_buffers() const {
     return contents.ptr->output_buffers;
 }
 
+std::vector<StorageBlock> Function::storage_blocks() const {
+    std::vector<StorageBlock> blocks;
+    const std::vector<StorageSplit> &splits = schedule().storage_splits();
+    for (size_t i = 0; i < splits.size(); i++) {
+        for (size_t j = 0; j < args().size(); j++) {
+            if (args()[j] == splits[i].var) {
+                StorageBlock b = {(int)j, splits[i].factor};
+                blocks.push_back(b);
+            }
+        }
+    }
+    internal_assert(blocks.size() == splits.size());
+    return blocks;
+}
+
 Schedule &Function::update_schedule(int idx) {
     return contents.ptr->updates[idx].schedule;
 }
@@ -612,6 +642,14 @@ std::string &Function::debug_file() {
     return contents.ptr->debug_file;
 }
 
+const DebugToFileOptions &Function::debug_file_options() const {
+    return contents.ptr->debug_file_options;
+}
+
+DebugToFileOptions &Function::debug_file_options() {
+    return contents.ptr->debug_file_options;
+}
+
 void Function::trace_loads() {
     contents.ptr->trace_loads = true;
 }
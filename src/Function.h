@@ -48,6 +48,26 @@ struct ExternFuncArgument {
     bool defined() const {return arg_type != UndefinedArg;}
 };
 
+/** Options for Func::debug_to_file that limit what gets written, and
+ * move the writing off the threads running the pipeline. */
+struct DebugToFileOptions {
+    /** The region of the Func to write, as a (min, extent) pair per
+     * dimension. Dimensions without an entry are written in full. The
+     * region is clipped to the part of the Func that was computed. */
+    std::vector<std::pair<Expr, Expr>> region;
+
+    /** Only write every nth realization of the Func. Realizations are
+     * counted per file, across all runs of the pipeline. */
+    int every;
+
+    /** Copy the data and write it from a background thread, so that
+     * the pipeline doesn't wait on the file system. Pending writes are
+     * finished before the pipeline returns. */
+    bool async;
+
+    DebugToFileOptions() : every(1), async(false) {}
+};
+
 namespace Internal {
 
 struct UpdateDefinition {
@@ -140,6 +160,11 @@ public:
      * on it. */
     EXPORT const std::vector<Parameter> &output_buffers() const;
 
+    /** Get the blocked dimensions of this function's storage,
+     * innermost block first, as dimension indices. See
+     * Func::split_storage. */
+    EXPORT std::vector<StorageBlock> storage_blocks() const;
+
     /** Get a mutable handle to the schedule for the update
      * stage */
     EXPORT Schedule &update_schedule(int idx = 0);
@@ -177,6 +202,12 @@ public:
     /** Get a handle to the debug filename */
     EXPORT std::string &debug_file();
 
+    /** Get a handle to the options for writing the debug file */
+    // @{
+    EXPORT const DebugToFileOptions &debug_file_options() const;
+    EXPORT DebugToFileOptions &debug_file_options();
+    // @}
+
     /** Use an an extern argument to another function. */
     operator ExternFuncArgument() const {
         return ExternFuncArgument(contents);
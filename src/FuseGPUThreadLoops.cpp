@@ -380,7 +380,7 @@ public:
             // Individual shared allocations.
             for (SharedAllocation alloc : allocations) {
                 s = Allocate::make(shared_mem_name + "_" + alloc.name,
-                                   alloc.type, {alloc.size}, const_true(), s);
+                                   alloc.type, MemoryType::Auto, {alloc.size}, const_true(), s);
             }
         } else {
             // One big combined shared allocation.
@@ -406,7 +406,7 @@ public:
             allocations.push_back(sentinel);
 
             Expr total_size = Variable::make(Int(32), allocations.back().name + ".shared_offset");
-            s = Allocate::make(shared_mem_name, UInt(8), {total_size}, const_true(), s);
+            s = Allocate::make(shared_mem_name, UInt(8), MemoryType::Auto, {total_size}, const_true(), s);
 
             // Define an offset for each allocation. The offsets are in
             // elements, not bytes, so that the stores and loads can use
@@ -391,7 +391,8 @@ Stmt Provide::make(std::string name, const std::vector<Expr> &values, const std:
     return node;
 }
 
-Stmt Allocate::make(std::string name, Type type, const std::vector<Expr> &extents,
+Stmt Allocate::make(std::string name, Type type, MemoryType memory_type,
+                    const std::vector<Expr> &extents,
                     Expr condition, Stmt body,
                     Expr new_expr, std::string free_function) {
     for (size_t i = 0; i < extents.size(); i++) {
@@ -405,6 +406,7 @@ Stmt Allocate::make(std::string name, Type type, const std::vector<Expr> &extent
     Allocate *node = new Allocate;
     node->name = name;
     node->type = type;
+    node->memory_type = memory_type;
     node->extents = extents;
     node->new_expr = new_expr;
     node->free_function = free_function;
@@ -641,6 +643,16 @@ Call::ConstString Call::likely = "likely";
 Call::ConstString Call::make_int64 = "make_int64";
 Call::ConstString Call::make_float64 = "make_float64";
 Call::ConstString Call::register_destructor = "register_destructor";
+Call::ConstString Call::vector_reduce_add = "vector_reduce_add";
+Call::ConstString Call::vector_reduce_mul = "vector_reduce_mul";
+Call::ConstString Call::vector_reduce_min = "vector_reduce_min";
+Call::ConstString Call::vector_reduce_max = "vector_reduce_max";
+Call::ConstString Call::saturating_add = "saturating_add";
+Call::ConstString Call::saturating_sub = "saturating_sub";
+Call::ConstString Call::halving_add = "halving_add";
+Call::ConstString Call::rounding_halving_add = "rounding_halving_add";
+Call::ConstString Call::mul_hi = "mul_hi";
+Call::ConstString Call::rounding_shift_right = "rounding_shift_right";
 
 }
 }
@@ -268,6 +268,7 @@ struct Provide : public StmtNode<Provide> {
 struct Allocate : public StmtNode<Allocate> {
     std::string name;
     Type type;
+    MemoryType memory_type;
     std::vector<Expr> extents;
     Expr condition;
 
@@ -282,7 +283,8 @@ struct Allocate : public StmtNode<Allocate> {
     std::string free_function;
     Stmt body;
 
-    EXPORT static Stmt make(std::string name, Type type, const std::vector<Expr> &extents,
+    EXPORT static Stmt make(std::string name, Type type, MemoryType memory_type,
+                            const std::vector<Expr> &extents,
                             Expr condition, Stmt body,
                             Expr new_expr = Expr(), std::string free_function = std::string());
 };
@@ -363,6 +365,18 @@ struct Call : public ExprNode<Call> {
     // they can be referenced at static-initialization time without
     // risking ambiguous initalization order; we use a typedef to simplify
     // declaration.
+    //
+    // The vector_reduce_* intrinsics take a single vector argument
+    // and combine each group of adjacent lanes using the named
+    // operator. The number of lanes of the result must divide the
+    // number of lanes of the argument; lane i of the result is the
+    // reduction of argument lanes [i*k, (i+1)*k), where k is the
+    // ratio of the two.
+    //
+    // The fixed-point intrinsics (saturating_add through
+    // rounding_shift_right) take two integer arguments of the same
+    // type as the result. See the functions of the same name in
+    // IROperator.h.
     typedef const char* const ConstString;
     EXPORT static ConstString debug_to_file,
         shuffle_vector,
@@ -408,7 +422,17 @@ struct Call : public ExprNode<Call> {
         likely,
         make_int64,
         make_float64,
-        register_destructor;
+        register_destructor,
+        vector_reduce_add,
+        vector_reduce_mul,
+        vector_reduce_min,
+        vector_reduce_max,
+        saturating_add,
+        saturating_sub,
+        halving_add,
+        rounding_halving_add,
+        mul_hi,
+        rounding_shift_right;
 
     // If it's a call to another halide function, this call node
     // holds onto a pointer to that function.
@@ -389,7 +389,13 @@ void match_types(Expr &a, Expr &b) {
     } else if (ta.is_float() && tb.is_float()) {
         // float(a) * float(b) -> float(max(a, b))
         if (ta.bits() > tb.bits()) b = cast(ta, b);
-        else a = cast(tb, a);
+        else if (ta.bits() < tb.bits()) a = cast(tb, a);
+        else {
+            // float16(a) * bfloat16(b) -> float32
+            Type t = Float(32, ta.lanes());
+            a = cast(t, a);
+            b = cast(t, b);
+        }
     } else if (ta.is_uint() && tb.is_uint()) {
         // uint(a) * uint(b) -> uint(max(a, b))
         if (ta.bits() > tb.bits()) b = cast(ta, b);
@@ -685,4 +691,75 @@ Expr memoize_tag(Expr result, const std::vector<Expr> &cache_key_values) {
                                 args, Internal::Call::Intrinsic);
 }
 
+namespace {
+Expr fixed_point_intrinsic(const char *fn, const char *name, Expr a, Expr b) {
+    user_assert(a.defined() && b.defined()) << fn << " of undefined Expr\n";
+    Internal::match_types(a, b);
+    user_assert(a.type().is_int() || a.type().is_uint())
+        << fn << " requires integer arguments, but got " << a << " of type " << a.type() << "\n";
+    return Internal::Call::make(a.type(), name, {a, b}, Internal::Call::Intrinsic);
+}
+
+// The largest value of an integer type, as a uint64_t.
+uint64_t max_value(Type t) {
+    int value_bits = t.bits() - (t.is_int() ? 1 : 0);
+    return value_bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << value_bits) - 1;
+}
+}
+
+Expr saturating_add(Expr a, Expr b) {
+    return fixed_point_intrinsic("saturating_add", Internal::Call::saturating_add, a, b);
+}
+
+Expr saturating_sub(Expr a, Expr b) {
+    return fixed_point_intrinsic("saturating_sub", Internal::Call::saturating_sub, a, b);
+}
+
+Expr halving_add(Expr a, Expr b) {
+    return fixed_point_intrinsic("halving_add", Internal::Call::halving_add, a, b);
+}
+
+Expr rounding_halving_add(Expr a, Expr b) {
+    return fixed_point_intrinsic("rounding_halving_add", Internal::Call::rounding_halving_add, a, b);
+}
+
+Expr mul_hi(Expr a, Expr b) {
+    Expr result = fixed_point_intrinsic("mul_hi", Internal::Call::mul_hi, a, b);
+    user_assert(result.type().bits() <= 32)
+        << "mul_hi of 64-bit integers is not supported\n";
+    return result;
+}
+
+Expr rounding_shift_right(Expr a, Expr b) {
+    return fixed_point_intrinsic("rounding_shift_right", Internal::Call::rounding_shift_right, a, b);
+}
+
+Expr saturating_cast(Type t, Expr e) {
+    user_assert(e.defined()) << "saturating_cast of undefined Expr\n";
+    Type src = e.type();
+    t = t.with_lanes(src.lanes());
+
+    if (src.is_float() && (t.is_int() || t.is_uint())) {
+        // The largest value of the integer type may round up when
+        // converted to float, so compare against it instead of
+        // clamping to it.
+        Expr hi = Internal::make_const(src, (double)max_value(t));
+        Expr lo = t.is_uint() ? Internal::make_zero(src) : Internal::make_const(src, -(double)max_value(t) - 1);
+        return select(e >= hi, t.max(), cast(t, max(e, lo)));
+    } else if (src.is_float() || t.is_float() || src.is_bool() || t.is_bool()) {
+        return cast(t, e);
+    }
+
+    // Clamp in the source type, in the order that the pattern
+    // matching for narrowing instructions expects.
+    if (!t.can_represent(max_value(src))) {
+        e = min(e, Internal::make_const(src, max_value(t)));
+    }
+    if (src.is_int() && (t.is_uint() || t.bits() < src.bits())) {
+        int64_t lo = t.is_uint() ? 0 : -(int64_t)max_value(t) - 1;
+        e = max(e, Internal::make_const(src, lo));
+    }
+    return cast(t, e);
+}
+
 }
@@ -84,6 +84,7 @@ inline Expr make_const(Type t, uint8_t val)   {return make_const(t, (uint64_t)va
 inline Expr make_const(Type t, bool val)      {return make_const(t, (uint64_t)val);}
 inline Expr make_const(Type t, float val)     {return make_const(t, (double)val);}
 inline Expr make_const(Type t, float16_t val) {return make_const(t, (double)val);}
+inline Expr make_const(Type t, bfloat16_t val) {return make_const(t, (double)val);}
 // @}
 
 /** Check if a constant value can be correctly represented as the given type. */
@@ -1634,6 +1635,52 @@ inline Expr count_trailing_zeros(Expr x) {
                                 {x}, Internal::Call::Intrinsic);
 }
 
+/** Fixed-point arithmetic on integers. Each of these takes two
+ * integers of matching type (after the usual type coercion) and
+ * returns a result of that type, without overflowing. They map to
+ * single instructions on x86 and ARM where those exist, and are
+ * emulated with wider arithmetic elsewhere. */
+// @{
+
+/** Add two integers, clamping the result to the range of the type
+ * instead of wrapping around. */
+EXPORT Expr saturating_add(Expr a, Expr b);
+
+/** Subtract two integers, clamping the result to the range of the
+ * type instead of wrapping around. */
+EXPORT Expr saturating_sub(Expr a, Expr b);
+
+/** Compute (a + b) / 2, rounding down, as if the sum were computed
+ * with enough bits that it doesn't overflow. */
+EXPORT Expr halving_add(Expr a, Expr b);
+
+/** Compute (a + b + 1) / 2, as if the sum were computed with enough
+ * bits that it doesn't overflow. This is the average of two integers,
+ * rounded up. */
+EXPORT Expr rounding_halving_add(Expr a, Expr b);
+
+/** Compute the high half of the double-width product of two
+ * integers, i.e. (a * b) >> bits. Integers must be 32 bits or
+ * narrower. */
+EXPORT Expr mul_hi(Expr a, Expr b);
+
+/** Shift a right by b bits, rounding to nearest with ties rounding
+ * up. Shifts by zero return a unchanged. The result is undefined if b
+ * is negative or at least the number of bits in the type. */
+EXPORT Expr rounding_shift_right(Expr a, Expr b);
+// @}
+
+/** Cast an expression to a new type, clamping it to the range of the
+ * new type first. Float to integer casts also clamp. Casts to and from integers of the same signedness and the
+ * packing casts on x86 and ARM are recognized and compile to single
+ * instructions. */
+EXPORT Expr saturating_cast(Type t, Expr e);
+
+template<typename T>
+inline Expr saturating_cast(Expr e) {
+    return saturating_cast(type_of<T>(), e);
+}
+
 /** Return a random variable representing a uniformly distributed
  * float in the half-open interval [0.0f, 1.0f). For random numbers of
  * other types, use lerp with a random float as the last parameter.
@@ -37,6 +37,12 @@ class Inliner : public IRMutator {
                        << f.name() << " because the function is scheduled inline.\n";
         }
 
+        if (s.memory_type() != MemoryType::Auto) {
+            user_error << "Cannot store function "
+                       << f.name() << " in " << s.memory_type()
+                       << " memory because the function is scheduled inline.\n";
+        }
+
         for (size_t i = 0; i < s.dims().size(); i++) {
             Dim d = s.dims()[i];
             if (d.for_type == ForType::Parallel) {
@@ -83,6 +89,24 @@ class Inliner : public IRMutator {
                          << s.bounds()[i].extent << "] because the function is scheduled inline.\n";
         }
 
+        for (size_t i = 0; i < s.fold_factors().size(); i++) {
+            user_warning << "It is meaningless to fold the storage of dimension "
+                         << s.fold_factors()[i].var << " of function "
+                         << f.name() << " because the function is scheduled inline.\n";
+        }
+
+        for (size_t i = 0; i < s.storage_splits().size(); i++) {
+            user_warning << "It is meaningless to split the storage of dimension "
+                         << s.storage_splits()[i].var << " of function "
+                         << f.name() << " because the function is scheduled inline.\n";
+        }
+
+        for (size_t i = 0; i < s.skip_tiles().size(); i++) {
+            user_warning << "It is meaningless to skip tiles of dimension "
+                         << s.skip_tiles()[i].var << " of function "
+                         << f.name() << " because the function is scheduled inline.\n";
+        }
+
     }
 
     void visit(const Call *op) {
@@ -0,0 +1,251 @@
+#include "InvariantDivision.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+using std::pair;
+
+namespace {
+
+// Check that an expression can be evaluated once outside a loop
+// without changing its value, given that it doesn't use any
+// variables defined inside the loop.
+class IsPure : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *) {
+        result = false;
+    }
+
+    void visit(const Call *) {
+        result = false;
+    }
+public:
+    bool result;
+    IsPure() : result(true) {}
+};
+
+bool is_pure(Expr e) {
+    IsPure p;
+    e.accept(&p);
+    return p.result;
+}
+
+// A divisor hoisted out of a loop, and the names of the values
+// computed from it.
+struct Divisor {
+    Expr value;
+    string name;
+};
+
+// The state for each enclosing loop.
+struct LoopFrame {
+    // Variables defined inside the loop, including the loop variable.
+    Scope<int> inner_vars;
+    // Divisors to compute before the loop.
+    vector<Divisor> divisors;
+    // The lets that compute them, in order.
+    vector<pair<string, Expr>> lets;
+};
+
+class InvariantDivision : public IRMutator {
+    // The enclosing loops, innermost last.
+    vector<LoopFrame *> loops;
+
+    // Vectors of 8, 16, or 32 bit integers divided by a broadcast of
+    // something that isn't a constant, and doesn't change over the
+    // innermost enclosing loop.
+    bool should_lower(Expr a, Expr b) {
+        Type t = a.type();
+        if (loops.empty() || !t.is_vector() || !(t.is_int() || t.is_uint()) ||
+            (t.bits() != 8 && t.bits() != 16 && t.bits() != 32)) {
+            return false;
+        }
+        const Broadcast *bcast = b.as<Broadcast>();
+        return (bcast && !is_const(bcast->value) && is_pure(bcast->value) &&
+                !expr_uses_vars(bcast->value, loops.back()->inner_vars));
+    }
+
+    // Get the name of the lets computing the multiplier and shift
+    // for a divisor, adding them to the innermost loop if necessary.
+    string divisor_name(Expr d) {
+        LoopFrame &frame = *loops.back();
+        for (const Divisor &div : frame.divisors) {
+            if (equal(div.value, d)) {
+                return div.name;
+            }
+        }
+
+        Type t = d.type();
+        int bits = t.bits();
+        Type ut = UInt(bits), wt = UInt(bits * 2);
+        string name = unique_name('d');
+
+        // The magnitude of the divisor as an unsigned value. Division
+        // by zero is undefined, but the lets are computed even if the
+        // loop doesn't run, so treat zero as one.
+        Expr abs_d = cast(ut, Variable::make(t, name));
+        if (t.is_int()) {
+            abs_d = select(Variable::make(t, name) < 0, make_zero(ut) - abs_d, abs_d);
+        }
+        abs_d = max(abs_d, make_one(ut));
+        Expr abs_var = Variable::make(ut, name + ".abs");
+
+        frame.lets.push_back({name, d});
+        frame.lets.push_back({name + ".abs", abs_d});
+
+        // Compute ceil(log2(d)) by binary search on the position of
+        // the highest set bit of d - 1.
+        string x_name = name + ".log";
+        frame.lets.push_back({x_name + "." + std::to_string(bits), abs_var - 1});
+        Expr log = make_zero(ut);
+        for (int k = bits / 2; k >= 1; k /= 2) {
+            Expr x = Variable::make(ut, x_name + "." + std::to_string(k * 2));
+            Expr step = select((x >> k) != 0, make_const(ut, k), make_zero(ut));
+            frame.lets.push_back({x_name + "." + std::to_string(k), x >> step});
+            log = log + step;
+        }
+        log = log + select(Variable::make(ut, x_name + ".1") != 0, make_one(ut), make_zero(ut));
+        frame.lets.push_back({name + ".ceil_log", log});
+        Expr log_var = Variable::make(ut, name + ".ceil_log");
+
+        // The multiplier is 2^bits * (2^log - d) / d + 1, which fits
+        // in the narrow type, and the final shift is log - 1. See
+        // Granlund and Montgomery, "Division by invariant integers
+        // using multiplication".
+        Expr mul = (cast(wt, make_one(wt) << cast(wt, log_var)) - cast(wt, abs_var)) << bits;
+        mul = cast(ut, mul / cast(wt, abs_var) + 1);
+        frame.lets.push_back({name + ".mul", mul});
+        frame.lets.push_back({name + ".shift", max(log_var, make_one(ut)) - 1});
+
+        Divisor div = {d, name};
+        frame.divisors.push_back(div);
+        return name;
+    }
+
+    // Divide a vector of unsigned integers by the divisor with the
+    // given name.
+    Expr unsigned_divide(Expr n, const string &name) {
+        Type t = n.type();
+        int bits = t.bits(), lanes = t.lanes();
+        Type ut = UInt(bits);
+        Type wt = UInt(bits * 2, lanes);
+        Expr mul = Broadcast::make(Variable::make(ut, name + ".mul"), lanes);
+        Expr shift = Broadcast::make(Variable::make(ut, name + ".shift"), lanes);
+
+        // Multiply-keep-high-half
+        Expr q = cast(t, (cast(wt, n) * cast(wt, mul)) >> bits);
+        // Add half the difference between input and output so far
+        q = q + ((n - q) >> 1);
+        // Do a final shift
+        q = q >> shift;
+
+        // The above doesn't work for a divisor of one
+        Expr is_one = Variable::make(ut, name + ".abs") == make_one(ut);
+        return Select::make(is_one, n, q);
+    }
+
+    // Halide's division rounds according to the sign of the
+    // divisor, so that the remainder is always positive.
+    Expr divide(Expr a, Expr d) {
+        string name = divisor_name(d);
+        Type t = a.type();
+        if (t.is_uint()) {
+            return unsigned_divide(a, name);
+        }
+
+        // Flip the bits of a negative numerator to make it
+        // non-negative, divide, and flip them back. This rounds
+        // towards negative infinity.
+        Type ut = UInt(t.bits(), t.lanes());
+        Expr xsign = a >> (t.bits() - 1);
+        Expr q = unsigned_divide(cast(ut, xsign ^ a), name);
+        q = xsign ^ cast(t, q);
+
+        // Negative divisors round up instead.
+        Expr negative = Variable::make(d.type(), name) < 0;
+        return Select::make(negative, make_zero(t) - q, q);
+    }
+
+    using IRMutator::visit;
+
+    void visit(const Div *op) {
+        Expr a = mutate(op->a), b = mutate(op->b);
+        if (should_lower(a, b)) {
+            expr = divide(a, b.as<Broadcast>()->value);
+        } else if (a.same_as(op->a) && b.same_as(op->b)) {
+            expr = op;
+        } else {
+            expr = Div::make(a, b);
+        }
+    }
+
+    void visit(const Mod *op) {
+        Expr a = mutate(op->a), b = mutate(op->b);
+        if (should_lower(a, b)) {
+            expr = a - divide(a, b.as<Broadcast>()->value) * b;
+        } else if (a.same_as(op->a) && b.same_as(op->b)) {
+            expr = op;
+        } else {
+            expr = Mod::make(a, b);
+        }
+    }
+
+    void visit(const Let *op) {
+        if (!loops.empty()) {
+            loops.back()->inner_vars.push(op->name, 0);
+        }
+        IRMutator::visit(op);
+    }
+
+    void visit(const LetStmt *op) {
+        if (!loops.empty()) {
+            loops.back()->inner_vars.push(op->name, 0);
+        }
+        IRMutator::visit(op);
+    }
+
+    void visit(const For *op) {
+        // Leave device code alone.
+        if (op->device_api != DeviceAPI::Host &&
+            op->device_api != DeviceAPI::Parent) {
+            stmt = op;
+            return;
+        }
+
+        Expr min = mutate(op->min);
+        Expr extent = mutate(op->extent);
+
+        LoopFrame frame;
+        frame.inner_vars.push(op->name, 0);
+        loops.push_back(&frame);
+        Stmt body = mutate(op->body);
+        loops.pop_back();
+
+        if (min.same_as(op->min) && extent.same_as(op->extent) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = For::make(op->name, min, extent, op->for_type, op->device_api, body);
+        }
+
+        for (size_t i = frame.lets.size(); i > 0; i--) {
+            stmt = LetStmt::make(frame.lets[i-1].first, frame.lets[i-1].second, stmt);
+        }
+    }
+};
+
+}
+
+Stmt lower_invariant_division(Stmt s) {
+    return InvariantDivision().mutate(s);
+}
+
+}
+}
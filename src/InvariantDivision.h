@@ -0,0 +1,26 @@
+#ifndef HALIDE_INVARIANT_DIVISION_H
+#define HALIDE_INVARIANT_DIVISION_H
+
+/** \file
+ * Defines the lowering pass that replaces vector division by
+ * loop-invariant runtime values with multiplies and shifts.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite vector integer division and modulo by a value that is not
+ * a compile-time constant, but doesn't change over the innermost
+ * enclosing loop (e.g. a Param), to use a multiplier and shift
+ * computed once outside that loop. There's no vector integer
+ * division instruction on most targets, so this turns a scalarized
+ * loop of divides into a few vector multiplies and shifts. Should be
+ * run after vectorization. */
+Stmt lower_invariant_division(Stmt s);
+
+}
+}
+
+#endif
@@ -1,9 +1,12 @@
+#include <condition_variable>
 #include <string>
 #include <stdint.h>
 #include <mutex>
 #include <set>
+#include <thread>
 
 #include "CodeGen_Internal.h"
+#include "CodeGen_LLVM.h"
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
@@ -110,6 +113,75 @@ void load_metal() {
 
 using namespace llvm;
 
+// The fully optimized tier of a module made by JITModule::make_tiered,
+// which is compiled on a background thread. The background thread
+// never touches the reference counts of Halide objects, which aren't
+// thread-safe, so it never deletes the optimized module. If the fast
+// module it was an upgrade for is destroyed first, the optimized module
+// is deleted by a later call to make_tiered, or at exit.
+struct TieredCompile {
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool done;
+    JITModule *optimized;
+
+    TieredCompile() : done(false), optimized(NULL) {}
+};
+
+namespace {
+
+// Tiered compiles still running on background threads, and the
+// optimized modules of fast modules that were destroyed before their
+// optimized version was ready. These are waited for and deleted at
+// exit, before the shared runtime they link against is destroyed. This
+// is constructed on first use, so it is destroyed before any of the
+// globals in this file.
+struct BackgroundCompiles {
+    std::mutex mutex;
+    std::condition_variable finished;
+    int running;
+    std::vector<std::shared_ptr<TieredCompile>> abandoned;
+
+    BackgroundCompiles() : running(0) {}
+
+    // Delete the abandoned optimized modules that are ready.
+    void reap() {
+        std::vector<JITModule *> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::shared_ptr<TieredCompile>> still_running;
+            for (const std::shared_ptr<TieredCompile> &tiered : abandoned) {
+                std::lock_guard<std::mutex> tiered_lock(tiered->mutex);
+                if (tiered->done) {
+                    ready.push_back(tiered->optimized);
+                    tiered->optimized = NULL;
+                } else {
+                    still_running.push_back(tiered);
+                }
+            }
+            abandoned.swap(still_running);
+        }
+        for (JITModule *m : ready) {
+            delete m;
+        }
+    }
+
+    ~BackgroundCompiles() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this]{ return running == 0; });
+        }
+        reap();
+    }
+};
+
+BackgroundCompiles &background_compiles() {
+    static BackgroundCompiles compiles;
+    return compiles;
+}
+
+}
+
 class JITModuleContents {
 public:
     mutable RefCount ref_count;
@@ -119,6 +191,18 @@ public:
     }
 
     ~JITModuleContents() {
+        if (tiered) {
+            std::unique_lock<std::mutex> lock(tiered->mutex);
+            if (tiered->done) {
+                delete tiered->optimized;
+                tiered->optimized = NULL;
+            } else {
+                lock.unlock();
+                BackgroundCompiles &compiles = background_compiles();
+                std::lock_guard<std::mutex> compiles_lock(compiles.mutex);
+                compiles.abandoned.push_back(tiered);
+            }
+        }
         if (execution_engine != NULL) {
             execution_engine->runStaticConstructorsDestructors(true);
             delete execution_engine;
@@ -133,6 +217,10 @@ public:
     JITModule::Symbol argv_entrypoint;
 
     std::string name;
+
+    // The optimized module that is being compiled to replace this
+    // one, if this is the fast tier of a tiered compile.
+    std::shared_ptr<TieredCompile> tiered;
 };
 
 template <>
@@ -177,8 +265,10 @@ JITModule::Symbol compile_and_get_function(ExecutionEngine &ee, const string &na
 
 // Expand LLVM's search for symbols to include code contained in a set of JITModule.
 // TODO: Does this need to be conditionalized to llvm 3.6?
+// The modules are those of the JITModuleContents that owns the
+// execution engine that owns this, so they outlive it.
 class HalideJITMemoryManager : public SectionMemoryManager {
-    std::vector<JITModule> modules;
+    const std::vector<JITModule> &modules;
 
 public:
     HalideJITMemoryManager(const std::vector<JITModule> &modules) : modules(modules) {}
@@ -209,14 +299,23 @@ JITModule::JITModule(const Module &m, const LoweredFunc &fn,
     jit_module = new JITModuleContents();
     std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(m, jit_module.ptr->context));
     std::vector<JITModule> deps_with_runtime = dependencies;
-    std::vector<JITModule> shared_runtime = JITSharedRuntime::get(llvm_module.get(), m.target());
+    // The shared runtime is used by everything compiled after it,
+    // so it is always fully optimized.
+    std::vector<JITModule> shared_runtime =
+        JITSharedRuntime::get(llvm_module.get(), m.target().without_feature(Target::FastCompile));
     deps_with_runtime.insert(deps_with_runtime.end(), shared_runtime.begin(), shared_runtime.end());
     compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime);
 }
 
-void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
-                               const std::vector<JITModule> &dependencies,
-                               const std::vector<std::string> &requested_exports) {
+namespace {
+
+// Compile an llvm module into a JITModuleContents, linking against its
+// dependencies, which must already be set. Doesn't touch the reference
+// counts of any JITModules, so it can run on a background thread.
+void compile_llvm_module(JITModuleContents *contents, std::unique_ptr<llvm::Module> m,
+                         const string &function_name, const Target &target,
+                         const std::vector<std::string> &requested_exports) {
+    typedef JITModule::Symbol Symbol;
 
     // Make the execution engine
     debug(2) << "Creating new execution engine\n";
@@ -249,13 +348,13 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     #endif
     //JITMemoryManager *memory_manager = JITMemoryManager::CreateDefaultMemManager();
     //engine_builder.setJITMemoryManager(memory_manager);
-    HalideJITMemoryManager *memory_manager = new HalideJITMemoryManager(dependencies);
+    HalideJITMemoryManager *memory_manager = new HalideJITMemoryManager(contents->dependencies);
     engine_builder.setMCJITMemoryManager(memory_manager);
     #else
-    engine_builder.setMCJITMemoryManager(std::unique_ptr<RTDyldMemoryManager>(new HalideJITMemoryManager(dependencies)));
+    engine_builder.setMCJITMemoryManager(std::unique_ptr<RTDyldMemoryManager>(new HalideJITMemoryManager(contents->dependencies)));
     #endif
 
-    engine_builder.setOptLevel(CodeGenOpt::Aggressive);
+    engine_builder.setOptLevel(target.has_feature(Target::FastCompile) ? CodeGenOpt::Less : CodeGenOpt::Aggressive);
     engine_builder.setMCPU(mcpu);
     std::vector<string> mattrs_array = {mattrs};
     engine_builder.setMAttrs(mattrs_array);
@@ -346,12 +445,91 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     ee->runStaticConstructorsDestructors(false);
 
     // Stash the various objects that need to stay alive behind a reference-counted pointer.
-    jit_module.ptr->exports = exports;
-    jit_module.ptr->execution_engine = ee;
+    contents->exports = exports;
+    contents->execution_engine = ee;
+    contents->entrypoint = entrypoint;
+    contents->argv_entrypoint = argv_entrypoint;
+    contents->name = function_name;
+}
+
+}
+
+void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
+                               const std::vector<JITModule> &dependencies,
+                               const std::vector<std::string> &requested_exports) {
     jit_module.ptr->dependencies = dependencies;
-    jit_module.ptr->entrypoint = entrypoint;
-    jit_module.ptr->argv_entrypoint = argv_entrypoint;
-    jit_module.ptr->name = function_name;
+    compile_llvm_module(jit_module.ptr, std::move(m), function_name, target, requested_exports);
+}
+
+JITModule JITModule::make_tiered(const Module &m, const LoweredFunc &fn,
+                                 const std::vector<JITModule> &dependencies) {
+    Module fast(m.name(), m.target().with_feature(Target::FastCompile));
+    for (const Buffer &b : m.buffers) {
+        fast.append(b);
+    }
+    for (const LoweredFunc &f : m.functions) {
+        fast.append(f);
+    }
+
+    JITModule baseline(fast, fn, dependencies);
+    if (m.target().has_feature(Target::FastCompile)) {
+        return baseline;
+    }
+
+    BackgroundCompiles &compiles = background_compiles();
+    compiles.reap();
+
+    // Halide IR isn't thread-safe, so generate the llvm module for the
+    // optimized tier here. Only the slow part, running all of llvm's
+    // optimizations and generating machine code, happens in the
+    // background. The llvm module is only lightly optimized so far.
+    JITModule *optimized = new JITModule();
+    JITModuleContents *contents = optimized->jit_module.ptr;
+    contents->dependencies = baseline.jit_module.ptr->dependencies;
+    llvm::Module *llvm_module = compile_module_to_llvm_module(fast, contents->context).release();
+
+    std::shared_ptr<TieredCompile> tiered = std::make_shared<TieredCompile>();
+    tiered->optimized = optimized;
+    baseline.jit_module.ptr->tiered = tiered;
+
+    {
+        std::lock_guard<std::mutex> lock(compiles.mutex);
+        compiles.running++;
+    }
+
+    Target target = m.target();
+    string name = fn.name;
+    debug(1) << "Compiling optimized version of " << name << " in the background\n";
+    std::thread([tiered, contents, llvm_module, target, name, &compiles]() {
+        std::unique_ptr<llvm::Module> module(llvm_module);
+        optimize_llvm_module(*module, target);
+        compile_llvm_module(contents, std::move(module), name, target, std::vector<std::string>());
+        debug(1) << "Optimized version of " << name << " is ready\n";
+
+        {
+            std::lock_guard<std::mutex> lock(tiered->mutex);
+            tiered->done = true;
+            tiered->ready.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(compiles.mutex);
+        compiles.running--;
+        compiles.finished.notify_all();
+    }).detach();
+
+    return baseline;
+}
+
+JITModule JITModule::tier_up(bool wait) const {
+    std::shared_ptr<TieredCompile> tiered = jit_module.ptr->tiered;
+    if (!tiered) {
+        return *this;
+    }
+    std::unique_lock<std::mutex> lock(tiered->mutex);
+    if (wait) {
+        tiered->ready.wait(lock, [&tiered]{ return tiered->done; });
+    }
+    return tiered->done ? *tiered->optimized : *this;
 }
 
 const std::map<std::string, JITModule::Symbol> &JITModule::exports() const {
@@ -58,6 +58,21 @@ struct JITModule {
     EXPORT JITModule();
     EXPORT JITModule(const Module &m, const LoweredFunc &fn,
                      const std::vector<JITModule> &dependencies = std::vector<JITModule>());
+
+    /** Compile a Module in two tiers. The module returned is compiled
+     * quickly, with few optimizations, so it can be used right
+     * away. The Module is then compiled again with full optimization
+     * on a background thread. Use tier_up to get the optimized
+     * version once it is ready. */
+    EXPORT static JITModule make_tiered(const Module &m, const LoweredFunc &fn,
+                                        const std::vector<JITModule> &dependencies = std::vector<JITModule>());
+
+    /** If this module was made by make_tiered and the optimized
+     * version of it has finished compiling, return the optimized
+     * version. Otherwise return this module. If wait is true, block
+     * until the optimized version is ready. */
+    EXPORT JITModule tier_up(bool wait = false) const;
+
     /** The exports map of a JITModule contains all symbols which are
      * available to other JITModules which depend on this one. For
      * runtime modules, this is all of the symbols exported from the
@@ -1,3 +1,6 @@
+#include <map>
+#include <mutex>
+
 #include "LLVM_Runtime_Linker.h"
 #include "LLVM_Headers.h"
 
@@ -532,8 +535,10 @@ void add_underscores_to_posix_calls_on_windows(llvm::Module *m) {
     }
 }
 
-/** Create an llvm module containing the support code for a given target. */
-std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool for_shared_jit_runtime, bool just_gpu) {
+namespace {
+
+/** Parse and link the runtime modules for a given target. */
+std::unique_ptr<llvm::Module> link_initial_module_for_target(Target t, llvm::LLVMContext *c, bool for_shared_jit_runtime, bool just_gpu) {
     enum InitialModuleType {
         ModuleAOT,
         ModuleAOTNoRuntime,
@@ -756,6 +761,82 @@ std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVM
     return std::move(modules[0]);
 }
 
+// The part of a target that link_initial_module_for_target and the
+// functions it calls depend on. Targets that agree on this share an
+// initial module.
+Target runtime_target(const Target &t) {
+    Target result(t.os, t.arch, t.bits);
+    const Target::Feature runtime_features[] = {
+        Target::JIT, Target::NoRuntime, Target::Debug, Target::Profile,
+        Target::ARMv7s, Target::NoNEON, Target::SSE41, Target::AVX,
+        Target::CUDA, Target::OpenCL, Target::OpenGL, Target::OpenGLCompute,
+        Target::Renderscript, Target::Metal, Target::Matlab
+    };
+    for (Target::Feature f : runtime_features) {
+        if (t.has_feature(f)) {
+            result.set_feature(f);
+        }
+    }
+    return result;
+}
+
+// An initial module that has already been linked, saved as bitcode.
+// llvm modules can't be cloned into another context, so the bitcode
+// is parsed again into the context of each new module, which is much
+// cheaper than parsing all of the runtime modules and linking them.
+struct LinkedRuntime {
+    string bitcode;
+    string name;
+};
+
+std::mutex linked_runtimes_mutex;
+std::map<string, LinkedRuntime> linked_runtimes;
+
+}
+
+/** Create an llvm module containing the support code for a given target. */
+std::unique_ptr<llvm::Module> get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool for_shared_jit_runtime, bool just_gpu) {
+    Target key_target = runtime_target(t);
+    string key = key_target.to_string();
+    if (for_shared_jit_runtime) {
+        key += "/shared";
+    }
+    if (just_gpu) {
+        key += "/gpu";
+    }
+
+    // Entries are never removed, so a reference to one stays valid
+    // after the lock is released.
+    const LinkedRuntime *linked = NULL;
+    {
+        std::lock_guard<std::mutex> lock(linked_runtimes_mutex);
+        std::map<string, LinkedRuntime>::const_iterator iter = linked_runtimes.find(key);
+        if (iter != linked_runtimes.end()) {
+            linked = &iter->second;
+        }
+    }
+
+    if (!linked) {
+        debug(2) << "Linking initial module for " << key << "\n";
+        std::unique_ptr<llvm::Module> module =
+            link_initial_module_for_target(key_target, c, for_shared_jit_runtime, just_gpu);
+        LinkedRuntime r;
+        r.name = module->getModuleIdentifier();
+        {
+            llvm::raw_string_ostream stream(r.bitcode);
+            llvm::WriteBitcodeToFile(module.get(), stream);
+        }
+
+        // Another thread may have linked the same module in the
+        // meantime, in which case this is a no-op.
+        std::lock_guard<std::mutex> lock(linked_runtimes_mutex);
+        linked_runtimes.insert(std::make_pair(key, std::move(r)));
+        return module;
+    }
+
+    return parse_bitcode_file(linked->bitcode, c, linked->name.c_str());
+}
+
 #ifdef WITH_PTX
 std::unique_ptr<llvm::Module> get_initial_module_for_ptx_device(Target target, llvm::LLVMContext *c) {
     std::vector<std::unique_ptr<llvm::Module>> modules;
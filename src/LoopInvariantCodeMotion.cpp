@@ -0,0 +1,402 @@
+#include <map>
+
+#include "LoopInvariantCodeMotion.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+bool is_pure_intrinsic(const string &name) {
+    return (name == Call::bitwise_and ||
+            name == Call::bitwise_not ||
+            name == Call::bitwise_xor ||
+            name == Call::bitwise_or ||
+            name == Call::shift_left ||
+            name == Call::shift_right ||
+            name == Call::abs ||
+            name == Call::absd ||
+            name == Call::lerp ||
+            name == Call::popcount ||
+            name == Call::count_leading_zeros ||
+            name == Call::count_trailing_zeros ||
+            name == Call::reinterpret ||
+            name == Call::saturating_add ||
+            name == Call::saturating_sub ||
+            name == Call::halving_add ||
+            name == Call::rounding_halving_add ||
+            name == Call::mul_hi ||
+            name == Call::rounding_shift_right);
+}
+
+// Check that an expression can be evaluated before a loop, even in
+// cases where the loop wouldn't have evaluated it at all (e.g. it
+// runs zero times, or the expression is guarded by an if).
+class CanHoist : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *) {
+        result = false;
+    }
+
+    void visit(const Variable *op) {
+        // Handles may refer to allocations made inside the loop.
+        if (op->type.is_handle()) {
+            result = false;
+        }
+    }
+
+    void visit(const Call *op) {
+        // Leave likely in place so that it still marks the branch it
+        // was attached to.
+        if (op->call_type != Call::Intrinsic || !is_pure_intrinsic(op->name)) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    // Integer division by zero faults.
+    bool safe_divisor(Expr b) {
+        return b.type().is_float() || (is_const(b) && !is_zero(b));
+    }
+
+    void visit(const Div *op) {
+        if (!safe_divisor(op->b)) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Mod *op) {
+        if (!safe_divisor(op->b)) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result;
+    CanHoist() : result(true) {}
+};
+
+bool can_hoist(Expr e) {
+    CanHoist c;
+    e.accept(&c);
+    return c.result;
+}
+
+// Count how many times each name is bound. Only lets with a unique
+// name can be moved without changing which definition a use refers
+// to.
+class CountDefinitions : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Let *op) {
+        count[op->name]++;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const LetStmt *op) {
+        count[op->name]++;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) {
+        count[op->name]++;
+        IRVisitor::visit(op);
+    }
+
+public:
+    map<string, int> count;
+};
+
+// The state for each enclosing loop.
+struct LoopFrame {
+    string loop_var;
+    // Variables defined inside the loop, but not inside any loop
+    // nested within it, including the loop variable.
+    Scope<int> inner_vars;
+    // The lets to compute before the loop, in order.
+    vector<pair<string, Expr>> lets;
+};
+
+class LoopInvariantCodeMotion : public IRMutator {
+    // The enclosing loops, innermost last.
+    vector<LoopFrame *> loops;
+
+    map<string, int> definitions;
+
+    // Find the outermost loop that an expression doesn't depend
+    // on. Returns loops.size() if it depends on the innermost loop.
+    size_t invariant_level(Expr e) {
+        for (size_t i = loops.size(); i > 0; i--) {
+            if (expr_uses_vars(e, loops[i-1]->inner_vars)) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    // Make a let to compute the given value before the loop at the
+    // given level, reusing an existing one if possible.
+    void add_let(size_t level, const string &name, Expr value) {
+        loops[level]->lets.push_back({name, value});
+        if (level > 0) {
+            loops[level-1]->inner_vars.push(name, 0);
+        }
+    }
+
+    Expr hoist(Expr e, size_t level) {
+        for (const pair<string, Expr> &let : loops[level]->lets) {
+            if (equal(let.second, e)) {
+                return Variable::make(e.type(), let.first);
+            }
+        }
+        string name = unique_name('t');
+        add_let(level, name, e);
+        return Variable::make(e.type(), name);
+    }
+
+    // Try to write an index as stride * var + offset, where the
+    // stride and offset don't depend on the innermost loop.
+    bool linear(Expr e, const string &var, Expr &stride, Expr &offset) {
+        if (e.type() != Int(32)) {
+            return false;
+        }
+        const Variable *v = e.as<Variable>();
+        if (v && v->name == var) {
+            stride = 1;
+            offset = 0;
+            return true;
+        } else if (!expr_uses_vars(e, loops.back()->inner_vars)) {
+            stride = 0;
+            offset = e;
+            return true;
+        }
+
+        Expr sa, oa, sb, ob;
+        if (const Add *add = e.as<Add>()) {
+            if (linear(add->a, var, sa, oa) && linear(add->b, var, sb, ob)) {
+                stride = sa + sb;
+                offset = oa + ob;
+                return true;
+            }
+        } else if (const Sub *sub = e.as<Sub>()) {
+            if (linear(sub->a, var, sa, oa) && linear(sub->b, var, sb, ob)) {
+                stride = sa - sb;
+                offset = oa - ob;
+                return true;
+            }
+        } else if (const Mul *mul = e.as<Mul>()) {
+            if (linear(mul->a, var, sa, oa) && linear(mul->b, var, sb, ob)) {
+                if (is_zero(sa)) {
+                    stride = sb * oa;
+                    offset = ob * oa;
+                    return true;
+                } else if (is_zero(sb)) {
+                    stride = sa * ob;
+                    offset = oa * ob;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Rewrite an index that is affine in the innermost loop variable
+    // to put the loop variable on the outside, so that the rest of
+    // it can be hoisted.
+    Expr strength_reduce(Expr index) {
+        if (loops.empty()) {
+            return index;
+        }
+        const string &var = loops.back()->loop_var;
+        Expr stride, offset;
+        if (!linear(index, var, stride, offset)) {
+            return index;
+        }
+        stride = simplify(stride);
+        offset = simplify(offset);
+        if (is_zero(stride)) {
+            return index;
+        }
+
+        Expr result = Variable::make(Int(32), var);
+        if (!is_one(stride)) {
+            result = Mul::make(result, stride);
+        }
+        if (!is_zero(offset)) {
+            result = Add::make(result, offset);
+        }
+        if (equal(result, index)) {
+            return index;
+        }
+        return result;
+    }
+
+    using IRMutator::visit;
+
+    void visit(const Load *op) {
+        Expr index = mutate(strength_reduce(op->index));
+        if (index.same_as(op->index)) {
+            expr = op;
+        } else {
+            expr = Load::make(op->type, op->name, index, op->image, op->param);
+        }
+    }
+
+    void visit(const Store *op) {
+        Expr value = mutate(op->value);
+        Expr index = mutate(strength_reduce(op->index));
+        if (value.same_as(op->value) && index.same_as(op->index)) {
+            stmt = op;
+        } else {
+            stmt = Store::make(op->name, value, index);
+        }
+    }
+
+    void visit(const Ramp *op) {
+        Expr base = mutate(strength_reduce(op->base));
+        Expr stride = mutate(op->stride);
+        if (base.same_as(op->base) && stride.same_as(op->stride)) {
+            expr = op;
+        } else {
+            expr = Ramp::make(base, stride, op->lanes);
+        }
+    }
+
+    void visit(const Let *op) {
+        if (loops.empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+        Expr value = mutate(op->value);
+        loops.back()->inner_vars.push(op->name, 0);
+        Expr body = mutate(op->body);
+        loops.back()->inner_vars.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            expr = op;
+        } else {
+            expr = Let::make(op->name, value, body);
+        }
+    }
+
+    void visit(const LetStmt *op) {
+        if (loops.empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        size_t level = invariant_level(op->value);
+        if (level < loops.size() && definitions[op->name] == 1 && can_hoist(op->value)) {
+            add_let(level, op->name, op->value);
+            stmt = mutate(op->body);
+            return;
+        }
+
+        Expr value = mutate(op->value);
+        loops.back()->inner_vars.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        loops.back()->inner_vars.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = LetStmt::make(op->name, value, body);
+        }
+    }
+
+    void visit(const Allocate *op) {
+        if (loops.empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+        loops.back()->inner_vars.push(op->name, 0);
+        IRMutator::visit(op);
+        loops.back()->inner_vars.pop(op->name);
+    }
+
+    void visit(const For *op) {
+        // Leave device code alone.
+        if (op->device_api != DeviceAPI::Host &&
+            op->device_api != DeviceAPI::Parent) {
+            stmt = op;
+            return;
+        }
+
+        Expr min = mutate(op->min);
+        Expr extent = mutate(op->extent);
+
+        LoopFrame frame;
+        frame.loop_var = op->name;
+        frame.inner_vars.push(op->name, 0);
+        loops.push_back(&frame);
+        Stmt body = mutate(op->body);
+        loops.pop_back();
+
+        Stmt result;
+        if (min.same_as(op->min) && extent.same_as(op->extent) && body.same_as(op->body)) {
+            result = op;
+        } else {
+            result = For::make(op->name, min, extent, op->for_type, op->device_api, body);
+        }
+
+        // The lets computed before this loop are inside the enclosing
+        // loop, so parts of them may be invariant in that loop too.
+        vector<pair<string, Expr>> lets;
+        for (const pair<string, Expr> &let : frame.lets) {
+            size_t level = invariant_level(let.second);
+            if (level < loops.size()) {
+                loops.back()->inner_vars.pop(let.first);
+                add_let(level, let.first, let.second);
+            } else {
+                lets.push_back({let.first, mutate(let.second)});
+            }
+        }
+
+        for (size_t i = lets.size(); i > 0; i--) {
+            result = LetStmt::make(lets[i-1].first, lets[i-1].second, result);
+        }
+        stmt = result;
+    }
+
+public:
+    LoopInvariantCodeMotion(const map<string, int> &d) : definitions(d) {}
+
+    Expr mutate(Expr e) {
+        if (!loops.empty() && e.defined() && e.type().is_scalar() &&
+            !is_const(e) && !e.as<Variable>()) {
+            size_t level = invariant_level(e);
+            if (level < loops.size() && can_hoist(e)) {
+                return hoist(e, level);
+            }
+        }
+        return IRMutator::mutate(e);
+    }
+
+    using IRMutator::mutate;
+};
+
+}
+
+Stmt loop_invariant_code_motion(Stmt s) {
+    CountDefinitions c;
+    s.accept(&c);
+    return LoopInvariantCodeMotion(c.count).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,30 @@
+#ifndef HALIDE_LOOP_INVARIANT_CODE_MOTION_H
+#define HALIDE_LOOP_INVARIANT_CODE_MOTION_H
+
+/** \file
+ * Defines the lowering pass that hoists loop-invariant values out of
+ * loops, and rewrites affine indices in terms of the loop variable.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Move pure scalar expressions and lets that don't depend on a loop
+ * out of it, as far out as they can go. This includes the values
+ * checked by asserts inside loops. Values that could fault, such as
+ * loads and integer division by an unknown value, are left in
+ * place. Load and store indices are also rewritten to the form
+ * loop_var * stride + offset, with the stride and offset hoisted, so
+ * that the code generator sees a simple induction variable it can
+ * turn into a pointer increment. Should be run after the final
+ * simplification, as the simplifier would substitute many of the
+ * hoisted lets back in. Only runs for targets with the
+ * HoistLoopInvariants feature. */
+Stmt loop_invariant_code_motion(Stmt s);
+
+}
+}
+
+#endif
@@ -11,10 +11,12 @@
 #include "Bounds.h"
 #include "BoundsInference.h"
 #include "CSE.h"
+#include "ComputeWith.h"
 #include "Debug.h"
 #include "DebugToFile.h"
 #include "Deinterleave.h"
 #include "EarlyFree.h"
+#include "EmulateFloat16Math.h"
 #include "FindCalls.h"
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
@@ -22,12 +24,16 @@
 #include "InjectImageIntrinsics.h"
 #include "InjectOpenGLIntrinsics.h"
 #include "Inline.h"
+#include "InvariantDivision.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "LoopInvariantCodeMotion.h"
 #include "Memoization.h"
 #include "PartitionLoops.h"
 #include "Profiling.h"
+#include "PromoteAccumulators.h"
+#include "PromoteRegisters.h"
 #include "Qualify.h"
 #include "RealizationOrder.h"
 #include "RemoveDeadAllocations.h"
@@ -36,11 +42,13 @@
 #include "ScheduleFunctions.h"
 #include "SelectGPUAPI.h"
 #include "SkipStages.h"
+#include "SkipTiles.h"
 #include "SlidingWindow.h"
 #include "Simplify.h"
 #include "StorageFlattening.h"
 #include "StorageFolding.h"
 #include "Substitute.h"
+#include "TileList.h"
 #include "Tracing.h"
 #include "UnifyDuplicateLets.h"
 #include "UniquifyVariableNames.h"
@@ -59,7 +67,8 @@ using std::map;
 using std::pair;
 using std::make_pair;
 
-Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const Target &t, const vector<IRMutator *> &custom_passes) {
+Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const Target &t,
+           const vector<IRMutator *> &custom_passes, const Parameter &tile_list) {
 
     // Compute an environment
     map<string, Function> env;
@@ -117,6 +126,23 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = bounds_inference(s, outputs, order, env, func_bounds);
     debug(2) << "Lowering after computation bounds inference:\n" << s << '\n';
 
+    if (tile_list.defined()) {
+        internal_assert(outputs.size() == 1);
+        debug(1) << "Injecting loop over the tile list...\n";
+        s = inject_tile_list(s, outputs[0], tile_list);
+        debug(2) << "Lowering after injecting loop over the tile list:\n" << s << '\n';
+    }
+
+    if (any_memoized) {
+        debug(1) << "Injecting memoization of tiles...\n";
+        s = inject_memoized_tiles(s, env, pipeline_name);
+        debug(2) << "Lowering after injecting memoization of tiles:\n" << s << '\n';
+    }
+
+    debug(1) << "Skipping tiles where a mask is zero...\n";
+    s = skip_tiles(s, env);
+    debug(2) << "Lowering after skipping tiles where a mask is zero:\n" << s << '\n';
+
     debug(1) << "Performing sliding window optimization...\n";
     s = sliding_window(s, env);
     debug(2) << "Lowering after sliding window:\n" << s << '\n';
@@ -137,7 +163,7 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
 
     debug(1) << "Performing storage folding optimization...\n";
-    s = storage_folding(s);
+    s = storage_folding(s, env);
     debug(2) << "Lowering after storage folding:\n" << s << '\n';
 
     debug(1) << "Injecting debug_to_file calls...\n";
@@ -152,6 +178,10 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = skip_stages(s, order);
     debug(2) << "Lowering after dynamically skipping stages:\n" << s << "\n\n";
 
+    debug(1) << "Fusing loop nests of stages computed with each other...\n";
+    s = fuse_compute_with(s, env);
+    debug(2) << "Lowering after compute_with fusion:\n" << s << "\n\n";
+
     if (t.has_feature(Target::OpenGL) || t.has_feature(Target::Renderscript)) {
         debug(1) << "Injecting image intrinsics...\n";
         s = inject_image_intrinsics(s);
@@ -218,6 +248,22 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = simplify(s);
     debug(2) << "Lowering after rewriting vector interleavings:\n" << s << "\n\n";
 
+    debug(1) << "Lowering vector division by loop invariants...\n";
+    s = lower_invariant_division(s);
+    debug(2) << "Lowering after lowering vector division by loop invariants:\n" << s << "\n\n";
+
+    debug(1) << "Emulating float16 math...\n";
+    s = emulate_float16_math(s, t);
+    debug(2) << "Lowering after emulating float16 math:\n" << s << "\n\n";
+
+    debug(1) << "Keeping accumulators in registers...\n";
+    s = promote_accumulators(s, t);
+    debug(2) << "Lowering after promoting accumulators:\n" << s << "\n\n";
+
+    debug(1) << "Promoting small allocations to registers...\n";
+    s = promote_registers(s);
+    debug(2) << "Lowering after promoting allocations to registers:\n" << s << "\n\n";
+
     debug(1) << "Partitioning loops to simplify boundary conditions...\n";
     s = partition_loops(s);
     s = simplify(s);
@@ -244,6 +290,12 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = simplify(s);
     debug(1) << "Lowering after final simplification:\n" << s << "\n\n";
 
+    if (t.has_feature(Target::HoistLoopInvariants)) {
+        debug(1) << "Hoisting loop invariants...\n";
+        s = loop_invariant_code_motion(s);
+        debug(2) << "Lowering after hoisting loop invariants:\n" << s << "\n\n";
+    }
+
     if (!custom_passes.empty()) {
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
@@ -17,9 +17,12 @@ class IRMutator;
 
 /** Given a halide function with a schedule, create a statement that
  * evaluates it. Automatically pulls in all the functions f depends
- * on. Some stages of lowering may be target-specific. */
+ * on. Some stages of lowering may be target-specific. If a tile list
+ * buffer parameter is given, the single output is only computed over
+ * the tiles in it (see inject_tile_list). */
 EXPORT Stmt lower(const std::vector<Function> &outputs, const std::string &pipeline_name, const Target &t,
-                  const std::vector<IRMutator *> &custom_passes = std::vector<IRMutator *>());
+                  const std::vector<IRMutator *> &custom_passes = std::vector<IRMutator *>(),
+                  const Parameter &tile_list = Parameter());
 
 void lower_test();
 
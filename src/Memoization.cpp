@@ -189,6 +189,29 @@ class KeyInfo {
     }
 #endif
 
+    // The arguments of the runtime cache calls: the key, the bounds
+    // it was computed over, and the buffers of the storage.
+    std::vector<Expr> cache_call_args(const std::string &key_allocation_name, const std::string &computed_bounds_name,
+                                      int32_t tuple_count, const std::string &storage_base_name) {
+        std::vector<Expr> args;
+        args.push_back(Call::make(type_of<uint8_t *>(), Call::address_of,
+                                  {Load::make(type_of<uint8_t>(), key_allocation_name, Expr(0), Buffer(), Parameter())},
+                                  Call::Intrinsic));
+        args.push_back(key_size());
+        args.push_back(Variable::make(type_of<buffer_t *>(), computed_bounds_name));
+        args.push_back(tuple_count);
+        std::vector<Expr> buffers;
+        if (tuple_count == 1) {
+            buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + ".buffer"));
+        } else {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + "." + std::to_string(i) + ".buffer"));
+            }
+        }
+        args.push_back(Call::make(type_of<buffer_t **>(), Call::make_struct, buffers, Call::Intrinsic));
+        return args;
+    }
+
 public:
   KeyInfo(const Function &function, const std::string &name)
         : top_level_name(name), function_name(function.name())
@@ -305,49 +328,38 @@ public:
     // by the code in this call.
     Expr generate_lookup(std::string key_allocation_name, std::string computed_bounds_name,
                          int32_t tuple_count, std::string storage_base_name) {
-        std::vector<Expr> args;
-        args.push_back(Call::make(type_of<uint8_t *>(), Call::address_of,
-                                  {Load::make(type_of<uint8_t>(), key_allocation_name, Expr(0), Buffer(), Parameter())},
-                                  Call::Intrinsic));
-        args.push_back(key_size());
-        args.push_back(Variable::make(type_of<buffer_t *>(), computed_bounds_name));
-        args.push_back(tuple_count);
-        std::vector<Expr> buffers;
-        if (tuple_count == 1) {
-            buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + ".buffer"));
-        } else {
-            for (int32_t i = 0; i < tuple_count; i++) {
-                buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + "." + std::to_string(i) + ".buffer"));
-            }
-        }
-        args.push_back(Call::make(type_of<buffer_t **>(), Call::make_struct, buffers, Call::Intrinsic));
-
+        std::vector<Expr> args = cache_call_args(key_allocation_name, computed_bounds_name,
+                                                 tuple_count, storage_base_name);
         return Call::make(Int(32), "halide_memoization_cache_lookup", args, Call::Extern);
     }
 
     // Returns a statement which will store the result of a computation under this key
     Stmt store_computation(std::string key_allocation_name, std::string computed_bounds_name,
                            int32_t tuple_count, std::string storage_base_name) {
-        std::vector<Expr> args;
-        args.push_back(Call::make(type_of<uint8_t *>(), Call::address_of,
-                                  {Load::make(type_of<uint8_t>(), key_allocation_name, Expr(0), Buffer(), Parameter())},
-                                  Call::Intrinsic));
-        args.push_back(key_size());
-        args.push_back(Variable::make(type_of<buffer_t *>(), computed_bounds_name));
-        args.push_back(tuple_count);
-        std::vector<Expr> buffers;
-        if (tuple_count == 1) {
-            buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + ".buffer"));
-        } else {
-            for (int32_t i = 0; i < tuple_count; i++) {
-                buffers.push_back(Variable::make(type_of<buffer_t *>(), storage_base_name + "." + std::to_string(i) + ".buffer"));
-            }
-        }
-        args.push_back(Call::make(type_of<buffer_t **>(), Call::make_struct, buffers, Call::Intrinsic));
-
+        std::vector<Expr> args = cache_call_args(key_allocation_name, computed_bounds_name,
+                                                 tuple_count, storage_base_name);
         // This is actually a void call. How to indicate that? Look at Extern_ stuff.
         return Evaluate::make(Call::make(Bool(), "halide_memoization_cache_store", args, Call::Extern));
     }
+
+    // Returns an expression which is zero if the tile given by
+    // tile_bounds_name was found in the cache, in which case it has
+    // been copied into the storage.
+    Expr generate_tile_lookup(std::string key_allocation_name, std::string tile_bounds_name,
+                              int32_t tuple_count, std::string storage_base_name) {
+        std::vector<Expr> args = cache_call_args(key_allocation_name, tile_bounds_name,
+                                                 tuple_count, storage_base_name);
+        return Call::make(Int(32), "halide_memoization_cache_lookup_tile", args, Call::Extern);
+    }
+
+    // Returns a statement which will copy a computed tile from the
+    // storage into the cache under this key
+    Stmt store_tile(std::string key_allocation_name, std::string tile_bounds_name,
+                    int32_t tuple_count, std::string storage_base_name) {
+        std::vector<Expr> args = cache_call_args(key_allocation_name, tile_bounds_name,
+                                                 tuple_count, storage_base_name);
+        return Evaluate::make(Call::make(Bool(), "halide_memoization_cache_store_tile", args, Call::Extern));
+    }
 };
 
 }
@@ -391,6 +403,13 @@ private:
                            << "it has compute and storage scheduled at different loop levels.\n";
             }
 
+            // Functions memoized in tiles are handled after bounds
+            // inference, by inject_memoized_tiles.
+            if (!f.schedule().memoize_tiles().empty()) {
+                IRMutator::visit(op);
+                return;
+            }
+
             Stmt produce = mutate(op->produce);
             Stmt update = mutate(op->update);
             Stmt consume = mutate(op->consume);
@@ -444,7 +463,7 @@ private:
 
             Stmt generate_key = Block::make(key_info.generate_key(cache_key_name), computed_bounds_let);
             Stmt cache_key_alloc =
-                Allocate::make(cache_key_name, UInt(8), {key_info.key_size()},
+                Allocate::make(cache_key_name, UInt(8), MemoryType::Auto, {key_info.key_size()},
                                const_true(), generate_key);
 
             stmt = cache_key_alloc;
@@ -462,6 +481,130 @@ Stmt inject_memoization(Stmt s, const std::map<std::string, Function> &env,
     return injector.mutate(s);
 }
 
+// Inject a loop over the tiles of functions memoized in tiles, which
+// looks up each tile and computes the ones that miss.
+class InjectMemoizedTiles : public IRMutator {
+public:
+    const std::map<std::string, Function> &env;
+    const std::string &top_level_name;
+
+    InjectMemoizedTiles(const std::map<std::string, Function> &e, const std::string &name) :
+        env(e), top_level_name(name) {}
+private:
+
+    using IRMutator::visit;
+
+    void visit(const ProducerConsumer *op) {
+        std::map<std::string, Function>::const_iterator iter = env.find(op->name);
+        if (iter == env.end() ||
+            !iter->second.schedule().memoized() ||
+            iter->second.schedule().memoize_tiles().empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        const Function f(iter->second);
+        const std::vector<MemoizeTile> &tiles = f.schedule().memoize_tiles();
+
+        user_assert(!f.has_extern_definition())
+            << "Function " << f.name() << " cannot be memoized in tiles because "
+            << "it has an extern definition.\n";
+        user_assert(f.schedule().storage_splits().empty())
+            << "Function " << f.name() << " cannot be memoized in tiles because "
+            << "its storage is split.\n";
+        user_assert(f.dimensions() <= 4)
+            << "Function " << f.name() << " cannot be memoized in tiles because "
+            << "it has more than four dimensions.\n";
+
+        // Find the dimension of each tiled var, and check that each
+        // tile can be computed on its own.
+        std::vector<int> tile_dims;
+        for (const MemoizeTile &t : tiles) {
+            int d = 0;
+            while (f.args()[d] != t.var) {
+                d++;
+            }
+            tile_dims.push_back(d);
+            for (const UpdateDefinition &u : f.updates()) {
+                const Variable *v = u.args[d].as<Variable>();
+                user_assert(v && v->name == t.var)
+                    << "Function " << f.name() << " cannot be memoized in tiles over "
+                    << t.var << " because one of its update definitions writes to "
+                    << u.args[d] << " instead of " << t.var << ".\n";
+            }
+        }
+
+        Stmt produce = mutate(op->produce);
+        Stmt update = mutate(op->update);
+        Stmt consume = mutate(op->consume);
+
+        KeyInfo key_info(f, top_level_name);
+
+        std::string cache_key_name = op->name + ".cache_key";
+        std::string cache_miss_name = op->name + ".cache_miss";
+        std::string tile_bounds_name = op->name + ".tile_bounds.buffer";
+
+        // Compute every stage of a tile that misses, then store it.
+        Stmt compute = update.defined() ? Block::make(produce, update) : produce;
+        compute = Block::make(compute, key_info.store_tile(cache_key_name, tile_bounds_name, f.outputs(), op->name));
+        Stmt body = IfThenElse::make(Variable::make(Bool(), cache_miss_name), compute);
+        Expr lookup = key_info.generate_tile_lookup(cache_key_name, tile_bounds_name, f.outputs(), op->name);
+        body = LetStmt::make(cache_miss_name, NE::make(lookup, 0), body);
+
+        // The bounds of the tile along the tiled dimensions, and of
+        // the whole computed region along the others.
+        std::string last_stage = op->name + ".s" + std::to_string(f.updates().size()) + ".";
+        std::vector<Expr> tile_bounds_args;
+        tile_bounds_args.push_back(Call::make(Handle(), Call::null_handle, std::vector<Expr>(), Call::Intrinsic));
+        tile_bounds_args.push_back(make_zero(f.output_types()[0]));
+        for (const std::string &arg : f.args()) {
+            Expr min = Variable::make(Int(32), last_stage + arg + ".min");
+            Expr max = Variable::make(Int(32), last_stage + arg + ".max");
+            tile_bounds_args.push_back(min);
+            tile_bounds_args.push_back(max - min + 1);
+            tile_bounds_args.push_back(0);
+        }
+        Expr tile_bounds = Call::make(Handle(), Call::create_buffer_t, tile_bounds_args, Call::Intrinsic);
+        body = LetStmt::make(tile_bounds_name, tile_bounds, body);
+
+        // Redefine the region each stage computes to be the tile. The
+        // region was rounded out to whole tiles by bounds inference,
+        // so the clamp doesn't change anything, but it tells
+        // allocation bounds inference that the tiles are inside it.
+        for (size_t i = 0; i < tiles.size(); i++) {
+            Expr tile = Variable::make(Int(32), op->name + ".memoize_tile." + tiles[i].var);
+            for (size_t stage = 0; stage <= f.updates().size(); stage++) {
+                std::string prefix = op->name + ".s" + std::to_string(stage) + "." + tiles[i].var;
+                Expr old_min = Variable::make(Int(32), prefix + ".min");
+                Expr old_max = Variable::make(Int(32), prefix + ".max");
+                Expr min = tile * tiles[i].extent;
+                body = LetStmt::make(prefix + ".min", clamp(min, old_min, old_max), body);
+                body = LetStmt::make(prefix + ".max", clamp(min + (tiles[i].extent - 1), old_min, old_max), body);
+            }
+        }
+
+        for (size_t i = 0; i < tiles.size(); i++) {
+            std::string prefix = last_stage + tiles[i].var;
+            Expr first = Variable::make(Int(32), prefix + ".min") / tiles[i].extent;
+            Expr last = Variable::make(Int(32), prefix + ".max") / tiles[i].extent;
+            body = For::make(op->name + ".memoize_tile." + tiles[i].var, first, last - first + 1,
+                             ForType::Serial, DeviceAPI::Parent, body);
+        }
+
+        stmt = ProducerConsumer::make(op->name, body, Stmt(), consume);
+        stmt = Block::make(key_info.generate_key(cache_key_name), stmt);
+        stmt = Allocate::make(cache_key_name, UInt(8), MemoryType::Auto, {key_info.key_size()},
+                              const_true(), stmt);
+    }
+};
+
+Stmt inject_memoized_tiles(Stmt s, const std::map<std::string, Function> &env,
+                           const std::string &name) {
+    InjectMemoizedTiles injector(env, name);
+
+    return injector.mutate(s);
+}
+
 class RewriteMemoizedAllocations : public IRMutator {
 public:
     RewriteMemoizedAllocations(const std::map<std::string, Function> &e)
@@ -493,7 +636,8 @@ private:
         std::string realization_name = get_realization_name(allocation->name);
         std::map<std::string, Function>::const_iterator iter = env.find(realization_name);
 
-        if (iter != env.end() && iter->second.schedule().memoized()) {
+        if (iter != env.end() && iter->second.schedule().memoized() &&
+            iter->second.schedule().memoize_tiles().empty()) {
             std::string old_innermost_realization_name = innermost_realization_name;
             innermost_realization_name = realization_name;
 
@@ -546,7 +690,7 @@ private:
                 const Allocate *allocation = allocations[i - 1];
 
                 // Make the allocation node
-                body = Allocate::make(allocation->name, allocation->type, allocation->extents, allocation->condition, body,
+                body = Allocate::make(allocation->name, allocation->type, allocation->memory_type, allocation->extents, allocation->condition, body,
                                       Call::make(Handle(), Call::extract_buffer_host,
                                                  { Variable::make(Handle(), allocation->name + ".buffer") }, Call::Intrinsic),
                                       "halide_memoization_cache_release");
@@ -24,6 +24,16 @@ Stmt inject_memoization(Stmt s, const std::map<std::string, Function> &env,
                         const std::string &name,
                         const std::vector<Function> &outputs);
 
+/** Transform the computation of Funcs memoized in tiles to loop over
+ *  the tiles, looking each one up in the runtime cache and computing
+ *  and storing back the ones that miss. This redefines the bounds of
+ *  the Func for each tile, so it should be called after bounds
+ *  inference.
+ *  Should leave other Funcs unchanged.
+ */
+Stmt inject_memoized_tiles(Stmt s, const std::map<std::string, Function> &env,
+                           const std::string &name);
+
 /** This should be called after Storage Flattening has added Allocation
  *  IR nodes. It connects the memoization cache lookups to the Allocations
  *  so they point to the buffers from the memoization cache and those buffers
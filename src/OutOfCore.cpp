@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "OutOfCore.h"
+#include "Error.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+struct MappedRawFileContents {
+    mutable RefCount ref_count;
+    string filename;
+    Type type;
+    vector<int32_t> sizes;
+    bool writable;
+    int fd;
+    uint8_t *data;
+    size_t size;
+};
+
+template<>
+EXPORT RefCount &ref_count<MappedRawFileContents>(const MappedRawFileContents *p) {
+    return p->ref_count;
+}
+
+template<>
+EXPORT void destroy<MappedRawFileContents>(const MappedRawFileContents *p) {
+    #ifndef _WIN32
+    munmap(p->data, p->size);
+    close(p->fd);
+    #endif
+    delete p;
+}
+
+namespace {
+
+int clamp_coord(int x, int size) {
+    return x < 0 ? 0 : (x >= size ? size - 1 : x);
+}
+
+// Copy a tile between a buffer and the file. When reading, parts of
+// the tile outside the file are filled in from the nearest edge.
+void copy_tile(const MappedRawFileContents *f, Buffer tile, bool to_file) {
+    user_assert(tile.defined() && tile.host_ptr()) << "Can't copy an undefined tile\n";
+    user_assert(tile.type() == f->type)
+        << "Tile of type " << tile.type() << " doesn't match the type "
+        << f->type << " of " << f->filename << "\n";
+    user_assert(tile.dimensions() <= (int)f->sizes.size())
+        << "Tile has more dimensions than " << f->filename << "\n";
+
+    // Pad everything out to four dimensions.
+    int min[4], extent[4], stride[4], size[4];
+    int64_t file_stride[4];
+    int64_t s = 1;
+    for (int d = 0; d < 4; d++) {
+        bool tile_dim = d < tile.dimensions();
+        bool file_dim = d < (int)f->sizes.size();
+        min[d] = tile_dim ? tile.min(d) : 0;
+        extent[d] = tile_dim ? tile.extent(d) : 1;
+        stride[d] = tile_dim ? tile.stride(d) : 0;
+        size[d] = file_dim ? f->sizes[d] : 1;
+        file_stride[d] = s;
+        s *= size[d];
+    }
+
+    if (to_file) {
+        user_assert(f->writable) << f->filename << " was not mapped as writable\n";
+        for (int d = 0; d < 4; d++) {
+            user_assert(min[d] >= 0 && min[d] + extent[d] <= size[d])
+                << "Tile [" << min[d] << ", " << min[d] + extent[d]
+                << ") in dimension " << d << " is outside of " << f->filename
+                << ", which has size " << size[d] << "\n";
+        }
+    }
+
+    const int elem = f->type.bytes();
+    uint8_t *host = (uint8_t *)tile.host_ptr();
+
+    // The part of each row that lies within the file.
+    int x_begin = std::max(min[0], 0), x_end = std::min(min[0] + extent[0], size[0]);
+
+    for (int w = 0; w < extent[3]; w++) {
+        for (int z = 0; z < extent[2]; z++) {
+            for (int y = 0; y < extent[1]; y++) {
+                int64_t file_row = (clamp_coord(min[1] + y, size[1]) * file_stride[1] +
+                                    clamp_coord(min[2] + z, size[2]) * file_stride[2] +
+                                    clamp_coord(min[3] + w, size[3]) * file_stride[3]);
+                uint8_t *file_ptr = f->data + file_row * elem;
+                uint8_t *tile_ptr = host + ((int64_t)y * stride[1] +
+                                            (int64_t)z * stride[2] +
+                                            (int64_t)w * stride[3]) * elem;
+
+                if (stride[0] == 1 && x_begin < x_end) {
+                    // Copy the part of the row in the file all at once.
+                    uint8_t *t = tile_ptr + (x_begin - min[0]) * elem;
+                    uint8_t *fp = file_ptr + (int64_t)x_begin * elem;
+                    size_t bytes = (size_t)(x_end - x_begin) * elem;
+                    if (to_file) {
+                        memcpy(fp, t, bytes);
+                    } else {
+                        memcpy(t, fp, bytes);
+                    }
+                }
+
+                for (int x = 0; x < extent[0]; x++) {
+                    int fx = min[0] + x;
+                    if (stride[0] == 1 && fx >= x_begin && fx < x_end) continue;
+                    uint8_t *t = tile_ptr + (int64_t)x * stride[0] * elem;
+                    uint8_t *fp = file_ptr + (int64_t)clamp_coord(fx, size[0]) * elem;
+                    if (to_file) {
+                        memcpy(fp, t, elem);
+                    } else {
+                        memcpy(t, fp, elem);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!to_file) {
+        tile.set_host_dirty();
+    }
+}
+
+}
+
+}
+
+MappedRawFile::MappedRawFile(const std::string &filename, Type t,
+                             const std::vector<int32_t> &sizes, bool writable) {
+    user_assert(!sizes.empty() && sizes.size() <= 4)
+        << "MappedRawFile " << filename << " must have between one and four dimensions\n";
+    user_assert(t.lanes() == 1) << "MappedRawFile " << filename << " can't have a vector type\n";
+
+    uint64_t size = t.bytes();
+    for (int32_t s : sizes) {
+        user_assert(s > 0) << "MappedRawFile " << filename << " has a non-positive size\n";
+        size *= s;
+    }
+
+    #ifdef _WIN32
+    user_error << "MappedRawFile is not supported on Windows\n";
+    #else
+    int fd = open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    user_assert(fd >= 0) << "Could not open " << filename << "\n";
+
+    bool size_ok;
+    if (writable) {
+        size_ok = ftruncate(fd, (off_t)size) == 0;
+    } else {
+        struct stat st;
+        size_ok = fstat(fd, &st) == 0 && (uint64_t)st.st_size >= size;
+    }
+    if (!size_ok) {
+        close(fd);
+        user_error << filename << " could not be " << (writable ? "resized to " : "read as ")
+                   << size << " bytes\n";
+    }
+
+    void *data = mmap(NULL, (size_t)size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                      MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        user_error << "Could not map " << filename << " into memory\n";
+    }
+
+    Internal::MappedRawFileContents *c = new Internal::MappedRawFileContents;
+    c->filename = filename;
+    c->type = t;
+    c->sizes = sizes;
+    c->writable = writable;
+    c->fd = fd;
+    c->data = (uint8_t *)data;
+    c->size = (size_t)size;
+    contents = c;
+    #endif
+}
+
+TileReader MappedRawFile::reader() const {
+    user_assert(defined()) << "Can't read from an undefined MappedRawFile\n";
+    Internal::IntrusivePtr<Internal::MappedRawFileContents> c = contents;
+    return [=](Buffer tile) {
+        Internal::copy_tile(c.ptr, tile, false);
+    };
+}
+
+TileWriter MappedRawFile::writer() const {
+    user_assert(defined()) << "Can't write to an undefined MappedRawFile\n";
+    user_assert(contents.ptr->writable)
+        << contents.ptr->filename << " was not mapped as writable\n";
+    Internal::IntrusivePtr<Internal::MappedRawFileContents> c = contents;
+    return [=](Buffer tile) {
+        Internal::copy_tile(c.ptr, tile, true);
+    };
+}
+
+Type MappedRawFile::type() const {
+    user_assert(defined()) << "MappedRawFile is undefined\n";
+    return contents.ptr->type;
+}
+
+const std::vector<int32_t> &MappedRawFile::sizes() const {
+    user_assert(defined()) << "MappedRawFile is undefined\n";
+    return contents.ptr->sizes;
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef HALIDE_OUT_OF_CORE_H
+#define HALIDE_OUT_OF_CORE_H
+
+/** \file
+ * Defines the tile sources and sinks used by Pipeline::realize_tiled
+ * to run pipelines over images too large to hold in memory.
+ */
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Buffer.h"
+#include "IntrusivePtr.h"
+
+namespace Halide {
+
+/** A function that fills in a tile of an input image. The buffer
+ * passed in is already allocated, and its min and extent fields give
+ * the region required, including any halo. The region may extend
+ * beyond the edges of the image, in which case the reader decides
+ * what to fill in. It may be called from a thread other than the one
+ * that called realize_tiled. */
+typedef std::function<void(Buffer)> TileReader;
+
+/** A function that consumes a tile of the output. The buffer's min
+ * and extent fields give the region of the output it covers. It may
+ * be called from a thread other than the one that called
+ * realize_tiled. */
+typedef std::function<void(Buffer)> TileWriter;
+
+namespace Internal {
+struct MappedRawFileContents;
+}
+
+/** A memory-mapped file containing a dense image with no header,
+ * with the first dimension innermost. Can be used as a tile source
+ * for inputs to realize_tiled, and as a tile sink for its output. The
+ * file is only ever accessed a tile at a time, so it may be much
+ * larger than physical memory.
+ *
+ * Copies of a MappedRawFile refer to the same mapping, and the file
+ * stays mapped as long as any copy, reader, or writer of it is
+ * alive. */
+class MappedRawFile {
+    Internal::IntrusivePtr<Internal::MappedRawFileContents> contents;
+
+public:
+    MappedRawFile() : contents(NULL) {}
+
+    /** Map a file containing an image of the given type and size. If
+     * writable is true, the file is created (or resized) to the right
+     * size, and can be written to. Otherwise it must already exist
+     * and be large enough. Not supported on Windows. */
+    EXPORT MappedRawFile(const std::string &filename, Type t,
+                         const std::vector<int32_t> &sizes, bool writable = false);
+
+    /** Get a tile reader that copies regions of this file. Parts of
+     * the tile outside the image are filled in by clamping the
+     * coordinates to the nearest edge. */
+    EXPORT TileReader reader() const;
+
+    /** Get a tile writer that copies tiles into this file. Tiles must
+     * lie within the image. The file must be writable. */
+    EXPORT TileWriter writer() const;
+
+    /** Get the type of the elements of the file. */
+    EXPORT Type type() const;
+
+    /** Get the size of the image in each dimension. */
+    EXPORT const std::vector<int32_t> &sizes() const;
+
+    /** Check if this refers to a mapped file. */
+    bool defined() const {
+        return contents.defined();
+    }
+};
+
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include "IROperator.h"
 #include "Substitute.h"
 #include "CSE.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
 
 namespace Halide {
 namespace Internal {
@@ -152,5 +154,61 @@ bool can_parallelize_rvar(const string &v,
     return is_zero(hazard);
 }
 
+namespace {
+
+/** If the binary operator is an accumulation into the site given by
+ * args, return the other operand. */
+template<typename T>
+Expr accumulated_operand(Expr value, const string &f, const vector<Expr> &args) {
+    const T *op = value.as<T>();
+    if (!op) return Expr();
+    Expr operands[2] = {op->a, op->b};
+    for (int i = 0; i < 2; i++) {
+        const Call *call = operands[i].as<Call>();
+        if (!call || call->name != f || call->call_type != Call::Halide ||
+            call->args.size() != args.size()) {
+            continue;
+        }
+        bool same_site = true;
+        for (size_t j = 0; j < args.size(); j++) {
+            same_site = same_site && equal(call->args[j], args[j]);
+        }
+        if (same_site) {
+            return operands[1-i];
+        }
+    }
+    return Expr();
+}
+
+}
+
+bool is_associative_rvar(const string &v,
+                         const string &f,
+                         const UpdateDefinition &r) {
+    if (r.values.size() != 1) {
+        return false;
+    }
+
+    for (size_t i = 0; i < r.args.size(); i++) {
+        if (expr_uses_var(r.args[i], v)) {
+            return false;
+        }
+    }
+
+    Expr value = r.values[0];
+    Expr other = accumulated_operand<Add>(value, f, r.args);
+    if (!other.defined()) other = accumulated_operand<Mul>(value, f, r.args);
+    if (!other.defined()) other = accumulated_operand<Min>(value, f, r.args);
+    if (!other.defined()) other = accumulated_operand<Max>(value, f, r.args);
+    if (!other.defined()) {
+        return false;
+    }
+
+    // The value being accumulated must not depend on the func itself.
+    FindLoads find(f);
+    other.accept(&find);
+    return find.loads.empty();
+}
+
 }
 }
@@ -3,8 +3,8 @@
 
 /** \file
  *
- * Method for checking if it's safe to parallelize an update
- * definition across a reduction variable.
+ * Methods for checking if it's safe to parallelize or vectorize an
+ * update definition across a reduction variable.
  */
 
 #include "Function.h"
@@ -21,6 +21,17 @@ bool can_parallelize_rvar(const std::string &rvar,
                           const std::string &func,
                           const UpdateDefinition &r);
 
+/** Returns whether an update definition is a simple accumulation
+ * across a specific variable, using an associative operator, into a
+ * site that doesn't depend on that variable. E.g. f(x) = f(x) + g(x,
+ * r) is such an accumulation across r. Vectorizing such a variable
+ * can be done with a horizontal reduction of the vector. Float
+ * addition and multiplication are treated as associative.
+ */
+bool is_associative_rvar(const std::string &rvar,
+                         const std::string &func,
+                         const UpdateDefinition &r);
+
 }
 }
 
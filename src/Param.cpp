@@ -1,4 +1,5 @@
 #include "Param.h"
+#include "IROperator.h"
 
 
 namespace Halide {
@@ -120,7 +121,9 @@ Internal::Parameter OutputImageParam::parameter() const {
 }
 
 OutputImageParam::operator Argument() const {
-    return Argument(name(), kind, type(), dimensions());
+    Argument arg(name(), kind, type(), dimensions());
+    arg.storage_blocks = param.storage_blocks();
+    return arg;
 }
 
 OutputImageParam::operator ExternFuncArgument() const {
@@ -151,6 +154,14 @@ Buffer ImageParam::get() const {
     return param.get_buffer();
 }
 
+ImageParam &ImageParam::split_storage(int dim, int factor) {
+    if (Internal::is_one(param.stride_constraint(0))) {
+        param.set_stride_constraint(0, Expr());
+    }
+    param.add_storage_block(dim, factor);
+    return *this;
+}
+
 Expr ImageParam::operator()() const {
     user_assert(dimensions() == 0)
         << "Zero-argument access to Buffer " << name()
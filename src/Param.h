@@ -325,6 +325,26 @@ public:
     /** Get the buffer bound to this ImageParam. Only relevant for jitting */
     EXPORT Buffer get() const;
 
+    /** Declare that the image is stored in blocks of factor
+     * contiguous elements along the given dimension. Blocks nest
+     * inside each other in the order they are declared, and inside
+     * all of the ordinary dimensions, so:
+     \code
+     im.split_storage(2, 16);
+     \endcode
+     * on an image with dimensions x, y, c describes the layout
+     * often called NCHW16c, and:
+     \code
+     im.split_storage(0, 8).split_storage(1, 8);
+     \endcode
+     * describes an image stored as 8x8 tiles. For a blocked
+     * dimension, the stride in the buffer_t passed in is the stride
+     * between successive blocks, and the strides within the blocks
+     * are implied. Because of this, declaring any blocked dimension
+     * removes the default constraint that the stride of dimension 0
+     * is one. */
+    EXPORT ImageParam &split_storage(int dim, int factor);
+
     /** Construct an expression which loads from this image
      * parameter. The location is extended with enough implicit
      * variables to match the dimensionality of the image
@@ -20,6 +20,7 @@ struct ParameterContents {
     Expr min_constraint[4];
     Expr extent_constraint[4];
     Expr stride_constraint[4];
+    std::vector<StorageBlock> storage_blocks;
     Expr min_value, max_value;
     ParameterContents(Type t, bool b, int d, const std::string &n, bool e, bool r)
         : type(t), is_buffer(b), dimensions(d), is_explicit_name(e), is_registered(r), name(n), buffer(Buffer()), data(0) {
@@ -226,6 +227,26 @@ Expr Parameter::stride_constraint(int dim) const {
     return contents.ptr->stride_constraint[dim];
 }
 
+void Parameter::add_storage_block(int dim, int factor) {
+    check_is_buffer();
+    check_dim_ok(dim);
+    for (const StorageBlock &b : contents.ptr->storage_blocks) {
+        user_assert(b.dim != dim)
+            << "Dimension " << dim << " of " << name()
+            << " already has a blocked storage layout.\n";
+    }
+    user_assert(factor > 0)
+        << "Storage block size for dimension " << dim << " of " << name()
+        << " must be positive.\n";
+    StorageBlock b = {dim, factor};
+    contents.ptr->storage_blocks.push_back(b);
+}
+
+const std::vector<StorageBlock> &Parameter::storage_blocks() const {
+    check_defined();
+    return contents.ptr->storage_blocks;
+}
+
 void Parameter::set_min_value(Expr e) {
     check_is_scalar();
     user_assert(e.type() == contents.ptr->type)
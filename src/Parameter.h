@@ -5,6 +5,7 @@
  * Defines the internal representation of parameters to halide piplines
  */
 
+#include "Argument.h"
 #include "Expr.h"
 
 namespace Halide {
@@ -120,6 +121,13 @@ public:
     EXPORT Expr stride_constraint(int dim) const;
     //@}
 
+    /** Get and add to the blocked storage layout of a buffer
+     * parameter (see ImageParam::split_storage) */
+    //@{
+    EXPORT void add_storage_block(int dim, int factor);
+    EXPORT const std::vector<StorageBlock> &storage_blocks() const;
+    //@}
+
     /** Get and set constraints for scalar parameters. These are used
      * directly by Param, so they must be exported. */
     // @{
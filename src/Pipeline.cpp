@@ -1,7 +1,9 @@
 #include <algorithm>
+#include <future>
 
 #include "Pipeline.h"
 #include "Argument.h"
+#include "DirtyRegion.h"
 #include "Func.h"
 #include "IRVisitor.h"
 #include "LLVM_Headers.h"
@@ -9,12 +11,14 @@
 #include "Lower.h"
 #include "Output.h"
 #include "PrintLoopNest.h"
+#include "TileList.h"
 
 using namespace Halide::Internal;
 
 namespace Halide {
 
 using std::vector;
+using std::pair;
 using std::string;
 using std::set;
 
@@ -55,6 +59,7 @@ struct PipelineContents {
         jit_module = JITModule();
         jit_target = Target();
         inferred_args.clear();
+        tile_list_pipeline = Pipeline();
     }
 
     // The outputs
@@ -76,12 +81,25 @@ struct PipelineContents {
     /** The inferred arguments. */
     vector<InferredArgument> inferred_args;
 
+    /** The buffer of tiles to compute, if this pipeline only computes
+     * a list of tiles of its output. Undefined otherwise. */
+    Parameter tile_list;
+
+    /** A pipeline with the same outputs that computes a list of tiles
+     * of them. Created and compiled the first time realize_tile_list
+     * is called. */
+    Pipeline tile_list_pipeline;
+
     /** List of C funtions and Funcs to satisfy HalideExtern* and
      * define_extern calls. */
     std::map<std::string, JITExtern> jit_externs;
 
+    /** Whether to compile for the JIT quickly first, and then again
+     * with full optimization in the background. */
+    bool tiered_jit;
+
     PipelineContents() :
-        module("", Target()) {
+        module("", Target()), tiered_jit(false) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, Handle(), 0);
         user_context_arg.param = Parameter(Handle(), false, 0, "__user_context",
                                            /*is_explicit_name*/ true, /*register_instance*/ false);
@@ -331,6 +349,9 @@ private:
                      p.type(), p.dimensions(), def, min, max),
             p,
             Buffer()};
+        if (p.is_buffer()) {
+            a.arg.storage_blocks = p.storage_blocks();
+        }
         args.push_back(a);
     }
 
@@ -379,6 +400,14 @@ vector<Argument> Pipeline::infer_arguments() {
         // followed by all non-buffers (alphabetical by name).
         std::sort(contents.ptr->inferred_args.begin(), contents.ptr->inferred_args.end());
 
+        // Add the tile list argument.
+        if (contents.ptr->tile_list.defined()) {
+            InferredArgument a;
+            a.param = contents.ptr->tile_list;
+            a.arg = Argument(a.param.name(), Argument::InputBuffer, Int(32), 2);
+            contents.ptr->inferred_args.push_back(a);
+        }
+
         // Add the user context argument.
         contents.ptr->inferred_args.push_back(contents.ptr->user_context_arg);
     }
@@ -492,7 +521,8 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
             custom_passes.push_back(p.pass);
         }
 
-        private_body = lower(contents.ptr->outputs, fn_name, target, custom_passes);
+        private_body = lower(contents.ptr->outputs, fn_name, target, custom_passes,
+                             contents.ptr->tile_list);
     }
 
     string private_name = "__" + new_fn_name;
@@ -519,9 +549,10 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
     // Add the output buffer arguments
     for (Function out : contents.ptr->outputs) {
         for (Parameter buf : out.output_buffers()) {
-            public_args.push_back(Argument(buf.name(),
-                                           Argument::OutputBuffer,
-                                           buf.type(), buf.dimensions()));
+            Argument arg(buf.name(), Argument::OutputBuffer,
+                         buf.type(), buf.dimensions());
+            arg.storage_blocks = out.storage_blocks();
+            public_args.push_back(arg);
         }
     }
 
@@ -590,6 +621,9 @@ void *Pipeline::compile_jit(const Target &target_arg) {
     if (contents.ptr->jit_target == target &&
         contents.ptr->jit_module.compiled()) {
         debug(2) << "Reusing old jit module compiled for :\n" << contents.ptr->jit_target.to_string() << "\n";
+        // Switch to the optimized version of a tiered compile if it
+        // has finished.
+        contents.ptr->jit_module = contents.ptr->jit_module.tier_up();
         return contents.ptr->jit_module.main_function();
     }
 
@@ -614,8 +648,14 @@ void *Pipeline::compile_jit(const Target &target_arg) {
 
     std::map<std::string, JITExtern> lowered_externs = contents.ptr->jit_externs;
     // Compile to jit module
-    JITModule jit_module(module, module.functions.back(),
-                         make_externs_jit_module(target_arg, lowered_externs));
+    JITModule jit_module;
+    if (contents.ptr->tiered_jit) {
+        jit_module = JITModule::make_tiered(module, module.functions.back(),
+                                            make_externs_jit_module(target_arg, lowered_externs));
+    } else {
+        jit_module = JITModule(module, module.functions.back(),
+                               make_externs_jit_module(target_arg, lowered_externs));
+    }
 
     if (debug::debug_level >= 3) {
         compile_module_to_native(module, name + ".bc", name + ".s");
@@ -660,6 +700,18 @@ void Pipeline::set_custom_print(void (*cust_print)(void *, const char *)) {
     contents.ptr->jit_handlers.custom_print = cust_print;
 }
 
+void Pipeline::set_tiered_jit(bool tiered) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    contents.ptr->tiered_jit = tiered;
+}
+
+void Pipeline::wait_for_tiered_jit() {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    if (contents.ptr->jit_module.compiled()) {
+        contents.ptr->jit_module = contents.ptr->jit_module.tier_up(true);
+    }
+}
+
 void Pipeline::set_jit_externs(const std::map<std::string, JITExtern> &externs) {
     user_assert(defined()) << "Pipeline is undefined\n";
     contents.ptr->jit_externs = externs;
@@ -697,12 +749,49 @@ void Pipeline::realize(Buffer b, const Target &target) {
     realize(Realization({b}), target);
 }
 
+namespace {
+// Allocate an output buffer of the given size. If the output has a
+// blocked storage layout, lay the buffer out in whole blocks, with
+// the dimensions in order outside of them.
+Buffer allocate_output(Type t, const vector<int32_t> &sizes, const Function &f) {
+    vector<StorageBlock> blocks = f.storage_blocks();
+    if (blocks.empty()) {
+        return Buffer(t, sizes);
+    }
+
+    vector<int32_t> factors(sizes.size(), 1), padded(sizes);
+    int32_t block_size = 1;
+    for (const StorageBlock &b : blocks) {
+        user_assert(b.dim < (int)sizes.size() && sizes[b.dim])
+            << "Can't realize " << f.name() << " with " << sizes.size()
+            << " dimensions, because it has a blocked storage layout in dimension "
+            << b.dim << ".\n";
+        factors[b.dim] = b.factor;
+        block_size *= b.factor;
+        padded[b.dim] = (sizes[b.dim] + b.factor - 1) / b.factor * b.factor;
+    }
+
+    // The padded size holds exactly as many elements as the blocked
+    // layout, so allocate that, and then set the real extents and the
+    // strides between blocks.
+    Buffer buf(t, padded);
+    buffer_t *raw = buf.raw_buffer();
+    int32_t stride = block_size;
+    for (size_t i = 0; i < sizes.size() && sizes[i]; i++) {
+        raw->extent[i] = sizes[i];
+        raw->stride[i] = stride;
+        stride *= padded[i] / factors[i];
+    }
+    return buf;
+}
+}
+
 Realization Pipeline::realize(vector<int32_t> sizes,
                               const Target &target) {
     user_assert(defined()) << "Pipeline is undefined\n";
     vector<Buffer> bufs;
     for (Type t : contents.ptr->outputs[0].output_types()) {
-        bufs.push_back(Buffer(t, sizes));
+        bufs.push_back(allocate_output(t, sizes, contents.ptr->outputs[0]));
     }
     Realization r(bufs);
     realize(r, target);
@@ -1078,9 +1167,365 @@ void Pipeline::realize(Realization dst, const Target &t) {
     jit_context.finalize(exit_status);
 }
 
-void Pipeline::infer_input_bounds(Realization dst) {
+void Pipeline::realize_tiled(vector<int32_t> sizes,
+                             vector<int32_t> tile_sizes,
+                             const std::map<string, TileReader> &inputs,
+                             TileWriter output,
+                             const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(contents.ptr->outputs.size() == 1 &&
+                contents.ptr->outputs[0].output_types().size() == 1)
+        << "realize_tiled only supports pipelines with a single output\n";
+    user_assert(sizes.size() == tile_sizes.size() && sizes.size() <= 4)
+        << "realize_tiled needs a tile size for each dimension of the output\n";
+    user_assert((bool)output) << "realize_tiled needs an output tile writer\n";
+
+    // Use the same target for the bounds queries and the realizations,
+    // so that we only compile once.
+    Target target = t;
+    if (target.os == Target::OSUnknown) {
+        if (contents.ptr->jit_module.compiled()) {
+            target = contents.ptr->jit_target;
+        } else {
+            target = get_jit_target_from_environment();
+        }
+    }
+    compile_jit(target);
 
-    Target target = get_jit_target_from_environment();
+    // Find the ImageParams to stream.
+    vector<Parameter> streamed;
+    vector<const TileReader *> readers;
+    for (const InferredArgument &arg : contents.ptr->inferred_args) {
+        if (!arg.param.defined() || !arg.param.is_buffer()) continue;
+        auto it = inputs.find(arg.param.name());
+        if (it != inputs.end()) {
+            user_assert(!arg.param.get_buffer().defined())
+                << "ImageParam " << arg.param.name()
+                << " has a tile reader, so it must not be bound to a Buffer\n";
+            streamed.push_back(arg.param);
+            readers.push_back(&(it->second));
+        } else {
+            user_assert(arg.param.get_buffer().defined())
+                << "Can't realize a pipeline because ImageParam " << arg.param.name()
+                << " is not bound to a Buffer and has no tile reader\n";
+        }
+    }
+    user_assert(streamed.size() == inputs.size())
+        << "realize_tiled was given a tile reader for an ImageParam not used by the pipeline\n";
+
+    // Enumerate the output tiles.
+    struct Tile {
+        vector<int32_t> min, extent;
+    };
+    vector<Tile> tiles;
+    Type type = contents.ptr->outputs[0].output_types()[0];
+    int tile_count = 1;
+    for (size_t d = 0; d < sizes.size(); d++) {
+        user_assert(sizes[d] > 0 && tile_sizes[d] > 0)
+            << "realize_tiled needs positive sizes and tile sizes\n";
+        tile_count *= (sizes[d] + tile_sizes[d] - 1) / tile_sizes[d];
+    }
+    for (int i = 0; i < tile_count; i++) {
+        int idx = i;
+        Tile tile;
+        tile.min.resize(4, 0);
+        for (size_t d = 0; d < sizes.size(); d++) {
+            int count = (sizes[d] + tile_sizes[d] - 1) / tile_sizes[d];
+            tile.min[d] = (idx % count) * tile_sizes[d];
+            tile.extent.push_back(std::min(tile_sizes[d], sizes[d] - tile.min[d]));
+            idx /= count;
+        }
+        tiles.push_back(tile);
+    }
+
+    // Allocate a tile of output, and run bounds inference to allocate
+    // the inputs it needs.
+    auto prepare_tile = [&](const Tile &tile, Buffer &out, vector<Buffer> &ins) {
+        out = Buffer(type, tile.extent);
+        out.set_min(tile.min[0], tile.min[1], tile.min[2], tile.min[3]);
+        for (Parameter &p : streamed) {
+            p.set_buffer(Buffer());
+        }
+        infer_input_bounds(Realization({out}), target);
+        ins.clear();
+        for (Parameter &p : streamed) {
+            ins.push_back(p.get_buffer());
+            p.set_buffer(Buffer());
+        }
+    };
+
+    // Read each input on another thread. Buffer reference counts
+    // aren't thread-safe, so the worker threads only use Buffers that
+    // this thread doesn't touch again until it has waited for them.
+    auto read_inputs = [&](vector<Buffer> *ins) {
+        for (size_t i = 0; i < ins->size(); i++) {
+            (*readers[i])((*ins)[i]);
+        }
+    };
+
+    Buffer current_out, next_out, written_out;
+    vector<Buffer> current_ins, next_ins;
+    std::future<void> pending_read, pending_write;
+
+    prepare_tile(tiles[0], next_out, next_ins);
+    pending_read = std::async(std::launch::async, read_inputs, &next_ins);
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        pending_read.get();
+        current_out = next_out;
+        current_ins.swap(next_ins);
+
+        // Start reading the inputs for the next tile.
+        if (i + 1 < tiles.size()) {
+            prepare_tile(tiles[i + 1], next_out, next_ins);
+            pending_read = std::async(std::launch::async, read_inputs, &next_ins);
+        }
+
+        for (size_t j = 0; j < streamed.size(); j++) {
+            streamed[j].set_buffer(current_ins[j]);
+        }
+        realize(Realization({current_out}), target);
+        current_out.copy_to_host();
+
+        // Write the output out while computing the next tile.
+        if (pending_write.valid()) {
+            pending_write.get();
+        }
+        written_out = current_out;
+        current_out = Buffer();
+        pending_write = std::async(std::launch::async, [&]() {output(written_out);});
+    }
+
+    if (pending_write.valid()) {
+        pending_write.get();
+    }
+    for (Parameter &p : streamed) {
+        p.set_buffer(Buffer());
+    }
+}
+
+namespace {
+
+// Make a buffer that views a region of the host memory of another.
+Buffer crop_to_region(Buffer b, const vector<pair<int32_t, int32_t>> &region) {
+    buffer_t crop = *b.raw_buffer();
+    int64_t offset = 0;
+    for (size_t d = 0; d < region.size(); d++) {
+        offset += (int64_t)(region[d].first - crop.min[d]) * crop.stride[d];
+        crop.min[d] = region[d].first;
+        crop.extent[d] = region[d].second;
+    }
+    crop.host += offset * crop.elem_size;
+    crop.dev = 0;
+    crop.host_dirty = false;
+    crop.dev_dirty = false;
+    return Buffer(b.type(), &crop);
+}
+
+}
+
+vector<pair<int32_t, int32_t>> Pipeline::realize_dirty(Realization dst, const string &input,
+                                                       const vector<pair<int32_t, int32_t>> &dirty,
+                                                       const Target &target) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(contents.ptr->outputs.size() == 1)
+        << "realize_dirty only supports pipelines with a single output\n";
+    Function f = contents.ptr->outputs[0];
+    user_assert(dst.size() == f.output_types().size())
+        << "realize_dirty was given " << dst.size() << " output buffers for "
+        << f.name() << ", which has " << f.output_types().size() << " outputs\n";
+
+    infer_arguments();
+    bool found = false;
+    for (const InferredArgument &arg : contents.ptr->inferred_args) {
+        found = found || (arg.arg.is_buffer() && arg.arg.name == input);
+    }
+    user_assert(found)
+        << "Can't realize the region of " << f.name() << " affected by a change to "
+        << input << ", because " << input << " is not an input buffer of the pipeline\n";
+
+    user_assert(dst[0].dimensions() == (int)f.args().size())
+        << "realize_dirty was given a " << dst[0].dimensions() << "-dimensional output buffer for "
+        << f.name() << ", which has " << f.args().size() << " dimensions\n";
+
+    vector<pair<int32_t, int32_t>> region;
+    for (size_t d = 0; d < f.args().size(); d++) {
+        region.push_back({dst[0].min(d), dst[0].extent(d)});
+    }
+    dirty_output_region(f, input, dirty, region);
+
+    for (const pair<int32_t, int32_t> &r : region) {
+        if (r.second <= 0) {
+            debug(2) << "Change to " << input << " doesn't affect " << f.name() << "\n";
+            return region;
+        }
+    }
+
+    // Realize into views of the affected part of the previous output.
+    vector<Buffer> crops;
+    for (size_t i = 0; i < dst.size(); i++) {
+        Buffer b = dst[i];
+        user_assert(b.host_ptr() && !b.device_dirty())
+            << "realize_dirty needs the previous output to be on the host\n";
+        crops.push_back(crop_to_region(b, region));
+    }
+
+    realize(Realization(crops), target);
+
+    for (size_t i = 0; i < dst.size(); i++) {
+        crops[i].copy_to_host();
+        if (dst[i].device_handle()) {
+            dst[i].set_host_dirty(true);
+        }
+    }
+
+    return region;
+}
+
+vector<pair<int32_t, int32_t>> Pipeline::realize_dirty(Buffer dst, const string &input,
+                                                       const vector<pair<int32_t, int32_t>> &dirty,
+                                                       const Target &target) {
+    return realize_dirty(Realization({dst}), input, dirty, target);
+}
+
+vector<string> Pipeline::realize_tile_list(Realization dst,
+                                           const vector<vector<pair<int32_t, int32_t>>> &tiles,
+                                           const Target &target) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(contents.ptr->outputs.size() == 1)
+        << "realize_tile_list only supports pipelines with a single output\n";
+    Function f = contents.ptr->outputs[0];
+    user_assert(dst.size() == f.output_types().size())
+        << "realize_tile_list was given " << dst.size() << " output buffers for "
+        << f.name() << ", which has " << f.output_types().size() << " outputs\n";
+    const int dims = f.dimensions();
+    user_assert(dst[0].dimensions() == dims)
+        << "realize_tile_list was given a " << dst[0].dimensions() << "-dimensional output buffer for "
+        << f.name() << ", which has " << dims << " dimensions\n";
+
+    vector<int32_t> min_extent, multiple_of;
+    tile_list_granularity(f, min_extent, multiple_of);
+
+    // Check each tile, and that it doesn't overlap the valid tiles
+    // before it. Tiles that fail are skipped.
+    vector<string> errors(tiles.size());
+    vector<size_t> valid;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        const vector<pair<int32_t, int32_t>> &tile = tiles[i];
+        std::ostringstream err;
+        if ((int)tile.size() != dims) {
+            err << "Tile has " << tile.size() << " dimensions, but "
+                << f.name() << " has " << dims << " dimensions";
+        }
+        for (int d = 0; d < dims && err.str().empty(); d++) {
+            int32_t min = tile[d].first, extent = tile[d].second;
+            if (extent <= 0) {
+                err << "Tile is empty in dimension " << d;
+            } else if (min < dst[0].min(d) ||
+                       (int64_t)min + extent > (int64_t)dst[0].min(d) + dst[0].extent(d)) {
+                err << "Tile [" << min << ", " << (int64_t)min + extent - 1
+                    << "] is outside the output buffer in dimension " << d;
+            } else if (extent < min_extent[d]) {
+                err << "Tile extent " << extent << " in dimension " << d
+                    << " is less than the split factor " << min_extent[d]
+                    << " of " << f.name();
+            } else if (extent % multiple_of[d]) {
+                err << "Tile extent " << extent << " in dimension " << d
+                    << " is not a multiple of the split factor " << multiple_of[d]
+                    << " of an update of " << f.name();
+            }
+        }
+        for (size_t j = 0; j < valid.size() && err.str().empty(); j++) {
+            const vector<pair<int32_t, int32_t>> &other = tiles[valid[j]];
+            bool overlaps = true;
+            for (int d = 0; d < dims; d++) {
+                overlaps = overlaps &&
+                    tile[d].first < other[d].first + other[d].second &&
+                    other[d].first < tile[d].first + tile[d].second;
+            }
+            if (overlaps) {
+                err << "Tile overlaps tile " << valid[j];
+            }
+        }
+        errors[i] = err.str();
+        if (errors[i].empty()) {
+            valid.push_back(i);
+        } else {
+            debug(1) << "Skipping tile " << i << ": " << errors[i] << "\n";
+        }
+    }
+
+    if (valid.empty()) {
+        return errors;
+    }
+
+    // Make the table of tiles, with a min and extent per dimension,
+    // and find their bounding box.
+    Buffer table(Int(32), {2*dims, (int)valid.size()});
+    int32_t *entry = (int32_t *)table.host_ptr();
+    vector<pair<int32_t, int32_t>> box(dims, {INT32_MAX, INT32_MIN});
+    for (size_t i : valid) {
+        for (int d = 0; d < dims; d++) {
+            *entry++ = tiles[i][d].first;
+            *entry++ = tiles[i][d].second;
+            box[d].first = std::min(box[d].first, tiles[i][d].first);
+            box[d].second = std::max(box[d].second, tiles[i][d].first + tiles[i][d].second);
+        }
+    }
+    for (int d = 0; d < dims; d++) {
+        box[d].second -= box[d].first;
+    }
+
+    // Realize into views of the bounding box, so that Funcs computed
+    // at root are only computed over what the tiles need.
+    vector<Buffer> crops;
+    for (size_t i = 0; i < dst.size(); i++) {
+        user_assert(dst[i].host_ptr() && !dst[i].device_dirty())
+            << "realize_tile_list needs the output to be on the host\n";
+        crops.push_back(crop_to_region(dst[i], box));
+    }
+
+    Pipeline &p = contents.ptr->tile_list_pipeline;
+    if (!p.defined()) {
+        p = Pipeline(outputs());
+        p.contents.ptr->tile_list = Parameter(Int(32), true, 2, f.name() + ".tile_list",
+                                              /*is_explicit_name*/ true, /*register_instance*/ false);
+        // The passes are still owned by this pipeline, which outlives p.
+        for (CustomLoweringPass pass : contents.ptr->custom_lowering_passes) {
+            pass.deleter = NULL;
+            p.contents.ptr->custom_lowering_passes.push_back(pass);
+        }
+        p.contents.ptr->jit_externs = contents.ptr->jit_externs;
+        p.contents.ptr->tiered_jit = contents.ptr->tiered_jit;
+    }
+    p.contents.ptr->jit_handlers = contents.ptr->jit_handlers;
+
+    p.contents.ptr->tile_list.set_buffer(table);
+    p.realize(Realization(crops), target);
+    p.contents.ptr->tile_list.set_buffer(Buffer());
+
+    for (size_t i = 0; i < dst.size(); i++) {
+        crops[i].copy_to_host();
+        if (dst[i].device_handle()) {
+            dst[i].set_host_dirty(true);
+        }
+    }
+
+    return errors;
+}
+
+vector<string> Pipeline::realize_tile_list(Buffer dst,
+                                           const vector<vector<pair<int32_t, int32_t>>> &tiles,
+                                           const Target &target) {
+    return realize_tile_list(Realization({dst}), tiles, target);
+}
+
+void Pipeline::infer_input_bounds(Realization dst, const Target &t) {
+
+    Target target = t;
+    if (target.os == Target::OSUnknown) {
+        target = get_jit_target_from_environment();
+    }
 
     vector<const void *> args = prepare_jit_call_arguments(dst, target);
 
@@ -1194,7 +1639,8 @@ void Pipeline::infer_input_bounds(int x_size, int y_size, int z_size, int w_size
 
     vector<Buffer> bufs;
     for (Type t : contents.ptr->outputs[0].output_types()) {
-        bufs.push_back(Buffer(t, x_size, y_size, z_size, w_size));
+        bufs.push_back(allocate_output(t, {x_size, y_size, z_size, w_size},
+                                       contents.ptr->outputs[0]));
     }
     Realization r(bufs);
     infer_input_bounds(r);
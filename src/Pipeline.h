@@ -14,6 +14,7 @@
 #include "Image.h"
 #include "JITModule.h"
 #include "Module.h"
+#include "OutOfCore.h"
 #include "Tuple.h"
 #include "Target.h"
 
@@ -308,6 +309,19 @@ public:
      */
     EXPORT void set_custom_print(void (*handler)(void *, const char *));
 
+    /** Compile for the JIT in two tiers: first quickly, with few
+     * optimizations, so that the first realization doesn't wait for a
+     * full compile, and then again with full optimization on a
+     * background thread. realize switches to the optimized code once
+     * it is ready. Useful for interactive tools, where the pipeline
+     * changes often. Takes effect the next time the pipeline is
+     * compiled. */
+    EXPORT void set_tiered_jit(bool tiered);
+
+    /** If the pipeline was last compiled with tiered JIT, block until
+     * its optimized version is ready, and use it from now on. */
+    EXPORT void wait_for_tiered_jit();
+
     /** Install a set of external C functions or Funcs to satisfy
      * dependencies introduced by HalideExtern and define_extern
      * mechanisms. These will be used by calls to realize,
@@ -381,14 +395,110 @@ public:
     }
     // @}
 
+    /** Evaluate this pipeline over an output too large to hold in
+     * memory, one tile at a time. The pipeline must have a single
+     * output. The output is divided into tiles of the given size
+     * (clipped at the edges), and each tile is realized into its own
+     * buffer and passed to the output writer.
+     *
+     * The inputs map gives a tile reader for each streamed ImageParam,
+     * keyed by name. These ImageParams must be unbound. Before each
+     * output tile is computed, bounds inference determines the region
+     * of each streamed input it needs, including any halo, and the
+     * reader is called to fill in a buffer covering that region. Other
+     * ImageParams must be bound to Buffers as usual.
+     *
+     * Reading the inputs for the next tile and writing the output of
+     * the previous tile happen on another thread, while the current
+     * tile is computed.
+     *
+     * Boundary conditions on a streamed input must use explicit
+     * bounds (e.g. BoundaryConditions::repeat_edge(input, 0, width, 0,
+     * height)), because the input's own bounds are those of the
+     * current tile. */
+    EXPORT void realize_tiled(std::vector<int32_t> sizes,
+                              std::vector<int32_t> tile_sizes,
+                              const std::map<std::string, TileReader> &inputs,
+                              TileWriter output,
+                              const Target &target = Target());
+
+    /** Update a previous output of this pipeline after a change to a
+     * region of one of its input buffers, recomputing only the part
+     * of the output that depends on the changed region. The pipeline
+     * must have a single output, and dst must hold its last output,
+     * on the host. The input is named by the ImageParam or Image,
+     * and the changed region of it is given as a (min, extent) pair
+     * for each dimension. Returns the region of the output that was
+     * recomputed, which is empty if the change couldn't have affected
+     * it.
+     *
+     * The affected region is found by walking back through bounds
+     * inference from a single point of the output to the input, and
+     * inverting the result. Only what the affected region needs of
+     * each intermediate Func is recomputed. Dimensions of the output
+     * that can't be narrowed down this way, e.g. because they depend
+     * on values loaded from a lookup table, are recomputed entirely.
+     *
+     \code
+     ImageParam input(Float(32), 2);
+     Func blur = ...;
+     Image<float> out = blur.realize(width, height);
+     // Paint on a 16x16 square of the input image.
+     blur.realize_dirty(out, input.name(), {{x, 16}, {y, 16}});
+     \endcode
+     */
+    // @{
+    EXPORT std::vector<std::pair<int32_t, int32_t>>
+    realize_dirty(Realization dst, const std::string &input,
+                  const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                  const Target &target = Target());
+    EXPORT std::vector<std::pair<int32_t, int32_t>>
+    realize_dirty(Buffer dst, const std::string &input,
+                  const std::vector<std::pair<int32_t, int32_t>> &dirty,
+                  const Target &target = Target());
+    // @}
+
+    /** Compute only some tiles of the output of this pipeline, in a
+     * single call. The pipeline must have a single output, and dst
+     * must be on the host and cover all of the tiles. Each tile is
+     * given as a (min, extent) pair for each dimension. The tiles are
+     * computed in parallel. Funcs computed at root are computed once,
+     * over the bounding box of the tiles, and shared between them. The
+     * rest of dst is left untouched.
+     *
+     * Returns an error message for each tile, which is empty if the
+     * tile was computed. Tiles are skipped if they are empty, fall
+     * outside of dst, overlap an earlier tile, or don't fit the splits
+     * in the output's schedule (e.g. a tile 4 pixels wide when x is
+     * vectorized by 8). Errors while running the pipeline aren't
+     * specific to one tile, and are reported as for realize.
+     *
+     \code
+     Image<float> out(width, height);
+     std::vector<std::string> errors =
+         f.realize_tile_list(out, {{{0, 64}, {0, 64}}, {{256, 64}, {128, 64}}});
+     \endcode
+     */
+    // @{
+    EXPORT std::vector<std::string>
+    realize_tile_list(Realization dst,
+                      const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                      const Target &target = Target());
+    EXPORT std::vector<std::string>
+    realize_tile_list(Buffer dst,
+                      const std::vector<std::vector<std::pair<int32_t, int32_t>>> &tiles,
+                      const Target &target = Target());
+    // @}
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
      * of the appropriate size and binding them to the unbound
-     * ImageParams. */
+     * ImageParams. Uses the JIT target from the environment if no
+     * target is given. */
     // @{
     EXPORT void infer_input_bounds(int x_size = 0, int y_size = 0, int z_size = 0, int w_size = 0);
-    EXPORT void infer_input_bounds(Realization dst);
+    EXPORT void infer_input_bounds(Realization dst, const Target &target = Target());
     EXPORT void infer_input_bounds(Buffer dst);
     // @}
 
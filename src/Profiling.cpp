@@ -105,7 +105,7 @@ Stmt inject_profiling(Stmt s, string pipeline_name) {
         s = Block::make(Store::make("profiling_func_names", p.first, p.second), s);
     }
 
-    s = Allocate::make("profiling_func_names", Handle(), {num_funcs}, const_true(), s);
+    s = Allocate::make("profiling_func_names", Handle(), MemoryType::Auto, {num_funcs}, const_true(), s);
     s = Block::make(Evaluate::make(stop_profiler), s);
 
     return s;
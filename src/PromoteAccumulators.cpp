@@ -0,0 +1,498 @@
+#include <map>
+#include <set>
+
+#include "PromoteAccumulators.h"
+#include "Debug.h"
+#include "ExprUsesVar.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// How a buffer is used within a loop body.
+struct BufferAccess {
+    // The distinct indices the buffer is accessed at.
+    vector<Expr> indices;
+    Type type;
+    bool consistent;
+    bool stored;
+    // Whether some access might not happen on every iteration.
+    bool conditional;
+};
+
+// Find the buffers in a loop body that are only ever accessed at a
+// few loop-invariant indices, and which could be replaced by
+// registers.
+class FindAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    // How many ifs, and loops that might not run, enclose the
+    // current node.
+    int conditions;
+
+    void record(const string &name, Expr index, Type type, bool is_store) {
+        map<string, BufferAccess>::iterator iter = accesses.find(name);
+        if (iter == accesses.end()) {
+            BufferAccess a = {{index}, type, true, is_store, conditions > 0};
+            accesses[name] = a;
+        } else {
+            BufferAccess &a = iter->second;
+            a.stored = a.stored || is_store;
+            a.conditional = a.conditional || conditions > 0;
+            if (a.type != type) {
+                a.consistent = false;
+            }
+            for (Expr i : a.indices) {
+                if (equal(i, index)) {
+                    return;
+                }
+            }
+            a.indices.push_back(index);
+        }
+    }
+
+    void visit(const Load *op) {
+        IRVisitor::visit(op);
+        record(op->name, op->index, op->type, false);
+    }
+
+    void visit(const Store *op) {
+        IRVisitor::visit(op);
+        record(op->name, op->index, op->value.type(), true);
+    }
+
+    void visit(const Variable *op) {
+        // The buffer may be accessed by something we can't see.
+        if (ends_with(op->name, ".buffer")) {
+            escaped.insert(op->name.substr(0, op->name.size() - 7));
+        } else if (ends_with(op->name, ".host")) {
+            escaped.insert(op->name.substr(0, op->name.size() - 5));
+        }
+    }
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::Intrinsic &&
+            (op->name == Call::address_of ||
+             op->name == Call::debug_to_file)) {
+            for (Expr arg : op->args) {
+                if (const Load *load = arg.as<Load>()) {
+                    escaped.insert(load->name);
+                }
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Let *op) {
+        defined.push(op->name, 0);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const LetStmt *op) {
+        defined.push(op->name, 0);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) {
+        if (op->for_type != ForType::Serial ||
+            (op->device_api != DeviceAPI::Host &&
+             op->device_api != DeviceAPI::Parent)) {
+            // Code in parallel tasks and on devices can't refer to
+            // allocations made outside of it.
+            only_serial_loops = false;
+        }
+        defined.push(op->name, 0);
+        op->min.accept(this);
+        op->extent.accept(this);
+        bool maybe_empty = !is_positive_const(op->extent);
+        if (maybe_empty) {
+            conditions++;
+        }
+        op->body.accept(this);
+        if (maybe_empty) {
+            conditions--;
+        }
+    }
+
+    void visit(const IfThenElse *op) {
+        op->condition.accept(this);
+        conditions++;
+        op->then_case.accept(this);
+        if (op->else_case.defined()) {
+            op->else_case.accept(this);
+        }
+        conditions--;
+    }
+
+    void visit(const Allocate *op) {
+        escaped.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    map<string, BufferAccess> accesses;
+    set<string> escaped;
+    // Everything defined inside the loop, including the loop variable.
+    Scope<int> defined;
+    bool only_serial_loops;
+
+    FindAccesses(const string &loop_var) : conditions(0), only_serial_loops(true) {
+        defined.push(loop_var, 0);
+    }
+};
+
+class ContainsLoad : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *) {
+        result = true;
+    }
+public:
+    bool result;
+    ContainsLoad() : result(false) {}
+};
+
+bool contains_load(Expr e) {
+    ContainsLoad c;
+    e.accept(&c);
+    return c.result;
+}
+
+// Redirect all accesses to a buffer to its accumulator.
+class ReplaceAccesses : public IRMutator {
+    using IRMutator::visit;
+
+    const string &name, &accumulator;
+    // The indices in the buffer, and the corresponding indices in
+    // the accumulator.
+    const vector<pair<Expr, Expr>> &indices;
+
+    Expr accumulator_index(Expr index) {
+        for (const pair<Expr, Expr> &i : indices) {
+            if (equal(i.first, index)) {
+                return i.second;
+            }
+        }
+        internal_error << "Access to " << name << " at unexpected index " << index << "\n";
+        return Expr();
+    }
+
+    void visit(const Load *op) {
+        if (op->name == name) {
+            expr = Load::make(op->type, accumulator, accumulator_index(op->index), Buffer(), Parameter());
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+    void visit(const Store *op) {
+        if (op->name == name) {
+            Expr value = mutate(op->value);
+            stmt = Store::make(accumulator, value, accumulator_index(op->index));
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+public:
+    ReplaceAccesses(const string &n, const string &a, const vector<pair<Expr, Expr>> &i) :
+        name(n), accumulator(a), indices(i) {}
+};
+
+// Get the first element accessed by a dense scalar or vector index.
+Expr dense_base(Expr index) {
+    if (index.type().is_scalar()) {
+        return index;
+    } else if (const Ramp *r = index.as<Ramp>()) {
+        if (is_one(r->stride)) {
+            return r->base;
+        }
+    }
+    return Expr();
+}
+
+// Check that the given accesses never touch the same element. Returns
+// false if they definitely might. Otherwise, any conditions that must
+// be checked at runtime are appended to the conditions vector.
+bool disjoint(const BufferAccess &a, vector<Expr> &conditions) {
+    if (a.indices.size() == 1) {
+        return true;
+    }
+    int lanes = a.type.lanes();
+    vector<Expr> bases;
+    for (Expr i : a.indices) {
+        Expr b = dense_base(i);
+        if (!b.defined()) {
+            return false;
+        }
+        bases.push_back(b);
+    }
+    vector<Expr> new_conditions;
+    for (size_t i = 0; i < bases.size(); i++) {
+        for (size_t j = i + 1; j < bases.size(); j++) {
+            Expr delta = simplify(bases[i] - bases[j]);
+            const int64_t *c = as_const_int(delta);
+            if (c) {
+                if (*c < lanes && *c > -lanes) {
+                    return false;
+                }
+            } else {
+                Expr cond = simplify(delta >= lanes || delta <= -lanes);
+                bool seen = false;
+                for (Expr c : new_conditions) {
+                    seen = seen || equal(c, cond);
+                }
+                if (!seen) {
+                    new_conditions.push_back(cond);
+                }
+            }
+        }
+    }
+    conditions.insert(conditions.end(), new_conditions.begin(), new_conditions.end());
+    return true;
+}
+
+// The number of vector registers needed to hold a value. Scalar
+// floats live in the vector registers too, but scalar integers live
+// in the general purpose ones.
+int vector_registers_needed(Type t, int vector_bytes) {
+    if (t.is_scalar() && !t.is_float()) {
+        return 0;
+    }
+    int bytes = t.bytes() * t.lanes();
+    return (bytes + vector_bytes - 1) / vector_bytes;
+}
+
+class PromoteAccumulators : public IRMutator {
+    using IRMutator::visit;
+
+    // Allocations already in registers.
+    Scope<int> registers;
+
+    // The vector register file of the target, used to warn about
+    // accumulators that won't fit. Zero if unknown.
+    int vector_registers, vector_bytes;
+
+    // Don't compare too many pairs of indices to prove they're
+    // disjoint.
+    static const size_t max_indices = 64;
+
+    void visit(const Allocate *op) {
+        if (op->memory_type == MemoryType::Register) {
+            registers.push(op->name, 0);
+            IRMutator::visit(op);
+            registers.pop(op->name);
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
+    void visit(const For *op) {
+        if (op->device_api != DeviceAPI::Host &&
+            op->device_api != DeviceAPI::Parent) {
+            stmt = op;
+            return;
+        }
+
+        if (op->for_type != ForType::Serial || is_one(op->extent)) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        FindAccesses finder(op->name);
+        op->body.accept(&finder);
+
+        Stmt body = op->body;
+        vector<Stmt> before, after;
+        vector<pair<string, Type>> allocations;
+        vector<Expr> conditions;
+        int regs = 0;
+        if (finder.only_serial_loops) {
+            for (const auto &i : finder.accesses) {
+                const string &name = i.first;
+                const BufferAccess &a = i.second;
+                // Accesses that might not happen can't be hoisted
+                // out of the loop, because the hoisted load and store
+                // would touch memory the loop never did.
+                if (!a.consistent || !a.stored || a.conditional ||
+                    a.indices.size() > max_indices ||
+                    a.type.is_bool() || a.type.is_handle() ||
+                    finder.escaped.count(name) ||
+                    registers.contains(name)) {
+                    continue;
+                }
+
+                bool invariant = true;
+                for (Expr index : a.indices) {
+                    if (expr_uses_vars(index, finder.defined) || contains_load(index)) {
+                        invariant = false;
+                    }
+                }
+                if (!invariant || !disjoint(a, conditions)) {
+                    continue;
+                }
+
+                // Each distinct index gets its own slot in the
+                // accumulator.
+                string acc = name + "." + op->name + ".accumulator";
+                int lanes = a.type.lanes();
+                vector<pair<Expr, Expr>> indices;
+                for (size_t j = 0; j < a.indices.size(); j++) {
+                    Expr index = a.indices[j];
+                    int slot = (int)j * lanes;
+                    Expr acc_index = lanes == 1 ? Expr(slot) : Ramp::make(slot, 1, lanes);
+                    debug(3) << "Keeping " << name << "[" << index << "] in a register over loop " << op->name << "\n";
+                    Expr load = Load::make(a.type, name, index, Buffer(), Parameter());
+                    Expr acc_load = Load::make(a.type, acc, acc_index, Buffer(), Parameter());
+                    before.push_back(Store::make(acc, load, acc_index));
+                    after.push_back(Store::make(name, acc_load, index));
+                    indices.push_back({index, acc_index});
+                    regs += vector_registers_needed(a.type, vector_bytes);
+                }
+                allocations.push_back({acc, a.type.with_lanes((int)a.indices.size() * lanes)});
+                body = ReplaceAccesses(name, acc, indices).mutate(body);
+            }
+        }
+
+        if (vector_registers > 0 && regs > vector_registers) {
+            user_warning << "Keeping the accumulators over the loop " << op->name
+                         << " in registers needs " << regs
+                         << " vector registers, but the target only has "
+                         << vector_registers << ". They will spill to the stack. "
+                         << "Consider unrolling by a smaller factor.\n";
+        }
+
+        // Accumulators have been made for the buffers accessed at
+        // loop-invariant indices, but there may be inner loops
+        // worth doing the same for.
+        for (const auto &a : allocations) {
+            registers.push(a.first, 0);
+        }
+        body = mutate(body);
+        for (const auto &a : allocations) {
+            registers.pop(a.first);
+        }
+
+        Stmt result;
+        if (body.same_as(op->body)) {
+            result = op;
+        } else {
+            result = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        }
+
+        if (!allocations.empty()) {
+            for (Stmt s : before) {
+                result = Block::make(s, result);
+            }
+            for (Stmt s : after) {
+                result = Block::make(result, s);
+            }
+            for (const auto &a : allocations) {
+                result = Allocate::make(a.first, a.second.element_of(), MemoryType::Register,
+                                        {a.second.lanes()}, const_true(), result);
+            }
+            // The locations are only loaded and stored if the loop
+            // would have run.
+            if (!is_positive_const(op->extent)) {
+                result = IfThenElse::make(0 < op->extent, result);
+            }
+            // If the indices couldn't be proven disjoint, fall back
+            // to the original loop when they overlap.
+            if (!conditions.empty()) {
+                Expr no_overlap = conditions[0];
+                for (size_t i = 1; i < conditions.size(); i++) {
+                    no_overlap = no_overlap && conditions[i];
+                }
+                result = IfThenElse::make(no_overlap, result, op);
+            }
+        }
+
+        stmt = result;
+    }
+
+public:
+    PromoteAccumulators(const Target &t) : vector_registers(0), vector_bytes(16) {
+        // avx512_vnni is only for the dot product instructions, and
+        // there's no general AVX-512 target feature, so assume the
+        // AVX2 register file.
+        if (t.arch == Target::X86) {
+            vector_registers = t.bits == 64 ? 16 : 8;
+            if (t.has_feature(Target::AVX)) {
+                vector_bytes = 32;
+            }
+        } else if (t.arch == Target::ARM && !t.has_feature(Target::NoNEON)) {
+            vector_registers = t.bits == 64 ? 32 : 16;
+        }
+    }
+};
+
+}
+
+Stmt promote_accumulators(Stmt s, const Target &t) {
+    return PromoteAccumulators(t).mutate(s);
+}
+
+namespace {
+
+// Whether the accumulators of the loop s were moved out of it.
+bool hoisted(Stmt s) {
+    return !promote_accumulators(s, Target()).as<For>();
+}
+
+}
+
+void promote_accumulators_test() {
+    Expr r = Variable::make(Int(32), "r");
+    Expr n = Variable::make(Int(32), "n");
+    Expr g = Load::make(Int(32), "g", r, Buffer(), Parameter());
+    Stmt update = Store::make("f", Load::make(Int(32), "f", 0, Buffer(), Parameter()) + g, 0);
+
+    // f[0] += g[r] keeps f[0] in a register.
+    Stmt s = For::make("r", 0, n, ForType::Serial, DeviceAPI::Host, update);
+    internal_assert(hoisted(s));
+
+    // Not if the update only happens on some iterations...
+    s = For::make("r", 0, n, ForType::Serial, DeviceAPI::Host,
+                  IfThenElse::make(g > 0, update));
+    internal_assert(!hoisted(s));
+
+    // ...or is in a loop that might not run. It's still kept in a
+    // register over that loop.
+    Expr m = Variable::make(Int(32), "m");
+    s = For::make("k", 0, m, ForType::Serial, DeviceAPI::Host, update);
+    s = For::make("r", 0, n, ForType::Serial, DeviceAPI::Host, s);
+    internal_assert(!hoisted(s));
+
+    // An inner loop that always runs is fine.
+    s = For::make("k", 0, 4, ForType::Serial, DeviceAPI::Host, update);
+    s = For::make("r", 0, n, ForType::Serial, DeviceAPI::Host, s);
+    internal_assert(hoisted(s));
+
+    // f[0] and f[p] might be the same location, so the promoted loop
+    // is only used when p is nonzero, and the original loop otherwise.
+    Expr p = Variable::make(Int(32), "p");
+    Stmt other = Store::make("f", Load::make(Int(32), "f", p, Buffer(), Parameter()) + g, p);
+    s = For::make("r", 0, n, ForType::Serial, DeviceAPI::Host, Block::make(update, other));
+    Stmt result = promote_accumulators(s, Target());
+    const IfThenElse *fallback = result.as<IfThenElse>();
+    internal_assert(fallback && fallback->else_case.same_as(s) &&
+                    expr_uses_var(fallback->condition, "p"))
+        << "Expected a fallback to the original loop:\n" << result;
+
+    std::cout << "PromoteAccumulators test passed" << std::endl;
+}
+
+}
+}
@@ -0,0 +1,33 @@
+#ifndef HALIDE_PROMOTE_ACCUMULATORS_H
+#define HALIDE_PROMOTE_ACCUMULATORS_H
+
+/** \file
+ * Defines the lowering pass that keeps values accumulated over a
+ * loop in registers.
+ */
+
+#include "IR.h"
+#include "Target.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find serial loops in which every access to some buffer is at one
+ * of a few indices, and those indices don't change over the loop
+ * (e.g. the reduction loop of f(x, y) += g(x, y, r) when r is
+ * innermost, possibly with some loops over x and y unrolled inside
+ * it). Load the values once before the loop into a register
+ * allocation, accumulate into that instead, and store them back once
+ * after the loop. Works for vector accumulators too. If the indices
+ * can't be proven not to overlap, the loop is versioned on a runtime
+ * check. Warns if the accumulators won't fit in the target's vector
+ * registers. Should be run after vectorization and unrolling, and
+ * before promote_registers. */
+Stmt promote_accumulators(Stmt s, const Target &t);
+
+EXPORT void promote_accumulators_test();
+
+}
+}
+
+#endif
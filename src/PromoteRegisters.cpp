@@ -0,0 +1,156 @@
+#include "PromoteRegisters.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+
+namespace {
+
+// Allocations no larger than this many bytes, whose accesses are
+// all at constant indices, are placed in registers automatically.
+const int64_t max_auto_register_bytes = 128;
+
+// Get the number of elements in an allocation, if it's a small
+// compile-time constant.
+bool constant_allocation_elements(const Allocate *op, int64_t &elements) {
+    elements = 1;
+    for (Expr e : op->extents) {
+        const int64_t *extent = as_const_int(e);
+        if (!extent || *extent <= 0) {
+            return false;
+        }
+        elements *= *extent;
+        if (elements > ((int64_t)1 << 31) - 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check whether every access to an allocation is at a constant
+// index, and that its address never escapes.
+class CheckRegisterAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    const string &name;
+
+    void check_index(Expr index) {
+        if (!is_const(index) && !bad_index.defined()) {
+            bad_index = index;
+        }
+    }
+
+    void visit(const Load *op) {
+        if (op->name == name) {
+            check_index(op->index);
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Store *op) {
+        if (op->name == name) {
+            check_index(op->index);
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::Intrinsic &&
+            (op->name == Call::address_of ||
+             op->name == Call::debug_to_file)) {
+            for (Expr arg : op->args) {
+                const Load *load = arg.as<Load>();
+                if (load && load->name == name) {
+                    address_taken = true;
+                }
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Variable *op) {
+        if (op->name == name + ".buffer" ||
+            op->name == name + ".host") {
+            address_taken = true;
+        }
+    }
+
+public:
+    Expr bad_index;
+    bool address_taken;
+
+    CheckRegisterAccesses(const string &n) : name(n), address_taken(false) {}
+};
+
+class PromoteRegisters : public IRMutator {
+    using IRMutator::visit;
+
+    int in_device_loop;
+
+    void visit(const For *op) {
+        bool is_device = (op->device_api != DeviceAPI::Parent &&
+                          op->device_api != DeviceAPI::Host);
+        if (is_device) {
+            in_device_loop++;
+        }
+        IRMutator::visit(op);
+        if (is_device) {
+            in_device_loop--;
+        }
+    }
+
+    void visit(const Allocate *op) {
+        MemoryType memory_type = op->memory_type;
+
+        if (memory_type == MemoryType::Register ||
+            (memory_type == MemoryType::Auto &&
+             !in_device_loop && !op->new_expr.defined())) {
+            int64_t elements = 0;
+            bool is_constant = constant_allocation_elements(op, elements);
+            CheckRegisterAccesses check(op->name);
+            op->body.accept(&check);
+
+            if (memory_type == MemoryType::Register) {
+                user_assert(is_constant)
+                    << "Func " << op->name << " is stored in registers, "
+                    << "but the size of its allocation is not a compile-time constant.\n";
+                user_assert(!check.bad_index.defined())
+                    << "Func " << op->name << " is stored in registers, "
+                    << "but it is accessed at the non-constant index " << check.bad_index << ". "
+                    << "Fully unroll the loops over its storage.\n";
+                user_assert(!check.address_taken)
+                    << "Func " << op->name << " is stored in registers, "
+                    << "but its address is passed to another function.\n";
+            } else if (is_constant &&
+                       elements * op->type.bytes() <= max_auto_register_bytes &&
+                       !check.bad_index.defined() &&
+                       !check.address_taken) {
+                debug(3) << "Promoting " << op->name << " to registers\n";
+                memory_type = MemoryType::Register;
+            }
+        }
+
+        Stmt body = mutate(op->body);
+        if (body.same_as(op->body) && memory_type == op->memory_type) {
+            stmt = op;
+        } else {
+            stmt = Allocate::make(op->name, op->type, memory_type, op->extents,
+                                  op->condition, body, op->new_expr, op->free_function);
+        }
+    }
+
+public:
+    PromoteRegisters() : in_device_loop(0) {}
+};
+
+}
+
+Stmt promote_registers(Stmt s) {
+    return PromoteRegisters().mutate(s);
+}
+
+}
+}
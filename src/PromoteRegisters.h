@@ -0,0 +1,24 @@
+#ifndef HALIDE_PROMOTE_REGISTERS_H
+#define HALIDE_PROMOTE_REGISTERS_H
+
+/** \file
+ * Defines the lowering pass that decides which allocations can live
+ * in registers.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Check that allocations explicitly stored in registers are only
+ * accessed at constant indices, and mark small constant-sized
+ * allocations that are only accessed at constant indices as living in
+ * registers. Should be run after unrolling and vectorization, and
+ * after storage flattening. */
+Stmt promote_registers(Stmt s);
+
+}
+}
+
+#endif
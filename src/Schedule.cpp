@@ -12,17 +12,24 @@ struct ScheduleContents {
     mutable RefCount ref_count;
 
     LoopLevel store_level, compute_level;
+    FuseLoopLevel fuse_level;
     std::vector<Split> splits;
     std::vector<Dim> dims;
     std::vector<std::string> storage_dims;
     std::vector<Bound> bounds;
+    std::vector<FoldFactor> fold_factors;
+    std::vector<StorageSplit> storage_splits;
+    std::vector<SkipTiles> skip_tiles;
+    std::vector<MemoizeTile> memoize_tiles;
     std::vector<Specialization> specializations;
     ReductionDomain reduction_domain;
     bool memoized;
     bool touched;
     bool allow_race_conditions;
+    MemoryType memory_type;
 
-    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false) {};
+    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false),
+                         memory_type(MemoryType::Auto) {};
 };
 
 
@@ -46,6 +53,14 @@ bool Schedule::memoized() const {
     return contents.ptr->memoized;
 }
 
+std::vector<MemoizeTile> &Schedule::memoize_tiles() {
+    return contents.ptr->memoize_tiles;
+}
+
+const std::vector<MemoizeTile> &Schedule::memoize_tiles() const {
+    return contents.ptr->memoize_tiles;
+}
+
 bool &Schedule::touched() {
     return contents.ptr->touched;
 }
@@ -86,6 +101,30 @@ const std::vector<Bound> &Schedule::bounds() const {
     return contents.ptr->bounds;
 }
 
+std::vector<FoldFactor> &Schedule::fold_factors() {
+    return contents.ptr->fold_factors;
+}
+
+const std::vector<FoldFactor> &Schedule::fold_factors() const {
+    return contents.ptr->fold_factors;
+}
+
+std::vector<StorageSplit> &Schedule::storage_splits() {
+    return contents.ptr->storage_splits;
+}
+
+const std::vector<StorageSplit> &Schedule::storage_splits() const {
+    return contents.ptr->storage_splits;
+}
+
+std::vector<SkipTiles> &Schedule::skip_tiles() {
+    return contents.ptr->skip_tiles;
+}
+
+const std::vector<SkipTiles> &Schedule::skip_tiles() const {
+    return contents.ptr->skip_tiles;
+}
+
 const std::vector<Specialization> &Schedule::specializations() const {
     return contents.ptr->specializations;
 }
@@ -118,6 +157,14 @@ const LoopLevel &Schedule::compute_level() const {
     return contents.ptr->compute_level;
 }
 
+FuseLoopLevel &Schedule::fuse_level() {
+    return contents.ptr->fuse_level;
+}
+
+const FuseLoopLevel &Schedule::fuse_level() const {
+    return contents.ptr->fuse_level;
+}
+
 
 const ReductionDomain &Schedule::reduction_domain() const {
     return contents.ptr->reduction_domain;
@@ -135,6 +182,14 @@ bool Schedule::allow_race_conditions() const {
     return contents.ptr->allow_race_conditions;
 }
 
+MemoryType &Schedule::memory_type() {
+    return contents.ptr->memory_type;
+}
+
+MemoryType Schedule::memory_type() const {
+    return contents.ptr->memory_type;
+}
+
 void Schedule::accept(IRVisitor *visitor) const {
     for (const Split &s : splits()) {
         if (s.factor.defined()) {
@@ -149,6 +204,14 @@ void Schedule::accept(IRVisitor *visitor) const {
             b.extent.accept(visitor);
         }
     }
+    for (const FoldFactor &f : fold_factors()) {
+        if (f.factor.defined()) {
+            f.factor.accept(visitor);
+        }
+    }
+    for (const SkipTiles &s : skip_tiles()) {
+        s.fill.accept(visitor);
+    }
     for (const Specialization &s : specializations()) {
         s.condition.accept(visitor);
     }
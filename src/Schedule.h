@@ -60,6 +60,22 @@ struct LoopLevel {
 
 };
 
+/** Identifies a loop of a particular stage of another function that
+ * a stage's loops should be fused with. Loops from the outermost in,
+ * down to and including the loop over var, are shared between the
+ * two stages. See \ref Func::compute_with */
+struct FuseLoopLevel {
+    std::string func, var;
+    int stage;
+
+    FuseLoopLevel() : stage(0) {}
+    FuseLoopLevel(const std::string &f, int s, const std::string &v) :
+        func(f), var(v), stage(s) {}
+
+    /** Test if this stage is fused with any other. */
+    bool defined() const {return !func.empty();}
+};
+
 struct Split {
     std::string old_var, outer, inner;
     Expr factor;
@@ -87,6 +103,12 @@ struct Dim {
     ForType for_type;
     DeviceAPI device_api;
     bool pure;
+
+    // True for an RVar of an update definition that accumulates into
+    // a location that doesn't depend on the RVar using an associative
+    // operator (e.g. f(x) += g(x, r)). Vectorizing such a dimension
+    // is lowered to a horizontal reduction rather than a race.
+    bool associative;
 };
 
 struct Bound {
@@ -94,6 +116,37 @@ struct Bound {
     Expr min, extent;
 };
 
+/** An upper bound on the extent of a function's storage along one
+ * dimension over any single iteration of the loop it's folded
+ * over. See \ref Func::fold_storage */
+struct FoldFactor {
+    std::string var;
+    Expr factor;
+};
+
+/** A dimension of a function's storage that is stored in blocks of
+ * factor contiguous elements. See \ref Func::split_storage */
+struct StorageSplit {
+    std::string var;
+    int factor;
+};
+
+/** A loop of a function's pure definition whose iterations are
+ * skipped when the values of mask they read are all zero, writing
+ * fill instead. See \ref Func::skip_tiles */
+struct SkipTiles {
+    std::string var, mask;
+    Expr fill;
+};
+
+/** A dimension of a memoized function that is cached in tiles of
+ * extent elements, aligned to multiples of extent. See \ref
+ * Func::memoize */
+struct MemoizeTile {
+    std::string var;
+    int extent;
+};
+
 struct ScheduleContents;
 
 struct Specialization {
@@ -120,6 +173,14 @@ public:
     bool memoized() const;
     // @}
 
+    /** The dimensions along which a memoized function is cached in
+     * separate tiles. Empty if it is cached as a whole. See \ref
+     * Func::memoize */
+    // @{
+    const std::vector<MemoizeTile> &memoize_tiles() const;
+    std::vector<MemoizeTile> &memoize_tiles();
+    // @}
+
     /** This flag is set to true if the dims list has been manipulated
      * by the user (or if a ScheduleHandle was created that could have
      * been used to manipulate it). It controls the warning that
@@ -171,6 +232,28 @@ public:
     std::vector<Bound> &bounds();
     // @}
 
+    /** You may explicitly give the factor by which some dimensions of
+     * a function's storage should be folded. See \ref
+     * Func::fold_storage */
+    // @{
+    const std::vector<FoldFactor> &fold_factors() const;
+    std::vector<FoldFactor> &fold_factors();
+    // @}
+
+    /** The dimensions of a function's storage that are stored in
+     * blocks, innermost block first. See \ref Func::split_storage */
+    // @{
+    const std::vector<StorageSplit> &storage_splits() const;
+    std::vector<StorageSplit> &storage_splits();
+    // @}
+
+    /** The loops whose iterations are skipped when a mask is
+     * zero. See \ref Func::skip_tiles */
+    // @{
+    const std::vector<SkipTiles> &skip_tiles() const;
+    std::vector<SkipTiles> &skip_tiles();
+    // @}
+
     /** You may create several specialized versions of a func with
      * different schedules. They trigger when the condition is
      * true. See \ref Func::specialize */
@@ -192,6 +275,20 @@ public:
     LoopLevel &compute_level();
     // @}
 
+    /** Which stage of which other function, if any, this stage's
+     * loops are fused with. See \ref Func::compute_with */
+    // @{
+    const FuseLoopLevel &fuse_level() const;
+    FuseLoopLevel &fuse_level();
+    // @}
+
+    /** Where should the storage for this function live? See \ref
+     * Func::store_in */
+    // @{
+    MemoryType memory_type() const;
+    MemoryType &memory_type();
+    // @}
+
     /** Are race conditions permitted? */
     // @{
     bool allow_race_conditions() const;
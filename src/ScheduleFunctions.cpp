@@ -6,6 +6,7 @@
 #include "Var.h"
 #include "Qualify.h"
 #include "IRMutator.h"
+#include "IRPrinter.h"
 #include "Target.h"
 #include "Inline.h"
 #include "CodeGen_GPU_Dev.h"
@@ -981,9 +982,22 @@ void validate_schedule(Function f, Stmt s, bool is_output) {
     LoopLevel store_at = f.schedule().store_level();
     LoopLevel compute_at = f.schedule().compute_level();
 
+    // Memoized functions live in the cache, which is on the heap.
+    if (f.schedule().memoized() &&
+        (f.schedule().memory_type() == MemoryType::Stack ||
+         f.schedule().memory_type() == MemoryType::Register)) {
+        user_error << "Func " << f.name() << " is memoized, so it can't be stored in "
+                   << f.schedule().memory_type() << " memory.\n";
+    }
+
     // Outputs must be compute_root and store_root. They're really
     // store_in_user_code, but store_root is close enough.
     if (is_output) {
+        if (f.schedule().memory_type() != MemoryType::Auto) {
+            user_error << "Func " << f.name() << " is the output, so its storage is"
+                       << " provided by the caller. It can't be stored in "
+                       << f.schedule().memory_type() << " memory.\n";
+        }
         if (store_at.is_root() && compute_at.is_root()) {
             return;
         } else {
@@ -1024,7 +1038,13 @@ void validate_schedule(Function f, Stmt s, bool is_output) {
                 err << "Func \"" << f.name()
                     << "\" is stored outside the parallel loop over "
                     << sites[i].loop_level.func << "." << sites[i].loop_level.var
-                    << " but computed within it. This is a potential race condition.\n";
+                    << " but computed within it. This is a potential race condition.";
+                if (sites[i].loop_level.var == compute_at.var) {
+                    err << " To keep a sliding window and also run in parallel, "
+                        << "use parallel_strips on " << sites[i].loop_level.func
+                        << " and store \"" << f.name() << "\" at the strip loop.";
+                }
+                err << "\n";
                 store_at_ok = compute_at_ok = false;
             }
         }
@@ -0,0 +1,1153 @@
+#include <fstream>
+#include <string.h>
+
+#include "Serialize.h"
+#include "Debug.h"
+#include "Error.h"
+#include "IREquality.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Parameter.h"
+#include "Reduction.h"
+
+namespace Halide {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace Internal {
+
+namespace {
+
+// Bump this whenever the format changes. Data written by a different
+// version is rejected rather than misread.
+const uint32_t format_version = 1;
+
+const char magic[4] = {'H', 'L', 'I', 'R'};
+
+// What the data after the header contains.
+enum class Contents : uint8_t {
+    Module = 0,
+    Expr,
+    Stmt
+};
+
+// Stable codes for each kind of IR node. Only ever add to the end of
+// this list.
+enum class NodeKind : uint8_t {
+    IntImm = 1,
+    UIntImm,
+    FloatImm,
+    StringImm,
+    Cast,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Min,
+    Max,
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    And,
+    Or,
+    Not,
+    Select,
+    Load,
+    Ramp,
+    Broadcast,
+    Let,
+    Call,
+    Variable,
+    LetStmt,
+    AssertStmt,
+    ProducerConsumer,
+    For,
+    Store,
+    Provide,
+    Allocate,
+    Free,
+    Realize,
+    Block,
+    IfThenElse,
+    Evaluate,
+    LastKind = Evaluate
+};
+
+// Objects that may be referred to from more than one place (IR nodes,
+// strings, buffers, parameters, reduction domains) are written in
+// full the first time they are seen, and by index after that. A
+// reference is written as 0 for an undefined object, 1 for a new
+// object, which follows, and 2 + i for the i'th object of its kind
+// written so far. Objects are numbered once they have been written,
+// so an IR node is numbered after its children.
+enum {
+    UndefinedRef = 0,
+    NewRef = 1,
+    FirstExistingRef = 2
+};
+
+class Serializer : public IRVisitor {
+    map<string, uint64_t> strings;
+    map<const IRNode *, uint64_t> exprs, stmts;
+    vector<Buffer> buffers;
+    vector<Parameter> params;
+    vector<ReductionDomain> domains;
+
+    using IRVisitor::visit;
+
+    void write_kind(NodeKind k) {
+        write_byte((uint8_t)k);
+    }
+
+    template<typename T>
+    void write_binary(NodeKind k, const T *op) {
+        write_kind(k);
+        write(op->a);
+        write(op->b);
+    }
+
+    void visit(const IntImm *op) {
+        write_kind(NodeKind::IntImm);
+        write(op->type);
+        write_int(op->value);
+    }
+
+    void visit(const UIntImm *op) {
+        write_kind(NodeKind::UIntImm);
+        write(op->type);
+        write_uint(op->value);
+    }
+
+    void visit(const FloatImm *op) {
+        write_kind(NodeKind::FloatImm);
+        write(op->type);
+        write_double(op->value);
+    }
+
+    void visit(const StringImm *op) {
+        write_kind(NodeKind::StringImm);
+        write(op->value);
+    }
+
+    void visit(const Cast *op) {
+        write_kind(NodeKind::Cast);
+        write(op->type);
+        write(op->value);
+    }
+
+    void visit(const Add *op) {write_binary(NodeKind::Add, op);}
+    void visit(const Sub *op) {write_binary(NodeKind::Sub, op);}
+    void visit(const Mul *op) {write_binary(NodeKind::Mul, op);}
+    void visit(const Div *op) {write_binary(NodeKind::Div, op);}
+    void visit(const Mod *op) {write_binary(NodeKind::Mod, op);}
+    void visit(const Min *op) {write_binary(NodeKind::Min, op);}
+    void visit(const Max *op) {write_binary(NodeKind::Max, op);}
+    void visit(const EQ *op) {write_binary(NodeKind::EQ, op);}
+    void visit(const NE *op) {write_binary(NodeKind::NE, op);}
+    void visit(const LT *op) {write_binary(NodeKind::LT, op);}
+    void visit(const LE *op) {write_binary(NodeKind::LE, op);}
+    void visit(const GT *op) {write_binary(NodeKind::GT, op);}
+    void visit(const GE *op) {write_binary(NodeKind::GE, op);}
+    void visit(const And *op) {write_binary(NodeKind::And, op);}
+    void visit(const Or *op) {write_binary(NodeKind::Or, op);}
+
+    void visit(const Not *op) {
+        write_kind(NodeKind::Not);
+        write(op->a);
+    }
+
+    void visit(const Select *op) {
+        write_kind(NodeKind::Select);
+        write(op->condition);
+        write(op->true_value);
+        write(op->false_value);
+    }
+
+    void visit(const Load *op) {
+        write_kind(NodeKind::Load);
+        write(op->type);
+        write(op->name);
+        write(op->index);
+        write(op->image);
+        write(op->param);
+    }
+
+    void visit(const Ramp *op) {
+        write_kind(NodeKind::Ramp);
+        write(op->base);
+        write(op->stride);
+        write_uint(op->lanes);
+    }
+
+    void visit(const Broadcast *op) {
+        write_kind(NodeKind::Broadcast);
+        write(op->value);
+        write_uint(op->lanes);
+    }
+
+    void visit(const Let *op) {
+        write_kind(NodeKind::Let);
+        write(op->name);
+        write(op->value);
+        write(op->body);
+    }
+
+    void visit(const Call *op) {
+        user_assert(op->call_type != Call::Halide)
+            << "Can't serialize the call to Func " << op->name
+            << ". Only lowered IR can be serialized.\n";
+        write_kind(NodeKind::Call);
+        write(op->type);
+        write(op->name);
+        write(op->args);
+        write_uint(op->call_type);
+        write_uint(op->value_index);
+        write(op->image);
+        write(op->param);
+    }
+
+    void visit(const Variable *op) {
+        write_kind(NodeKind::Variable);
+        write(op->type);
+        write(op->name);
+        write(op->image);
+        write(op->param);
+        write(op->reduction_domain);
+    }
+
+    void visit(const LetStmt *op) {
+        write_kind(NodeKind::LetStmt);
+        write(op->name);
+        write(op->value);
+        write(op->body);
+    }
+
+    void visit(const AssertStmt *op) {
+        write_kind(NodeKind::AssertStmt);
+        write(op->condition);
+        write(op->message);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        write_kind(NodeKind::ProducerConsumer);
+        write(op->name);
+        write(op->produce);
+        write(op->update);
+        write(op->consume);
+    }
+
+    void visit(const For *op) {
+        write_kind(NodeKind::For);
+        write(op->name);
+        write(op->min);
+        write(op->extent);
+        write_uint((uint64_t)op->for_type);
+        write_uint((uint64_t)op->device_api);
+        write(op->body);
+    }
+
+    void visit(const Store *op) {
+        write_kind(NodeKind::Store);
+        write(op->name);
+        write(op->value);
+        write(op->index);
+    }
+
+    void visit(const Provide *op) {
+        write_kind(NodeKind::Provide);
+        write(op->name);
+        write(op->values);
+        write(op->args);
+    }
+
+    void visit(const Allocate *op) {
+        write_kind(NodeKind::Allocate);
+        write(op->name);
+        write(op->type);
+        write_uint((uint64_t)op->memory_type);
+        write(op->extents);
+        write(op->condition);
+        write(op->new_expr);
+        write(op->free_function);
+        write(op->body);
+    }
+
+    void visit(const Free *op) {
+        write_kind(NodeKind::Free);
+        write(op->name);
+    }
+
+    void visit(const Realize *op) {
+        write_kind(NodeKind::Realize);
+        write(op->name);
+        write_uint(op->types.size());
+        for (Type t : op->types) {
+            write(t);
+        }
+        write_uint(op->bounds.size());
+        for (const Range &r : op->bounds) {
+            write(r.min);
+            write(r.extent);
+        }
+        write(op->condition);
+        write(op->body);
+    }
+
+    void visit(const Block *op) {
+        write_kind(NodeKind::Block);
+        write(op->first);
+        write(op->rest);
+    }
+
+    void visit(const IfThenElse *op) {
+        write_kind(NodeKind::IfThenElse);
+        write(op->condition);
+        write(op->then_case);
+        write(op->else_case);
+    }
+
+    void visit(const Evaluate *op) {
+        write_kind(NodeKind::Evaluate);
+        write(op->value);
+    }
+
+    // Write a reference to an object that is compared by identity,
+    // returning true if the object itself must be written next.
+    template<typename T>
+    bool write_ref(const T &x, const vector<T> &seen) {
+        if (!x.defined()) {
+            write_uint(UndefinedRef);
+            return false;
+        }
+        for (size_t i = 0; i < seen.size(); i++) {
+            if (seen[i].same_as(x)) {
+                write_uint(FirstExistingRef + i);
+                return false;
+            }
+        }
+        write_uint(NewRef);
+        return true;
+    }
+
+    // Write an IR node, sharing it if it has been written before.
+    void write_node(const IRHandle &n, map<const IRNode *, uint64_t> &seen) {
+        if (!n.defined()) {
+            write_uint(UndefinedRef);
+            return;
+        }
+        map<const IRNode *, uint64_t>::const_iterator iter = seen.find(n.ptr);
+        if (iter != seen.end()) {
+            write_uint(FirstExistingRef + iter->second);
+            return;
+        }
+        write_uint(NewRef);
+        n.accept(this);
+        uint64_t id = seen.size();
+        seen[n.ptr] = id;
+    }
+
+public:
+    vector<uint8_t> out;
+
+    Serializer(Contents c) {
+        out.insert(out.end(), magic, magic + 4);
+        write_uint(format_version);
+        write_byte((uint8_t)c);
+    }
+
+    void write_byte(uint8_t x) {
+        out.push_back(x);
+    }
+
+    // Unsigned integers are written seven bits at a time, low bits
+    // first, with the top bit of each byte set if more follow.
+    void write_uint(uint64_t x) {
+        while (x >= 0x80) {
+            out.push_back((uint8_t)(x | 0x80));
+            x >>= 7;
+        }
+        out.push_back((uint8_t)x);
+    }
+
+    // Signed integers are zigzag encoded first, so that small negative
+    // numbers are short too.
+    void write_int(int64_t x) {
+        write_uint(((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+    }
+
+    void write_double(double x) {
+        uint64_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        for (int i = 0; i < 8; i++) {
+            write_byte((uint8_t)(bits >> (i * 8)));
+        }
+    }
+
+    void write(const string &s) {
+        map<string, uint64_t>::const_iterator iter = strings.find(s);
+        if (iter != strings.end()) {
+            write_uint(iter->second);
+            return;
+        }
+        // A new string is written as the next unused index, followed
+        // by its contents.
+        uint64_t id = strings.size();
+        strings[s] = id;
+        write_uint(id);
+        write_uint(s.size());
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    void write(Type t) {
+        write_uint(t.code());
+        write_uint(t.bits());
+        write_uint(t.lanes());
+    }
+
+    void write(Expr e) {
+        write_node(e, exprs);
+    }
+
+    void write(Stmt s) {
+        write_node(s, stmts);
+    }
+
+    void write(const vector<Expr> &v) {
+        write_uint(v.size());
+        for (Expr e : v) {
+            write(e);
+        }
+    }
+
+    void write(const Buffer &b) {
+        if (!write_ref(b, buffers)) {
+            return;
+        }
+        user_assert(b.host_ptr() && !b.device_dirty())
+            << "Can't serialize buffer " << b.name()
+            << " because its contents are not on the host.\n";
+        write(b.name());
+        write(b.type());
+        write_uint(b.dimensions());
+        for (int i = 0; i < b.dimensions(); i++) {
+            write_int(b.min(i));
+            write_uint(b.extent(i));
+        }
+
+        // Write the elements densely, in storage order.
+        const buffer_t *buf = b.raw_buffer();
+        int extent[4] = {1, 1, 1, 1};
+        for (int i = 0; i < b.dimensions(); i++) {
+            extent[i] = buf->extent[i];
+        }
+        for (int w = 0; w < extent[3]; w++) {
+            for (int z = 0; z < extent[2]; z++) {
+                for (int y = 0; y < extent[1]; y++) {
+                    for (int x = 0; x < extent[0]; x++) {
+                        int64_t offset = ((int64_t)x * buf->stride[0] + (int64_t)y * buf->stride[1] +
+                                          (int64_t)z * buf->stride[2] + (int64_t)w * buf->stride[3]);
+                        const uint8_t *elem = buf->host + offset * buf->elem_size;
+                        out.insert(out.end(), elem, elem + buf->elem_size);
+                    }
+                }
+            }
+        }
+        buffers.push_back(b);
+    }
+
+    void write(const Parameter &p) {
+        if (!write_ref(p, params)) {
+            return;
+        }
+        write(p.name());
+        write(p.type());
+        write_uint(p.is_buffer());
+        write_uint(p.dimensions());
+        write_uint(p.is_explicit_name());
+        params.push_back(p);
+    }
+
+    void write(const ReductionDomain &d) {
+        if (!write_ref(d, domains)) {
+            return;
+        }
+        write_uint(d.domain().size());
+        for (const ReductionVariable &v : d.domain()) {
+            write(v.var);
+            write(v.min);
+            write(v.extent);
+        }
+        domains.push_back(d);
+    }
+
+    void write(const Argument &a) {
+        write(a.name);
+        write_uint(a.kind);
+        write_uint(a.dimensions);
+        write(a.type);
+        write(a.def);
+        write(a.min);
+        write(a.max);
+        write_uint(a.storage_blocks.size());
+        for (const StorageBlock &b : a.storage_blocks) {
+            write_uint(b.dim);
+            write_uint(b.factor);
+        }
+    }
+};
+
+class Deserializer {
+    const vector<uint8_t> &data;
+    size_t pos;
+    vector<string> strings;
+    vector<Expr> exprs;
+    vector<Stmt> stmts;
+    vector<Buffer> buffers;
+    vector<Parameter> params;
+    vector<ReductionDomain> domains;
+
+    void check_available(uint64_t bytes) {
+        user_assert(bytes <= data.size() - pos)
+            << "Serialized Halide IR is truncated.\n";
+    }
+
+    void check(bool condition) {
+        user_assert(condition) << "Serialized Halide IR is malformed.\n";
+    }
+
+    // Read a reference to a shared object. Returns true if the object
+    // must be read next. Otherwise the object is undefined if index
+    // is -1, or seen[index] if not.
+    template<typename T>
+    bool read_ref(const vector<T> &seen, int64_t &index) {
+        uint64_t r = read_uint();
+        index = -1;
+        if (r == UndefinedRef) {
+            return false;
+        } else if (r == NewRef) {
+            return true;
+        } else {
+            check(r - FirstExistingRef < seen.size());
+            index = (int64_t)(r - FirstExistingRef);
+            return false;
+        }
+    }
+
+    template<typename T>
+    T read_shared(vector<T> &seen, T (Deserializer::*read_new)()) {
+        int64_t index;
+        if (read_ref(seen, index)) {
+            T x = (this->*read_new)();
+            seen.push_back(x);
+            return x;
+        } else if (index >= 0) {
+            return seen[index];
+        } else {
+            return T();
+        }
+    }
+
+    template<typename T>
+    Expr read_binary() {
+        Expr a = read_expr();
+        Expr b = read_expr();
+        check(a.defined() && b.defined() && a.type() == b.type());
+        return T::make(a, b);
+    }
+
+    Expr read_new_expr() {
+        NodeKind k = read_kind();
+        switch (k) {
+        case NodeKind::IntImm: {
+            Type t = read_type();
+            check(t.is_int() && t.is_scalar());
+            return IntImm::make(t, read_int());
+        }
+        case NodeKind::UIntImm: {
+            Type t = read_type();
+            check(t.is_uint() && t.is_scalar());
+            return UIntImm::make(t, read_uint());
+        }
+        case NodeKind::FloatImm: {
+            Type t = read_type();
+            check(t.is_float() && t.is_scalar());
+            return FloatImm::make(t, read_double());
+        }
+        case NodeKind::StringImm:
+            return StringImm::make(read_string());
+        case NodeKind::Cast: {
+            Type t = read_type();
+            Expr value = read_defined_expr();
+            return Cast::make(t, value);
+        }
+        case NodeKind::Add: return read_binary<Add>();
+        case NodeKind::Sub: return read_binary<Sub>();
+        case NodeKind::Mul: return read_binary<Mul>();
+        case NodeKind::Div: return read_binary<Div>();
+        case NodeKind::Mod: return read_binary<Mod>();
+        case NodeKind::Min: return read_binary<Min>();
+        case NodeKind::Max: return read_binary<Max>();
+        case NodeKind::EQ: return read_binary<EQ>();
+        case NodeKind::NE: return read_binary<NE>();
+        case NodeKind::LT: return read_binary<LT>();
+        case NodeKind::LE: return read_binary<LE>();
+        case NodeKind::GT: return read_binary<GT>();
+        case NodeKind::GE: return read_binary<GE>();
+        case NodeKind::And: return read_binary<And>();
+        case NodeKind::Or: return read_binary<Or>();
+        case NodeKind::Not:
+            return Not::make(read_defined_expr());
+        case NodeKind::Select: {
+            Expr condition = read_defined_expr();
+            Expr true_value = read_defined_expr();
+            Expr false_value = read_defined_expr();
+            return Select::make(condition, true_value, false_value);
+        }
+        case NodeKind::Load: {
+            Type t = read_type();
+            string name = read_string();
+            Expr index = read_defined_expr();
+            Buffer image = read_buffer();
+            Parameter param = read_parameter();
+            return Load::make(t, name, index, image, param);
+        }
+        case NodeKind::Ramp: {
+            Expr base = read_defined_expr();
+            Expr stride = read_defined_expr();
+            int lanes = read_lanes();
+            return Ramp::make(base, stride, lanes);
+        }
+        case NodeKind::Broadcast: {
+            Expr value = read_defined_expr();
+            int lanes = read_lanes();
+            return Broadcast::make(value, lanes);
+        }
+        case NodeKind::Let: {
+            string name = read_string();
+            Expr value = read_defined_expr();
+            Expr body = read_defined_expr();
+            return Let::make(name, value, body);
+        }
+        case NodeKind::Call: {
+            Type t = read_type();
+            string name = read_string();
+            vector<Expr> args = read_exprs();
+            uint64_t call_type = read_uint();
+            check(call_type <= Call::Intrinsic && call_type != Call::Halide);
+            uint64_t value_index = read_uint();
+            check(value_index < 256);
+            Buffer image = read_buffer();
+            Parameter param = read_parameter();
+            return Call::make(t, name, args, (Call::CallType)call_type,
+                              Function(), (int)value_index, image, param);
+        }
+        case NodeKind::Variable: {
+            Type t = read_type();
+            string name = read_string();
+            Buffer image = read_buffer();
+            Parameter param = read_parameter();
+            ReductionDomain domain = read_shared(domains, &Deserializer::read_new_domain);
+            return Variable::make(t, name, image, param, domain);
+        }
+        default:
+            check(false);
+            return Expr();
+        }
+    }
+
+    Stmt read_new_stmt() {
+        NodeKind k = read_kind();
+        switch (k) {
+        case NodeKind::LetStmt: {
+            string name = read_string();
+            Expr value = read_defined_expr();
+            Stmt body = read_defined_stmt();
+            return LetStmt::make(name, value, body);
+        }
+        case NodeKind::AssertStmt: {
+            Expr condition = read_defined_expr();
+            Expr message = read_defined_expr();
+            return AssertStmt::make(condition, message);
+        }
+        case NodeKind::ProducerConsumer: {
+            string name = read_string();
+            Stmt produce = read_defined_stmt();
+            Stmt update = read_stmt();
+            Stmt consume = read_defined_stmt();
+            return ProducerConsumer::make(name, produce, update, consume);
+        }
+        case NodeKind::For: {
+            string name = read_string();
+            Expr min = read_defined_expr();
+            Expr extent = read_defined_expr();
+            uint64_t for_type = read_uint();
+            check(for_type <= (uint64_t)ForType::Unrolled);
+            uint64_t device_api = read_uint();
+            check(device_api <= (uint64_t)DeviceAPI::Metal);
+            Stmt body = read_defined_stmt();
+            return For::make(name, min, extent, (ForType)for_type, (DeviceAPI)device_api, body);
+        }
+        case NodeKind::Store: {
+            string name = read_string();
+            Expr value = read_defined_expr();
+            Expr index = read_defined_expr();
+            return Store::make(name, value, index);
+        }
+        case NodeKind::Provide: {
+            string name = read_string();
+            vector<Expr> values = read_exprs();
+            vector<Expr> args = read_exprs();
+            return Provide::make(name, values, args);
+        }
+        case NodeKind::Allocate: {
+            string name = read_string();
+            Type t = read_type();
+            uint64_t memory_type = read_uint();
+            check(memory_type <= (uint64_t)MemoryType::Register);
+            vector<Expr> extents = read_exprs();
+            Expr condition = read_defined_expr();
+            Expr new_expr = read_expr();
+            string free_function = read_string();
+            Stmt body = read_defined_stmt();
+            return Allocate::make(name, t, (MemoryType)memory_type, extents,
+                                  condition, body, new_expr, free_function);
+        }
+        case NodeKind::Free:
+            return Free::make(read_string());
+        case NodeKind::Realize: {
+            string name = read_string();
+            vector<Type> types(read_count());
+            for (Type &t : types) {
+                t = read_type();
+            }
+            Region bounds(read_count());
+            for (Range &r : bounds) {
+                r.min = read_defined_expr();
+                r.extent = read_defined_expr();
+            }
+            Expr condition = read_defined_expr();
+            Stmt body = read_defined_stmt();
+            return Realize::make(name, types, bounds, condition, body);
+        }
+        case NodeKind::Block: {
+            Stmt first = read_defined_stmt();
+            Stmt rest = read_defined_stmt();
+            return Block::make(first, rest);
+        }
+        case NodeKind::IfThenElse: {
+            Expr condition = read_defined_expr();
+            Stmt then_case = read_defined_stmt();
+            Stmt else_case = read_stmt();
+            return IfThenElse::make(condition, then_case, else_case);
+        }
+        case NodeKind::Evaluate:
+            return Evaluate::make(read_defined_expr());
+        default:
+            check(false);
+            return Stmt();
+        }
+    }
+
+    Buffer read_new_buffer() {
+        string name = read_string();
+        Type t = read_type();
+        check(t.is_scalar());
+        uint64_t dims = read_uint();
+        check(dims <= 4);
+        vector<int32_t> sizes;
+        int mins[4] = {0, 0, 0, 0};
+        uint64_t elements = 1;
+        for (size_t i = 0; i < dims; i++) {
+            mins[i] = (int)read_int();
+            uint64_t extent = read_uint();
+            check(extent < (1U << 31));
+            sizes.push_back((int32_t)extent);
+            elements *= extent;
+            check(elements < (1U << 31));
+        }
+        uint64_t bytes = elements * t.bytes();
+        check_available(bytes);
+        Buffer b(t, sizes, NULL, name);
+        b.set_min(mins[0], mins[1], mins[2], mins[3]);
+        memcpy(b.host_ptr(), &data[pos], bytes);
+        pos += bytes;
+        return b;
+    }
+
+    Parameter read_new_parameter() {
+        string name = read_string();
+        Type t = read_type();
+        bool is_buffer = read_uint() != 0;
+        uint64_t dims = read_uint();
+        check(dims <= 4 && (is_buffer || dims == 0));
+        bool is_explicit_name = read_uint() != 0;
+        return Parameter(t, is_buffer, (int)dims, name, is_explicit_name, false);
+    }
+
+    ReductionDomain read_new_domain() {
+        vector<ReductionVariable> domain(read_count());
+        for (ReductionVariable &v : domain) {
+            v.var = read_string();
+            v.min = read_defined_expr();
+            v.extent = read_defined_expr();
+        }
+        return ReductionDomain(domain);
+    }
+
+    NodeKind read_kind() {
+        uint8_t k = read_byte();
+        check(k >= (uint8_t)NodeKind::IntImm && k <= (uint8_t)NodeKind::LastKind);
+        return (NodeKind)k;
+    }
+
+    int read_lanes() {
+        uint64_t lanes = read_uint();
+        check(lanes > 0 && lanes < (1 << 16));
+        return (int)lanes;
+    }
+
+    Expr read_defined_expr() {
+        Expr e = read_expr();
+        check(e.defined());
+        return e;
+    }
+
+    Stmt read_defined_stmt() {
+        Stmt s = read_stmt();
+        check(s.defined());
+        return s;
+    }
+
+    vector<Expr> read_exprs() {
+        vector<Expr> v(read_count());
+        for (Expr &e : v) {
+            e = read_defined_expr();
+        }
+        return v;
+    }
+
+public:
+    Deserializer(const vector<uint8_t> &data, Contents c) : data(data), pos(0) {
+        check_available(4);
+        user_assert(memcmp(&data[0], magic, 4) == 0)
+            << "Data is not serialized Halide IR.\n";
+        pos += 4;
+        uint64_t version = read_uint();
+        user_assert(version == format_version)
+            << "Serialized Halide IR has format version " << version
+            << ", but this version of Halide reads version " << format_version << ".\n";
+        user_assert(read_byte() == (uint8_t)c)
+            << "Serialized Halide IR doesn't contain a "
+            << (c == Contents::Module ? "module" : c == Contents::Expr ? "single expression" : "single statement")
+            << ".\n";
+    }
+
+    void check_finished() {
+        check(pos == data.size());
+    }
+
+    uint8_t read_byte() {
+        check_available(1);
+        return data[pos++];
+    }
+
+    uint64_t read_uint() {
+        uint64_t x = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = read_byte();
+            x |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return x;
+            }
+        }
+        check(false);
+        return 0;
+    }
+
+    // Read the length of a vector, each element of which takes at
+    // least one byte.
+    size_t read_count() {
+        uint64_t n = read_uint();
+        check_available(n);
+        return (size_t)n;
+    }
+
+    int64_t read_int() {
+        uint64_t x = read_uint();
+        return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+    }
+
+    double read_double() {
+        check_available(8);
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++) {
+            bits |= (uint64_t)data[pos++] << (i * 8);
+        }
+        double x;
+        memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    string read_string() {
+        uint64_t id = read_uint();
+        if (id < strings.size()) {
+            return strings[id];
+        }
+        check(id == strings.size());
+        uint64_t size = read_uint();
+        check_available(size);
+        strings.push_back(string((const char *)&data[pos], (size_t)size));
+        pos += size;
+        return strings.back();
+    }
+
+    Type read_type() {
+        uint64_t code = read_uint();
+        check(code <= halide_type_bfloat);
+        uint64_t bits = read_uint();
+        check(bits > 0 && bits <= 64);
+        return Type((halide_type_code_t)code, (uint8_t)bits, read_lanes());
+    }
+
+    Expr read_expr() {
+        return read_shared(exprs, &Deserializer::read_new_expr);
+    }
+
+    Stmt read_stmt() {
+        return read_shared(stmts, &Deserializer::read_new_stmt);
+    }
+
+    Buffer read_buffer() {
+        return read_shared(buffers, &Deserializer::read_new_buffer);
+    }
+
+    Parameter read_parameter() {
+        return read_shared(params, &Deserializer::read_new_parameter);
+    }
+
+    Argument read_argument() {
+        string name = read_string();
+        uint64_t kind = read_uint();
+        check(kind <= Argument::OutputBuffer);
+        uint64_t dims = read_uint();
+        check(dims <= 4);
+        Type t = read_type();
+        Expr def = read_expr();
+        Expr min = read_expr();
+        Expr max = read_expr();
+        Argument a(name, (Argument::Kind)kind, t, (uint8_t)dims, def, min, max);
+        a.storage_blocks.resize(read_count());
+        for (StorageBlock &b : a.storage_blocks) {
+            b.dim = (int)read_uint();
+            b.factor = (int)read_uint();
+        }
+        return a;
+    }
+};
+
+}
+
+vector<uint8_t> serialize(Expr e) {
+    Serializer s(Contents::Expr);
+    s.write(e);
+    return s.out;
+}
+
+vector<uint8_t> serialize(Stmt stmt) {
+    Serializer s(Contents::Stmt);
+    s.write(stmt);
+    return s.out;
+}
+
+Expr deserialize_expr(const vector<uint8_t> &data) {
+    Deserializer d(data, Contents::Expr);
+    Expr e = d.read_expr();
+    d.check_finished();
+    return e;
+}
+
+Stmt deserialize_stmt(const vector<uint8_t> &data) {
+    Deserializer d(data, Contents::Stmt);
+    Stmt s = d.read_stmt();
+    d.check_finished();
+    return s;
+}
+
+namespace {
+
+void check_round_trip(Expr e) {
+    vector<uint8_t> data = serialize(e);
+    Expr result = deserialize_expr(data);
+    internal_assert(equal(e, result))
+        << "Serialization round trip failure:\n" << e << "\n-> " << result << "\n";
+    internal_assert(serialize(result) == data)
+        << "Serialization of " << e << " is not deterministic\n";
+}
+
+void check_round_trip(Stmt s) {
+    vector<uint8_t> data = serialize(s);
+    Stmt result = deserialize_stmt(data);
+    internal_assert(equal(s, result))
+        << "Serialization round trip failure:\n" << s << "\n-> " << result << "\n";
+    internal_assert(serialize(result) == data)
+        << "Serialization of " << s << " is not deterministic\n";
+}
+
+}
+
+void serialize_test() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Float(32), "y");
+    Expr v = Variable::make(Int(32, 4), "v");
+
+    check_round_trip(Expr());
+    check_round_trip(x + 3);
+    check_round_trip(make_const(Int(64), (int64_t)-1234567890123ll) * cast<int64_t>(x));
+    check_round_trip(make_const(UInt(16), (uint64_t)65535) - cast<uint16_t>(x));
+    check_round_trip(y * 0.5f + cast<float>(Expr(0.1)));
+    check_round_trip(Expr("a string"));
+    check_round_trip(select(x < 3 && !(x >= 10), x / 2, x % 7));
+    check_round_trip(min(x, 4) == max(x, -4) || x != 2);
+    check_round_trip(x <= 2 && x > -2);
+    check_round_trip(Ramp::make(x, 2, 4) + Broadcast::make(x, 4) + v);
+    check_round_trip(Let::make("z", x * 2, Variable::make(Int(32), "z") + x));
+    check_round_trip(Call::make(Int(32), Call::abs, {x}, Call::Intrinsic));
+    check_round_trip(Call::make(Float(32), "sinf_f32", {y}, Call::Extern));
+
+    Parameter p(Int(32), false, 0, "p", true, false);
+    Parameter input(UInt(8), true, 2, "input", true, false);
+    Expr px = Variable::make(Int(32), "p", p);
+    check_round_trip(px + Load::make(UInt(8), "input", x, Buffer(), input));
+
+    Buffer b(Int(16), 3, 2, 0, 0, NULL, "b");
+    for (int i = 0; i < 6; i++) {
+        ((int16_t *)b.host_ptr())[i] = (int16_t)(i * 1000 - 2500);
+    }
+    Expr load_b = Load::make(Int(16), "b", x, b, Parameter());
+    Expr loaded = deserialize_expr(serialize(load_b));
+    const Load *l = loaded.as<Load>();
+    internal_assert(l && l->image.defined() && l->image.extent(0) == 3 && l->image.extent(1) == 2);
+    for (int i = 0; i < 6; i++) {
+        internal_assert(((int16_t *)l->image.host_ptr())[i] == (int16_t)(i * 1000 - 2500));
+    }
+
+    // References to the same parameter are to the same parameter
+    // after a round trip too.
+    Expr two_params = deserialize_expr(serialize(px + px * 2));
+    const Add *add = two_params.as<Add>();
+    internal_assert(add);
+    const Variable *a = add->a.as<Variable>();
+    const Variable *c = add->b.as<Mul>()->a.as<Variable>();
+    internal_assert(a->param.same_as(c->param) && a->param.is_explicit_name());
+
+    ReductionDomain r({{"r.x", 0, 10}});
+    check_round_trip(Variable::make(Int(32), "r.x", r) + 1);
+
+    Stmt store = Store::make("buf", x + 1, x);
+    Stmt loop = For::make("x", 0, 10, ForType::Vectorized, DeviceAPI::Host, store);
+    Stmt alloc = Allocate::make("buf", Int(32), MemoryType::Heap, {10, x}, x > 0,
+                                Block::make(loop, Free::make("buf")));
+    Stmt s = LetStmt::make("x", 4, alloc);
+    s = Block::make(AssertStmt::make(x > 0, Call::make(Int(32), "halide_error", {Expr("message")}, Call::Extern)), s);
+    s = IfThenElse::make(x < 100, s, Evaluate::make(x));
+    s = Realize::make("f", {Int(32), Float(32)}, {Range(0, 10), Range(x, 5)}, const_true(),
+                      ProducerConsumer::make("f", Provide::make("f", {x, y}, {x, x}), Stmt(), s));
+    check_round_trip(s);
+
+    // Shared subexpressions are written once.
+    Expr e = x;
+    for (int i = 0; i < 40; i++) {
+        e = e + e;
+    }
+    vector<uint8_t> data = serialize(e);
+    internal_assert(data.size() < 200) << data.size() << "\n";
+    Expr result = deserialize_expr(data);
+    for (int i = 0; i < 40; i++) {
+        add = result.as<Add>();
+        internal_assert(add && add->a.same_as(add->b));
+        result = add->a;
+    }
+
+    std::cout << "Serialization test passed" << std::endl;
+}
+
+}
+
+vector<uint8_t> serialize_module(const Module &module) {
+    Internal::Serializer s(Internal::Contents::Module);
+    s.write(module.name());
+    s.write(module.target().to_string());
+    s.write_uint(module.buffers.size());
+    for (const Buffer &b : module.buffers) {
+        s.write(b);
+    }
+    s.write_uint(module.functions.size());
+    for (const Internal::LoweredFunc &f : module.functions) {
+        s.write(f.name);
+        s.write_uint(f.linkage);
+        s.write_uint(f.args.size());
+        for (const Argument &a : f.args) {
+            s.write(a);
+        }
+        s.write(f.body);
+    }
+    return s.out;
+}
+
+Module deserialize_module(const vector<uint8_t> &data) {
+    Internal::Deserializer d(data, Internal::Contents::Module);
+    string name = d.read_string();
+    string target_string = d.read_string();
+    Target target;
+    user_assert(target.from_string(target_string))
+        << "Serialized module " << name << " has an unknown target: " << target_string << "\n";
+    Module module(name, target);
+
+    size_t buffers = d.read_count();
+    for (size_t i = 0; i < buffers; i++) {
+        Buffer b = d.read_buffer();
+        user_assert(b.defined()) << "Serialized Halide IR is malformed.\n";
+        module.append(b);
+    }
+
+    size_t functions = d.read_count();
+    for (size_t i = 0; i < functions; i++) {
+        string fn_name = d.read_string();
+        uint64_t linkage = d.read_uint();
+        user_assert(linkage <= Internal::LoweredFunc::Internal) << "Serialized Halide IR is malformed.\n";
+        vector<Argument> args(d.read_count());
+        for (Argument &a : args) {
+            a = d.read_argument();
+        }
+        Internal::Stmt body = d.read_stmt();
+        module.append(Internal::LoweredFunc(fn_name, args, body, (Internal::LoweredFunc::LinkageType)linkage));
+    }
+    d.check_finished();
+    return module;
+}
+
+void save_module(const Module &module, std::string filename) {
+    if (filename.empty()) {
+        filename = module.name() + ".hlir";
+    }
+    vector<uint8_t> data = serialize_module(module);
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    user_assert(file.is_open()) << "Could not open " << filename << " for writing.\n";
+    file.write((const char *)data.data(), data.size());
+    user_assert(file.good()) << "Could not write " << filename << ".\n";
+}
+
+Module load_module(const std::string &filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    user_assert(file.is_open()) << "Could not open " << filename << " for reading.\n";
+    vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return deserialize_module(data);
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef HALIDE_SERIALIZE_H
+#define HALIDE_SERIALIZE_H
+
+/** \file
+ *
+ * Defines a compact binary format for lowered Halide IR, so that a
+ * Module can be saved once and loaded later to be compiled, without
+ * running the code that defines the pipeline or lowering it again.
+ */
+
+#include <vector>
+
+#include "Module.h"
+
+namespace Halide {
+
+/** Serialize a lowered module, including the contents of any buffers
+ * it contains. The format is versioned, and deserialize_module fails
+ * with an error on data written by an incompatible version of
+ * Halide. */
+// @{
+EXPORT std::vector<uint8_t> serialize_module(const Module &module);
+EXPORT Module deserialize_module(const std::vector<uint8_t> &data);
+// @}
+
+/** Save a module to a file, or load one saved with save_module. The
+ * default filename is the name of the module with the extension
+ * .hlir. */
+// @{
+EXPORT void save_module(const Module &module, std::string filename = "");
+EXPORT Module load_module(const std::string &filename);
+// @}
+
+namespace Internal {
+
+/** Serialize a single expression or statement, in the same format
+ * used for the bodies of the functions of a module. Calls to Funcs
+ * can't be serialized, so this is for lowered IR. Expressions and
+ * statements that are shared within the input are shared in the
+ * output too. */
+// @{
+EXPORT std::vector<uint8_t> serialize(Expr e);
+EXPORT std::vector<uint8_t> serialize(Stmt s);
+EXPORT Expr deserialize_expr(const std::vector<uint8_t> &data);
+EXPORT Stmt deserialize_stmt(const std::vector<uint8_t> &data);
+// @}
+
+EXPORT void serialize_test();
+
+}
+
+}
+
+#endif
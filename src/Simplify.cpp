@@ -2796,12 +2796,12 @@ private:
                 !b.type().is_max(ib) &&
                 is_const_power_of_two_integer(make_const(a.type(), ib + 1), &bits)) {
                 expr = Mod::make(a, make_const(a.type(), ib + 1));
-            } else if (const_uint(b, &ub)) {
-                if (b.type().is_max(ub)) {
-                    expr = a;
-                } else if (is_const_power_of_two_integer(make_const(a.type(), ub + 1), &bits)) {
-                    expr = Mod::make(a, make_const(a.type(), ib + 1));
-                }
+            } else if (const_uint(b, &ub) &&
+                       b.type().is_max(ub)) {
+                expr = a;
+            } else if (const_uint(b, &ub) &&
+                       is_const_power_of_two_integer(make_const(a.type(), ub + 1), &bits)) {
+                expr = Mod::make(a, make_const(a.type(), ub + 1));
             } else if (a.same_as(op->args[0]) && b.same_as(op->args[1])) {
                 expr = op;
             } else {
@@ -3464,6 +3464,8 @@ void simplify_test() {
     check(max(cast(UInt(32), (int) 4000000023UL) , cast(UInt(32), 1000)), make_const(UInt(32), (int) 4000000023UL));
     check(cast(UInt(32), (int) 4000000023UL) < cast(UInt(32), 1000), const_false());
     check(cast(UInt(32), (int) 4000000023UL) == cast(UInt(32), 1000), const_false());
+    check(cast(UInt(32), x) & cast(UInt(32), 0x7fff), cast(UInt(32), x) % cast(UInt(32), 0x8000));
+    check(cast(UInt(32), x) & cast(UInt(32), 0x7ffe), cast(UInt(32), x) & cast(UInt(32), 0x7ffe));
 
     check(cast(Float(64), 0.5f), Expr(0.5));
 
@@ -0,0 +1,199 @@
+#include "SkipTiles.h"
+#include "Bounds.h"
+#include "Debug.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+class FindRealizations : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Realize *op) {
+        names.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    set<string> names;
+};
+
+// Does a Stmt realize a Func?
+bool realizes(Stmt s, const string &func) {
+    FindRealizations r;
+    s.accept(&r);
+    return r.names.count(func) > 0;
+}
+
+// Guard the body of a loop to be skipped. Descends past the
+// computation of the mask and of anything computed before it, and of
+// any Funcs stored outside of the loop, which may rely on being
+// computed on every iteration (e.g. because of sliding window).
+class GuardTile : public IRMutator {
+    Function func, mask;
+    Expr fill;
+    const string &loop, &flag;
+    set<string> realized_inside;
+    bool mask_ready;
+
+    using IRMutator::visit;
+
+    void visit(const Realize *op) {
+        if (op->name == mask.name() || realizes(op->body, mask.name())) {
+            IRMutator::visit(op);
+        } else {
+            stmt = guard(op);
+        }
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name == mask.name() || !realized_inside.count(op->name) ||
+            realizes(op->consume, mask.name())) {
+            mask_ready = mask_ready || op->name == mask.name();
+            Stmt consume = mutate(op->consume);
+            stmt = ProducerConsumer::make(op->name, op->produce, op->update, consume);
+        } else {
+            stmt = guard(op);
+        }
+    }
+
+    // Build a loop nest over a box.
+    Stmt loop_over(const Box &b, const vector<Expr> &vars, Stmt body) {
+        for (size_t i = 0; i < b.size(); i++) {
+            const Variable *v = vars[i].as<Variable>();
+            body = For::make(v->name, b[i].min, b[i].max - b[i].min + 1,
+                             ForType::Serial, DeviceAPI::Parent, body);
+        }
+        return body;
+    }
+
+    Stmt guard(Stmt s) {
+        user_assert(mask_ready)
+            << "Can't skip tiles of " << func.name() << " over " << loop
+            << " because " << mask.name() << " is computed inside of the loop.\n";
+
+        Box read = box_required(s, mask.name());
+        user_assert(!read.empty())
+            << "Can't skip tiles of " << func.name() << " over " << loop
+            << " because it doesn't read " << mask.name() << " inside of the loop.\n";
+        Box written = box_provided(s, func.name());
+        internal_assert(written.size() == func.args().size());
+        for (size_t i = 0; i < read.size(); i++) {
+            user_assert(read[i].min.defined() && read[i].max.defined())
+                << "Can't skip tiles of " << func.name() << " over " << loop
+                << " because the region of " << mask.name() << " it reads is unbounded.\n";
+        }
+        for (size_t i = 0; i < written.size(); i++) {
+            internal_assert(written[i].min.defined() && written[i].max.defined());
+        }
+
+        // Scan the region of the mask the tile reads for a non-zero
+        // value.
+        vector<Expr> coords;
+        for (const string &arg : mask.args()) {
+            coords.push_back(Variable::make(Int(32), flag + "." + arg));
+        }
+        Expr value = Call::make(mask, coords);
+        Stmt scan = IfThenElse::make(value != make_zero(value.type()),
+                                     Store::make(flag, make_one(UInt(8)), 0));
+        scan = loop_over(read, coords, scan);
+        scan = Block::make(Store::make(flag, make_zero(UInt(8)), 0), scan);
+
+        // Otherwise write the fill value over the tile.
+        vector<Expr> site;
+        for (const string &arg : func.args()) {
+            site.push_back(Variable::make(Int(32), flag + ".fill." + arg));
+        }
+        Stmt fill_tile = loop_over(written, site, Provide::make(func.name(), {fill}, site));
+
+        Expr is_set = Load::make(UInt(8), flag, 0, Buffer(), Parameter()) != 0;
+        return Block::make(scan, IfThenElse::make(is_set, s, fill_tile));
+    }
+
+public:
+    GuardTile(Function f, Function m, Expr fill, const string &loop, const string &flag, Stmt body) :
+        func(f), mask(m), fill(fill), loop(loop), flag(flag) {
+        FindRealizations r;
+        body.accept(&r);
+        realized_inside = r.names;
+        mask_ready = !realized_inside.count(mask.name());
+    }
+
+    using IRMutator::mutate;
+
+    Stmt mutate(Stmt s) {
+        if (s.as<LetStmt>() || s.as<Realize>() || s.as<ProducerConsumer>()) {
+            return IRMutator::mutate(s);
+        } else {
+            return guard(s);
+        }
+    }
+};
+
+class InjectSkipTiles : public IRMutator {
+    struct Skip {
+        Function func, mask;
+        SkipTiles params;
+    };
+    vector<Skip> skips;
+
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        IRMutator::visit(op);
+        for (const Skip &skip : skips) {
+            if (starts_with(op->name, skip.func.name() + ".s0.") &&
+                ends_with(op->name, "." + skip.params.var)) {
+                op = stmt.as<For>();
+                internal_assert(op);
+                debug(3) << "Skipping tiles of " << op->name << " where "
+                         << skip.mask.name() << " is zero\n";
+                // The flag is set until the mask has been scanned, so
+                // that anything that tests it early (e.g. allocation
+                // conditions from skip_stages) sees that the tile is
+                // computed.
+                string flag = unique_name(skip.func.name() + "_skip", false);
+                Stmt body = GuardTile(skip.func, skip.mask, skip.params.fill,
+                                      op->name, flag, op->body).mutate(op->body);
+                body = Block::make(Store::make(flag, make_one(UInt(8)), 0), body);
+                body = Allocate::make(flag, UInt(8), MemoryType::Stack, {1}, const_true(), body);
+                stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+            }
+        }
+    }
+
+public:
+    InjectSkipTiles(const map<string, Function> &env) {
+        for (const auto &i : env) {
+            for (const SkipTiles &s : i.second.schedule().skip_tiles()) {
+                map<string, Function>::const_iterator mask = env.find(s.mask);
+                user_assert(mask != env.end())
+                    << "Can't skip tiles of " << i.first << " where " << s.mask
+                    << " is zero, because " << i.first << " doesn't use " << s.mask << ".\n";
+                user_assert(!mask->second.schedule().compute_level().is_inline())
+                    << "Can't skip tiles of " << i.first << " where " << s.mask
+                    << " is zero, because " << s.mask << " is scheduled inline.\n";
+                skips.push_back({i.second, mask->second, s});
+            }
+        }
+    }
+};
+
+}
+
+Stmt skip_tiles(Stmt s, const map<string, Function> &env) {
+    return InjectSkipTiles(env).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,26 @@
+#ifndef HALIDE_SKIP_TILES_H
+#define HALIDE_SKIP_TILES_H
+
+/** \file
+ * Defines the lowering pass that skips tiles of a function where a
+ * mask is zero.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Guard the body of each loop scheduled with Func::skip_tiles with a
+ * scan over the region of the mask it reads. If the mask is all zero
+ * there, the function's fill value is written to the region the body
+ * would have computed instead. Should be run right after bounds
+ * inference, before sliding window. */
+Stmt skip_tiles(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
@@ -48,11 +48,36 @@ private:
     const map<string, Function> &env;
     Scope<int> realizations;
 
+    // Get the blocked storage layout of a function or an input
+    // image.
+    vector<StorageBlock> storage_blocks(const string &name, const Parameter &param) {
+        map<string, Function>::const_iterator iter = env.find(name);
+        if (iter != env.end()) {
+            return iter->second.storage_blocks();
+        } else if (param.defined() && param.is_buffer()) {
+            return param.storage_blocks();
+        } else {
+            return vector<StorageBlock>();
+        }
+    }
+
     Expr flatten_args(const string &name, const vector<Expr> &args,
-                      bool internal) {
+                      bool internal, const vector<StorageBlock> &blocks) {
         Expr idx = 0;
         vector<Expr> mins(args.size()), strides(args.size());
 
+        // The blocks are nested innermost first inside all of the
+        // other dimensions, so the strides within them are
+        // constants.
+        vector<int> block_factor(args.size(), 0), block_stride(args.size(), 0);
+        int inner_stride = 1;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            internal_assert(blocks[i].dim < (int)args.size());
+            block_factor[blocks[i].dim] = blocks[i].factor;
+            block_stride[blocks[i].dim] = inner_stride;
+            inner_stride *= blocks[i].factor;
+        }
+
         for (size_t i = 0; i < args.size(); i++) {
             string dim = std::to_string(i);
             string stride_name = name + ".stride." + dim;
@@ -74,6 +99,7 @@ private:
             // strategy makes sense when we expect x to cancel with
             // something in xmin.  We use this for internal allocations
             for (size_t i = 0; i < args.size(); i++) {
+                if (block_factor[i]) continue;
                 idx += (args[i] - mins[i]) * strides[i];
             }
         } else {
@@ -84,12 +110,22 @@ private:
             // to be symbolic
             Expr base = 0;
             for (size_t i = 0; i < args.size(); i++) {
+                if (block_factor[i]) continue;
                 idx += args[i] * strides[i];
                 base += mins[i] * strides[i];
             }
             idx -= base;
         }
 
+        // A blocked dimension is addressed by which block the
+        // coordinate is in, using the stride between blocks, plus the
+        // offset within the block. Blocks start at the min.
+        for (size_t i = 0; i < args.size(); i++) {
+            if (!block_factor[i]) continue;
+            Expr rel = args[i] - mins[i];
+            idx += (rel / block_factor[i]) * strides[i] + (rel % block_factor[i]) * block_stride[i];
+        }
+
         return idx;
     }
 
@@ -111,9 +147,13 @@ private:
         realizations.pop(realize->name);
 
         vector<int> storage_permutation;
+        MemoryType memory_type;
+        vector<StorageBlock> blocks;
         {
             map<string, Function>::const_iterator iter = env.find(realize->name);
             internal_assert(iter != env.end()) << "Realize node refers to function not in environment.\n";
+            memory_type = iter->second.schedule().memory_type();
+            blocks = iter->second.storage_blocks();
             const vector<string> &storage_dims = iter->second.schedule().storage_dims();
             const vector<string> &args = iter->second.args();
             for (size_t i = 0; i < storage_dims.size(); i++) {
@@ -128,6 +168,24 @@ private:
 
         internal_assert(storage_permutation.size() == realize->bounds.size());
 
+        // Blocked dimensions take up whole blocks, which are stored
+        // innermost, so the allocation is the product of the block
+        // sizes and the number of blocks along each dimension.
+        vector<int> block_factor(realize->bounds.size(), 0);
+        int block_size = 1;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            block_factor[blocks[i].dim] = blocks[i].factor;
+            block_size *= blocks[i].factor;
+        }
+        if (!blocks.empty()) {
+            for (size_t i = 0; i < extents.size(); i++) {
+                if (block_factor[i]) {
+                    extents[i] = (extents[i] + block_factor[i] - 1) / block_factor[i];
+                }
+            }
+            extents.push_back(block_size);
+        }
+
         stmt = body;
         for (size_t idx = 0; idx < realize->types.size(); idx++) {
             string buffer_name = realize->name;
@@ -172,19 +230,23 @@ private:
                                  stmt);
 
             // Make the allocation node
-            stmt = Allocate::make(buffer_name, t, extents, condition, stmt);
+            stmt = Allocate::make(buffer_name, t, memory_type, extents, condition, stmt);
 
             // Compute the strides
             for (int i = (int)realize->bounds.size()-1; i > 0; i--) {
                 int prev_j = storage_permutation[i-1];
                 int j = storage_permutation[i];
-                Expr stride = stride_var[prev_j] * extent_var[prev_j];
+                Expr prev_extent = extent_var[prev_j];
+                if (block_factor[prev_j]) {
+                    prev_extent = (prev_extent + block_factor[prev_j] - 1) / block_factor[prev_j];
+                }
+                Expr stride = stride_var[prev_j] * prev_extent;
                 stmt = LetStmt::make(stride_name[j], stride, stmt);
             }
-            // Innermost stride is one
+            // Innermost stride is one, or the size of a block
             if (dims > 0) {
                 int innermost = storage_permutation.empty() ? 0 : storage_permutation[0];
-                stmt = LetStmt::make(stride_name[innermost], 1, stmt);
+                stmt = LetStmt::make(stride_name[innermost], block_size, stmt);
             }
 
             // Assign the mins and extents stored
@@ -236,7 +298,8 @@ private:
         for (size_t i = 0; i < values.size(); i++) {
             const ProvideValue &cv = values[i];
 
-            Expr idx = mutate(flatten_args(cv.name, provide->args, !is_output));
+            Expr idx = mutate(flatten_args(cv.name, provide->args, !is_output,
+                                           storage_blocks(provide->name, Parameter())));
             Expr var = Variable::make(cv.value.type(), cv.name + ".value");
             Stmt store = Store::make(cv.name, var, idx);
 
@@ -268,7 +331,8 @@ private:
         for (size_t i = 0; i < values.size(); i++) {
             const ProvideValue &cv = values[i];
 
-            Expr idx = mutate(flatten_args(cv.name, provide->args, !is_output));
+            Expr idx = mutate(flatten_args(cv.name, provide->args, !is_output,
+                                           storage_blocks(provide->name, Parameter())));
             Stmt store = Store::make(cv.name, cv.value, idx);
 
             if (result.defined()) {
@@ -343,7 +407,8 @@ private:
             // Promote the type to be a multiple of 8 bits
             Type t = call->type.with_bits(call->type.bytes() * 8);
 
-            Expr idx = mutate(flatten_args(name, call->args, !(is_output || is_input)));
+            Expr idx = mutate(flatten_args(name, call->args, !(is_output || is_input),
+                                           storage_blocks(call->name, call->param)));
             expr = Load::make(t, name, idx, call->image, call->param);
 
             if (call->type.bits() != t.bits()) {
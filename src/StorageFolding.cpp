@@ -54,6 +54,8 @@ public:
 // Attempt to fold the storage of a particular function in a statement
 class AttemptStorageFoldingOfFunction : public IRMutator {
     string func;
+    vector<string> args;
+    vector<FoldFactor> explicit_factors;
 
     using IRMutator::visit;
 
@@ -66,6 +68,33 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
         }
     }
 
+    bool already_folded(int dim) {
+        for (const Fold &f : dims_folded) {
+            if (f.dim == dim) return true;
+        }
+        return false;
+    }
+
+    // Get the fold factor requested by the schedule for a dimension,
+    // if any, rounded up to a power of two so that the wraparound is
+    // a mask.
+    Expr explicit_factor(int dim) {
+        if (dim >= (int)args.size()) return Expr();
+        for (const FoldFactor &f : explicit_factors) {
+            if (f.var == args[dim]) {
+                Expr factor = simplify(f.factor);
+                if (const int64_t *c = as_const_int(factor)) {
+                    int p = 1;
+                    while (p < *c) p *= 2;
+                    return p;
+                }
+                Expr bits = 32 - count_leading_zeros(max(factor, 2) - 1);
+                return select(factor > 1, 1 << bits, 1);
+            }
+        }
+        return Expr();
+    }
+
     void visit(const For *op) {
         if (op->for_type != ForType::Serial && op->for_type != ForType::Unrolled) {
             // We can't proceed into a parallel for loop.
@@ -81,11 +110,29 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
         Box box = box_touched(op->body, func);
 
         Stmt result = op;
-
-        // Try each dimension in turn from outermost in
+        vector<Stmt> checks;
+
+        // Set if one of the folds shares values between iterations
+        // of this loop, in which case folding further along inner
+        // loops would clobber values still in use.
+        bool overlapping = false;
+
+        // Try each dimension in turn from outermost in. Several
+        // dimensions can be folded over the same loop: as long as the
+        // region touched in each iteration fits within the folded
+        // storage in every dimension, no two live values share a
+        // location.
         for (size_t i = box.size(); i > 0; i--) {
-            Expr min = simplify(box[i-1].min);
-            Expr max = simplify(box[i-1].max);
+            int dim = (int)i - 1;
+            if (already_folded(dim) ||
+                !box[dim].min.defined() ||
+                !box[dim].max.defined()) {
+                continue;
+            }
+
+            Expr min = simplify(box[dim].min);
+            Expr max = simplify(box[dim].max);
+            Expr hint = explicit_factor(dim);
 
             debug(3) << "\nConsidering folding " << func << " over for loop over " << op->name << '\n'
                      << "Min: " << min << '\n'
@@ -93,68 +140,97 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
 
             // The min or max has to be monotonic with the loop
             // variable, and should depend on the loop variable.
-            if (is_monotonic(min, op->name) == MonotonicIncreasing ||
-                is_monotonic(max, op->name) == MonotonicDecreasing) {
-
-                // The max of the extent over all values of the loop variable must be a constant
-                Expr extent = simplify(max - min);
-                Scope<Interval> scope;
-                scope.push(op->name, Interval(Variable::make(Int(32), op->name + ".loop_min"),
-                                              Variable::make(Int(32), op->name + ".loop_max")));
-                Expr max_extent = bounds_of_expr_in_scope(extent, scope).max;
-                scope.pop(op->name);
-
-                max_extent = simplify(max_extent);
-
-                const IntImm *max_extent_int = max_extent.as<IntImm>();
-                if (max_extent_int) {
-                    int extent = max_extent_int->value;
-
-                    int factor = 1;
-                    while (factor <= extent) factor *= 2;
-
-                    debug(3) << "Proceeding with factor " << factor << "\n";
-
-                    Fold fold = {(int)i - 1, factor};
-                    dims_folded.push_back(fold);
-                    result = FoldStorageOfFunction(func, (int)i - 1, factor).mutate(result);
-
-                    Expr step = finite_difference(min, op->name);
-
-                    if (is_one(simplify(extent < step))) {
-                        // There's no overlapping usage between loop
-                        // iterations, so we can continue to search
-                        // for further folding opportinities
-                        // recursively.
-                    } else {
-                        stmt = result;
-                        return;
-                    }
+            bool monotonic = (is_monotonic(min, op->name) == MonotonicIncreasing ||
+                              is_monotonic(max, op->name) == MonotonicDecreasing);
+
+            // The max of the extent over all values of the loop
+            // variable must be a constant, unless the schedule gave
+            // us a fold factor, in which case we check it at runtime.
+            Expr extent = simplify(max - min);
+            Scope<Interval> scope;
+            scope.push(op->name, Interval(Variable::make(Int(32), op->name + ".loop_min"),
+                                          Variable::make(Int(32), op->name + ".loop_max")));
+            Expr max_extent = simplify(bounds_of_expr_in_scope(extent, scope).max);
+            scope.pop(op->name);
 
+            const IntImm *max_extent_int = max_extent.as<IntImm>();
+            Expr factor;
+            if (monotonic && max_extent_int) {
+                int extent = max_extent_int->value;
+                if (hint.defined()) {
+                    const IntImm *hint_int = hint.as<IntImm>();
+                    user_assert(!hint_int || hint_int->value > extent)
+                        << "Can't fold storage of " << func << " over " << args[dim]
+                        << " by a factor of " << hint << ", because each iteration of the loop over "
+                        << op->name << " uses " << (extent + 1) << " values of it.\n";
+                    factor = hint;
+                    if (!hint_int) {
+                        checks.push_back(make_check(dim, op->name, extent, factor));
+                    }
                 } else {
-                    debug(3) << "Not folding because extent not bounded by a constant\n"
-                             << "extent = " << extent << "\n"
-                             << "max extent = " << max_extent << "\n";
+                    int f = 1;
+                    while (f <= extent) f *= 2;
+                    factor = f;
                 }
+            } else if (hint.defined()) {
+                // We couldn't prove that folding is safe, but the
+                // schedule asked for it. If the region moves
+                // monotonically, we only have to check that it fits.
+                // If it doesn't, then sliding window didn't reuse any
+                // values across iterations either, so the same check
+                // suffices.
+                factor = hint;
+                checks.push_back(make_check(dim, op->name, extent, factor));
             } else {
-                debug(3) << "Not folding because loop min or max not monotonic in the loop variable\n"
+                debug(3) << "Not folding because loop min or max not monotonic in the loop variable, "
+                         << "or extent not bounded by a constant\n"
                          << "min = " << min << "\n"
-                         << "max = " << max << "\n";
+                         << "max = " << max << "\n"
+                         << "max extent = " << max_extent << "\n";
+                continue;
             }
-        }
 
-        // Any folds that took place folded dimensions away entirely, so we can proceed recursively.
-        if (const For *f = result.as<For>()) {
-            Stmt body = mutate(f->body);
-            if (body.same_as(f->body)) {
-                stmt = result;
-            } else {
-                stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+            debug(3) << "Proceeding with factor " << factor << "\n";
+
+            Fold fold = {dim, factor};
+            dims_folded.push_back(fold);
+            result = FoldStorageOfFunction(func, dim, factor).mutate(result);
+
+            Expr step = finite_difference(min, op->name);
+
+            if (!is_one(simplify(extent < step))) {
+                // There may be overlapping usage between loop
+                // iterations, so we can't search inner loops for
+                // further folding opportunities.
+                overlapping = true;
             }
+        }
+
+        const For *f = result.as<For>();
+        internal_assert(f);
+        Stmt body = f->body;
+        if (!overlapping) {
+            // Any folds that took place folded dimensions away
+            // entirely, so we can proceed recursively.
+            body = mutate(body);
+        }
+        for (Stmt check : checks) {
+            body = Block::make(check, body);
+        }
+        if (body.same_as(op->body)) {
+            stmt = op;
         } else {
-            stmt = result;
+            stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
         }
+    }
 
+    // Make an assertion that the extent touched of a dimension fits
+    // within the fold factor.
+    Stmt make_check(int dim, const string &loop, Expr extent, Expr factor) {
+        Expr error = Call::make(Int(32), "halide_error_bad_fold",
+                                {func, args[dim], loop, extent + 1, factor},
+                                Call::Extern);
+        return AssertStmt::make(extent < factor, error);
     }
 
 public:
@@ -164,7 +240,9 @@ public:
     };
     vector<Fold> dims_folded;
 
-    AttemptStorageFoldingOfFunction(string f) : func(f) {}
+    AttemptStorageFoldingOfFunction(string f, const vector<string> &a,
+                                    const vector<FoldFactor> &e) :
+        func(f), args(a), explicit_factors(e) {}
 };
 
 /** Check if a buffer's allocated is referred to directly via an
@@ -190,12 +268,24 @@ private:
 
 // Look for opportunities for storage folding in a statement
 class StorageFolding : public IRMutator {
+    const map<string, Function> &env;
+
     using IRMutator::visit;
 
     void visit(const Realize *op) {
         Stmt body = mutate(op->body);
 
-        AttemptStorageFoldingOfFunction folder(op->name);
+        // Anonymous realizations (e.g. inlined reductions) have no
+        // schedule, so there are no explicit fold factors.
+        vector<string> args;
+        vector<FoldFactor> explicit_factors;
+        map<string, Function>::const_iterator iter = env.find(op->name);
+        if (iter != env.end()) {
+            args = iter->second.args();
+            explicit_factors = iter->second.schedule().fold_factors();
+        }
+
+        AttemptStorageFoldingOfFunction folder(op->name, args, explicit_factors);
         IsBufferSpecial special(op->name);
         op->accept(&special);
 
@@ -230,6 +320,9 @@ class StorageFolding : public IRMutator {
             }
         }
     }
+
+public:
+    StorageFolding(const map<string, Function> &e) : env(e) {}
 };
 
 // Because storage folding runs before simplification, it's useful to
@@ -266,9 +359,9 @@ class SubstituteInConstants : public IRMutator {
     }
 };
 
-Stmt storage_folding(Stmt s) {
+Stmt storage_folding(Stmt s, const map<string, Function> &env) {
     s = SubstituteInConstants().mutate(s);
-    s = StorageFolding().mutate(s);
+    s = StorageFolding(env).mutate(s);
     return s;
 }
 
@@ -6,7 +6,10 @@
  * down to smaller circular buffers when possible
  */
 
+#include <map>
+
 #include "IR.h"
+#include "Function.h"
 
 namespace Halide {
 namespace Internal {
@@ -22,9 +25,13 @@ namespace Internal {
  \endcode
  *
  * We can store f as a circular buffer of size two, instead of
- * allocating space for all of it.
+ * allocating space for all of it. Several dimensions may be folded
+ * over the same loop. Fold factors are rounded up to powers of two,
+ * so that the wraparound is a mask. Fold factors given in a
+ * function's schedule (see \ref Func::fold_storage) are used when
+ * the factor can't be inferred, and are checked at runtime.
  */
-Stmt storage_folding(Stmt s);
+Stmt storage_folding(Stmt s, const std::map<std::string, Function> &env);
 
 }
 }
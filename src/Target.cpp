@@ -101,10 +101,20 @@ Target get_host_target() {
         // Call cpuid with eax=7, ecx=0
         int info2[4];
         cpuid(info2, 7, 0);
-        bool have_avx2 = info[1] & (1 << 5);
+        bool have_avx2 = info2[1] & (1 << 5);
         if (have_avx2) {
             initial_features.push_back(Target::AVX2);
         }
+        #if LLVM_VERSION >= 70
+        // Halide can only use VNNI with LLVM 7 or later.
+        bool have_avx512 = ((info2[1] & (1 << 16)) &&  // F
+                            (info2[1] & (1 << 30)) &&  // BW
+                            (info2[1] & (1U << 31)));  // VL
+        bool have_vnni = info2[2] & (1 << 11);
+        if (have_avx2 && have_avx512 && have_vnni) {
+            initial_features.push_back(Target::AVX512_VNNI);
+        }
+        #endif
     }
 
     return Target(os, arch, bits, initial_features);
@@ -180,8 +190,10 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"fma", Target::FMA},
     {"fma4", Target::FMA4},
     {"f16c", Target::F16C},
+    {"avx512_vnni", Target::AVX512_VNNI},
     {"armv7s", Target::ARMv7s},
     {"no_neon", Target::NoNEON},
+    {"arm_dot_prod", Target::ARMDotProd},
     {"cuda", Target::CUDA},
     {"cuda_capability_30", Target::CUDACapability30},
     {"cuda_capability_32", Target::CUDACapability32},
@@ -198,6 +210,9 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"profile", Target::Profile},
     {"no_runtime", Target::NoRuntime},
     {"metal", Target::Metal},
+    {"fast_compile", Target::FastCompile},
+    {"soft_float16", Target::SoftFloat16},
+    {"hoist_loop_invariants", Target::HoistLoopInvariants},
 };
 
 bool lookup_feature(const std::string &tok, Target::Feature &result) {
@@ -356,6 +371,20 @@ bool Target::merge_string(const std::string &target) {
     return true;
 }
 
+bool Target::supported() const {
+    #if LLVM_VERSION < 70
+    if (has_feature(Target::AVX512_VNNI)) {
+        return false;
+    }
+    #endif
+    #if LLVM_VERSION < 60
+    if (has_feature(Target::ARMDotProd)) {
+        return false;
+    }
+    #endif
+    return true;
+}
+
 std::string Target::to_string() const {
     string result;
     for (auto const &arch_entry : arch_name_map) {
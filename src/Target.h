@@ -46,9 +46,11 @@ struct Target {
         FMA,  ///< Enable x86 FMA instruction
         FMA4,  ///< Enable x86 (AMD) FMA4 instruction set
         F16C,  ///< Enable x86 16-bit float support
+        AVX512_VNNI,  ///< Use AVX-512 VNNI dot-product instructions. Implies AVX-512 F, BW and VL. Only relevant on x86. Needs LLVM 7 or later.
 
         ARMv7s,  ///< Generate code for ARMv7s. Only relevant for 32-bit ARM.
         NoNEON,  ///< Avoid using NEON instructions. Only relevant for 32-bit ARM.
+        ARMDotProd,  ///< Use ARMv8.2 sdot/udot dot-product instructions. Only relevant on ARM. Needs LLVM 6 or later.
 
         CUDA,  ///< Enable the CUDA runtime. Defaults to compute capability 2.0 (Fermi)
         CUDACapability30,  ///< Enable CUDA compute capability 3.0 (Kepler)
@@ -75,6 +77,12 @@ struct Target {
 
         Metal, ///< Enable the (Apple) Metal runtime.
 
+        FastCompile, ///< Run fewer LLVM optimizations, to compile more quickly at the cost of slower code.
+
+        SoftFloat16, ///< Convert between float16 and float32 with integer math, even on targets with instructions for it. Useful for testing the emulation.
+
+        HoistLoopInvariants, ///< Hoist loop invariant values out of loops and rewrite affine indices as induction variables during lowering. Experimental.
+
         FeatureEnd
     };
 
@@ -225,6 +233,11 @@ struct Target {
         return merge_string(target);
     }
 
+    /** Whether this build of Halide can generate code for all of the
+     * features of this target. Some features need a newer version of
+     * LLVM than the one Halide was built with. */
+    EXPORT bool supported() const;
+
     /** Given a data type, return an estimate of the "natural" vector size
      * for that data type when compiling for this Target. */
     int natural_vector_size(Halide::Type t) const {
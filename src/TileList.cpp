@@ -0,0 +1,132 @@
+#include "TileList.h"
+#include "Debug.h"
+#include "Function.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+class InjectTileList : public IRMutator {
+    Function output;
+    Parameter tiles;
+
+    using IRMutator::visit;
+
+    // Compute some stages of the output over each tile in turn, by
+    // redefining the bounds that bounds inference gave them.
+    Stmt tile_loop(Stmt body, int first_stage, int last_stage) {
+        string tile_name = output.name() + ".tile";
+        Expr tile = Variable::make(Int(32), tile_name);
+        const vector<string> &args = output.args();
+        for (int stage = first_stage; stage <= last_stage; stage++) {
+            string prefix = output.name() + ".s" + std::to_string(stage) + ".";
+            for (size_t d = 0; d < args.size(); d++) {
+                // Clamp the tile to the bounds of the whole output, so
+                // that the Funcs the tile uses can still be bounded.
+                string min_name = prefix + args[d] + ".min";
+                string max_name = prefix + args[d] + ".max";
+                Expr old_min = Variable::make(Int(32), min_name);
+                Expr old_max = Variable::make(Int(32), max_name);
+                Expr min = Call::make(tiles, {(int)(2*d), tile});
+                Expr extent = Call::make(tiles, {(int)(2*d + 1), tile});
+                body = LetStmt::make(min_name, clamp(min, old_min, old_max), body);
+                body = LetStmt::make(max_name, clamp(min + extent - 1, old_min, old_max), body);
+            }
+        }
+        Expr count = Variable::make(Int(32), tiles.name() + ".extent.1", tiles);
+        return For::make(tile_name, 0, count, ForType::Parallel, DeviceAPI::Host, body);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name != output.name()) {
+            IRMutator::visit(op);
+            return;
+        }
+        Stmt produce = tile_loop(op->produce, 0, 0);
+        Stmt update = op->update;
+        if (update.defined()) {
+            update = tile_loop(update, 1, (int)output.updates().size());
+        }
+        stmt = ProducerConsumer::make(op->name, produce, update, op->consume);
+    }
+
+public:
+    InjectTileList(Function o, Parameter t) : output(o), tiles(t) {}
+};
+
+// The product of the constant factors of the splits of a var and of
+// the vars it is split into.
+int32_t split_product(const vector<Split> &splits, const string &var) {
+    set<string> vars = {var};
+    int32_t product = 1;
+    for (const Split &s : splits) {
+        if (s.is_fuse()) {
+            if (vars.count(s.inner) || vars.count(s.outer)) {
+                vars.insert(s.old_var);
+            }
+        } else if (vars.count(s.old_var)) {
+            vars.insert(s.outer);
+            if (s.is_split()) {
+                vars.insert(s.inner);
+                const int64_t *factor = as_const_int(s.factor);
+                if (factor) {
+                    product *= (int32_t)*factor;
+                }
+            }
+        }
+    }
+    return product;
+}
+
+int32_t gcd(int32_t a, int32_t b) {
+    while (b) {
+        int32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+}
+
+Stmt inject_tile_list(Stmt s, Function output, Parameter tiles) {
+    internal_assert(tiles.is_buffer() && tiles.type() == Int(32) && tiles.dimensions() == 2);
+    return InjectTileList(output, tiles).mutate(s);
+}
+
+void tile_list_granularity(Function output,
+                           vector<int32_t> &min_extent,
+                           vector<int32_t> &multiple_of) {
+    user_assert(!output.has_extern_definition())
+        << "Can't compute a list of tiles of " << output.name()
+        << " because it has an extern definition\n";
+
+    const vector<string> &args = output.args();
+    min_extent.clear();
+    multiple_of.assign(args.size(), 1);
+    for (const string &arg : args) {
+        min_extent.push_back(split_product(output.schedule().splits(), arg));
+    }
+
+    for (const UpdateDefinition &u : output.updates()) {
+        for (size_t d = 0; d < args.size(); d++) {
+            const Variable *v = u.args[d].as<Variable>();
+            user_assert(v && v->name == args[d])
+                << "Can't compute a list of tiles of " << output.name()
+                << ", because one of its update definitions writes to "
+                << u.args[d] << " instead of " << args[d] << "\n";
+            int32_t p = split_product(u.schedule.splits(), args[d]);
+            multiple_of[d] = multiple_of[d] / gcd(multiple_of[d], p) * p;
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,39 @@
+#ifndef HALIDE_TILE_LIST_H
+#define HALIDE_TILE_LIST_H
+
+/** \file
+ * Defines the lowering pass that computes the output of a pipeline
+ * over a list of tiles given at runtime.
+ */
+
+#include <vector>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Wrap each stage of the output Function in a parallel loop over the
+ * tiles in a two-dimensional int32 buffer, which holds a min and an
+ * extent for each dimension of the output (in that order along the
+ * first dimension) for each tile (along the second dimension). Each
+ * iteration computes the stage over one tile. Everything else is
+ * still computed over the bounds of the whole output buffer, so Funcs
+ * computed at root are shared by all of the tiles. Should be run
+ * right after bounds inference. */
+Stmt inject_tile_list(Stmt s, Function output, Parameter tiles);
+
+/** Find the tile sizes the schedule of a Function can compute without
+ * writing outside of the tile. For each dimension, tiles must be at
+ * least min_extent wide, so that splits of the pure definition can
+ * shift inwards, and a multiple of multiple_of wide, so that splits
+ * of the update definitions don't round up past the end of the
+ * tile. Splits by factors that aren't constant are ignored. */
+void tile_list_granularity(Function output,
+                           std::vector<int32_t> &min_extent,
+                           std::vector<int32_t> &multiple_of);
+
+}
+}
+
+#endif
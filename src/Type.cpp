@@ -33,7 +33,9 @@ Halide::Expr Type::max() const {
         return Internal::UIntImm::make(*this, max_uint(bits()));
     } else {
         internal_assert(is_float());
-        if (bits() == 16) {
+        if (is_bfloat() && bits() == 16) {
+            return Internal::FloatImm::make(*this, (double)bfloat16_t::make_from_bits(0x7f7f));
+        } else if (bits() == 16) {
             return Internal::FloatImm::make(*this, 65504.0);
         } else if (bits() == 32) {
             return Internal::FloatImm::make(*this, FLT_MAX);
@@ -57,7 +59,9 @@ Halide::Expr Type::min() const {
         return Internal::UIntImm::make(*this, 0);
     } else {
         internal_assert(is_float());
-        if (bits() == 16) {
+        if (is_bfloat() && bits() == 16) {
+            return Internal::FloatImm::make(*this, (double)bfloat16_t::make_from_bits(0xff7f));
+        } else if (bits() == 16) {
             return Internal::FloatImm::make(*this, -65504.0);
         } else if (bits() == 32) {
             return Internal::FloatImm::make(*this, -FLT_MAX);
@@ -106,8 +110,12 @@ bool Type::can_represent(Type other) const {
                 (other.is_uint() && other.bits() < bits()));
     } else if (is_uint()) {
         return other.is_uint() && other.bits() <= bits();
+    } else if (is_bfloat()) {
+        return ((other.is_bfloat() && other.bits() <= bits()) ||
+                (bits() == 16 && !other.is_float() && other.bits() <= 8));
     } else if (is_float()) {
-        return ((other.is_float() && other.bits() <= bits()) ||
+        return ((other.is_float() && other.bits() < bits()) ||
+                (other.is_float() && !other.is_bfloat() && other.bits() == bits()) ||
                 (bits() == 64 && other.bits() <= 32) ||
                 (bits() == 32 && other.bits() <= 16));
     } else {
@@ -123,6 +131,9 @@ bool Type::can_represent(int64_t x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (int64_t)(float)(bfloat16_t)(float)x == x;
+            }
             return (int64_t)(float)(float16_t)(float)x == x;
         case 32:
             return (int64_t)(float)x == x;
@@ -144,6 +155,9 @@ bool Type::can_represent(uint64_t x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (uint64_t)(float)(bfloat16_t)(float)x == x;
+            }
             return (uint64_t)(float)(float16_t)(float)x == x;
         case 32:
             return (uint64_t)(float)x == x;
@@ -167,6 +181,9 @@ bool Type::can_represent(double x) const {
     } else if (is_float()) {
         switch (bits()) {
         case 16:
+            if (is_bfloat()) {
+                return (double)(bfloat16_t)x == x;
+            }
             return (double)(float16_t)x == x;
         case 32:
             return (double)(float)x == x;
@@ -31,6 +31,7 @@ struct Type {
     static const halide_type_code_t UInt = halide_type_uint;
     static const halide_type_code_t Float = halide_type_float;
     static const halide_type_code_t Handle = halide_type_handle;
+    static const halide_type_code_t BFloat = halide_type_bfloat;
     // @}
 
     /** The number of bytes required to store a single scalar value of this type. Ignores vector lanes. */
@@ -96,8 +97,14 @@ struct Type {
      * TODO(abadams): Decide what to do for lanes() == 0. */
     bool is_scalar() const {return lanes() == 1;}
 
-    /** Is this type a floating point type (float or double). */
-    bool is_float() const {return code() == Float;}
+    /** Is this type a floating point type (float, double, or
+     * bfloat). */
+    bool is_float() const {return code() == Float || code() == BFloat;}
+
+    /** Is this type a floating point type in the bfloat format? These
+     * have the exponent range of a float, and fewer bits of
+     * mantissa. */
+    bool is_bfloat() const {return code() == BFloat;}
 
     /** Is this type a signed integer type? */
     bool is_int() const {return code() == Int;}
@@ -164,6 +171,12 @@ inline Type Float(int bits, int lanes = 1) {
     return Type(Type::Float, bits, lanes);
 }
 
+/** Construct a floating-point type in the bfloat format. Only 16-bit
+ * is supported. */
+inline Type BFloat(int bits, int lanes = 1) {
+    return Type(Type::BFloat, bits, lanes);
+}
+
 /** Construct a boolean type */
 inline Type Bool(int lanes = 1) {
     return UInt(1, lanes);
@@ -15,6 +15,33 @@ namespace Internal {
 
 using std::string;
 using std::vector;
+using std::pair;
+
+namespace {
+
+/** Check if an expression loads from the named buffer. */
+class LoadsFromBuffer : public IRVisitor {
+    using IRVisitor::visit;
+
+    const string &buf;
+
+    void visit(const Load *op) {
+        result = result || op->name == buf;
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result;
+    LoadsFromBuffer(const string &b) : buf(b), result(false) {}
+};
+
+bool loads_from_buffer(Expr e, const string &buf) {
+    LoadsFromBuffer loads(buf);
+    e.accept(&loads);
+    return loads.result;
+}
+
+}
 
 class VectorizeLoops : public IRMutator {
     class VectorSubs : public IRMutator {
@@ -372,7 +399,56 @@ class VectorizeLoops : public IRMutator {
             }
         }
 
+        // Find the Load of the stored-to site in an accumulation of
+        // the form f[i] = f[i] op b.
+        template<typename T>
+        const Load *accumulating_load(const Store *op, Expr &other) {
+            const T *e = op->value.as<T>();
+            if (!e) return NULL;
+            Expr operands[2] = {e->a, e->b};
+            for (int i = 0; i < 2; i++) {
+                const Load *load = operands[i].as<Load>();
+                if (load && load->name == op->name && equal(load->index, op->index)) {
+                    other = operands[1-i];
+                    return load;
+                }
+            }
+            return NULL;
+        }
+
+        // Rewrite an accumulation into a site that doesn't depend on
+        // the vectorized var as a horizontal reduction of the
+        // vectorized operand, e.g. f[x] = f[x] + g[ramp(r, 1, 8)]
+        // becomes f[x] = f[x] + vector_reduce_add(g[ramp(r, 1, 8)]).
+        template<typename T>
+        Stmt reduce_horizontally(const Store *op, const string &intrin) {
+            Expr other;
+            const Load *load = accumulating_load<T>(op, other);
+            if (!load) return Stmt();
+
+            Expr index = mutate(op->index);
+            if (index.type().is_vector()) return Stmt();
+
+            Expr value = mutate(other);
+            if (value.type().is_scalar() || loads_from_buffer(value, op->name)) return Stmt();
+
+            Expr reduced = Call::make(value.type().element_of(), intrin, {value}, Call::Intrinsic);
+            Expr old_value = Load::make(load->type, op->name, index, load->image, load->param);
+            return Store::make(op->name, T::make(old_value, reduced), index);
+        }
+
         void visit(const Store *op) {
+            if (!scalarized && !internal_allocations.contains(op->name)) {
+                Stmt reduced = reduce_horizontally<Add>(op, Call::vector_reduce_add);
+                if (!reduced.defined()) reduced = reduce_horizontally<Mul>(op, Call::vector_reduce_mul);
+                if (!reduced.defined()) reduced = reduce_horizontally<Min>(op, Call::vector_reduce_min);
+                if (!reduced.defined()) reduced = reduce_horizontally<Max>(op, Call::vector_reduce_max);
+                if (reduced.defined()) {
+                    stmt = reduced;
+                    return;
+                }
+            }
+
             Expr value = mutate(op->value);
             Expr index = mutate(op->index);
             // Internal allocations always get vectorized.
@@ -508,7 +584,7 @@ class VectorizeLoops : public IRMutator {
             internal_allocations.push(op->name, 0);
             Stmt body = mutate(op->body);
             internal_allocations.pop(op->name);
-            stmt = Allocate::make(op->name, op->type, new_extents, op->condition, body, new_expr, op->free_function);
+            stmt = Allocate::make(op->name, op->type, op->memory_type, new_extents, op->condition, body, new_expr, op->free_function);
         }
 
         Stmt scalarize(Stmt s) {
@@ -636,8 +712,149 @@ class VectorizeLoops : public IRMutator {
 
 };
 
+/** Vectorizing an accumulation across an RVar does a horizontal
+ * reduction on every iteration of the enclosing loops. When an
+ * enclosing serial loop accumulates into the same site on every
+ * iteration, we instead keep a vector of partial sums across that
+ * loop and only do the horizontal reduction once at the end:
+ *
+ \code
+ for (r.ro, 0, n) {
+   f[x] = f[x] + vector_reduce_add(g[ramp(r.ro*8, 1, 8)])
+ }
+ \endcode
+ *
+ * becomes
+ *
+ \code
+ allocate f.partial[8]
+ f.partial[ramp(0, 1, 8)] = x8(0)
+ for (r.ro, 0, n) {
+   f.partial[ramp(0, 1, 8)] = f.partial[ramp(0, 1, 8)] + g[ramp(r.ro*8, 1, 8)]
+ }
+ f[x] = f[x] + vector_reduce_add(f.partial[ramp(0, 1, 8)])
+ \endcode
+ *
+ * If the values summed are products of narrow integers, we instead
+ * keep fewer, wider partial sums, and reduce groups of adjacent
+ * products into them on each iteration. This is the shape of the
+ * widening multiply-add instructions (pmaddwd, vpdpbusd, sdot), which
+ * the backends can then select:
+ *
+ \code
+ f.partial[ramp(0, 1, 4)] = f.partial[ramp(0, 1, 4)] +
+     vector_reduce_add(i32(a[ramp(r.ro*16, 1, 16)]) * i32(b[ramp(r.ro*16, 1, 16)]))
+ \endcode
+ */
+class LiftVectorReductions : public IRMutator {
+    using IRMutator::visit;
+
+    bool in_device_loop;
+
+    // How many adjacent lanes of a product of narrow integers to sum
+    // into each partial sum. Returns 1 if the value isn't such a
+    // product.
+    int widening_factor(Expr value) {
+        const Mul *mul = value.as<Mul>();
+        Type t = value.type();
+        if (!mul || !(t.is_int() || t.is_uint())) {
+            return 1;
+        }
+        for (int bits = 8; bits < t.bits(); bits *= 2) {
+            int factor = t.bits() / bits;
+            if (t.lanes() % factor != 0 || t.lanes() == factor) {
+                continue;
+            }
+            bool narrow_a = (lossless_cast(Int(bits, t.lanes()), mul->a).defined() ||
+                             lossless_cast(UInt(bits, t.lanes()), mul->a).defined());
+            bool narrow_b = (lossless_cast(Int(bits, t.lanes()), mul->b).defined() ||
+                             lossless_cast(UInt(bits, t.lanes()), mul->b).defined());
+            if (narrow_a && narrow_b) {
+                return factor;
+            }
+        }
+        return 1;
+    }
+
+    void visit(const For *op) {
+        bool old_in_device_loop = in_device_loop;
+        if (op->device_api != DeviceAPI::Parent &&
+            op->device_api != DeviceAPI::Host) {
+            in_device_loop = true;
+        }
+        IRMutator::visit(op);
+        in_device_loop = old_in_device_loop;
+
+        if (in_device_loop || op->for_type != ForType::Serial) {
+            return;
+        }
+
+        op = stmt.as<For>();
+        internal_assert(op);
+
+        // Peel off the lets at the top of the loop body.
+        vector<pair<string, Expr>> lets;
+        Stmt body = op->body;
+        while (const LetStmt *let = body.as<LetStmt>()) {
+            lets.push_back(std::make_pair(let->name, let->value));
+            body = let->body;
+        }
+
+        const Store *store = body.as<Store>();
+        const Add *add = store ? store->value.as<Add>() : NULL;
+        const Load *load = add ? add->a.as<Load>() : NULL;
+        const Call *reduce = add ? add->b.as<Call>() : NULL;
+        if (!load || !reduce ||
+            load->name != store->name ||
+            !equal(load->index, store->index) ||
+            reduce->name != Call::vector_reduce_add ||
+            reduce->call_type != Call::Intrinsic ||
+            reduce->type.is_vector()) {
+            return;
+        }
+
+        // The site accumulated into must be invariant across the loop.
+        if (expr_uses_var(store->index, op->name)) return;
+        for (size_t i = 0; i < lets.size(); i++) {
+            if (expr_uses_var(store->index, lets[i].first)) return;
+        }
+
+        Expr value = reduce->args[0];
+        if (loads_from_buffer(value, store->name)) return;
+
+        int factor = widening_factor(value);
+        Expr accumulated = value;
+        Type t = value.type();
+        if (factor > 1) {
+            t = t.with_lanes(t.lanes() / factor);
+            accumulated = Call::make(t, Call::vector_reduce_add, {value}, Call::Intrinsic);
+        }
+
+        string partial = unique_name(store->name + ".partial", false);
+        Expr partial_index = Ramp::make(0, 1, t.lanes());
+        Expr partial_value = Load::make(t, partial, partial_index, Buffer(), Parameter());
+
+        Stmt update = Store::make(partial, Add::make(partial_value, accumulated), partial_index);
+        for (size_t i = lets.size(); i > 0; i--) {
+            update = LetStmt::make(lets[i-1].first, lets[i-1].second, update);
+        }
+        Stmt loop = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, update);
+
+        Stmt init = Store::make(partial, make_zero(t), partial_index);
+        Expr reduced = Call::make(t.element_of(), Call::vector_reduce_add, {partial_value}, Call::Intrinsic);
+        Stmt final = Store::make(store->name, Add::make(load, reduced), store->index);
+
+        stmt = Block::make(init, Block::make(loop, final));
+        stmt = Allocate::make(partial, t.element_of(), MemoryType::Auto, {t.lanes()}, const_true(), stmt);
+    }
+
+public:
+    LiftVectorReductions() : in_device_loop(false) {}
+};
+
 Stmt vectorize_loops(Stmt s) {
-    return VectorizeLoops().mutate(s);
+    s = VectorizeLoops().mutate(s);
+    return LiftVectorReductions().mutate(s);
 }
 
 }
@@ -125,6 +125,36 @@ extern int32_t halide_debug_to_file(void *user_context, const char *filename,
                                     int32_t s3, int32_t type_code,
                                     int32_t bytes_per_element);
 
+/** Called when debug_to_file is used with DebugToFileOptions. Writes
+ * the region of buf with the given mins and extents (clipped to buf)
+ * for every nth call with the same filename. If async is non-zero
+ * the region is copied and written by a background thread. Files
+ * ending in .npy or .raw are appended to. The mins and extents of
+ * dimensions beyond the given number of dimensions are ignored.
+ */
+extern int32_t halide_debug_to_file_region(void *user_context, const char *func,
+                                           const char *filename, int32_t type_code,
+                                           struct buffer_t *buf, int32_t dimensions,
+                                           int32_t min0, int32_t extent0,
+                                           int32_t min1, int32_t extent1,
+                                           int32_t min2, int32_t extent2,
+                                           int32_t min3, int32_t extent3,
+                                           int32_t every, int32_t async);
+
+/** Wait for all asynchronous debug_to_file writes to finish. Returns
+ * halide_error_code_debug_to_file_failed if any of them failed since
+ * the last call. Called at the end of any pipeline that uses
+ * asynchronous debug_to_file. */
+extern int32_t halide_debug_to_file_wait(void *user_context);
+
+/** Set the maximum amount of memory, in bytes, used by copies of data
+ * waiting to be written by asynchronous debug_to_file. Pipelines
+ * wait for earlier writes to finish when this is exceeded. A single
+ * region larger than this is still written, once nothing else is
+ * waiting. The default is 64MB. Passing zero restores the default.
+ */
+extern void halide_debug_to_file_set_queue_size(int64_t size);
+
 
 enum halide_trace_event_code {halide_trace_load = 0,
                               halide_trace_store = 1,
@@ -296,6 +326,30 @@ extern int halide_memoization_cache_lookup(void *user_context, const uint8_t *ca
 extern void halide_memoization_cache_store(void *user_context, const uint8_t *cache_key, int32_t size,
                                            buffer_t *realized_bounds, int32_t tuple_count, buffer_t **tuple_buffers);
 
+/** Like halide_memoization_cache_lookup, but for a Func that is
+ * memoized in tiles. The tile_bounds give the region of the tile, and
+ * the buffers are the whole realization of the Func, which must
+ * contain the tile. On a hit, the tile is copied from the cache into
+ * the buffers, and they do not need to be released.
+ *
+ * The return values are:
+ *  0: Success and cache hit.
+ *  1: Success and cache miss.
+ */
+extern int halide_memoization_cache_lookup_tile(void *user_context, const uint8_t *cache_key, int32_t size,
+                                                buffer_t *tile_bounds, int32_t tuple_count, buffer_t **tuple_buffers);
+
+/** Store a tile of a Func that is memoized in tiles, looked up with
+ * halide_memoization_cache_lookup_tile. The tile is copied out of the
+ * buffers, which are unmodified. Each tile is a separate cache entry,
+ * evicted on its own when the cache is full.
+ *
+ * If there is a memory allocation failure, the store does not store
+ * the data into the cache.
+ */
+extern void halide_memoization_cache_store_tile(void *user_context, const uint8_t *cache_key, int32_t size,
+                                                buffer_t *tile_bounds, int32_t tuple_count, buffer_t **tuple_buffers);
+
 /** If halide_memoization_cache_lookup succeeds,
  * halide_memoization_cache_release must be called to signal the
  * storage is no longer being used by the caller. It will be passed
@@ -416,6 +470,16 @@ enum halide_error_code_t {
      * a GPU kernel. Turn on -debug in your target string to see more
      * details. */
     halide_error_code_device_run_failed = -23,
+
+    /** A Func was scheduled with fold_storage, but some iteration of
+     * the loop it is folded over used more of it than the fold
+     * factor. */
+    halide_error_code_bad_fold = -24,
+
+    /** A buffer with a blocked storage layout (see
+     * Func::split_storage) has a stride smaller than the size of a
+     * block, so its blocks would overlap. */
+    halide_error_code_bad_blocked_stride = -25,
 };
 
 /** Halide calls the functions below on various error conditions. The
@@ -467,6 +531,10 @@ extern int halide_error_out_of_memory(void *user_context);
 extern int halide_error_buffer_argument_is_null(void *user_context, const char *buffer_name);
 extern int halide_error_debug_to_file_failed(void *user_context, const char *func,
                                              const char *filename, int error_code);
+extern int halide_error_bad_fold(void *user_context, const char *func_name, const char *var_name,
+                                 const char *loop_name, int extent, int fold_factor);
+extern int halide_error_bad_blocked_stride(void *user_context, const char *buffer_name,
+                                           int dimension, int stride, int block_size);
 // @}
 
 /** Types in the halide type system. They can be ints, unsigned ints,
@@ -481,8 +549,9 @@ typedef enum halide_type_code_t
 {
     halide_type_int = 0,   //!< signed integers
     halide_type_uint = 1,  //!< unsigned integers
-    halide_type_float = 2, //!< floating point numbers
-    halide_type_handle = 3 //!< opaque pointer type (void *)
+    halide_type_float = 2, //!< IEEE floating point numbers
+    halide_type_handle = 3, //!< opaque pointer type (void *)
+    halide_type_bfloat = 4 //!< floating point numbers in the bfloat format
 } halide_type_code_t;
 
 // Note that while __attribute__ can go before or after the declaration,
@@ -629,6 +698,14 @@ enum halide_argument_kind_t {
     5) don't forget that 32 and 64 bit pointers are different sizes
 */
 
+/** One dimension of a buffer argument with a blocked storage layout:
+ * the dimension is stored as blocks of factor contiguous elements.
+ * See halide_filter_argument_t::storage_blocks. */
+struct halide_storage_block_t {
+    int32_t dim;
+    int32_t factor;
+};
+
 /**
  * halide_filter_argument_t is essentially a plain-C-struct equivalent to
  * Halide::Argument; most user code will never need to create one.
@@ -645,10 +722,18 @@ struct halide_filter_argument_t {
     const halide_scalar_value_t *def;
     const halide_scalar_value_t *min;
     const halide_scalar_value_t *max;
+    // The blocked dimensions of a buffer argument, innermost block
+    // first. The blocks are stored inside all of the other
+    // dimensions, and the buffer_t stride of a blocked dimension is
+    // the stride between blocks. Zero and null for scalar arguments,
+    // and for buffers with an ordinary strided layout.
+    int32_t num_storage_blocks;
+    int32_t padding;
+    const halide_storage_block_t *storage_blocks;
 };
 
 struct halide_filter_metadata_t {
-    /** version of this metadata; currently always 0. */
+    /** version of this metadata; currently always 1. */
     int32_t version;
 
     /** The number of entries in the arguments field. This is always >= 1. */
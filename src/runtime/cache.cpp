@@ -184,6 +184,62 @@ const uint64_t kDefaultCacheSize = 1 << 20;
 WEAK int64_t max_cache_size = kDefaultCacheSize;
 WEAK int64_t current_cache_size = 0;
 
+WEAK void make_most_recently_used(void *user_context, CacheEntry *entry) {
+    if (entry != most_recently_used) {
+        halide_assert(user_context, entry->more_recent != NULL);
+        if (entry->less_recent != NULL) {
+            entry->less_recent->more_recent = entry->more_recent;
+        } else {
+            halide_assert(user_context, least_recently_used == entry);
+            least_recently_used = entry->more_recent;
+        }
+        halide_assert(user_context, entry->more_recent != NULL);
+        entry->more_recent->less_recent = entry->less_recent;
+
+        entry->more_recent = NULL;
+        entry->less_recent = most_recently_used;
+        if (most_recently_used != NULL) {
+            most_recently_used->more_recent = entry;
+        }
+        most_recently_used = entry;
+    }
+}
+
+// Copy the region given by tile from one buffer to another. Both
+// buffers must contain it. Dimensions of the tile with zero extent
+// are unused.
+WEAK void copy_tile(const buffer_t &tile, const buffer_t &src, const buffer_t &dst) {
+    size_t elem_size = src.elem_size;
+    int32_t extent[4];
+    int64_t src_off = 0, dst_off = 0;
+    for (int i = 0; i < 4; i++) {
+        extent[i] = tile.extent[i] ? tile.extent[i] : 1;
+        if (tile.extent[i]) {
+            src_off += (int64_t)(tile.min[i] - src.min[i]) * src.stride[i];
+            dst_off += (int64_t)(tile.min[i] - dst.min[i]) * dst.stride[i];
+        }
+    }
+    // Copy whole rows at a time when they are dense.
+    bool dense_rows = src.stride[0] == 1 && dst.stride[0] == 1;
+    for (int32_t w = 0; w < extent[3]; w++) {
+        for (int32_t z = 0; z < extent[2]; z++) {
+            for (int32_t y = 0; y < extent[1]; y++) {
+                int64_t src_row = src_off + (int64_t)w * src.stride[3] + (int64_t)z * src.stride[2] + (int64_t)y * src.stride[1];
+                int64_t dst_row = dst_off + (int64_t)w * dst.stride[3] + (int64_t)z * dst.stride[2] + (int64_t)y * dst.stride[1];
+                if (dense_rows) {
+                    memcpy(dst.host + dst_row * elem_size, src.host + src_row * elem_size, extent[0] * elem_size);
+                } else {
+                    for (int32_t x = 0; x < extent[0]; x++) {
+                        memcpy(dst.host + (dst_row + (int64_t)x * dst.stride[0]) * elem_size,
+                               src.host + (src_row + (int64_t)x * src.stride[0]) * elem_size,
+                               elem_size);
+                    }
+                }
+            }
+        }
+    }
+}
+
 #if CACHE_DEBUGGING
 WEAK void validate_cache() {
     print(NULL) << "validating cache, "
@@ -341,24 +397,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
             }
 
             if (all_bounds_equal) {
-                if (entry != most_recently_used) {
-                    halide_assert(user_context, entry->more_recent != NULL);
-                    if (entry->less_recent != NULL) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        halide_assert(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
-                    }
-                    halide_assert(user_context, entry->more_recent != NULL);
-                    entry->more_recent->less_recent = entry->less_recent;
-
-                    entry->more_recent = NULL;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != NULL) {
-                        most_recently_used->more_recent = entry;
-                    }
-                    most_recently_used = entry;
-                }
+                make_most_recently_used(user_context, entry);
 
                 for (int32_t i = 0; i < tuple_count; i++) {
                     buffer_t *buf = tuple_buffers[i];
@@ -510,6 +549,137 @@ WEAK void halide_memoization_cache_store(void *user_context, const uint8_t *cach
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 }
 
+WEAK int halide_memoization_cache_lookup_tile(void *user_context, const uint8_t *cache_key, int32_t size,
+                                              buffer_t *tile_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    uint32_t h = djb_hash(cache_key, size);
+    uint32_t index = h % kHashTableSize;
+
+    ScopedMutexLock lock(&memoization_lock);
+
+#if CACHE_DEBUGGING
+    debug_print_key(user_context, "halide_memoization_cache_lookup_tile", cache_key, size);
+
+    debug_print_buffer(user_context, "tile_bounds", *tile_bounds);
+#endif
+
+    CacheEntry *entry = cache_entries[index];
+    while (entry != NULL) {
+        if (entry->hash == h && entry->key_size == (size_t)size &&
+            keys_equal(entry->key, cache_key, size) &&
+            bounds_equal(entry->computed_bounds, *tile_bounds) &&
+            entry->tuple_count == (uint32_t)tuple_count) {
+
+            bool all_elem_sizes_equal = true;
+            for (int32_t i = 0; all_elem_sizes_equal && i < tuple_count; i++) {
+                all_elem_sizes_equal = entry->buffer(i).elem_size == tuple_buffers[i]->elem_size;
+            }
+
+            if (all_elem_sizes_equal) {
+                make_most_recently_used(user_context, entry);
+
+                // The tile is copied out, so the entry is never in use
+                // by the caller.
+                for (int32_t i = 0; i < tuple_count; i++) {
+                    copy_tile(*tile_bounds, entry->buffer(i), *tuple_buffers[i]);
+                }
+
+                return 0;
+            }
+        }
+        entry = entry->next;
+    }
+
+    return 1;
+}
+
+WEAK void halide_memoization_cache_store_tile(void *user_context, const uint8_t *cache_key, int32_t size,
+                                              buffer_t *tile_bounds, int32_t tuple_count, buffer_t **tuple_buffers) {
+    uint32_t h = djb_hash(cache_key, size);
+    uint32_t index = h % kHashTableSize;
+
+    ScopedMutexLock lock(&memoization_lock);
+
+#if CACHE_DEBUGGING
+    debug_print_key(user_context, "halide_memoization_cache_store_tile", cache_key, size);
+
+    debug_print_buffer(user_context, "tile_bounds", *tile_bounds);
+#endif
+
+    // Another thread may have stored the same tile in the meantime.
+    CacheEntry *entry = cache_entries[index];
+    while (entry != NULL) {
+        if (entry->hash == h && entry->key_size == (size_t)size &&
+            keys_equal(entry->key, cache_key, size) &&
+            bounds_equal(entry->computed_bounds, *tile_bounds) &&
+            entry->tuple_count == (uint32_t)tuple_count) {
+            return;
+        }
+        entry = entry->next;
+    }
+
+    void *entry_storage = halide_malloc(NULL, sizeof(CacheEntry) + sizeof(buffer_t) * (tuple_count - 1));
+    if (entry_storage == NULL) {
+        return;
+    }
+
+    CacheEntry *new_entry = (CacheEntry *)entry_storage;
+    if (!new_entry->init(cache_key, size, h, *tile_bounds, tuple_count, tuple_buffers)) {
+        halide_free(user_context, new_entry);
+        return;
+    }
+
+    // Give each buffer of the entry a dense copy of the tile.
+    uint64_t added_size = 0;
+    for (int32_t i = 0; i < tuple_count; i++) {
+        buffer_t &buf = new_entry->buffer(i);
+        int32_t stride = 1;
+        for (int j = 0; j < 4; j++) {
+            buf.min[j] = tile_bounds->min[j];
+            buf.extent[j] = tile_bounds->extent[j];
+            buf.stride[j] = tile_bounds->extent[j] ? stride : 0;
+            stride *= tile_bounds->extent[j] ? tile_bounds->extent[j] : 1;
+        }
+        buf.dev = 0;
+        buf.host_dirty = false;
+        buf.dev_dirty = false;
+
+        size_t buffer_size = full_extent(buf);
+        // See documentation on extra_bytes_host_bytes
+        buf.host = (uint8_t *)halide_malloc(user_context, buffer_size * buf.elem_size + extra_bytes_host_bytes);
+        if (buf.host == NULL) {
+            for (int32_t j = i; j > 0; j--) {
+                halide_free(user_context, new_entry->buffer(j - 1).host - extra_bytes_host_bytes);
+            }
+            halide_free(NULL, new_entry->key);
+            halide_free(user_context, new_entry);
+            return;
+        }
+        buf.host += extra_bytes_host_bytes;
+        *(CacheEntry **)(buf.host - extra_bytes_host_bytes) = new_entry;
+
+        copy_tile(*tile_bounds, *tuple_buffers[i], buf);
+        added_size += buffer_size;
+    }
+
+    current_cache_size += added_size;
+    prune_cache();
+
+    new_entry->next = cache_entries[index];
+    new_entry->less_recent = most_recently_used;
+    if (most_recently_used != NULL) {
+        most_recently_used->more_recent = new_entry;
+    }
+    most_recently_used = new_entry;
+    if (least_recently_used == NULL) {
+        least_recently_used = new_entry;
+    }
+    cache_entries[index] = new_entry;
+
+#if CACHE_DEBUGGING
+    validate_cache();
+#endif
+}
+
 WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     uint8_t *base = (uint8_t *)host - extra_bytes_host_bytes;
     debug(user_context) << "halide_memoization_cache_release\n";
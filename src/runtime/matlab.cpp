@@ -261,6 +261,11 @@ WEAK int halide_matlab_array_to_buffer_t(void *user_context,
         return halide_error_code_matlab_bad_param_type;
     }
 
+    if (arg->num_storage_blocks != 0) {
+        error(user_context) << "Blocked storage layout not supported for parameter " << arg->name << ".\n";
+        return halide_error_code_matlab_bad_param_type;
+    }
+
     int dim_count = get_number_of_dimensions(arr);
     int expected_dims = arg->dimensions;
 
@@ -197,4 +197,23 @@ WEAK int halide_error_debug_to_file_failed(void *user_context, const char *func,
     return halide_error_code_debug_to_file_failed;
 }
 
+WEAK int halide_error_bad_fold(void *user_context, const char *func_name, const char *var_name,
+                               const char *loop_name, int extent, int fold_factor) {
+    error(user_context)
+        << "The folded storage dimension " << var_name << " of " << func_name
+        << " was accessed over an extent of " << extent
+        << " in one iteration of the loop over " << loop_name
+        << ", which is larger than the fold factor " << fold_factor;
+    return halide_error_code_bad_fold;
+}
+
+WEAK int halide_error_bad_blocked_stride(void *user_context, const char *buffer_name,
+                                         int dimension, int stride, int block_size) {
+    error(user_context)
+        << buffer_name << " has a blocked storage layout, but its stride in dimension "
+        << dimension << " is " << stride
+        << ", which is smaller than the block size " << block_size;
+    return halide_error_code_bad_blocked_stride;
+}
+
 }
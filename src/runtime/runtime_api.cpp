@@ -26,6 +26,9 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_cuda_wrap_device_ptr,
     (void *)&halide_current_time_ns,
     (void *)&halide_debug_to_file,
+    (void *)&halide_debug_to_file_region,
+    (void *)&halide_debug_to_file_set_queue_size,
+    (void *)&halide_debug_to_file_wait,
     (void *)&halide_device_free,
     (void *)&halide_device_free_as_destructor,
     (void *)&halide_device_malloc,
@@ -36,7 +39,9 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_enumerate_registered_filters,
     (void *)&halide_error,
     (void *)&halide_error_access_out_of_bounds,
+    (void *)&halide_error_bad_blocked_stride,
     (void *)&halide_error_bad_elem_size,
+    (void *)&halide_error_bad_fold,
     (void *)&halide_error_bounds_inference_call_failed,
     (void *)&halide_error_buffer_allocation_too_large,
     (void *)&halide_error_buffer_argument_is_null,
@@ -65,9 +70,11 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_malloc,
     (void *)&halide_memoization_cache_cleanup,
     (void *)&halide_memoization_cache_lookup,
+    (void *)&halide_memoization_cache_lookup_tile,
     (void *)&halide_memoization_cache_release,
     (void *)&halide_memoization_cache_set_size,
     (void *)&halide_memoization_cache_store,
+    (void *)&halide_memoization_cache_store_tile,
     (void *)&halide_metal_acquire_context,
     (void *)&halide_metal_detach_buffer,
     (void *)&halide_metal_device_interface,
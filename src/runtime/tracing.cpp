@@ -161,6 +161,15 @@ WEAK int32_t default_trace(void *user_context, const halide_trace_event *e) {
                     }
                 } else if (e->type_code == 3) {
                     ss << ((void **)(e->value))[i];
+                } else if (e->type_code == 4) {
+                    halide_assert(user_context, print_bits == 16 && "Tracing a bad type");
+                    // bfloat16 is the top half of a float.
+                    union {
+                        uint32_t as_uint;
+                        float as_float;
+                    } u;
+                    u.as_uint = (uint32_t)(((uint16_t *)(e->value))[i]) << 16;
+                    ss << u.as_float;
                 }
             }
             if (e->vector_width > 1) {
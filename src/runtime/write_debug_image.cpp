@@ -1,9 +1,11 @@
 #include "runtime_internal.h"
 #include "HalideRuntime.h"
+#include "scoped_mutex_lock.h"
 
 extern "C" void *fopen(const char *, const char *);
 extern "C" int fclose(void *);
 extern "C" size_t fwrite(const void *, size_t, size_t, void *);
+extern "C" int fseek(void *, long, int);
 
 // Use TIFF because it meets the following criteria:
 // - Supports uncompressed data
@@ -102,9 +104,250 @@ WEAK bool has_tiff_extension(const char *filename) {
     return *f == '\0';
 }
 
+// Case-insensitive check for an extension, given in lower case
+// including the dot.
+WEAK bool has_extension(const char *filename, const char *ext) {
+    size_t n = strlen(filename), m = strlen(ext);
+    if (n < m) return false;
+    const char *f = filename + n - m;
+    for (size_t i = 0; i < m; i++) {
+        char c = f[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != ext[i]) return false;
+    }
+    return true;
+}
+
+// What we know about each file written by debug_to_file with
+// options. Entries are never freed, as frames appended to a file must
+// match the ones already there.
+struct debug_file_state {
+    debug_file_state *next;
+    char *filename;
+    char *func;
+    // The number of calls to halide_debug_to_file_region for this
+    // file, used to implement "every".
+    int32_t calls;
+    // The frames written so far, and their type and shape, which
+    // are the same for every frame of a .npy file. Guarded by
+    // debug_file_io_lock.
+    int32_t frames;
+    int32_t type_code, dimensions, extent[4];
+};
+
+// A region of a Func waiting to be written.
+struct debug_file_frame {
+    debug_file_frame *next;
+    debug_file_state *file;
+    uint8_t *data;
+    size_t size;
+    int32_t type_code, bytes_per_element, dimensions, extent[4];
+};
+
+// Guards the list of files and the queue of asynchronous writes.
+WEAK halide_mutex debug_file_lock;
+// Guards writing to the files, so that frames are appended whole.
+WEAK halide_mutex debug_file_io_lock;
+WEAK debug_file_state *debug_files = NULL;
+WEAK debug_file_frame *debug_file_queue_head = NULL;
+WEAK debug_file_frame *debug_file_queue_tail = NULL;
+// The frames queued or being written, and the bytes they use.
+WEAK int debug_file_frames_pending = 0;
+WEAK int64_t debug_file_bytes_pending = 0;
+const int64_t kDefaultDebugFileQueueSize = 64 * 1024 * 1024;
+WEAK int64_t debug_file_queue_size = kDefaultDebugFileQueueSize;
+WEAK bool debug_file_writer_running = false;
+WEAK int debug_file_async_error = 0;
+
+WEAK char *copy_string(const char *s) {
+    size_t n = strlen(s) + 1;
+    char *result = (char *)malloc(n);
+    if (result) {
+        memcpy(result, s, n);
+    }
+    return result;
+}
+
+// Must be called with debug_file_lock held.
+WEAK debug_file_state *find_or_create_debug_file(const char *func, const char *filename) {
+    for (debug_file_state *f = debug_files; f; f = f->next) {
+        if (strcmp(f->filename, filename) == 0) {
+            return f;
+        }
+    }
+    debug_file_state *f = (debug_file_state *)malloc(sizeof(debug_file_state));
+    if (!f) return NULL;
+    memset(f, 0, sizeof(debug_file_state));
+    f->filename = copy_string(filename);
+    f->func = copy_string(func);
+    if (!f->filename || !f->func) {
+        free(f->filename);
+        free(f->func);
+        free(f);
+        return NULL;
+    }
+    f->next = debug_files;
+    debug_files = f;
+    return f;
+}
+
+// See "type_code" in DebugToFile.cpp
+WEAK const char *npy_type_names[] = {
+    "f4", "f8", "u1", "i1", "u2", "i2", "u4", "i4", "u8", "i8"
+};
+
+// The size of the .npy header. It has room for the largest possible
+// shape, so that it can be rewritten in place as frames are
+// appended. numpy wants the data aligned to 64 bytes.
+const int npy_header_size = 128;
+
+WEAK void make_npy_header(char *header, const debug_file_state *file, int32_t bytes_per_element) {
+    memset(header, ' ', npy_header_size);
+    memcpy(header, "\x93NUMPY\x01\x00", 8);
+    header[8] = (char)((npy_header_size - 10) & 0xff);
+    header[9] = (char)((npy_header_size - 10) >> 8);
+
+    int32_t one = 1;
+    bool little_endian = *((const char *)&one) == 1;
+    char byte_order = bytes_per_element == 1 ? '|' : (little_endian ? '<' : '>');
+
+    // The frame is the outermost dimension, and numpy lists
+    // dimensions from outermost to innermost.
+    char *dst = header + 10;
+    char *end = header + npy_header_size - 1;
+    dst = halide_string_to_string(dst, end, "{'descr': '");
+    *dst++ = byte_order;
+    dst = halide_string_to_string(dst, end, npy_type_names[file->type_code]);
+    dst = halide_string_to_string(dst, end, "', 'fortran_order': False, 'shape': (");
+    dst = halide_int64_to_string(dst, end, file->frames, 1);
+    if (file->dimensions == 0) {
+        dst = halide_string_to_string(dst, end, ",");
+    }
+    for (int i = file->dimensions - 1; i >= 0; i--) {
+        dst = halide_string_to_string(dst, end, ", ");
+        dst = halide_int64_to_string(dst, end, file->extent[i], 1);
+    }
+    dst = halide_string_to_string(dst, end, "), }");
+    // Replace the nul written by halide_string_to_string, and end
+    // the padded header with a newline.
+    *dst = ' ';
+    *end = '\n';
+}
+
+WEAK int append_debug_frame(const debug_file_frame *frame) {
+    debug_file_state *file = frame->file;
+    bool npy = has_extension(file->filename, ".npy");
+
+    if (npy) {
+        if (file->frames == 0) {
+            file->type_code = frame->type_code;
+            file->dimensions = frame->dimensions;
+            for (int i = 0; i < 4; i++) {
+                file->extent[i] = frame->extent[i];
+            }
+        } else {
+            // All the frames in a .npy file must have the same type
+            // and shape.
+            if (file->type_code != frame->type_code ||
+                file->dimensions != frame->dimensions) {
+                return -3;
+            }
+            for (int i = 0; i < frame->dimensions; i++) {
+                if (file->extent[i] != frame->extent[i]) {
+                    return -3;
+                }
+            }
+        }
+    }
+
+    // The first write in this process replaces whatever was there.
+    void *f = fopen(file->filename, file->frames == 0 ? "wb" : (npy ? "r+b" : "ab"));
+    if (!f) return -1;
+
+    if (npy) {
+        file->frames++;
+        char header[npy_header_size];
+        make_npy_header(header, file, frame->bytes_per_element);
+        if (fseek(f, 0, 0) ||
+            !fwrite((void *)header, npy_header_size, 1, f) ||
+            fseek(f, 0, 2)) {
+            file->frames--;
+            fclose(f);
+            return -2;
+        }
+    } else {
+        file->frames++;
+    }
+
+    if (!fwrite((void *)frame->data, frame->size, 1, f)) {
+        fclose(f);
+        return -2;
+    }
+    fclose(f);
+    return 0;
+}
+
+WEAK int write_debug_frame(const debug_file_frame *frame) {
+    ScopedMutexLock lock(&debug_file_io_lock);
+    const char *filename = frame->file->filename;
+    if (has_extension(filename, ".npy") || has_extension(filename, ".raw")) {
+        return append_debug_frame(frame);
+    } else {
+        frame->file->frames++;
+        return halide_debug_to_file(NULL, filename, frame->data,
+                                    frame->extent[0], frame->extent[1],
+                                    frame->extent[2], frame->extent[3],
+                                    frame->type_code, frame->bytes_per_element);
+    }
+}
+
+// Writes the queued frames. The runtime has no condition variables,
+// so this polls, backing off while the queue is empty. It exits after
+// a second with nothing to do, and is respawned by the next
+// asynchronous write.
+WEAK void debug_file_writer_thread(void *) {
+    halide_mutex_lock(&debug_file_lock);
+    int sleep_ms = 1, idle_ms = 0;
+    while (debug_file_queue_head || idle_ms < 1000) {
+        debug_file_frame *frame = debug_file_queue_head;
+        if (frame) {
+            debug_file_queue_head = frame->next;
+            if (!debug_file_queue_head) {
+                debug_file_queue_tail = NULL;
+            }
+            halide_mutex_unlock(&debug_file_lock);
+
+            int result = write_debug_frame(frame);
+            if (result) {
+                halide_error_debug_to_file_failed(NULL, frame->file->func, frame->file->filename, result);
+            }
+
+            halide_mutex_lock(&debug_file_lock);
+            if (result && !debug_file_async_error) {
+                debug_file_async_error = halide_error_code_debug_to_file_failed;
+            }
+            debug_file_bytes_pending -= frame->size;
+            debug_file_frames_pending--;
+            free(frame);
+            sleep_ms = 1;
+            idle_ms = 0;
+        } else {
+            halide_mutex_unlock(&debug_file_lock);
+            halide_sleep_ms(NULL, sleep_ms);
+            halide_mutex_lock(&debug_file_lock);
+            idle_ms += sleep_ms;
+            if (sleep_ms < 16) sleep_ms *= 2;
+        }
+    }
+    debug_file_writer_running = false;
+    halide_mutex_unlock(&debug_file_lock);
+}
+
 }}} // namespace Halide::Runtime::Internal
 
-WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *filename, uint8_t *data,
+extern "C" {
+
+WEAK int32_t halide_debug_to_file(void *user_context, const char *filename, uint8_t *data,
                                              int32_t s0, int32_t s1, int32_t s2, int32_t s3,
                                              int32_t type_code, int32_t bytes_per_element) {
     void *f = fopen(filename, "wb");
@@ -207,3 +450,147 @@ WEAK extern "C" int32_t halide_debug_to_file(void *user_context, const char *fil
         return -1;
     }
 }
+
+WEAK int32_t halide_debug_to_file_region(void *user_context, const char *func,
+                                         const char *filename, int32_t type_code,
+                                         buffer_t *buf, int32_t dimensions,
+                                         int32_t min0, int32_t extent0,
+                                         int32_t min1, int32_t extent1,
+                                         int32_t min2, int32_t extent2,
+                                         int32_t min3, int32_t extent3,
+                                         int32_t every, int32_t async) {
+    debug_file_state *file;
+    {
+        ScopedMutexLock lock(&debug_file_lock);
+        file = find_or_create_debug_file(func, filename);
+        if (!file) return -4;
+        if (every > 1 && (file->calls++) % every != 0) {
+            return 0;
+        }
+    }
+
+    if (!buf->host) return -1;
+
+    // Clip the region to the buffer.
+    const int32_t mins[] = {min0, min1, min2, min3};
+    const int32_t extents[] = {extent0, extent1, extent2, extent3};
+    int32_t lo[4], ext[4], stride[4];
+    int64_t offset = 0;
+    size_t elts = 1;
+    bool dense = true;
+    for (int i = 0; i < 4; i++) {
+        if (i < dimensions) {
+            int32_t buf_max = buf->min[i] + buf->extent[i];
+            int32_t hi = mins[i] + extents[i];
+            lo[i] = mins[i] > buf->min[i] ? mins[i] : buf->min[i];
+            hi = hi < buf_max ? hi : buf_max;
+            if (hi <= lo[i]) {
+                // Nothing to write.
+                return 0;
+            }
+            ext[i] = hi - lo[i];
+            stride[i] = buf->stride[i];
+            offset += (int64_t)(lo[i] - buf->min[i]) * stride[i];
+            dense = dense && ext[i] == buf->extent[i] && stride[i] == (int32_t)elts;
+        } else {
+            lo[i] = 0;
+            ext[i] = 1;
+            stride[i] = 0;
+        }
+        elts *= ext[i];
+    }
+
+    debug_file_frame frame;
+    frame.next = NULL;
+    frame.file = file;
+    frame.size = elts * buf->elem_size;
+    frame.type_code = type_code;
+    frame.bytes_per_element = buf->elem_size;
+    frame.dimensions = dimensions;
+    for (int i = 0; i < 4; i++) {
+        frame.extent[i] = ext[i];
+    }
+
+    if (dense && !async) {
+        // Write straight from the buffer.
+        frame.data = buf->host;
+        return write_debug_frame(&frame);
+    }
+
+    // Copy the region densely, either because it's not dense in the
+    // buffer, or so that the buffer can be reused while it's written.
+    debug_file_frame *copy = (debug_file_frame *)malloc(sizeof(debug_file_frame) + frame.size);
+    if (!copy) return -4;
+    *copy = frame;
+    copy->data = (uint8_t *)(copy + 1);
+    size_t elem_size = buf->elem_size;
+    uint8_t *dst = copy->data;
+    for (int32_t k3 = 0; k3 < ext[3]; k3++) {
+        for (int32_t k2 = 0; k2 < ext[2]; k2++) {
+            for (int32_t k1 = 0; k1 < ext[1]; k1++) {
+                int64_t idx = offset + (int64_t)k3 * stride[3] + (int64_t)k2 * stride[2] + (int64_t)k1 * stride[1];
+                const uint8_t *src = buf->host + idx * elem_size;
+                if (stride[0] == 1) {
+                    memcpy(dst, src, ext[0] * elem_size);
+                    dst += ext[0] * elem_size;
+                } else {
+                    for (int32_t k0 = 0; k0 < ext[0]; k0++) {
+                        memcpy(dst, src + (int64_t)k0 * stride[0] * elem_size, elem_size);
+                        dst += elem_size;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!async) {
+        int result = write_debug_frame(copy);
+        free(copy);
+        return result;
+    }
+
+    ScopedMutexLock lock(&debug_file_lock);
+    // Wait for the writer to catch up if the queue is full, unless
+    // there's nothing else in it.
+    while (debug_file_frames_pending &&
+           debug_file_bytes_pending + (int64_t)copy->size > debug_file_queue_size) {
+        halide_mutex_unlock(&debug_file_lock);
+        halide_sleep_ms(user_context, 1);
+        halide_mutex_lock(&debug_file_lock);
+    }
+    if (debug_file_queue_tail) {
+        debug_file_queue_tail->next = copy;
+    } else {
+        debug_file_queue_head = copy;
+    }
+    debug_file_queue_tail = copy;
+    debug_file_frames_pending++;
+    debug_file_bytes_pending += copy->size;
+    if (!debug_file_writer_running) {
+        debug_file_writer_running = true;
+        halide_spawn_thread(user_context, debug_file_writer_thread, NULL);
+    }
+    return 0;
+}
+
+WEAK int32_t halide_debug_to_file_wait(void *user_context) {
+    ScopedMutexLock lock(&debug_file_lock);
+    while (debug_file_frames_pending) {
+        halide_mutex_unlock(&debug_file_lock);
+        halide_sleep_ms(user_context, 1);
+        halide_mutex_lock(&debug_file_lock);
+    }
+    int result = debug_file_async_error;
+    debug_file_async_error = 0;
+    return result;
+}
+
+WEAK void halide_debug_to_file_set_queue_size(int64_t size) {
+    if (size == 0) {
+        size = kDefaultDebugFileQueueSize;
+    }
+    ScopedMutexLock lock(&debug_file_lock);
+    debug_file_queue_size = size;
+}
+
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <set>
+#include "Halide.h"
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the names of the buffers stored to by a Stmt.
+class FindStores : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Store *op) {
+        names.insert(op->name);
+        IRVisitor::visit(op);
+    }
+public:
+    std::set<std::string> names;
+};
+
+// Check that some loop over var stores to both of two Funcs, i.e. that
+// their loops over var really were fused.
+class CheckFused : public IRMutator {
+    using IRMutator::visit;
+
+    std::string var, a, b;
+
+    void visit(const For *op) {
+        if (ends_with(op->name, "." + var)) {
+            FindStores stores;
+            op->body.accept(&stores);
+            if (stores.names.count(a) && stores.names.count(b)) {
+                fused = true;
+            }
+        }
+        IRMutator::visit(op);
+    }
+public:
+    bool fused;
+    CheckFused(const std::string &var, const std::string &a, const std::string &b) :
+        var(var), a(a), b(b), fused(false) {}
+};
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    ImageParam input(Int(32), 2);
+    Image<int> in(64, 64);
+    for (int y = 0; y < in.height(); y++) {
+        for (int x = 0; x < in.width(); x++) {
+            in(x, y) = (x * 17 + y * 31) % 23;
+        }
+    }
+    input.set(in);
+
+    {
+        // Two siblings with the same bounds share one loop nest.
+        Func sum("sum"), sq("sq"), out("out");
+        sum(x, y) = input(x, y) + input(x + 1, y);
+        sq(x, y) = input(x, y) * input(x, y);
+        out(x, y) = sum(x, y) * 2 - sq(x, y);
+
+        sum.compute_root();
+        sq.compute_root().compute_with(sum, y);
+
+        CheckFused check("y", "sum", "sq");
+        out.add_custom_lowering_pass(&check, NULL);
+
+        Image<int> result = out.realize(32, 32);
+        if (!check.fused) {
+            printf("The loops over y of sum and sq were not fused\n");
+            return -1;
+        }
+        for (int y = 0; y < 32; y++) {
+            for (int x = 0; x < 32; x++) {
+                int correct = (in(x, y) + in(x + 1, y)) * 2 - in(x, y) * in(x, y);
+                if (result(x, y) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Siblings with different bounds, fused all the way down to
+        // the innermost loop, and an update stage fused with the
+        // pure stage of the other function.
+        Func a("a"), b("b"), out("out");
+        a(x, y) = input(x, y);
+        a(x, y) += 1;
+        b(x, y) = input(x, y) * 3;
+        out(x, y) = a(x, y) + b(x + 2, y + 1);
+
+        a.compute_root();
+        b.compute_root();
+        a.update(0).compute_with(b, x);
+
+        CheckFused check("x", "a", "b");
+        out.add_custom_lowering_pass(&check, NULL);
+
+        Image<int> result = out.realize(32, 32);
+        if (!check.fused) {
+            printf("The loops over x of a and b were not fused\n");
+            return -1;
+        }
+        for (int y = 0; y < 32; y++) {
+            for (int x = 0; x < 32; x++) {
+                int correct = in(x, y) + 1 + in(x + 2, y + 1) * 3;
+                if (result(x, y) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    {
+        // Write a region of f asynchronously, appending each run of
+        // the pipeline to a numpy file.
+        Func f, g;
+        f(x, y) = x + y * 100;
+        g(x, y) = f(x, y) * 2;
+        f.compute_root();
+
+        DebugToFileOptions options;
+        options.region = {{2, 4}, {3, 5}};
+        options.async = true;
+        f.debug_to_file("f_options.npy", options);
+
+        Target target = get_jit_target_from_environment();
+        if (target.has_gpu_feature()) {
+            f.gpu_tile(x, y, 4, 4);
+        }
+
+        g.realize(10, 10, target);
+        g.realize(10, 10, target);
+    }
+
+    {
+        // Write every third row of a Func computed per row of its
+        // consumer to a raw file.
+        Func f, g;
+        f(x, y) = x + y * 10;
+        g(x, y) = f(x, y) + 1;
+        f.compute_at(g, y);
+
+        DebugToFileOptions options;
+        options.every = 3;
+        f.debug_to_file("f_options.raw", options);
+
+        g.realize(10, 10);
+    }
+
+    FILE *f = fopen("f_options.npy", "rb");
+    if (!f) {
+        printf("Could not open f_options.npy\n");
+        return -1;
+    }
+
+    char header[128];
+    if (fread(header, 1, 128, f) != 128) {
+        printf("Could not read npy header\n");
+        return -1;
+    }
+    if (memcmp(header, "\x93NUMPY\x01\x00", 8) != 0 || header[127] != '\n') {
+        printf("Bad npy header\n");
+        return -1;
+    }
+    std::string dict(header + 10, header + 127);
+    if (dict.find("'descr': '<i4'") == std::string::npos ||
+        dict.find("'fortran_order': False") == std::string::npos ||
+        dict.find("'shape': (2, 5, 4)") == std::string::npos) {
+        printf("Unexpected npy header: %s\n", dict.c_str());
+        return -1;
+    }
+
+    int32_t npy_data[2][5][4];
+    if (fread(npy_data, sizeof(npy_data), 1, f) != 1) {
+        printf("Could not read npy data\n");
+        return -1;
+    }
+    fclose(f);
+    for (int frame = 0; frame < 2; frame++) {
+        for (int j = 0; j < 5; j++) {
+            for (int i = 0; i < 4; i++) {
+                int correct = (i + 2) + (j + 3) * 100;
+                if (npy_data[frame][j][i] != correct) {
+                    printf("npy frame %d at (%d, %d) = %d instead of %d\n",
+                           frame, i + 2, j + 3, npy_data[frame][j][i], correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    f = fopen("f_options.raw", "rb");
+    if (!f) {
+        printf("Could not open f_options.raw\n");
+        return -1;
+    }
+    // Rows 0, 3, 6 and 9, with no header.
+    int32_t raw_data[4][10];
+    if (fread(raw_data, sizeof(raw_data), 1, f) != 1) {
+        printf("Could not read raw data\n");
+        return -1;
+    }
+    int32_t extra;
+    if (fread(&extra, sizeof(extra), 1, f) != 0) {
+        printf("Too many frames in raw file\n");
+        return -1;
+    }
+    fclose(f);
+    for (int frame = 0; frame < 4; frame++) {
+        for (int i = 0; i < 10; i++) {
+            int correct = i + frame * 3 * 10;
+            if (raw_data[frame][i] != correct) {
+                printf("raw frame %d at %d = %d instead of %d\n",
+                       frame, i, raw_data[frame][i], correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <limits>
+#include "Halide.h"
+
+using namespace Halide;
+
+// Compute the expected result of each fixed-point intrinsic in 64-bit
+// arithmetic.
+template<typename T>
+int64_t reference(int op, int64_t a, int64_t b) {
+    const int64_t t_min = std::numeric_limits<T>::min();
+    const int64_t t_max = std::numeric_limits<T>::max();
+    const int bits = sizeof(T) * 8;
+    switch (op) {
+    case 0:
+        return std::min(std::max(a + b, t_min), t_max);
+    case 1:
+        return std::min(std::max(a - b, t_min), t_max);
+    case 2:
+        return (a + b) >> 1;
+    case 3:
+        return (a + b + 1) >> 1;
+    case 4:
+        if (std::numeric_limits<T>::is_signed) {
+            return (a * b) >> bits;
+        } else {
+            return (int64_t)(((uint64_t)a * (uint64_t)b) >> bits);
+        }
+    default:
+        return b == 0 ? a : (a + ((int64_t)1 << (b - 1))) >> b;
+    }
+}
+
+template<typename T>
+bool test() {
+    const int size = 1024;
+    Type t = type_of<T>();
+    const int64_t t_min = std::numeric_limits<T>::min();
+    const int64_t t_max = std::numeric_limits<T>::max();
+
+    Image<T> a(size), b(size), shift(size);
+    for (int i = 0; i < size; i++) {
+        if (i < 64) {
+            // Make sure every pair of extreme values is covered.
+            int64_t extremes[] = {t_min, t_min + 1, -1, 0, 1, t_max - 1, t_max, t_max / 2};
+            a(i) = (T)extremes[i % 8];
+            b(i) = (T)extremes[i / 8];
+        } else {
+            a(i) = (T)rand();
+            b(i) = (T)rand();
+        }
+        shift(i) = (T)(rand() % t.bits());
+    }
+
+    const char *names[] = {"saturating_add", "saturating_sub", "halving_add",
+                           "rounding_halving_add", "mul_hi", "rounding_shift_right"};
+
+    Var x;
+    Expr ax = a(x), bx = b(x), sx = shift(x);
+    std::vector<Expr> exprs = {saturating_add(ax, bx), saturating_sub(ax, bx),
+                               halving_add(ax, bx), rounding_halving_add(ax, bx),
+                               mul_hi(ax, bx), rounding_shift_right(ax, sx)};
+
+    for (size_t op = 0; op < exprs.size(); op++) {
+        // Check both the vector instructions, and the scalar
+        // emulation.
+        for (int vec = 0; vec < 2; vec++) {
+            Func f;
+            f(x) = exprs[op];
+            if (vec) {
+                f.vectorize(x, 32);
+            }
+            Image<T> out = f.realize(size);
+
+            for (int i = 0; i < size; i++) {
+                int64_t rhs = (op == 5) ? (int64_t)shift(i) : (int64_t)b(i);
+                int64_t correct = reference<T>((int)op, a(i), rhs);
+                if ((int64_t)out(i) != correct) {
+                    printf("%s%d %s of %lld and %lld %s gave %lld instead of %lld\n",
+                           t.is_int() ? "int" : "uint", t.bits(), names[op],
+                           (long long)a(i), (long long)rhs, vec ? "(vectorized)" : "(scalar)",
+                           (long long)out(i), (long long)correct);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Saturating casts from the wider type.
+    Func g;
+    g(x) = saturating_cast(t, cast<int64_t>(ax) * 3 - cast<int64_t>(bx));
+    g.vectorize(x, 32);
+    Image<T> out = g.realize(size);
+    for (int i = 0; i < size; i++) {
+        int64_t value = (int64_t)a(i) * 3 - (int64_t)b(i);
+        int64_t correct = std::min(std::max(value, t_min), t_max);
+        if ((int64_t)out(i) != correct) {
+            printf("saturating_cast of %lld to %s%d gave %lld instead of %lld\n",
+                   (long long)value, t.is_int() ? "int" : "uint", t.bits(),
+                   (long long)out(i), (long long)correct);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!test<uint8_t>() ||
+        !test<int8_t>() ||
+        !test<uint16_t>() ||
+        !test<int16_t>() ||
+        !test<uint32_t>() ||
+        !test<int32_t>()) {
+        return -1;
+    }
+
+    // Float to integer saturating casts.
+    Image<float> in(8);
+    float values[] = {-1e10f, -129.0f, -128.5f, 0.0f, 12.75f, 127.5f, 128.0f, 1e10f};
+    uint8_t u8_correct[] = {0, 0, 0, 0, 12, 127, 128, 255};
+    int8_t i8_correct[] = {-128, -128, -128, 0, 12, 127, 127, 127};
+    for (int i = 0; i < 8; i++) {
+        in(i) = values[i];
+    }
+    Func f;
+    Var x;
+    f(x) = Tuple(saturating_cast<uint8_t>(in(x)), saturating_cast<int8_t>(in(x)));
+    f.vectorize(x, 8);
+    Realization r = f.realize(8);
+    Image<uint8_t> u8_out(r[0]);
+    Image<int8_t> i8_out(r[1]);
+    for (int i = 0; i < 8; i++) {
+        if (u8_out(i) != u8_correct[i] || i8_out(i) != i8_correct[i]) {
+            printf("saturating_cast of %f gave %d and %d instead of %d and %d\n",
+                   values[i], u8_out(i), i8_out(i), u8_correct[i], i8_correct[i]);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
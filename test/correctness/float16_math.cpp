@@ -0,0 +1,251 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <cmath>
+
+using namespace Halide;
+
+// Get the float value of the 16-bit float type T with the given bits.
+template<typename T>
+float to_float(uint16_t bits) {
+    return (float)T::make_from_bits(bits);
+}
+
+// Check that T can be converted to float32 exactly, for every bit
+// pattern.
+template<typename T>
+bool test_widening(Target target) {
+    Type t = type_of<T>();
+    Image<uint16_t> in(65536);
+    for (int i = 0; i < 65536; i++) {
+        in(i) = (uint16_t)i;
+    }
+
+    Func f;
+    Var x;
+    f(x) = cast<float>(reinterpret(t, in(x)));
+    f.vectorize(x, 16);
+    Image<float> out = f.realize(65536, target);
+
+    for (int i = 0; i < 65536; i++) {
+        float correct = to_float<T>((uint16_t)i);
+        bool ok = std::isnan(correct) ? std::isnan(out(i)) : (out(i) == correct);
+        if (!ok) {
+            printf("Widening %s bits %x gave %f instead of %f\n",
+                   t.is_bfloat() ? "bfloat16" : "float16", i, out(i), correct);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check that converting float32 to T rounds to nearest, with ties to
+// even. Use values a quarter, half, and three quarters of the way
+// between each pair of adjacent positive finite values.
+template<typename T>
+bool test_narrowing(uint16_t max_finite, Target target) {
+    Type t = type_of<T>();
+    std::vector<float> inputs;
+    std::vector<uint16_t> expected;
+    for (uint16_t h = 0; h < max_finite; h++) {
+        float a = to_float<T>(h), b = to_float<T>(h + 1);
+        uint16_t even = (h & 1) ? h + 1 : h;
+        float fracs[] = {0.0f, 0.25f, 0.5f, 0.75f};
+        uint16_t results[] = {h, h, even, (uint16_t)(h + 1)};
+        for (int j = 0; j < 4; j++) {
+            float v = a + (b - a) * fracs[j];
+            inputs.push_back(v);
+            expected.push_back(results[j]);
+            inputs.push_back(-v);
+            expected.push_back(results[j] | 0x8000);
+        }
+    }
+
+    // Overflow, infinity, and nan.
+    float inf = INFINITY;
+    inputs.push_back(inf);
+    expected.push_back(max_finite + 1);
+    inputs.push_back(-inf);
+    expected.push_back((max_finite + 1) | 0x8000);
+    if (!t.is_bfloat()) {
+        inputs.push_back(65520.0f);
+        expected.push_back(0x7c00);
+        inputs.push_back(65519.0f);
+        expected.push_back(0x7bff);
+    }
+
+    Image<float> in((int)inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        in((int)i) = inputs[i];
+    }
+
+    Func f;
+    Var x;
+    f(x) = reinterpret<uint16_t>(cast(t, in(x)));
+    f.vectorize(x, 16);
+    Image<uint16_t> out = f.realize(in.width(), target);
+
+    for (int i = 0; i < in.width(); i++) {
+        if (out(i) != expected[i]) {
+            printf("Narrowing %.10g to %s gave bits %x instead of %x\n",
+                   in(i), t.is_bfloat() ? "bfloat16" : "float16", out(i), expected[i]);
+            return false;
+        }
+    }
+
+    Image<float> nan_in(16);
+    for (int i = 0; i < 16; i++) {
+        nan_in(i) = (i & 1) ? NAN : -NAN;
+    }
+    Func g;
+    g(x) = reinterpret<uint16_t>(cast(t, nan_in(x)));
+    g.vectorize(x, 16);
+    Image<uint16_t> nans = g.realize(16, target);
+    for (int i = 0; i < 16; i++) {
+        if (!std::isnan(to_float<T>(nans(i)))) {
+            printf("Narrowing nan to %s gave bits %x\n",
+                   t.is_bfloat() ? "bfloat16" : "float16", nans(i));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Check that arithmetic on T gives the same result as doing it in
+// float32 and rounding after each operation.
+template<typename T>
+bool test_arithmetic(Target target) {
+    Type t = type_of<T>();
+    const int size = 1024;
+    Image<T> a(size), b(size);
+    for (int i = 0; i < size; i++) {
+        a(i) = T((float)(rand() % 2000 - 1000) / 16.0f);
+        b(i) = T((float)(rand() % 2000 + 1) / 64.0f);
+    }
+
+    Func f, g;
+    Var x;
+    Expr ax = a(x), bx = b(x);
+    f(x) = select(ax < bx, max(ax * bx + ax, bx), min(ax / bx - bx, ax)) + Expr(T(1.5f));
+    f.vectorize(x, 16);
+
+    Expr fa = cast<float>(ax), fb = cast<float>(bx);
+    Expr prod = cast<float>(cast(t, fa * fb));
+    Expr quot = cast<float>(cast(t, fa / fb));
+    Expr true_value = cast<float>(cast(t, prod + fa));
+    Expr false_value = cast<float>(cast(t, quot - fb));
+    g(x) = cast(t, select(fa < fb, max(true_value, fb), min(false_value, fa)) + 1.5f);
+
+    Image<T> out = f.realize(size, target);
+    Image<T> correct = g.realize(size, target);
+
+    for (int i = 0; i < size; i++) {
+        if (out(i).to_bits() != correct(i).to_bits()) {
+            printf("Arithmetic on %s with inputs %f and %f gave %f instead of %f\n",
+                   t.is_bfloat() ? "bfloat16" : "float16",
+                   (float)a(i), (float)b(i), (float)out(i), (float)correct(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check that horizontal reductions of T, which are done in float32,
+// match the serial reduction. The values are small integers, so the
+// sums are exact either way.
+template<typename T>
+bool test_reduction(Target target) {
+    Type t = type_of<T>();
+    const int size = 256;
+    Image<T> in(size);
+    for (int i = 0; i < size; i++) {
+        in(i) = T((float)(i % 7 - 3));
+    }
+
+    RDom r(0, size);
+    Func sum, mx, sum_serial, mx_serial;
+    sum() = Expr(T(0.0f));
+    sum() += in(r);
+    sum.update().vectorize(r, 8);
+    mx() = Expr(T(-100.0f));
+    mx() = max(mx(), in(r));
+    mx.update().vectorize(r, 8);
+    sum_serial() = Expr(T(0.0f));
+    sum_serial() += in(r);
+    mx_serial() = Expr(T(-100.0f));
+    mx_serial() = max(mx_serial(), in(r));
+
+    Image<T> sum_result = sum.realize(std::vector<int>(), target);
+    Image<T> mx_result = mx.realize(std::vector<int>(), target);
+    Image<T> sum_correct = sum_serial.realize(std::vector<int>(), target);
+    Image<T> mx_correct = mx_serial.realize(std::vector<int>(), target);
+    if (sum_result(0).to_bits() != sum_correct(0).to_bits() ||
+        mx_result(0).to_bits() != mx_correct(0).to_bits()) {
+        printf("Horizontal reductions of %s gave sum %f and max %f instead of %f and %f\n",
+               t.is_bfloat() ? "bfloat16" : "float16",
+               (float)sum_result(0), (float)mx_result(0),
+               (float)sum_correct(0), (float)mx_correct(0));
+        return false;
+    }
+    return true;
+}
+
+// Check that the pipelines using one target's float16 conversions
+// give the same bits as using another's.
+bool test_targets_agree(Target a, Target b) {
+    const int size = 1024;
+    Image<float> in(size);
+    for (int i = 0; i < size; i++) {
+        in(i) = (float)(rand() % 20000 - 10000) / 7.0f;
+    }
+    Func f;
+    Var x;
+    Expr h = cast<float16_t>(in(x));
+    f(x) = reinterpret<uint16_t>(h * h / (abs(h) + Expr(float16_t(1.0f))) + Expr(float16_t(1.25f)));
+    f.vectorize(x, 16);
+    Image<uint16_t> out_a = f.realize(size, a);
+    Image<uint16_t> out_b = f.realize(size, b);
+    for (int i = 0; i < size; i++) {
+        if (out_a(i) != out_b(i)) {
+            printf("Input %f gave bits %x with target %s but %x with target %s\n",
+                   in(i), out_a(i), a.to_string().c_str(), out_b(i), b.to_string().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_target(Target target) {
+    return (test_widening<float16_t>(target) &&
+            test_widening<bfloat16_t>(target) &&
+            test_narrowing<float16_t>(0x7bff, target) &&
+            test_narrowing<bfloat16_t>(0x7f7f, target) &&
+            test_arithmetic<float16_t>(target) &&
+            test_arithmetic<bfloat16_t>(target) &&
+            test_reduction<float16_t>(target) &&
+            test_reduction<bfloat16_t>(target));
+}
+
+int main(int argc, char **argv) {
+    // Test the host target, which may convert float16 with
+    // instructions, and the same target with float16 emulated using
+    // integer math, so both paths are tested on every machine.
+    Target host = get_jit_target_from_environment();
+    Target emulated = host.with_feature(Target::SoftFloat16);
+
+    if (!test_target(host) ||
+        !test_target(emulated) ||
+        !test_targets_agree(host, emulated)) {
+        return -1;
+    }
+
+    // Mixing float16 and bfloat16 gives float32.
+    Expr mixed = Expr(float16_t(1.0)) + Expr(bfloat16_t(2.0f));
+    if (mixed.type() != Float(32)) {
+        printf("float16 + bfloat16 has type %s\n", mixed.type() == Float(16) ? "float16" : "bfloat16");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <limits>
+#include "Halide.h"
+
+using namespace Halide;
+
+// Vector division and modulo by a Param are lowered to multiplies and
+// shifts. Check them against the scalar versions, which use plain
+// division.
+template<typename T>
+bool test(const std::vector<int> &divisors) {
+    const int size = 1024;
+    Type t = type_of<T>();
+    const long long t_min = std::numeric_limits<T>::min();
+    const long long t_max = std::numeric_limits<T>::max();
+
+    Image<T> in(size);
+    for (int i = 0; i < size; i++) {
+        if (i < 16) {
+            // Make sure the extreme values are covered.
+            in(i) = (T)((i & 1) ? t_max - i / 2 : t_min + i / 2);
+        } else {
+            in(i) = (T)rand();
+        }
+    }
+
+    Param<T> p;
+    Var x;
+    Func f, g;
+    f(x) = Tuple(in(x) / p, in(x) % p);
+    g(x) = Tuple(in(x) / p, in(x) % p);
+    f.vectorize(x, 16);
+
+    for (int d : divisors) {
+        if (t.is_uint() && d < 0) continue;
+        if (d > t_max || d < t_min) continue;
+        p.set((T)d);
+
+        Realization vec = f.realize(size);
+        Realization scalar = g.realize(size);
+        Image<T> vec_div(vec[0]), vec_mod(vec[1]);
+        Image<T> scalar_div(scalar[0]), scalar_mod(scalar[1]);
+
+        for (int i = 0; i < size; i++) {
+            if (vec_div(i) != scalar_div(i) || vec_mod(i) != scalar_mod(i)) {
+                printf("%s%d: %lld / %d = %lld, %lld %% %d = %lld instead of %lld and %lld\n",
+                       t.is_int() ? "int" : "uint", t.bits(), (long long)in(i),
+                       d, (long long)vec_div(i), (long long)in(i), d, (long long)vec_mod(i),
+                       (long long)scalar_div(i), (long long)scalar_mod(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> divisors = {1, 2, 3, 7, 10, 16, 100, 127, 128, 255, 256, 1000,
+                                 32767, 65535, 65536, 1000000, 0x7fffffff,
+                                 -2, -3, -7, -128, -1000, -32768, -1000000};
+
+    if (!test<uint8_t>(divisors) ||
+        !test<int8_t>(divisors) ||
+        !test<uint16_t>(divisors) ||
+        !test<int16_t>(divisors) ||
+        !test<uint32_t>(divisors) ||
+        !test<int32_t>(divisors)) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Check that every multiply in an innermost loop depends on the loop
+// variable. Index computations like y * stride should have been
+// hoisted out.
+class CheckInnerLoops : public IRVisitor {
+    using IRVisitor::visit;
+
+    std::string loop_var;
+    bool found_loop;
+
+    void visit(const For *op) {
+        found_loop = false;
+        IRVisitor::visit(op);
+        if (!found_loop) {
+            loop_var = op->name;
+            op->body.accept(&muls);
+            inner_loops++;
+        }
+        found_loop = true;
+    }
+
+    // Count the multiplies in the innermost loop that don't use the
+    // loop variable.
+    struct FindMuls : public IRVisitor {
+        CheckInnerLoops *parent;
+        using IRVisitor::visit;
+        void visit(const Mul *op) {
+            IRVisitor::visit(op);
+            if (!expr_uses_var(op, parent->loop_var)) {
+                std::cout << "Loop invariant multiply left in loop over "
+                          << parent->loop_var << ": " << Expr(op) << "\n";
+                parent->invariant_muls++;
+            }
+        }
+    } muls;
+
+public:
+    int inner_loops, invariant_muls;
+    CheckInnerLoops() : found_loop(false), inner_loops(0), invariant_muls(0) {
+        muls.parent = this;
+    }
+};
+
+class Checker : public IRMutator {
+public:
+    using IRMutator::mutate;
+
+    Stmt mutate(Stmt s) {
+        CheckInnerLoops c;
+        s.accept(&c);
+        if (c.inner_loops == 0) {
+            printf("Didn't find any innermost loops\n");
+            exit(-1);
+        }
+        if (c.invariant_muls) {
+            std::cout << s;
+            exit(-1);
+        }
+        return s;
+    }
+};
+
+int main(int argc, char **argv) {
+    const int W = 67, H = 43, C = 3;
+
+    ImageParam input(Float(32), 3);
+    Param<int> offset;
+    Var x, y, c;
+
+    Func f;
+    f(x, y, c) = input(x, y, c) * 2 + input(x + 1, y + offset, c) + cast<float>(offset * c);
+    f.vectorize(x, 4).parallel(c);
+    f.add_custom_lowering_pass(new Checker);
+
+    Image<float> in(W + 1, H + 2, C);
+    for (int k = 0; k < C; k++) {
+        for (int j = 0; j < H + 2; j++) {
+            for (int i = 0; i < W + 1; i++) {
+                in(i, j, k) = (float)(rand() % 256);
+            }
+        }
+    }
+    input.set(in);
+    offset.set(2);
+
+    // The pass only runs with the hoist_loop_invariants feature.
+    Target t = get_jit_target_from_environment().with_feature(Target::HoistLoopInvariants);
+    Image<float> out = f.realize(W, H, C, t);
+
+    for (int k = 0; k < C; k++) {
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                float correct = in(i, j, k) * 2 + in(i + 1, j + 2, k) + 2 * k;
+                if (out(i, j, k) != correct) {
+                    printf("out(%d, %d, %d) = %f instead of %f\n", i, j, k, out(i, j, k), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <set>
+
+using namespace Halide;
+
+int stores = 0;
+
+int my_trace(void *user_context, const halide_trace_event *e) {
+    if (e->event == halide_trace_store && std::string(e->func) == "g") {
+        stores++;
+    }
+    return 0;
+}
+
+const int T = 16;
+std::set<int> tiles_computed;
+
+int record_tiles(void *user_context, const halide_trace_event *e) {
+    if (e->event == halide_trace_store && std::string(e->func) == "h") {
+        tiles_computed.insert(e->coordinates[0] / T);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const int W = 64, H = 64;
+
+    Var x("x"), y("y");
+    Param<int> offset;
+    Func g("g"), f("f");
+    g(x, y) = x * 3 + y * 7;
+    f(x, y) = g(x + offset, y) + g(x + offset + 1, y);
+
+    g.compute_root().memoize(x, y, T, T).trace_stores();
+    f.set_custom_trace(&my_trace);
+
+    // Pan over g. Each request only computes the tiles of g that
+    // weren't used by an earlier one.
+    struct {
+        int offset, tiles_computed;
+    } requests[] = {
+        // g is needed over [0, 64] x [0, 63], which is 5 x 4 tiles.
+        {0, 20},
+        // [8, 72] is covered by the same tiles.
+        {8, 0},
+        // [20, 84] needs one new column of tiles.
+        {20, 4},
+        {0, 0},
+    };
+
+    for (auto r : requests) {
+        offset.set(r.offset);
+        stores = 0;
+        Image<int> out = f.realize(W, H);
+
+        if (stores != r.tiles_computed * T * T) {
+            printf("With offset %d, %d values of g were computed instead of %d\n",
+                   r.offset, stores, r.tiles_computed * T * T);
+            return -1;
+        }
+
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                int correct = (x + r.offset) * 6 + 3 + y * 14;
+                if (out(x, y) != correct) {
+                    printf("With offset %d, out(%d, %d) = %d instead of %d\n",
+                           r.offset, x, y, out(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Shrink the cache so that it only holds three tiles, and pan
+        // over a single row of tiles of h, two tiles at a time. Only
+        // the tiles evicted as least recently used are recomputed.
+        Internal::JITSharedRuntime::memoization_cache_set_size(3 * T * T);
+
+        Func h("h"), out_func("out_func");
+        h(x, y) = x * 5 + y;
+        out_func(x, y) = h(x + offset, y);
+
+        h.compute_root().memoize(x, y, T, T).trace_stores();
+        out_func.set_custom_trace(&record_tiles);
+
+        struct {
+            int first_tile;
+            std::set<int> computed;
+        } requests[] = {
+            {0, {0, 1}},
+            // Storing tile 3 evicts tile 0.
+            {2, {2, 3}},
+            // Tiles 1 and 2 are still cached.
+            {1, {}},
+            // Tile 0 is recomputed, and storing it evicts tile 3,
+            // which was used less recently than 1 and 2.
+            {0, {0}},
+            {2, {3}},
+        };
+
+        for (auto r : requests) {
+            offset.set(r.first_tile * T);
+            tiles_computed.clear();
+            Image<int> out = out_func.realize(2 * T, T);
+
+            if (tiles_computed != r.computed) {
+                printf("Starting at tile %d, computed tiles:", r.first_tile);
+                for (int t : tiles_computed) {
+                    printf(" %d", t);
+                }
+                printf("\nExpected:");
+                for (int t : r.computed) {
+                    printf(" %d", t);
+                }
+                printf("\n");
+                return -1;
+            }
+
+            for (int y = 0; y < T; y++) {
+                for (int x = 0; x < 2 * T; x++) {
+                    int correct = (x + r.first_tile * T) * 5 + y;
+                    if (out(x, y) != correct) {
+                        printf("Starting at tile %d, out(%d, %d) = %d instead of %d\n",
+                               r.first_tile, x, y, out(x, y), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+
+        // Return cache size to default.
+        Internal::JITSharedRuntime::memoization_cache_set_size(0);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <atomic>
+#include "Halide.h"
+
+using namespace Halide;
+
+#ifdef _MSC_VER
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+std::atomic<int> count;
+extern "C" DLLEXPORT int call_counter(int x, int y) {
+    count++;
+    return x + y;
+}
+HalideExtern_2(int, call_counter, int, int);
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), strip("strip");
+
+    const int width = 10, height = 128, strip_size = 16;
+
+    Func f("f"), g("g");
+    f(x, y) = call_counter(x, y);
+    g(x, y) = f(x, y - 1) + f(x, y) + f(x, y + 1);
+
+    // Each strip slides f down its own scanlines, so f is only
+    // recomputed for the two rows of overlap between strips.
+    g.parallel_strips(y, strip, strip_size);
+    f.store_at(g, strip).compute_at(g, y);
+
+    count = 0;
+    Image<int> result = g.realize(width, height);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int correct = 3 * (x + y);
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    int strips = height / strip_size;
+    int expected = width * strips * (strip_size + 2);
+    if (count != expected) {
+        printf("f was called %d times instead of %d times\n", (int)count, expected);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Count the loads and stores of a buffer inside a loop.
+class CountAccesses : public IRVisitor {
+    using IRVisitor::visit;
+
+    const std::string &buffer, &loop;
+    int inside;
+
+    void visit(const For *op) {
+        bool is_loop = ends_with(op->name, "." + loop);
+        if (is_loop) {
+            loops_found++;
+            inside++;
+        }
+        IRVisitor::visit(op);
+        if (is_loop) {
+            inside--;
+        }
+    }
+
+    void visit(const Load *op) {
+        IRVisitor::visit(op);
+        if (inside && op->name == buffer) {
+            accesses++;
+        }
+    }
+
+    void visit(const Store *op) {
+        IRVisitor::visit(op);
+        if (inside && op->name == buffer) {
+            accesses++;
+        }
+    }
+
+public:
+    int loops_found, accesses;
+    CountAccesses(const std::string &b, const std::string &l) :
+        buffer(b), loop(l), inside(0), loops_found(0), accesses(0) {}
+};
+
+// Check that a buffer isn't touched inside a reduction loop.
+class CheckNoAccesses : public IRMutator {
+    std::string buffer, loop;
+public:
+    using IRMutator::mutate;
+
+    Stmt mutate(Stmt s) {
+        CountAccesses c(buffer, loop);
+        s.accept(&c);
+        if (c.loops_found == 0) {
+            printf("Didn't find the loop over %s\n", loop.c_str());
+            exit(-1);
+        }
+        if (c.accesses) {
+            printf("There were %d accesses to %s in the loop over %s\n",
+                   c.accesses, buffer.c_str(), loop.c_str());
+            exit(-1);
+        }
+        return s;
+    }
+
+    CheckNoAccesses(const std::string &b, const std::string &l) : buffer(b), loop(l) {}
+};
+
+int main(int argc, char **argv) {
+    const int N = 32, K = 50;
+
+    Image<float> a(K, N), b(N, K);
+    for (int y = 0; y < N; y++) {
+        for (int x = 0; x < K; x++) {
+            a(x, y) = (float)(rand() % 16);
+            b(y, x) = (float)(rand() % 16);
+        }
+    }
+
+    Var x("x"), y("y"), xi("xi");
+    RDom r(0, K);
+
+    // A matrix multiply, with the reduction inside the vectorized
+    // columns of the output.
+    {
+        Func f("f");
+        f(x, y) = 0.0f;
+        f(x, y) += a(r, y) * b(x, r);
+        f.update().split(x, x, xi, 8).reorder(xi, r, x, y).vectorize(xi);
+        f.add_custom_lowering_pass(new CheckNoAccesses(f.name(), r.x.name()));
+
+        Image<float> out = f.realize(N, N);
+        for (int j = 0; j < N; j++) {
+            for (int i = 0; i < N; i++) {
+                float correct = 0.0f;
+                for (int k = 0; k < K; k++) {
+                    correct += a(k, j) * b(i, k);
+                }
+                if (out(i, j) != correct) {
+                    printf("f(%d, %d) = %f instead of %f\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A scalar sum of each row, with the reduction innermost.
+    {
+        Func g("g");
+        g(y) = 0;
+        g(y) += cast<int>(a(r, y));
+        g.update().reorder(r, y);
+        g.add_custom_lowering_pass(new CheckNoAccesses(g.name(), r.x.name()));
+
+        Image<int> out = g.realize(N);
+        for (int j = 0; j < N; j++) {
+            int correct = 0;
+            for (int k = 0; k < K; k++) {
+                correct += (int)a(k, j);
+            }
+            if (out(j) != correct) {
+                printf("g(%d) = %d instead of %d\n", j, out(j), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Rows of the output that can't be proven not to overlap. The
+    // accumulators are only used if they don't at runtime.
+    {
+        Func h("h");
+        h(x, y) = 0;
+        h(x, y) += cast<int>(a(r, y));
+        h.update().reorder(r, x, y).unroll_and_jam(y, r, 2);
+
+        // An output whose two rows are the same memory, so the
+        // original loop must run, which adds both rows of a into it.
+        int storage = -1;
+        buffer_t buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.host = (uint8_t *)&storage;
+        buf.extent[0] = 1;
+        buf.extent[1] = 2;
+        buf.stride[0] = 1;
+        buf.stride[1] = 0;
+        buf.elem_size = sizeof(int);
+        h.realize(Image<int>(&buf));
+
+        int both_rows = 0;
+        for (int k = 0; k < K; k++) {
+            both_rows += (int)a(k, 0) + (int)a(k, 1);
+        }
+        if (storage != both_rows) {
+            printf("Overlapping rows of h summed to %d instead of %d\n", storage, both_rows);
+            return -1;
+        }
+
+        // Without the overlap, the accumulators are used.
+        Image<int> out = h.realize(N, N);
+        for (int j = 0; j < N; j++) {
+            for (int i = 0; i < N; i++) {
+                int correct = 0;
+                for (int k = 0; k < K; k++) {
+                    correct += (int)a(k, j);
+                }
+                if (out(i, j) != correct) {
+                    printf("h(%d, %d) = %d instead of %d\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 100, H = 80;
+
+    ImageParam input(Float(32), 2);
+    Image<float> in(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in(x, y) = (float)(rand() % 256);
+        }
+    }
+    input.set(in);
+
+    Var x, y;
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    Func blur_x, blur_y;
+    blur_x(x, y) = clamped(x - 1, y) + clamped(x, y) + clamped(x + 1, y);
+    blur_y(x, y) = blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1);
+    blur_x.compute_root();
+
+    Image<float> out = blur_y.realize(W, H);
+
+    // Paint over part of the input.
+    const int x0 = 40, y0 = 30, w = 10, h = 5;
+    for (int j = y0; j < y0 + h; j++) {
+        for (int i = x0; i < x0 + w; i++) {
+            in(i, j) = (float)(rand() % 256);
+        }
+    }
+
+    // Mark the output so we can tell which pixels were recomputed.
+    for (int j = 0; j < H; j++) {
+        for (int i = 0; i < W; i++) {
+            out(i, j) = -1.0f;
+        }
+    }
+
+    std::vector<std::pair<int32_t, int32_t>> region =
+        blur_y.realize_dirty(out, input.name(), {{x0, w}, {y0, h}});
+
+    if (region.size() != 2 ||
+        region[0].first != x0 - 1 || region[0].second != w + 2 ||
+        region[1].first != y0 - 1 || region[1].second != h + 2) {
+        printf("Unexpected dirty region: [%d, %d] x [%d, %d]\n",
+               region[0].first, region[0].second,
+               region[1].first, region[1].second);
+        return -1;
+    }
+
+    Image<float> correct = blur_y.realize(W, H);
+    for (int j = 0; j < H; j++) {
+        for (int i = 0; i < W; i++) {
+            bool inside = (i >= region[0].first && i < region[0].first + region[0].second &&
+                           j >= region[1].first && j < region[1].first + region[1].second);
+            float expected = inside ? correct(i, j) : -1.0f;
+            if (out(i, j) != expected) {
+                printf("out(%d, %d) = %f instead of %f\n", i, j, out(i, j), expected);
+                return -1;
+            }
+        }
+    }
+
+    // A change at the edge of the input spreads to the edge of the
+    // output through the boundary condition.
+    region = blur_y.realize_dirty(out, input.name(), {{0, 1}, {0, 1}});
+    if (region[0].first != 0 || region[0].second != 2 ||
+        region[1].first != 0 || region[1].second != 2) {
+        printf("Unexpected dirty region at the edge: [%d, %d] x [%d, %d]\n",
+               region[0].first, region[0].second,
+               region[1].first, region[1].second);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
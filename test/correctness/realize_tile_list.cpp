@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 256, H = 128;
+
+    Image<float> in(W + 2, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W + 2; x++) {
+            in(x, y) = (float)(rand() % 256);
+        }
+    }
+
+    Var x("x"), y("y"), yi("yi");
+    Func g("g"), h("h"), f("f");
+    g(x, y) = in(x, y) * 2.0f;
+    h(x, y) = g(x, y) + 1.0f;
+    f(x, y) = g(x, y) + h(x + 2, y);
+    f(x, y) += 1.0f;
+
+    g.compute_root();
+    h.compute_at(f, y);
+    f.split(y, y, yi, 4).parallel(y).vectorize(x, 8);
+    f.update().vectorize(x, 4);
+
+    Image<float> out(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            out(x, y) = -1.0f;
+        }
+    }
+
+    std::vector<std::vector<std::pair<int32_t, int32_t>>> tiles = {
+        {{0, 32}, {0, 32}},
+        {{192, 64}, {96, 32}},
+        {{64, 32}, {40, 12}},
+        // Overlaps the first tile.
+        {{16, 32}, {16, 32}},
+        // Outside the output.
+        {{240, 32}, {0, 32}},
+        // Narrower than the vectorization.
+        {{128, 4}, {0, 32}},
+        // Not a multiple of the vectorization of the update.
+        {{128, 10}, {0, 32}},
+        // Empty.
+        {{0, 0}, {0, 32}},
+    };
+    const int valid_tiles = 3;
+
+    std::vector<std::string> errors = f.realize_tile_list(out, tiles);
+
+    if (errors.size() != tiles.size()) {
+        printf("Got %d errors for %d tiles\n", (int)errors.size(), (int)tiles.size());
+        return -1;
+    }
+    for (size_t i = 0; i < tiles.size(); i++) {
+        bool valid = (int)i < valid_tiles;
+        if (valid != errors[i].empty()) {
+            printf("Unexpected result for tile %d: \"%s\"\n", (int)i, errors[i].c_str());
+            return -1;
+        }
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            bool inside = false;
+            for (int i = 0; i < valid_tiles; i++) {
+                inside = inside ||
+                    (x >= tiles[i][0].first && x < tiles[i][0].first + tiles[i][0].second &&
+                     y >= tiles[i][1].first && y < tiles[i][1].first + tiles[i][1].second);
+            }
+            float correct = inside ? in(x, y) * 2.0f + in(x + 2, y) * 2.0f + 2.0f : -1.0f;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
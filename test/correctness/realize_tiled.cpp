@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 1000, H = 700;
+
+    // Make an input file.
+    {
+        MappedRawFile file("realize_tiled_in.tmp", UInt(16), {W, H}, true);
+        Image<uint16_t> im(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                im(x, y) = (uint16_t)rand();
+            }
+        }
+        file.writer()(im);
+    }
+
+    // A blur of the file, plus another input generated on the fly.
+    ImageParam input(UInt(16), 2), ramp(Int(32), 2);
+    Func clamped = BoundaryConditions::repeat_edge(input, 0, W, 0, H);
+    Func blur;
+    Var x, y;
+    blur(x, y) = (clamped(x - 1, y) + clamped(x + 1, y) +
+                  clamped(x, y - 1) + clamped(x, y + 1) +
+                  cast<uint16_t>(ramp(x, y + 2)));
+    blur.vectorize(x, 8);
+
+    MappedRawFile in_file("realize_tiled_in.tmp", UInt(16), {W, H});
+    int ramp_tiles = 0;
+    TileReader ramp_reader = [&](Buffer b) {
+        Image<int32_t> im(b);
+        for (int j = im.min(1); j < im.min(1) + im.extent(1); j++) {
+            for (int i = im.min(0); i < im.min(0) + im.extent(0); i++) {
+                im(i, j) = i + j * 3;
+            }
+        }
+        ramp_tiles++;
+    };
+
+    {
+        MappedRawFile out_file("realize_tiled_out.tmp", UInt(16), {W, H}, true);
+        blur.realize_tiled({W, H}, {128, 96},
+                           {{input.name(), in_file.reader()}, {ramp.name(), ramp_reader}},
+                           out_file.writer());
+    }
+
+    // 8 x 8 tiles.
+    if (ramp_tiles != 64) {
+        printf("Ramp reader was called %d times instead of 64\n", ramp_tiles);
+        return -1;
+    }
+
+    // Compare against realizing the whole thing in memory.
+    Image<uint16_t> whole_input(W, H);
+    in_file.reader()(whole_input);
+    Image<int32_t> whole_ramp(W, H + 2);
+    ramp_reader(whole_ramp);
+    input.set(whole_input);
+    ramp.set(whole_ramp);
+    Image<uint16_t> correct = blur.realize(W, H);
+
+    MappedRawFile result("realize_tiled_out.tmp", UInt(16), {W, H});
+    Image<uint16_t> out(W, H);
+    result.reader()(out);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (out(x, y) != correct(x, y)) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct(x, y));
+                return -1;
+            }
+        }
+    }
+
+    unlink("realize_tiled_in.tmp");
+    unlink("realize_tiled_out.tmp");
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <sstream>
+
+using namespace Halide;
+
+std::string to_text(const Module &m) {
+    std::ostringstream s;
+    s << m;
+    return s.str();
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(UInt(8), 2, "input");
+    Param<float> gain("gain", 1.0f, 0.0f, 4.0f);
+
+    Image<int> lut(256, 1, "lut");
+    for (int i = 0; i < 256; i++) {
+        lut(i, 0) = 255 - i;
+    }
+
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    RDom r(0, 3, "r");
+    Func blur("blur"), f("f");
+    blur(x, y) = sum(cast<float>(input(x + r, y)));
+    f(x, y) = cast<uint8_t>(clamp(blur(x, y) * gain, 0.0f, 255.0f));
+    f(x, y) = cast<uint8_t>(lut(cast<int>(f(x, y)), 0));
+    blur.compute_at(f, x).vectorize(x, 4);
+    f.tile(x, y, xi, yi, 8, 8).parallel(y).vectorize(xi, 8);
+
+    Module m = f.compile_to_module({input, gain}, "serialized");
+    std::string text = to_text(m);
+
+    std::vector<uint8_t> data = serialize_module(m);
+    Module loaded = deserialize_module(data);
+
+    if (loaded.name() != m.name() || loaded.target() != m.target()) {
+        printf("Module name or target changed\n");
+        return -1;
+    }
+    if (to_text(loaded) != text) {
+        printf("Module changed by serialization. Before:\n%s\nAfter:\n%s\n",
+               text.c_str(), to_text(loaded).c_str());
+        return -1;
+    }
+    if (serialize_module(loaded) != data) {
+        printf("Serializing the deserialized module gave different data\n");
+        return -1;
+    }
+
+    // The lowered IR is smaller than its text form, because
+    // shared expressions and repeated names are only written once.
+    printf("Serialized %d bytes of lowered IR to %d bytes\n", (int)text.size(), (int)data.size());
+
+    save_module(m, "serialize_module.hlir");
+    Module from_file = load_module("serialize_module.hlir");
+    unlink("serialize_module.hlir");
+    if (to_text(from_file) != text) {
+        printf("Module changed by saving and loading it\n");
+        return -1;
+    }
+
+    // The loaded module can be compiled without the code that
+    // defined the pipeline.
+    compile_module_to_object(from_file, "serialize_module.o");
+    unlink("serialize_module.o");
+
+    printf("Success!\n");
+    return 0;
+}
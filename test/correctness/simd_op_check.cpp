@@ -17,7 +17,8 @@ using std::string;
 bool failed = false;
 Var x("x"), y("y");
 
-bool use_ssse3, use_sse41, use_sse42, use_avx, use_avx2;
+bool use_ssse3, use_sse41, use_sse42, use_avx, use_avx2, use_avx512_vnni;
+bool use_dot_prod;
 
 string filter = "";
 
@@ -26,12 +27,15 @@ Target target;
 int num_processes = 16;
 int my_process_id = 0;
 
-void check(string op, int vector_width, Expr e) {
+const int W = 256*3, H = 100;
+
+// Make a name for the test by uniquing then sanitizing the op
+// name. Returns false if the test should be skipped by this process.
+bool make_test_name(string op, string &name) {
     static int counter = 0;
     counter++;
 
-    // Make a name for the test by uniquing then sanitizing the op name
-    string name = "op_" + op;
+    name = "op_" + op;
     for (size_t i = 0; i < name.size(); i++) {
         if (!isalnum(name[i])) name[i] = '_';
     }
@@ -40,23 +44,12 @@ void check(string op, int vector_width, Expr e) {
     // Bail out after generating the unique_name, so that names are
     // unique across different processes and don't depend on filter
     // settings.
-    if ((!filter.empty()) && (op.find(filter) == string::npos)) return;
-    if (counter % num_processes != my_process_id) return;
-
-    const int W = 256*3, H = 100;
-
-    // Define a vectorized Func that uses the pattern.
-    Func f(name);
-    f(x, y) = e;
-    f.bound(x, 0, W).vectorize(x, vector_width);
-    f.compute_root();
-
-    // Include a scalar version
-    Func f_scalar("scalar_" + name);
-    f_scalar(x, y) = e;
-    f_scalar.bound(x, 0, W);
-    f_scalar.compute_root();
+    if ((!filter.empty()) && (op.find(filter) == string::npos)) return false;
+    if (counter % num_processes != my_process_id) return false;
+    return true;
+}
 
+void check_func(string op, string name, Func f, Func f_scalar) {
     // The output to the pipeline is the maximum absolute difference as a double.
     RDom r(0, W, 0, H);
     Func error("error_" + name);
@@ -109,6 +102,51 @@ void check(string op, int vector_width, Expr e) {
 
 }
 
+void check(string op, int vector_width, Expr e) {
+    string name;
+    if (!make_test_name(op, name)) return;
+
+    // Define a vectorized Func that uses the pattern.
+    Func f(name);
+    f(x, y) = e;
+    f.bound(x, 0, W).vectorize(x, vector_width);
+    f.compute_root();
+
+    // Include a scalar version
+    Func f_scalar("scalar_" + name);
+    f_scalar(x, y) = e;
+    f_scalar.bound(x, 0, W);
+    f_scalar.compute_root();
+
+    check_func(op, name, f, f_scalar);
+}
+
+// Check a horizontal reduction. The expression e (a function of x) is
+// summed over a window of x, with the reduction vectorized in pieces
+// of vector_width lanes.
+void check_reduce(string op, int vector_width, Expr e) {
+    string name;
+    if (!make_test_name(op, name)) return;
+
+    Func g;
+    g(x) = e;
+
+    RDom r(0, 64);
+    Func f(name);
+    f(x, y) = cast(e.type(), 0);
+    f(x, y) += g(x + r);
+    f.bound(x, 0, W).compute_root();
+    RVar ro, ri;
+    f.update().split(r, ro, ri, vector_width).vectorize(ri);
+
+    Func f_scalar("scalar_" + name);
+    f_scalar(x, y) = cast(e.type(), 0);
+    f_scalar(x, y) += g(x + r);
+    f_scalar.bound(x, 0, W).compute_root();
+
+    check_func(op, name, f, f_scalar);
+}
+
 Expr i64(Expr e) {
     return cast(Int(64), e);
 }
@@ -347,6 +385,37 @@ void check_sse_all() {
         check("pmaddwd", 8, i32(i16_1) * 3 + i32(i16_2) * 4);
     }
 
+    // Horizontal sums of widening multiplies
+    check_reduce("pmaddwd", 16, i32(i16_1) * i32(i16_2));
+    if (use_avx512_vnni) {
+        check_reduce("vpdpbusd", 32, i32(u8_1) * i32(i8_2));
+    } else {
+        // Without vnni, bytes get widened to 16 bits and use pmaddwd.
+        check_reduce("pmaddwd", 32, i32(u8_1) * i32(i8_2));
+    }
+    if (use_ssse3) {
+        // pmaddubsw saturates, so we only use it when the
+        // coefficients are small enough that it can't.
+        check_reduce("pmaddubsw", 32, i16(u8_1) * 3);
+    }
+
+    // Lookups into a small table of bytes
+    if (use_ssse3) {
+        Func lut;
+        lut(x) = u8(x * 37 + 3);
+        lut.compute_root();
+        check("pshufb", 16, lut(i32(u8_1 % 16)));
+        check("pshufb", 32, lut(i32(u8_1 % 32)));
+    }
+
+    // Gathers with data-dependent indices
+    if (use_avx2) {
+        check("vpgatherdd", 8, in_i32(i32(u8_1)));
+        check("vgatherdps", 8, in_f32(i32(u8_1)));
+        check("vpgatherdq", 4, in_i64(i32(u8_1)));
+        check("vgatherdpd", 4, in_f64(i32(u8_1)));
+    }
+
     // llvm doesn't distinguish between signed and unsigned multiplies
     //check("pmuldq", 4, i64(i32_1) * i64(i32_2));
 
@@ -865,6 +934,13 @@ void check_neon_all() {
         check(arm32 ? "vmlsl.s32" : "smlsl", 2*w, i64_1 - i64(i32_2)*i32_3);
         check(arm32 ? "vmlsl.u32" : "umlsl", 2*w, u64_1 - u64(u32_2)*u32_3);
 
+        // VSDOT    I       -       Signed Dot Product (ARMv8.2)
+        // VUDOT    I       -       Unsigned Dot Product (ARMv8.2)
+        if (use_dot_prod) {
+            check_reduce(arm32 ? "vsdot.s8" : "sdot", 8*w, i32(i8_1) * i32(i8_2));
+            check_reduce(arm32 ? "vudot.u8" : "udot", 8*w, u32(u8_1) * u32(u8_2));
+        }
+
         // VMOV     X       F, D    Move Register or Immediate
         // This is for loading immediates, which we won't do in the inner loop anyway
 
@@ -1316,7 +1392,17 @@ int main(int argc, char **argv) {
     target = get_target_from_environment();
     target.set_features({Target::NoBoundsQuery, Target::NoRuntime});
 
-    use_avx2 = target.has_feature(Target::AVX2);
+    // Don't expect the instructions of features that need a newer
+    // LLVM than the one Halide was built with.
+    for (Target::Feature f : {Target::AVX512_VNNI, Target::ARMDotProd}) {
+        if (target.has_feature(f) && !Target().with_feature(f).supported()) {
+            printf("Skipping checks for a feature this build of Halide can't use\n");
+            target = target.without_feature(f);
+        }
+    }
+
+    use_avx512_vnni = target.has_feature(Target::AVX512_VNNI);
+    use_avx2 = use_avx512_vnni || target.has_feature(Target::AVX2);
     use_avx = use_avx2 || target.has_feature(Target::AVX);
     use_sse41 = use_avx || target.has_feature(Target::SSE41);
 
@@ -1326,6 +1412,8 @@ int main(int argc, char **argv) {
     // There's no separate target for SSS4.2; we currently assume that
     // it should be used iff AVX is being used.
     use_sse42 = use_avx;
+
+    use_dot_prod = target.has_feature(Target::ARMDotProd);
     if (target.arch == Target::X86) {
         check_sse_all();
     } else {
@@ -0,0 +1,61 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 128, H = 96, T = 16;
+
+    Image<uint8_t> m(W, H);
+    Image<float> in(W + 2, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W + 2; x++) {
+            in(x, y) = (float)(rand() % 256);
+            if (x < W) {
+                // Only a few pixels of the mask are set.
+                m(x, y) = (x == 20 && y == 40) || (x >= 70 && x < 90 && y == 10);
+            }
+        }
+    }
+
+    Var x("x"), y("y"), xo("xo"), yo("yo"), xi("xi"), yi("yi");
+    Func mask("mask"), g("g"), f("f");
+    mask(x, y) = m(x, y);
+    g(x, y) = in(x, y) * 2.0f;
+    f(x, y) = select(mask(x, y) != 0, g(x, y) + g(x + 2, y), 0.0f);
+
+    // Use a fill value that f never takes, so that we can tell
+    // which tiles were skipped.
+    mask.compute_root();
+    g.compute_at(f, xo);
+    f.tile(x, y, xo, yo, xi, yi, T, T).vectorize(xi, 8).skip_tiles(xo, mask, -1.0f);
+
+    Image<float> out = f.realize(W, H);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int tx = x / T, ty = y / T;
+            bool tile_is_set = false;
+            for (int j = ty * T; j < (ty + 1) * T; j++) {
+                for (int i = tx * T; i < (tx + 1) * T; i++) {
+                    tile_is_set = tile_is_set || m(i, j);
+                }
+            }
+            float correct;
+            if (!tile_is_set) {
+                correct = -1.0f;
+            } else if (m(x, y)) {
+                correct = in(x, y) * 2.0f + in(x + 2, y) * 2.0f;
+            } else {
+                correct = 0.0f;
+            }
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %f instead of %f\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y"), c("c");
+
+    {
+        // An intermediate stored with channels in blocks of four,
+        // with the extent in c not a multiple of the block size.
+        Func f("f"), g("g");
+        f(x, y, c) = x + 10 * y + 100 * c;
+        g(x, y, c) = f(x, y, c) * 2 + f(x + 1, y, c);
+
+        f.compute_root().split_storage(c, 4).vectorize(c, 4);
+
+        Image<int> result = g.realize(10, 10, 6);
+        for (int c = 0; c < 6; c++) {
+            for (int y = 0; y < 10; y++) {
+                for (int x = 0; x < 10; x++) {
+                    int correct = (x + 10 * y + 100 * c) * 2 + (x + 1 + 10 * y + 100 * c);
+                    if (result(x, y, c) != correct) {
+                        printf("result(%d, %d, %d) = %d instead of %d\n",
+                               x, y, c, result(x, y, c), correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        // An intermediate stored as 8x8 tiles, read both along rows
+        // and along columns.
+        Func f("f"), g("g");
+        f(x, y) = x * 3 + y * 7;
+        g(x, y) = f(x, y) + f(y, x) * 2;
+
+        f.compute_root().split_storage(x, 8).split_storage(y, 8);
+
+        Image<int> result = g.realize(20, 20);
+        for (int y = 0; y < 20; y++) {
+            for (int x = 0; x < 20; x++) {
+                int correct = (x * 3 + y * 7) + (y * 3 + x * 7) * 2;
+                if (result(x, y) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // An input stored as 4x4 tiles. The buffer_t strides are the
+        // strides between tiles.
+        ImageParam input(Int(32), 2);
+        input.split_storage(0, 4).split_storage(1, 4);
+
+        Image<int> in(16, 16);
+        in.raw_buffer()->stride[0] = 16;
+        in.raw_buffer()->stride[1] = 64;
+        for (int y = 0; y < 16; y++) {
+            for (int x = 0; x < 16; x++) {
+                in.data()[(x / 4) * 16 + (y / 4) * 64 + (x % 4) + (y % 4) * 4] = x + y * 16;
+            }
+        }
+        input.set(in);
+
+        Func h("h");
+        h(x, y) = input(x, y) * 3;
+
+        Image<int> result = h.realize(16, 16);
+        for (int y = 0; y < 16; y++) {
+            for (int x = 0; x < 16; x++) {
+                int correct = (x + y * 16) * 3;
+                if (result(x, y) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n",
+                           x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // An output in the NCHW4c layout.
+        Func out("out");
+        out(x, y, c) = x + 10 * y + 100 * c;
+        out.split_storage(c, 4).vectorize(c, 4);
+
+        Image<int> result(8, 8, 8);
+        result.raw_buffer()->stride[0] = 4;
+        result.raw_buffer()->stride[1] = 32;
+        result.raw_buffer()->stride[2] = 256;
+        out.realize(result);
+
+        for (int c = 0; c < 8; c++) {
+            for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                    int val = result.data()[(c / 4) * 256 + y * 32 + x * 4 + c % 4];
+                    int correct = x + 10 * y + 100 * c;
+                    if (val != correct) {
+                        printf("out(%d, %d, %d) = %d instead of %d\n",
+                               x, y, c, val, correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        // realize allocates an output with a blocked layout in whole
+        // blocks, even when the extent isn't a multiple of the block
+        // size.
+        Func out("out");
+        out(x, y, c) = x + 10 * y + 100 * c;
+        out.split_storage(c, 4).vectorize(c, 4);
+
+        Buffer buf = out.realize(6, 5, 6)[0];
+        const buffer_t *raw = buf.raw_buffer();
+        if (raw->extent[2] != 6 ||
+            raw->stride[0] != 4 || raw->stride[1] != 24 || raw->stride[2] != 120) {
+            printf("Blocked output allocated with strides %d %d %d and extent %d\n",
+                   raw->stride[0], raw->stride[1], raw->stride[2], raw->extent[2]);
+            return -1;
+        }
+
+        const int *data = (const int *)buf.host_ptr();
+        for (int c = 0; c < 6; c++) {
+            for (int y = 0; y < 5; y++) {
+                for (int x = 0; x < 6; x++) {
+                    int val = data[(c / 4) * 120 + y * 24 + x * 4 + c % 4];
+                    int correct = x + 10 * y + 100 * c;
+                    if (val != correct) {
+                        printf("out(%d, %d, %d) = %d instead of %d\n",
+                               x, y, c, val, correct);
+                        return -1;
+                    }
+                }
+            }
+        }
+
+        // A dense buffer can't hold the blocked layout.
+        out.set_error_handler(my_error_handler);
+        Image<int> dense(8, 8, 8);
+        error_occurred = false;
+        out.realize(dense);
+        if (!error_occurred) {
+            printf("Realizing a blocked output into a dense buffer did not fail\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
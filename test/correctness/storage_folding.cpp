@@ -19,6 +19,11 @@ void my_free(void *user_context, void *ptr) {
     free(((void**)ptr)[-1]);
 }
 
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    error_occurred = true;
+}
+
 int main(int argc, char **argv) {
     Var x, y;
 
@@ -180,6 +185,182 @@ int main(int argc, char **argv) {
 
     }
 
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+
+        f(x, y) = x * y;
+        g(x) = f(x, x) + f(x+1, x+1);
+
+        // Each instance of g uses a 2x2 box of f that moves along the
+        // diagonal. Both dimensions can be folded over the loop over
+        // x, so f should fit in a small stack allocation.
+        f.store_root().compute_at(g, x);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        Image<int> im = g.realize(10000);
+
+        if (custom_malloc_size != 0) {
+            printf("There should not have been a heap allocation\n");
+            return -1;
+        }
+
+        for (int x = 0; x < im.width(); x++) {
+            int correct = x * x + (x+1) * (x+1);
+            if (im(x) != correct) {
+                printf("im(%d) = %d instead of %d\n", x, im(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+        Param<int> p;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + p);
+
+        // The stencil size isn't known at compile time, so storage
+        // folding needs to be told the fold factor.
+        f.store_root().compute_at(g, y).fold_storage(y, 8);
+
+        g.set_custom_allocator(my_malloc, my_free);
+        g.set_error_handler(my_error_handler);
+
+        p.set(3);
+        error_occurred = false;
+        Image<int> im = g.realize(1000, 1000);
+
+        if (error_occurred) {
+            printf("Error incorrectly raised\n");
+            return -1;
+        }
+
+        if (custom_malloc_size == 0 || custom_malloc_size > 1000*8*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)(1000*8*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 3);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // A stencil taller than the fold factor should be caught at
+        // runtime.
+        p.set(10);
+        error_occurred = false;
+        g.realize(1000, 1000);
+        if (!error_occurred) {
+            printf("Error incorrectly not raised for a stencil taller than the fold factor\n");
+            return -1;
+        }
+    }
+
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+        Param<int> factor;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + 2);
+
+        // A fold factor given by a Param that isn't used anywhere
+        // else must still become an argument of the pipeline.
+        f.store_root().compute_at(g, y).fold_storage(y, factor);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        factor.set(4);
+        Image<int> im = g.realize(1000, 1000);
+
+        if (custom_malloc_size == 0 || custom_malloc_size > 1000*4*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)(1000*4*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 2);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + 2);
+
+        // A fold factor that isn't a power of two gets rounded up to
+        // one.
+        f.store_root().compute_at(g, y).fold_storage(y, 5);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        Image<int> im = g.realize(1000, 1000);
+
+        if (custom_malloc_size != 1000*8*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)(1000*8*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 2);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        custom_malloc_size = 0;
+        Func f, g;
+        Param<int> factor;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + 2);
+
+        // So does one only known at runtime.
+        f.store_root().compute_at(g, y).fold_storage(y, factor);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        factor.set(3);
+        Image<int> im = g.realize(1000, 1000);
+
+        if (custom_malloc_size != 1000*4*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)(1000*4*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 2);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,95 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    // A large constant-sized intermediate forced onto the stack.
+    {
+        Func f("f"), g("g");
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) + f(x + 1, y);
+        f.compute_at(g, y).store_in(MemoryType::Stack);
+
+        Image<int> result = g.realize(8192, 4);
+        for (int y = 0; y < result.height(); y++) {
+            for (int x = 0; x < result.width(); x++) {
+                int correct = 2 * (x + y) + 1;
+                if (result(x, y) != correct) {
+                    printf("stack: result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A dynamically-sized intermediate forced onto the stack.
+    {
+        Func f("f"), g("g");
+        Param<int> p;
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x + p, y);
+        f.compute_at(g, y).store_in(MemoryType::Stack);
+
+        p.set(3);
+        Image<int> result = g.realize(100, 10);
+        for (int y = 0; y < result.height(); y++) {
+            for (int x = 0; x < result.width(); x++) {
+                int correct = x * y + (x + 3) * y;
+                if (result(x, y) != correct) {
+                    printf("dynamic stack: result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // A tiny intermediate forced onto the heap.
+    {
+        Func f("f"), g("g");
+        f(x) = x * 2;
+        g(x) = f(x) + f(x + 1);
+        f.compute_at(g, x).store_in(MemoryType::Heap);
+
+        Image<int> result = g.realize(16);
+        for (int x = 0; x < result.width(); x++) {
+            int correct = 4 * x + 2;
+            if (result(x) != correct) {
+                printf("heap: result(%d) = %d instead of %d\n", x, result(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    // A 3x3 window of a producer held in registers. The consumer and
+    // producer are fully unrolled, so every access is at a constant
+    // index.
+    {
+        Func in("in"), f("f"), g("g");
+        in(x, y) = x * 3 + y;
+        f(x, y) = in(x, y) * in(x, y);
+        g(x, y) = f(x, y) + f(x + 1, y) + f(x + 2, y) + f(x, y + 2);
+
+        Var xo, yo, xi, yi;
+        g.tile(x, y, xo, yo, xi, yi, 2, 2).unroll(xi).unroll(yi);
+        f.compute_at(g, xo).unroll(x).unroll(y).store_in(MemoryType::Register);
+
+        Image<int> result = g.realize(32, 32);
+        for (int y = 0; y < result.height(); y++) {
+            for (int x = 0; x < result.width(); x++) {
+                auto sq = [](int a) {return a * a;};
+                int correct = (sq(x * 3 + y) + sq((x + 1) * 3 + y) +
+                               sq((x + 2) * 3 + y) + sq(x * 3 + y + 2));
+                if (result(x, y) != correct) {
+                    printf("register: result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
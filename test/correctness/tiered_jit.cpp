@@ -0,0 +1,68 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+Func make_pipeline(int k) {
+    Var x("x"), y("y");
+    Func f("f"), g("g");
+    f(x, y) = x * k + y;
+    g(x, y) = f(x, y) + f(x + 1, y) * 2;
+    f.compute_root().vectorize(x, 8);
+    g.parallel(y).vectorize(x, 8);
+    g.set_tiered_jit(true);
+    return g;
+}
+
+bool check(Image<int> out, int k) {
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            int correct = (x * k + y) + (x + 1) * k * 2 + y * 2;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    // Realize a pipeline a few times while its optimized version is
+    // being compiled, then wait for it and check that realize
+    // switched over to it.
+    Func g = make_pipeline(3);
+    void *fast = g.compile_jit();
+    for (int i = 0; i < 5; i++) {
+        if (!check(g.realize(100, 50), 3)) {
+            return -1;
+        }
+    }
+    g.wait_for_tiered_jit();
+    void *optimized = g.compile_jit();
+    if (optimized == fast) {
+        printf("Pipeline did not switch to its optimized version\n");
+        return -1;
+    }
+    for (int i = 0; i < 5; i++) {
+        if (!check(g.realize(100, 50), 3)) {
+            return -1;
+        }
+    }
+    if (g.compile_jit() != optimized) {
+        printf("Pipeline did not stay on its optimized version\n");
+        return -1;
+    }
+
+    // Throw pipelines away before their optimized versions are
+    // ready, as an interactive tool would when the user edits them.
+    for (int k = 0; k < 5; k++) {
+        Func h = make_pipeline(k);
+        if (!check(h.realize(100, 50), k)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
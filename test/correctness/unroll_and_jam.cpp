@@ -0,0 +1,106 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Find the register allocation made for the accumulators.
+class FindAccumulators : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) {
+        if (op->memory_type == MemoryType::Register &&
+            ends_with(op->name, ".accumulator")) {
+            const int64_t *size = as_const_int(op->extents[0]);
+            if (size && *size > largest) {
+                largest = *size;
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    int64_t largest;
+    FindAccumulators() : largest(0) {}
+};
+
+class CheckAccumulators : public IRMutator {
+    int64_t expected;
+public:
+    using IRMutator::mutate;
+
+    Stmt mutate(Stmt s) {
+        FindAccumulators f;
+        s.accept(&f);
+        if (f.largest != expected) {
+            printf("Expected an accumulator of size %d, but the largest was %d\n",
+                   (int)expected, (int)f.largest);
+            exit(-1);
+        }
+        return s;
+    }
+
+    CheckAccumulators(int64_t e) : expected(e) {}
+};
+
+int main(int argc, char **argv) {
+    const int N = 32, K = 37;
+
+    Image<float> a(K, N), b(N, K);
+    for (int y = 0; y < N; y++) {
+        for (int x = 0; x < K; x++) {
+            a(x, y) = (float)(rand() % 16);
+            b(y, x) = (float)(rand() % 16);
+        }
+    }
+
+    Var x("x"), y("y"), xi("xi");
+    RDom r(0, K);
+
+    // A matrix multiply, accumulating a 4x8 tile of the output over
+    // the reduction.
+    {
+        Func f("f");
+        f(x, y) = 0.0f;
+        f(x, y) += a(r, y) * b(x, r);
+        f.update()
+            .split(x, x, xi, 8).reorder(xi, r, x, y).vectorize(xi)
+            .unroll_and_jam(y, r, 4);
+        f.add_custom_lowering_pass(new CheckAccumulators(4 * 8));
+
+        Image<float> out = f.realize(N, N);
+        for (int j = 0; j < N; j++) {
+            for (int i = 0; i < N; i++) {
+                float correct = 0.0f;
+                for (int k = 0; k < K; k++) {
+                    correct += a(k, j) * b(i, k);
+                }
+                if (out(i, j) != correct) {
+                    printf("f(%d, %d) = %f instead of %f\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Unroll-and-jam of a pure definition, by a factor that doesn't
+    // divide the extent.
+    {
+        Func g("g");
+        g(x, y) = x * 3 + y;
+        g.unroll_and_jam(y, x, 3);
+
+        Image<int> out = g.realize(10, 11);
+        for (int j = 0; j < 11; j++) {
+            for (int i = 0; i < 10; i++) {
+                if (out(i, j) != i * 3 + j) {
+                    printf("g(%d, %d) = %d instead of %d\n", i, j, out(i, j), i * 3 + j);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
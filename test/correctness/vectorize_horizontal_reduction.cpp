@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int size = 256;
+
+    Image<float> a(size, size);
+    Image<float> b(size);
+    Image<uint8_t> c(size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            a(x, y) = (float)((x * 7 + y * 3) % 11) - 5.0f;
+        }
+        b(y) = (float)(y % 5) - 2.0f;
+        c(y) = (uint8_t)((y * 37) & 0xff);
+    }
+
+    Var x;
+    RDom r(0, size);
+
+    // A matrix-vector product, with the reduction vectorized along
+    // the RVar. This is only legal because the update is an
+    // associative accumulation into a location that doesn't depend on
+    // r, so each vector of products is horizontally summed.
+    Func mv;
+    mv(x) = 0.0f;
+    mv(x) += a(r, x) * b(r);
+    RVar ro, ri;
+    mv.update().split(r, ro, ri, 8).vectorize(ri);
+
+    Image<float> mv_result = mv.realize(size);
+    for (int y = 0; y < size; y++) {
+        float correct = 0.0f;
+        for (int i = 0; i < size; i++) {
+            correct += a(i, y) * b(i);
+        }
+        if (mv_result(y) != correct) {
+            printf("mv(%d) = %f instead of %f\n", y, mv_result(y), correct);
+            return -1;
+        }
+    }
+
+    // A sum of widened uint8 values, which should use psadbw on x86.
+    Func sum;
+    sum() = 0;
+    sum() += cast<int>(c(r));
+    sum.update().vectorize(r, 16);
+
+    Image<int> sum_result = sum.realize();
+    int correct_sum = 0;
+    for (int i = 0; i < size; i++) {
+        correct_sum += c(i);
+    }
+    if (sum_result(0) != correct_sum) {
+        printf("sum = %d instead of %d\n", sum_result(0), correct_sum);
+        return -1;
+    }
+
+    // A max over an RDom.
+    Func mx;
+    mx() = cast<uint8_t>(0);
+    mx() = max(mx(), c(r));
+    mx.update().vectorize(r, 16);
+
+    Image<uint8_t> mx_result = mx.realize();
+    uint8_t correct_max = 0;
+    for (int i = 0; i < size; i++) {
+        correct_max = std::max(correct_max, c(i));
+    }
+    if (mx_result(0) != correct_max) {
+        printf("max = %d instead of %d\n", mx_result(0), correct_max);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
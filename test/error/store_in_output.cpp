@@ -0,0 +1,19 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f");
+    Var x("x");
+
+    f(x) = x;
+
+    // The storage for an output is provided by the caller.
+    f.store_in(MemoryType::Stack);
+
+    f.realize(10);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g");
+    Var x("x"), xo("xo"), xi("xi");
+
+    f(x) = x * 2;
+    g(x) = f(x) + f(x + 1);
+
+    g.split(x, xo, xi, 8);
+
+    // f is accessed at an index that depends on xi, which is not
+    // unrolled, so it can't live in registers.
+    f.compute_at(g, xo).store_in(MemoryType::Register);
+
+    g.realize(64);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
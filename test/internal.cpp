@@ -12,6 +12,8 @@
 #include "CSE.h"
 #include "IREquality.h"
 #include "Solve.h"
+#include "Serialize.h"
+#include "PromoteAccumulators.h"
 
 using namespace Halide;
 using namespace Halide::Internal;
@@ -29,6 +31,8 @@ int main(int argc, const char **argv) {
     simplify_test();
     solve_test();
     target_test();
+    serialize_test();
+    promote_accumulators_test();
 
     return 0;
 }
@@ -0,0 +1,139 @@
+#include "Halide.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Check that converting between packed and planar images with 2, 3,
+// or 4 channels runs about as fast as a dense copy of the same
+// number of bytes, i.e. at memory bandwidth.
+
+const int width = 2048, height = 2048;
+const int samples = 10, iterations = 10;
+
+// Timings are the best of many samples, but other load on the machine
+// still makes them noisy, so only fail when a conversion is much
+// slower than a copy. Conversions that fall back to scalar code are
+// an order of magnitude slower.
+const double max_slowdown = 4;
+
+// Make an image with the given number of channels stored either
+// packed (e.g. RGBRGBRGB...) or planar.
+Image<uint8_t> make_image(std::vector<uint8_t> &storage, int channels, bool packed) {
+    storage.resize(width * height * channels);
+    buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.host = &storage[0];
+    buf.extent[0] = width;
+    buf.extent[1] = height;
+    buf.extent[2] = channels;
+    if (packed) {
+        buf.stride[0] = channels;
+        buf.stride[1] = width * channels;
+        buf.stride[2] = 1;
+    } else {
+        buf.stride[0] = 1;
+        buf.stride[1] = width;
+        buf.stride[2] = width * height;
+    }
+    buf.elem_size = 1;
+    return Image<uint8_t>(&buf);
+}
+
+// Time a copy from src to dst, where one of them is packed and the
+// other is planar, and check the result.
+double time_conversion(int channels, bool to_planar) {
+    std::vector<uint8_t> src_storage, dst_storage;
+    Image<uint8_t> src_image = make_image(src_storage, channels, !to_planar);
+    Image<uint8_t> dst_image = make_image(dst_storage, channels, to_planar);
+
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                src_image(x, y, c) = (uint8_t)(x + y * 3 + c * 50);
+            }
+        }
+    }
+
+    ImageParam src(UInt(8), 3);
+    Func dst;
+    Var x, y, c;
+    dst(x, y, c) = src(x, y, c);
+
+    src.set_stride(0, to_planar ? channels : 1);
+    src.set_extent(2, channels);
+    if (to_planar) {
+        src.set_stride(2, 1);
+    } else {
+        dst.output_buffer().set_stride(0, channels).set_stride(2, 1);
+    }
+    dst.output_buffer().set_extent(2, channels);
+
+    dst.reorder(c, x, y).bound(c, 0, channels).unroll(c).vectorize(x, 16);
+
+    src.set(src_image);
+    dst.compile_jit();
+    dst.realize(dst_image);
+
+    double t = benchmark(samples, iterations, [&]() {
+        dst.realize(dst_image);
+    });
+
+    for (int c = 0; c < channels; c++) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (dst_image(x, y, c) != src_image(x, y, c)) {
+                    printf("dst(%d, %d, %d) = %d instead of %d\n",
+                           x, y, c, dst_image(x, y, c), src_image(x, y, c));
+                    exit(-1);
+                }
+            }
+        }
+    }
+
+    return t;
+}
+
+// Time a dense copy of an image with the same number of bytes.
+double time_dense_copy(int channels) {
+    Image<uint8_t> src_image(width * channels, height), dst_image(width * channels, height);
+
+    ImageParam src(UInt(8), 2);
+    Func dst;
+    Var x, y;
+    dst(x, y) = src(x, y);
+    dst.vectorize(x, 16);
+
+    src.set(src_image);
+    dst.compile_jit();
+    dst.realize(dst_image);
+
+    return benchmark(samples, iterations, [&]() {
+        dst.realize(dst_image);
+    });
+}
+
+int main(int argc, char **argv) {
+    for (int channels = 2; channels <= 4; channels++) {
+        double t_copy = time_dense_copy(channels);
+        double t_planar = time_conversion(channels, true);
+        double t_packed = time_conversion(channels, false);
+
+        double bytes = (double)width * height * channels;
+        printf("%d channels: dense copy %.3e byte/s, packed to planar %.3e byte/s (%.2fx the time), "
+               "planar to packed %.3e byte/s (%.2fx the time)\n",
+               channels, bytes / t_copy, bytes / t_planar, t_planar / t_copy,
+               bytes / t_packed, t_packed / t_copy);
+
+        if (t_planar > max_slowdown * t_copy || t_packed > max_slowdown * t_copy) {
+            printf("Converting between packed and planar with %d channels is slower than it should be.\n",
+                   channels);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
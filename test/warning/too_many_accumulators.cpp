@@ -0,0 +1,21 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    ImageParam a(Float(32), 2), b(Float(32), 2);
+    Func f;
+    Var x, y, xi;
+    RDom r(0, 64);
+
+    // A tile of 64 rows of vectors of accumulators is more than any
+    // target's vector register file.
+    f(x, y) = 0.0f;
+    f(x, y) += a(r, y) * b(x, r);
+    f.update().split(x, x, xi, 16).reorder(xi, r, x, y).vectorize(xi).unroll_and_jam(y, r, 64);
+
+    f.compile_jit();
+
+    return 0;
+}
@@ -83,6 +83,11 @@ public:
         initialize(x, y, z, w, interleaved);
     }
 
+    // Wrap an existing buffer_t, such as one from a MappedImage. The
+    // Image does not own the pixels, which must outlive it.
+    explicit Image(const buffer_t *b) : contents(new Contents(*b, NULL)) {
+    }
+
     Image(const Image &other) : contents(other.contents) {
         if (contents) {
             contents->ref_count++;
@@ -1,17 +1,30 @@
 // This simple PNG IO library works with *both* the Halide::Image<T> type *and*
-// the simple halide_image.h version. Also now includes PPM support for faster load/save.
+// the simple halide_image.h version. Also now includes PPM/PGM support for faster
+// load/save, and zero-copy memory-mapped readers for PPM/PGM, NPY, and raw files.
 
 #ifndef HALIDE_IMAGE_IO_H
 #define HALIDE_IMAGE_IO_H
 
 #include <algorithm>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "png.h"
+#include "HalideRuntime.h"
 
 namespace Halide {
 namespace Tools {
@@ -93,6 +106,91 @@ inline void swap_endian_16(bool little_endian, uint16_t &value) {
     }
 }
 
+// Convert an array of big-endian 16-bit values to native byte order.
+inline void big_endian_to_native_16(uint16_t *data, size_t count) {
+    if (is_little_endian()) {
+        for (size_t i = 0; i < count; i++) {
+            data[i] = (uint16_t)((data[i] << 8) | (data[i] >> 8));
+        }
+    }
+}
+
+// Convert a row of interleaved samples to a row of an image. The
+// common channel counts get their own instantiation, so the inner loop
+// has a fixed number of channels and a fixed stride between them.
+template<int channels, typename SrcType, typename DstType>
+inline void deinterleave_row_fixed(const SrcType *src, int width,
+                                   DstType *dst, int x_stride, int c_stride) {
+    for (int x = 0; x < width; x++) {
+        for (int c = 0; c < channels; c++) {
+            convert(src[x * channels + c], dst[x * x_stride + c * c_stride]);
+        }
+    }
+}
+
+template<typename SrcType, typename DstType>
+inline void deinterleave_row(const SrcType *src, int width, int channels,
+                             DstType *dst, int x_stride, int c_stride) {
+    switch (channels) {
+    case 1:
+        deinterleave_row_fixed<1>(src, width, dst, x_stride, c_stride);
+        break;
+    case 2:
+        deinterleave_row_fixed<2>(src, width, dst, x_stride, c_stride);
+        break;
+    case 3:
+        deinterleave_row_fixed<3>(src, width, dst, x_stride, c_stride);
+        break;
+    case 4:
+        deinterleave_row_fixed<4>(src, width, dst, x_stride, c_stride);
+        break;
+    default:
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < channels; c++) {
+                convert(src[x * channels + c], dst[x * x_stride + c * c_stride]);
+            }
+        }
+    }
+}
+
+// The inverse of deinterleave_row.
+template<typename SrcType, typename DstType>
+inline void interleave_row(const SrcType *src, int width, int channels,
+                           int x_stride, int c_stride, DstType *dst) {
+    for (int c = 0; c < channels; c++) {
+        const SrcType *s = src + c * c_stride;
+        DstType *d = dst + c;
+        for (int x = 0; x < width; x++) {
+            convert(s[x * x_stride], d[x * channels]);
+        }
+    }
+}
+
+// Call f(y_begin, y_end) on ranges of rows covering [0, height),
+// using up to the given number of threads. Zero threads means one per
+// core.
+template<typename F>
+inline void parallel_rows(int height, int threads, F f) {
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+    }
+    // Don't bother with threads for tiny images.
+    threads = std::min(threads, height / 16);
+    if (threads <= 1) {
+        f(0, height);
+        return;
+    }
+    int rows = (height + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (int y = rows; y < height; y += rows) {
+        workers.emplace_back(f, y, std::min(y + rows, height));
+    }
+    f(0, rows);
+    for (std::thread &t : workers) {
+        t.join();
+    }
+}
+
 struct FileOpener {
     FileOpener(const char* filename, const char* mode) : f(fopen(filename, mode)) {
         // nothing
@@ -128,8 +226,11 @@ struct PngRowPointers {
 }  // namespace Internal
 
 
+// Decoding is done by libpng on the calling thread. Converting the
+// decoded rows to the image's type and planar layout is split across
+// the given number of threads (zero means one per core).
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool load_png(const std::string &filename, ImageType *im) {
+bool load_png(const std::string &filename, ImageType *im, int threads = 0) {
     png_byte header[8];
     png_structp png_ptr;
     png_infop info_ptr;
@@ -184,31 +285,24 @@ bool load_png(const std::string &filename, ImageType *im) {
 
     // convert the data to ImageType::ElemType
 
+    typedef typename ImageType::ElemType ElemType;
+    ElemType *ptr = (ElemType*)im->data();
+    int x_stride = im->stride(0), y_stride = im->stride(1);
     int c_stride = (im->channels() == 1) ? 0 : im->stride(2);
-    typename ImageType::ElemType *ptr = (typename ImageType::ElemType*)im->data();
-    if (bit_depth == 8) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    Internal::convert(*srcPtr++, ptr[c*c_stride]);
-                }
-                ptr++;
-            }
-        }
-    } else if (bit_depth == 16) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    uint16_t hi = (*srcPtr++) << 8;
-                    uint16_t lo = hi | (*srcPtr++);
-                    Internal::convert(lo, ptr[c*c_stride]);
-                }
-                ptr++;
+    Internal::parallel_rows(im->height(), threads, [&](int y_begin, int y_end) {
+        std::vector<uint16_t> row16(bit_depth == 16 ? width * channels : 0);
+        for (int y = y_begin; y < y_end; y++) {
+            ElemType *dst = ptr + (ptrdiff_t)y * y_stride;
+            if (bit_depth == 8) {
+                Internal::deinterleave_row((const uint8_t *)row_pointers.p[y], width, channels,
+                                           dst, x_stride, c_stride);
+            } else {
+                memcpy(row16.data(), row_pointers.p[y], row16.size() * sizeof(uint16_t));
+                Internal::big_endian_to_native_16(row16.data(), row16.size());
+                Internal::deinterleave_row(row16.data(), width, channels, dst, x_stride, c_stride);
             }
         }
-    }
+    });
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
@@ -216,9 +310,11 @@ bool load_png(const std::string &filename, ImageType *im) {
     return true;
 }
 
-// "im" is not const-ref because copy_to_host() is not const.
+// "im" is not const-ref because copy_to_host() is not const. Converting
+// to PNG's interleaved layout is split across the given number of
+// threads (zero means one per core).
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool save_png(ImageType &im, const std::string &filename) {
+bool save_png(ImageType &im, const std::string &filename, int threads = 0) {
     png_structp png_ptr;
     png_infop info_ptr;
     png_byte color_type;
@@ -266,36 +362,25 @@ bool save_png(ImageType &im, const std::string &filename) {
 
     // im.copyToHost(); // in case the image is on the gpu
 
+    typedef typename ImageType::ElemType ElemType;
+    const ElemType *ptr = (const ElemType*)im.data();
+    int x_stride = im.stride(0), y_stride = im.stride(1);
     int c_stride = (im.channels() == 1) ? 0 : im.stride(2);
-    typename ImageType::ElemType *srcPtr = (typename ImageType::ElemType*)im.data();
-
-    for (int y = 0; y < im.height(); y++) {
-        uint8_t *dstPtr = (uint8_t *)(row_pointers.p[y]);
-        if (bit_depth == 16) {
-            // convert to uint16_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint16_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out >> 8;
-                    *dstPtr++ = out & 0xff;
-                }
-                srcPtr++;
-            }
-        } else if (bit_depth == 8) {
-            // convert to uint8_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint8_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out;
-                }
-                srcPtr++;
+    int width = im.width(), channels = im.channels();
+    Internal::parallel_rows(im.height(), threads, [&](int y_begin, int y_end) {
+        for (int y = y_begin; y < y_end; y++) {
+            const ElemType *src = ptr + (ptrdiff_t)y * y_stride;
+            if (bit_depth == 16) {
+                uint16_t *dst = (uint16_t *)(row_pointers.p[y]);
+                Internal::interleave_row(src, width, channels, x_stride, c_stride, dst);
+                // PNG stores 16-bit samples big-endian.
+                Internal::big_endian_to_native_16(dst, width * channels);
+            } else {
+                uint8_t *dst = (uint8_t *)(row_pointers.p[y]);
+                Internal::interleave_row(src, width, channels, x_stride, c_stride, dst);
             }
-        } else {
-            if (!check(bit_depth == 8 || bit_depth == 16, "We only support saving 8- and 16-bit images.")) return false;
         }
-    }
+    });
 
     // write data
     if (!check(!setjmp(png_jmpbuf(png_ptr)), "[write_png_file] Error during writing bytes")) return false;
@@ -312,8 +397,9 @@ bool save_png(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// Loads binary PPM (P6) and PGM (P5) files.
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool load_ppm(const std::string &filename, ImageType *im) {
+bool load_ppm(const std::string &filename, ImageType *im, int threads = 0) {
 
     /* open file and test for it being a ppm */
     Internal::FileOpener f(filename.c_str(), "rb");
@@ -331,97 +417,432 @@ bool load_ppm(const std::string &filename, ImageType *im) {
     else if (maxval == 65535) { bit_depth = 16; }
     else { if (!check(false, "Invalid bit depth in PPM\n")) return false; }
 
-    if (!check(header == std::string("P6") || header == std::string("p6"), "Input is not binary PPM\n")) return false;
+    int channels = 0;
+    if (header == std::string("P6") || header == std::string("p6")) {
+        channels = 3;
+        *im = ImageType(width, height, channels);
+    } else if (header == std::string("P5") || header == std::string("p5")) {
+        channels = 1;
+        *im = ImageType(width, height);
+    } else {
+        return check(false, "Input is not binary PPM or PGM\n");
+    }
 
-    int channels = 3;
-    *im = ImageType(width, height, channels);
+    // Read all the data, then convert it to ImageType::ElemType.
+    size_t samples = (size_t)width * height * channels;
+    std::vector<uint8_t> data(samples * bit_depth / 8);
+    if (!check(fread((void *) data.data(), 1, data.size(), f.f) == data.size(), "Could not read PPM data\n")) return false;
+    if (bit_depth == 16) {
+        Internal::big_endian_to_native_16((uint16_t *)data.data(), samples);
+    }
 
-    // convert the data to ImageType::ElemType
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
-        if (!check(fread((void *) data.data(), sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 8-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *row = &data[(y*width)*3];
-            for (int x = 0; x < im->width(); x++) {
-                Internal::convert(*row++, im_data[(0*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(1*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(2*height+y)*width+x]);
+    typedef typename ImageType::ElemType ElemType;
+    ElemType *ptr = (ElemType*)im->data();
+    int x_stride = im->stride(0), y_stride = im->stride(1);
+    int c_stride = (channels == 1) ? 0 : im->stride(2);
+    Internal::parallel_rows(height, threads, [&](int y_begin, int y_end) {
+        for (int y = y_begin; y < y_end; y++) {
+            ElemType *dst = ptr + (ptrdiff_t)y * y_stride;
+            size_t row = (size_t)y * width * channels;
+            if (bit_depth == 8) {
+                Internal::deinterleave_row(data.data() + row, width, channels, dst, x_stride, c_stride);
+            } else {
+                Internal::deinterleave_row((const uint16_t *)data.data() + row, width, channels,
+                                           dst, x_stride, c_stride);
             }
         }
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
-        if (!check(fread((void *) data.data(), sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 16-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        for (int y = 0; y < im->height(); y++) {
-            uint16_t *row = &data[(y*width)*3];
-            for (int x = 0; x < im->width(); x++) {
-                uint16_t value;
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(0*height+y)*width+x]);
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(1*height+y)*width+x]);
-                value = *row++; Internal::swap_endian_16(little_endian, value); Internal::convert(value, im_data[(2*height+y)*width+x]);
-            }
-        }
-    }
-    (*im)(0,0,0) = (*im)(0,0,0);      /* Mark dirty inside read/write functions. */
+    });
+    im->set_host_dirty();
 
     return true;
 }
 
-// "im" is not const-ref because copy_to_host() is not const.
+// Saves single-channel images as binary PGM (P5), and others as binary
+// PPM (P6). "im" is not const-ref because copy_to_host() is not const.
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool save_ppm(ImageType &im, const std::string &filename) {
+bool save_ppm(ImageType &im, const std::string &filename, int threads = 0) {
     im.copy_to_host();
 
-	unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
+    unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
+    int channels = im.channels() == 1 ? 1 : 3;
+    if (!check(im.channels() == 1 || im.channels() == 3, "Can only save PPM files with 1 or 3 channels\n")) return false;
 
     Internal::FileOpener f(filename.c_str(), "wb");
     if (!check(f.f != nullptr, "File %s could not be opened for writing\n", filename.c_str())) return false;
-    fprintf(f.f, "P6\n%d %d\n%d\n", im.width(), im.height(), (1<<bit_depth)-1);
+    fprintf(f.f, "%s\n%d %d\n%d\n", channels == 1 ? "P5" : "P6", im.width(), im.height(), (1<<bit_depth)-1);
     int width = im.width(), height = im.height();
 
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
-        for (int y = 0; y < im.height(); y++) {
-            for (int x = 0; x < im.width(); x++) {
-                uint8_t *p = &data[(y*width+x)*3];
-                for (int c = 0; c < im.channels(); c++) {
-                    Internal::convert(im(x, y, c), p[c]);
-                }
+    typedef typename ImageType::ElemType ElemType;
+    const ElemType *ptr = (const ElemType*)im.data();
+    int x_stride = im.stride(0), y_stride = im.stride(1);
+    int c_stride = (channels == 1) ? 0 : im.stride(2);
+    size_t samples = (size_t)width * height * channels;
+    std::vector<uint8_t> data(samples * bit_depth / 8);
+    Internal::parallel_rows(height, threads, [&](int y_begin, int y_end) {
+        for (int y = y_begin; y < y_end; y++) {
+            const ElemType *src = ptr + (ptrdiff_t)y * y_stride;
+            size_t row = (size_t)y * width * channels;
+            if (bit_depth == 8) {
+                Internal::interleave_row(src, width, channels, x_stride, c_stride, data.data() + row);
+            } else {
+                uint16_t *dst = (uint16_t *)data.data() + row;
+                Internal::interleave_row(src, width, channels, x_stride, c_stride, dst);
+                Internal::big_endian_to_native_16(dst, width * channels);
             }
         }
-        if (!check(fwrite((void *) data.data(), sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 8-bit data\n")) return false;
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
-        for (int y = 0; y < im.height(); y++) {
-            for (int x = 0; x < im.width(); x++) {
-                uint16_t *p = &data[(y*width+x)*3];
-                for (int c = 0; c < im.channels(); c++) {
-                    uint16_t value;
-                    Internal::convert(im(x, y, c), value);
-                    Internal::swap_endian_16(little_endian, value);
-                    p[c] = value;
-                }
-            }
+    });
+    if (!check(fwrite((void *) data.data(), 1, data.size(), f.f) == data.size(), "Could not write PPM data\n")) return false;
+    return true;
+}
+
+namespace Internal {
+
+// The contents of a whole file. Where possible the file is mapped
+// copy-on-write, so pages are only read from disk as they are touched,
+// and writes to them never reach the file. Elsewhere it is read into
+// memory.
+class MappedFile {
+    uint8_t *ptr;
+    size_t bytes;
+    bool mapped;
+    std::vector<uint8_t> copy;
+
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+public:
+    MappedFile() : ptr(nullptr), bytes(0), mapped(false) {}
+
+    bool open(const std::string &filename) {
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        bytes = (size_t)st.st_size;
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // The mapping holds its own reference to the file.
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        ptr = (uint8_t *)p;
+        mapped = true;
+        return true;
+#else
+        FileOpener f(filename.c_str(), "rb");
+        if (f.f == nullptr || fseek(f.f, 0, SEEK_END) != 0) return false;
+        long size = ftell(f.f);
+        if (size <= 0 || fseek(f.f, 0, SEEK_SET) != 0) return false;
+        copy.resize((size_t)size);
+        if (fread(copy.data(), 1, copy.size(), f.f) != copy.size()) return false;
+        ptr = copy.data();
+        bytes = copy.size();
+        return true;
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped) {
+            munmap(ptr, bytes);
+        }
+#endif
+    }
+
+    uint8_t *data() const { return ptr; }
+    size_t size() const { return bytes; }
+};
+
+struct MappedImageContents {
+    MappedFile file;
+    buffer_t buf;
+    halide_type_t type;
+
+    MappedImageContents() : type(halide_type_uint, 8) {
+        memset(&buf, 0, sizeof(buf));
+    }
+};
+
+// Point buf at the pixels, which start at the given offset into the
+// file, checking that the file is big enough and the pixels suitably
+// aligned.
+inline bool set_mapped_pixels(MappedImageContents *c, size_t offset) {
+    size_t elem_size = (c->type.bits + 7) / 8;
+    size_t end = offset;
+    for (int i = 0; i < 4 && c->buf.extent[i]; i++) {
+        end += (size_t)(c->buf.extent[i] - 1) * c->buf.stride[i] * elem_size;
+    }
+    end += elem_size;
+    if (end > c->file.size() || (offset % elem_size) != 0) return false;
+    c->buf.host = c->file.data() + offset;
+    c->buf.elem_size = (int32_t)elem_size;
+    return true;
+}
+
+// Skip whitespace and comments in a PNM header, then parse an integer.
+inline bool parse_pnm_int(const uint8_t *data, size_t size, size_t *pos, int *value) {
+    while (*pos < size) {
+        if (data[*pos] == '#') {
+            while (*pos < size && data[*pos] != '\n') (*pos)++;
+        } else if (isspace(data[*pos])) {
+            (*pos)++;
+        } else {
+            break;
         }
-        if (!check(fwrite((void *) data.data(), sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 16-bit data\n")) return false;
+    }
+    int64_t v = 0;
+    size_t start = *pos;
+    while (*pos < size && isdigit(data[*pos]) && v <= 0x7fffffff) {
+        v = v * 10 + (data[(*pos)++] - '0');
+    }
+    *value = (int)v;
+    return *pos > start && v <= 0x7fffffff;
+}
+
+// Find the value following 'key': in the Python dict literal that makes
+// up an NPY header.
+inline bool find_npy_field(const std::string &header, const std::string &key, size_t *pos) {
+    size_t k = header.find("'" + key + "'");
+    if (k == std::string::npos) return false;
+    k = header.find(':', k);
+    if (k == std::string::npos) return false;
+    k = header.find_first_not_of(" ", k + 1);
+    if (k == std::string::npos) return false;
+    *pos = k;
+    return true;
+}
+
+}  // namespace Internal
+
+// An image whose pixels live in a memory-mapped file, as returned by
+// map_ppm, map_npy, map_raw, and map_image. No pixels are copied or
+// converted; the image has whatever type and layout the file uses, so
+// it is described by a buffer_t rather than an Image<T>. Pass it
+// directly to a statically-compiled pipeline, or wrap it with an Image
+// of the right type. Copies refer to the same mapping, which stays
+// alive as long as any copy does. The file is mapped copy-on-write, so
+// writing to the pixels does not modify it.
+class MappedImage {
+    std::shared_ptr<Internal::MappedImageContents> contents;
+
+public:
+    MappedImage() {}
+    explicit MappedImage(std::shared_ptr<Internal::MappedImageContents> c) : contents(c) {}
+
+    bool defined() const { return contents != nullptr; }
+
+    buffer_t *raw_buffer() const { return &contents->buf; }
+    operator buffer_t *() const { return raw_buffer(); }
+
+    halide_type_t type() const { return contents->type; }
+
+    int dimensions() const {
+        int d = 0;
+        while (d < 4 && contents->buf.extent[d]) d++;
+        return d;
+    }
+
+    int width() const { return contents->buf.extent[0]; }
+    int height() const { return contents->buf.extent[1]; }
+    int channels() const { return contents->buf.extent[2]; }
+    int extent(int dim) const { return contents->buf.extent[dim]; }
+    int stride(int dim) const { return contents->buf.stride[dim]; }
+};
+
+// Maps a binary PPM (P6) or PGM (P5) file. PPM images are interleaved,
+// with channels innermost. 16-bit samples are stored big-endian, so on
+// little-endian hosts they are byte-swapped in place (and moved back a
+// byte over the header if they're misaligned), which touches every
+// page of the mapping but allocates nothing.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+bool map_ppm(const std::string &filename, MappedImage *im) {
+    std::shared_ptr<Internal::MappedImageContents> c(new Internal::MappedImageContents);
+    if (!check(c->file.open(filename), "File %s could not be mapped\n", filename.c_str())) return false;
+
+    const uint8_t *data = c->file.data();
+    size_t size = c->file.size();
+    if (!check(size > 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6'),
+               "%s is not a binary PPM or PGM file\n", filename.c_str())) return false;
+    int channels = data[1] == '6' ? 3 : 1;
+
+    size_t pos = 2;
+    int width = 0, height = 0, maxval = 0;
+    if (!check(Internal::parse_pnm_int(data, size, &pos, &width) &&
+               Internal::parse_pnm_int(data, size, &pos, &height) &&
+               Internal::parse_pnm_int(data, size, &pos, &maxval) &&
+               pos < size && isspace(data[pos]),
+               "Could not parse the header of %s\n", filename.c_str())) return false;
+    // Exactly one whitespace character separates the header from the pixels.
+    pos++;
+
+    if (!check(maxval == 255 || maxval == 65535, "Invalid bit depth in PPM\n")) return false;
+    c->type = halide_type_t(halide_type_uint, maxval == 255 ? 8 : 16);
+    size_t samples = (size_t)width * height * channels;
+    if (maxval == 65535 && (pos & 1) && pos + samples * 2 <= size) {
+        memmove(c->file.data() + pos - 1, c->file.data() + pos, samples * 2);
+        pos--;
+    }
+
+    buffer_t &buf = c->buf;
+    buf.extent[0] = width;
+    buf.extent[1] = height;
+    buf.stride[0] = channels;
+    buf.stride[1] = width * channels;
+    if (channels == 3) {
+        buf.extent[2] = 3;
+        buf.stride[2] = 1;
+    }
+    if (!check(width > 0 && height > 0 && Internal::set_mapped_pixels(c.get(), pos),
+               "%s is truncated, or its pixels are misaligned\n", filename.c_str())) return false;
+
+    if (maxval == 65535) {
+        Internal::big_endian_to_native_16((uint16_t *)buf.host, samples);
+    }
+
+    *im = MappedImage(c);
+    return true;
+}
+
+// Maps a NumPy .npy file containing a little-endian array of bools,
+// integers, or floats with between one and four dimensions. The first
+// two axes of the array are swapped, so that an array of shape
+// (height, width) or (height, width, channels), as produced by most
+// Python imaging libraries, has x as its first dimension.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+bool map_npy(const std::string &filename, MappedImage *im) {
+    std::shared_ptr<Internal::MappedImageContents> c(new Internal::MappedImageContents);
+    if (!check(c->file.open(filename), "File %s could not be mapped\n", filename.c_str())) return false;
+
+    const uint8_t *data = c->file.data();
+    size_t size = c->file.size();
+    if (!check(size > 10 && memcmp(data, "\x93NUMPY", 6) == 0,
+               "%s is not an NPY file\n", filename.c_str())) return false;
+
+    // Version 1 has a 16-bit header length; later versions a 32-bit one.
+    int major = data[6];
+    size_t header_start = major == 1 ? 10 : 12;
+    size_t header_len = data[8] | (data[9] << 8);
+    if (major != 1 && size > 12) {
+        header_len |= ((size_t)data[10] << 16) | ((size_t)data[11] << 24);
+    }
+    if (!check(header_start + header_len <= size, "%s has a truncated header\n", filename.c_str())) return false;
+    std::string header((const char *)data + header_start, header_len);
+
+    size_t pos;
+    if (!check(Internal::find_npy_field(header, "descr", &pos) && pos + 4 <= header.size(),
+               "%s has no dtype\n", filename.c_str())) return false;
+    char order = header[pos + 1], kind = header[pos + 2];
+    int bytes = atoi(header.c_str() + pos + 3);
+    if (!check(order != '>' || bytes == 1,
+               "%s is big-endian, which is not supported\n", filename.c_str())) return false;
+    if (!check(Internal::is_little_endian() || bytes == 1,
+               "Mapping multi-byte NPY data requires a little-endian host\n")) return false;
+    if (kind == 'b' && bytes == 1) {
+        c->type = halide_type_t(halide_type_uint, 8);
+    } else if (kind == 'u' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        c->type = halide_type_t(halide_type_uint, bytes * 8);
+    } else if (kind == 'i' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        c->type = halide_type_t(halide_type_int, bytes * 8);
+    } else if (kind == 'f' && (bytes == 2 || bytes == 4 || bytes == 8)) {
+        c->type = halide_type_t(halide_type_float, bytes * 8);
     } else {
-        return check(false, "We only support saving 8- and 16-bit images.");
+        return check(false, "%s has unsupported dtype %c%d\n", filename.c_str(), kind, bytes);
+    }
+
+    bool fortran_order = false;
+    if (Internal::find_npy_field(header, "fortran_order", &pos)) {
+        fortran_order = header.compare(pos, 4, "True") == 0;
+    }
+
+    std::vector<int> shape;
+    if (!check(Internal::find_npy_field(header, "shape", &pos) && header[pos] == '(',
+               "%s has no shape\n", filename.c_str())) return false;
+    for (pos++; pos < header.size() && header[pos] != ')'; pos++) {
+        if (isdigit(header[pos])) {
+            long s = strtol(header.c_str() + pos, nullptr, 10);
+            if (!check(s > 0 && s <= 0x7fffffff, "%s has an empty or oversized axis\n", filename.c_str())) return false;
+            shape.push_back((int)s);
+            while (pos + 1 < header.size() && isdigit(header[pos + 1])) pos++;
+        }
     }
+    int dims = (int)shape.size();
+    if (!check(dims >= 1 && dims <= 4, "%s must have between one and four dimensions\n", filename.c_str())) return false;
+
+    // Element strides of each axis of the array.
+    std::vector<int64_t> strides(dims);
+    int64_t s = 1;
+    for (int i = 0; i < dims; i++) {
+        int axis = fortran_order ? i : dims - 1 - i;
+        strides[axis] = s;
+        s *= shape[axis];
+    }
+    if (!check(s <= 0x7fffffff, "%s is too large to describe with a buffer_t\n", filename.c_str())) return false;
+
+    for (int d = 0; d < dims; d++) {
+        int axis = (dims >= 2 && d < 2) ? 1 - d : d;
+        c->buf.extent[d] = shape[axis];
+        c->buf.stride[d] = (int32_t)strides[axis];
+    }
+    if (!check(Internal::set_mapped_pixels(c.get(), header_start + header_len),
+               "%s is truncated, or its pixels are misaligned\n", filename.c_str())) return false;
+
+    *im = MappedImage(c);
+    return true;
+}
+
+// Maps a file containing a dense planar image of the given type and
+// size, with the first dimension innermost, after a header of the given
+// number of bytes.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+bool map_raw(const std::string &filename, halide_type_t type, const std::vector<int> &sizes,
+             MappedImage *im, size_t header_bytes = 0) {
+    if (!check(!sizes.empty() && sizes.size() <= 4, "Raw images must have between one and four dimensions\n")) return false;
+    if (!check(type.lanes == 1 && type.bits % 8 == 0 && type.bits > 0, "Raw images must have a scalar type with whole bytes\n")) return false;
+
+    std::shared_ptr<Internal::MappedImageContents> c(new Internal::MappedImageContents);
+    if (!check(c->file.open(filename), "File %s could not be mapped\n", filename.c_str())) return false;
+    c->type = type;
+
+    int64_t s = 1;
+    for (size_t d = 0; d < sizes.size(); d++) {
+        if (!check(sizes[d] > 0, "Raw images must have a positive size in each dimension\n")) return false;
+        c->buf.extent[d] = sizes[d];
+        c->buf.stride[d] = (int32_t)s;
+        s *= sizes[d];
+        if (!check(s <= 0x7fffffff, "%s is too large to describe with a buffer_t\n", filename.c_str())) return false;
+    }
+    if (!check(Internal::set_mapped_pixels(c.get(), header_bytes),
+               "%s is truncated, or its pixels are misaligned\n", filename.c_str())) return false;
+
+    *im = MappedImage(c);
     return true;
 }
 
+// Returns false upon failure.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+bool map_image(const std::string &filename, MappedImage *im) {
+    if (Internal::ends_with_ignore_case(filename, ".ppm") ||
+        Internal::ends_with_ignore_case(filename, ".pgm")) {
+        return map_ppm<check>(filename, im);
+    } else if (Internal::ends_with_ignore_case(filename, ".npy")) {
+        return map_npy<check>(filename, im);
+    } else {
+        return check(false, "[map_image] unsupported file extension (ppm|pgm|npy supported)");
+    }
+}
+
 // Returns false upon failure.
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool load(const std::string &filename, ImageType *im) {
     if (Internal::ends_with_ignore_case(filename, ".png")) {
         return load_png<ImageType, check>(filename, im);
-    } else if (Internal::ends_with_ignore_case(filename, ".ppm")) {
+    } else if (Internal::ends_with_ignore_case(filename, ".ppm") ||
+               Internal::ends_with_ignore_case(filename, ".pgm")) {
         return load_ppm<ImageType, check>(filename, im);
     } else {
-        return check(false, "[load] unsupported file extension (png|ppm supported)");
+        return check(false, "[load] unsupported file extension (png|ppm|pgm supported)");
     }
 }
 
@@ -430,10 +851,11 @@ template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool save(ImageType &im, const std::string &filename) {
     if (Internal::ends_with_ignore_case(filename, ".png")) {
         return save_png<ImageType, check>(im, filename);
-    } else if (Internal::ends_with_ignore_case(filename, ".ppm")) {
+    } else if (Internal::ends_with_ignore_case(filename, ".ppm") ||
+               Internal::ends_with_ignore_case(filename, ".pgm")) {
         return save_ppm<ImageType, check>(im, filename);
     } else {
-        return check(false, "[save] unsupported file extension (png|ppm supported)");
+        return check(false, "[save] unsupported file extension (png|ppm|pgm supported)");
     }
 }
 